@@ -5,6 +5,7 @@ import (
 	"flag"
 	"os"
 	"os/signal"
+	"strings"
 	"syscall"
 	"time"
 
@@ -19,6 +20,7 @@ import (
 
 	"github.com/zrs-products/hetero-compute-router/pkg/agent"
 	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
+	"github.com/zrs-products/hetero-compute-router/pkg/monitoring/ebpf"
 )
 
 var (
@@ -51,6 +53,33 @@ var (
 
 	// ReportInterval report interval
 	ReportInterval time.Duration
+
+	// InterceptorStatsDir root of the interceptor's shared stats pages
+	InterceptorStatsDir string
+
+	// EBPFEnabled registers the eBPF health collector
+	EBPFEnabled bool
+
+	// EBPFPinPath bpffs directory for pinned maps and links
+	EBPFPinPath string
+
+	// EBPFGPUSampleInterval interval for reading the kernel GPU aggregates
+	EBPFGPUSampleInterval time.Duration
+
+	// EBPFPCIeSampleInterval interval for reading the kernel PCIe counters
+	EBPFPCIeSampleInterval time.Duration
+
+	// EBPFVRAMTracing loads vram_tracker to attribute VRAM to pods via uprobes
+	EBPFVRAMTracing bool
+
+	// EBPFVRAMLibraries runtime libraries to probe (comma-separated)
+	EBPFVRAMLibraries string
+
+	// EBPFVRAMLibraryDirs directories searched for runtime libraries (comma-separated)
+	EBPFVRAMLibraryDirs string
+
+	// EBPFCgroupRoot host cgroup v2 tree used to map cgroup ids to pods
+	EBPFCgroupRoot string
 )
 
 func init() {
@@ -61,6 +90,28 @@ func init() {
 	flag.IntVar(&MockDeviceCount, "mock-devices", 4, "Number of mock devices")
 	flag.DurationVar(&CollectInterval, "collect-interval", 10*time.Second, "Metrics collection interval")
 	flag.DurationVar(&ReportInterval, "report-interval", 30*time.Second, "CRD report interval")
+	flag.StringVar(&InterceptorStatsDir, "interceptor-stats-dir", "/dev/shm/hcs", "Root of the interceptor stats pages (empty to disable)")
+
+	defaults := ebpf.DefaultConfig()
+	flag.BoolVar(&EBPFEnabled, "ebpf", false, "Enable the eBPF health collector (programs load only in hcs_bpf builds)")
+	flag.StringVar(&EBPFPinPath, "ebpf-pin-path", defaults.PinPath, "bpffs directory for pinned eBPF maps and links")
+	flag.DurationVar(&EBPFGPUSampleInterval, "ebpf-gpu-sample-interval", defaults.GPUSampleInterval, "Interval for reading eBPF GPU aggregates")
+	flag.DurationVar(&EBPFPCIeSampleInterval, "ebpf-pcie-sample-interval", defaults.PCIeSampleInterval, "Interval for reading eBPF PCIe counters")
+	flag.BoolVar(&EBPFVRAMTracing, "ebpf-vram-tracing", false, "Attribute VRAM to pods with uprobes on the GPU runtime libraries (requires --ebpf and hostPID)")
+	flag.StringVar(&EBPFVRAMLibraries, "ebpf-vram-libraries", "", "Comma-separated runtime libraries to probe (default: search --ebpf-vram-library-dirs)")
+	flag.StringVar(&EBPFVRAMLibraryDirs, "ebpf-vram-library-dirs", "", "Comma-separated directories searched for runtime libraries (default: common host library dirs)")
+	flag.StringVar(&EBPFCgroupRoot, "ebpf-cgroup-root", "", "Host cgroup v2 mount used to resolve pods (default: /sys/fs/cgroup)")
+}
+
+// splitList splits a comma-separated flag value, dropping empty fields
+func splitList(s string) []string {
+	var values []string
+	for _, v := range strings.Split(s, ",") {
+		if v = strings.TrimSpace(v); v != "" {
+			values = append(values, v)
+		}
+	}
+	return values
 }
 
 func main() {
@@ -96,6 +147,19 @@ func main() {
 		CollectInterval: CollectInterval,
 		ReportInterval:  ReportInterval,
 		UseMock:         UseMock,
+
+		InterceptorStatsDir: InterceptorStatsDir,
+	}
+
+	if EBPFEnabled {
+		config.EBPF = ebpf.DefaultConfig()
+		config.EBPF.PinPath = EBPFPinPath
+		config.EBPF.GPUSampleInterval = EBPFGPUSampleInterval
+		config.EBPF.PCIeSampleInterval = EBPFPCIeSampleInterval
+		config.EBPF.VRAMTracing = EBPFVRAMTracing
+		config.EBPF.VRAMLibraries = splitList(EBPFVRAMLibraries)
+		config.EBPF.VRAMLibraryDirs = splitList(EBPFVRAMLibraryDirs)
+		config.EBPF.CgroupRoot = EBPFCgroupRoot
 	}
 
 	if UseMock {
@@ -18,6 +18,7 @@ import (
 	"k8s.io/client-go/rest"
 	"k8s.io/client-go/tools/clientcmd"
 	"k8s.io/klog/v2"
+	"sigs.k8s.io/controller-runtime/pkg/cache"
 	"sigs.k8s.io/controller-runtime/pkg/client"
 
 	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
@@ -84,10 +85,16 @@ type HostPriority struct {
 type HostPriorityList []HostPriority
 
 // NewSchedulerExtender 创建调度器扩展器
-func NewSchedulerExtender(c client.Client) *SchedulerExtender {
+// nodeCache 为 nil 时插件直接通过 client 读取 ComputeNode
+func NewSchedulerExtender(c client.Client, nodeCache *plugins.ComputeNodeCache) *SchedulerExtender {
+	filterPlugin := plugins.NewFilterPlugin(c)
+	if nodeCache != nil {
+		filterPlugin.UseComputeNodeCache(nodeCache)
+	}
+
 	return &SchedulerExtender{
 		client:        c,
-		filterPlugin:  plugins.NewFilterPlugin(c),
+		filterPlugin:  filterPlugin,
 		scorePlugin:   plugins.NewScorePlugin(c, nil),
 		reservePlugin: plugins.NewReservePlugin(c),
 	}
@@ -263,14 +270,31 @@ func main() {
 	klog.Info("Initializing Hetero Compute Scheduler Extender")
 
 	// 创建 K8s 客户端
-	k8sClient, err := createK8sClient()
+	config, err := createRESTConfig()
 	if err != nil {
 		klog.Errorf("Failed to create Kubernetes client: %v", err)
 		os.Exit(1)
 	}
+	k8sClient, err := client.New(config, client.Options{Scheme: scheme})
+	if err != nil {
+		klog.Errorf("Failed to create Kubernetes client: %v", err)
+		os.Exit(1)
+	}
+
+	// 启动 ComputeNode informer，失败时回退到逐节点读取 API Server
+	nodeCache, err := startComputeNodeCache(ctx, config)
+	if err != nil {
+		klog.Warningf("ComputeNode cache unavailable, falling back to direct reads: %v", err)
+		nodeCache = nil
+	}
 
 	// 创建调度器扩展器
-	extender := NewSchedulerExtender(k8sClient)
+	extender := NewSchedulerExtender(k8sClient, nodeCache)
+
+	// 按拦截器上报的 Pod 实际用量收缩预留
+	if nodeCache != nil {
+		go extender.reservePlugin.RunReconciler(ctx, nodeCache, plugins.DefaultReconcileInterval, plugins.DefaultReservationTTL)
+	}
 
 	// 启动 HTTP 服务器
 	server := &http.Server{
@@ -307,8 +331,39 @@ func main() {
 	klog.Info("Scheduler extender stopped")
 }
 
-// createK8sClient 创建 Kubernetes 客户端
-func createK8sClient() (client.Client, error) {
+// startComputeNodeCache 启动 ComputeNode informer 并等待首次同步完成
+func startComputeNodeCache(ctx context.Context, config *rest.Config) (*plugins.ComputeNodeCache, error) {
+	informers, err := cache.New(config, cache.Options{Scheme: scheme})
+	if err != nil {
+		return nil, err
+	}
+
+	informer, err := informers.GetInformer(ctx, &v1alpha1.ComputeNode{})
+	if err != nil {
+		return nil, err
+	}
+
+	nodeCache := plugins.NewComputeNodeCache()
+	if err := nodeCache.AddToInformer(informer); err != nil {
+		return nil, err
+	}
+
+	go func() {
+		if err := informers.Start(ctx); err != nil {
+			klog.Errorf("ComputeNode informer stopped: %v", err)
+		}
+	}()
+
+	if !informers.WaitForCacheSync(ctx) {
+		return nil, fmt.Errorf("ComputeNode informer failed to sync")
+	}
+	klog.Infof("ComputeNode cache synced with %d nodes", nodeCache.Snapshot().Len())
+
+	return nodeCache, nil
+}
+
+// createRESTConfig 创建 Kubernetes 客户端配置
+func createRESTConfig() (*rest.Config, error) {
 	var config *rest.Config
 	var err error
 
@@ -338,10 +393,5 @@ func createK8sClient() (client.Client, error) {
 		}
 	}
 
-	c, err := client.New(config, client.Options{Scheme: scheme})
-	if err != nil {
-		return nil, err
-	}
-
-	return c, nil
+	return config, nil
 }
@@ -48,6 +48,9 @@ var (
 
 	// EnableLeaderElection enables leader election
 	EnableLeaderElection bool
+
+	// StatsHostPath is the host directory for interceptor stats pages
+	StatsHostPath string
 )
 
 func init() {
@@ -57,6 +60,7 @@ func init() {
 	flag.StringVar(&CertDir, "cert-dir", "/tmp/k8s-webhook-server/serving-certs", "Directory containing TLS certificates")
 	flag.StringVar(&DefaultVendor, "default-vendor", "nvidia", "Default vendor for injection (nvidia, huawei, hygon, cambricon)")
 	flag.BoolVar(&EnableLeaderElection, "enable-leader-election", false, "Enable leader election")
+	flag.StringVar(&StatsHostPath, "interceptor-stats-host-path", webhook.DefaultStatsHostDir, "Host directory for interceptor stats pages (empty to disable)")
 }
 
 func main() {
@@ -99,7 +103,9 @@ func main() {
 	injector := webhook.NewInjector(injectorOpts...)
 
 	// Create HCS injector for VRAM quota enforcement
-	hcsInjector := webhook.NewHCSInjector()
+	hcsInjector := webhook.NewHCSInjector(
+		webhook.WithStatsHostPath(StatsHostPath),
+	)
 
 	// Create mutator and validator
 	mutator := webhook.NewPodMutator(mgr.GetClient(),
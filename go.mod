@@ -4,6 +4,7 @@ go 1.21
 
 require (
 	github.com/NVIDIA/go-nvml v0.13.0-1
+	github.com/cilium/ebpf v0.12.3
 	k8s.io/api v0.28.0
 	k8s.io/apimachinery v0.28.0
 	k8s.io/client-go v0.28.0
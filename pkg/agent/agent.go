@@ -10,6 +10,7 @@ import (
 
 	"github.com/zrs-products/hetero-compute-router/pkg/collectors"
 	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
+	"github.com/zrs-products/hetero-compute-router/pkg/monitoring/ebpf"
 )
 
 // Config Agent 配置
@@ -28,6 +29,13 @@ type Config struct {
 
 	// MockConfig Mock 检测器配置
 	MockConfig *MockConfig
+
+	// InterceptorStatsDir 拦截器共享统计页根目录，为空时不采集
+	InterceptorStatsDir string
+
+	// EBPF eBPF 健康采集器配置，为 nil 时不注册
+	// 未以 hcs_bpf 标签构建或内核不支持时退化为轮询，采集器仍注册
+	EBPF *ebpf.Config
 }
 
 // MockConfig Mock 配置
@@ -54,6 +62,7 @@ type Agent struct {
 	detector   detectors.Detector
 	collectors *collectors.Manager
 	reporter   *Reporter
+	ebpf       *ebpf.EBPFHealthCollector
 
 	// 最新采集的数据
 	latestMetrics *collectors.Metrics
@@ -79,8 +88,32 @@ func New(config *Config, reporter *Reporter) (*Agent, error) {
 		stopCh:     make(chan struct{}),
 	}
 
+	// 连续 3 个采集周期拿不到新结果时不再沿用旧值，健康状态按数据缺失上报
+	if config.CollectInterval > 0 {
+		agent.collectors.SetMaxStale(3 * config.CollectInterval)
+	}
+
+	if config.InterceptorStatsDir != "" {
+		agent.collectors.Register(collectors.NewInterceptorCollector(config.InterceptorStatsDir))
+	}
+
+	if config.EBPF != nil {
+		collector, err := ebpf.NewEBPFHealthCollector(config.EBPF)
+		if err != nil {
+			return nil, fmt.Errorf("failed to create eBPF collector: %w", err)
+		}
+		if !collector.IsEnabled() {
+			klog.Warning("eBPF programs not loaded, eBPF health collector falls back to polling")
+		}
+		agent.ebpf = collector
+		agent.collectors.Register(collector)
+	}
+
 	// 初始化检测器
 	if err := agent.initDetector(); err != nil {
+		if agent.ebpf != nil {
+			agent.ebpf.Close()
+		}
 		return nil, fmt.Errorf("failed to initialize detector: %w", err)
 	}
 
@@ -173,6 +206,12 @@ func (a *Agent) Stop() error {
 		}
 	}
 
+	if a.ebpf != nil {
+		if err := a.ebpf.Close(); err != nil {
+			klog.Warningf("Failed to close eBPF collector: %v", err)
+		}
+	}
+
 	klog.Info("Node-Agent stopped")
 	return nil
 }
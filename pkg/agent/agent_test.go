@@ -4,6 +4,8 @@ import (
 	"context"
 	"testing"
 	"time"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/monitoring/ebpf"
 )
 
 func TestNewAgent(t *testing.T) {
@@ -34,6 +36,40 @@ func TestNewAgent(t *testing.T) {
 	}
 }
 
+func TestNewAgent_EBPF(t *testing.T) {
+	config := &Config{
+		NodeName:        "test-node",
+		CollectInterval: 10 * time.Second,
+		UseMock:         true,
+	}
+
+	agent, err := New(config, nil)
+	if err != nil {
+		t.Fatalf("New() failed: %v", err)
+	}
+	for _, name := range agent.collectors.List() {
+		if name == "ebpf-health" {
+			t.Error("eBPF collector should not be registered without Config.EBPF")
+		}
+	}
+
+	config.EBPF = ebpf.DefaultConfig()
+	config.EBPF.PinPath = t.TempDir()
+	agent, err = New(config, nil)
+	if err != nil {
+		t.Fatalf("New() failed: %v", err)
+	}
+	defer agent.Stop()
+
+	registered := false
+	for _, name := range agent.collectors.List() {
+		registered = registered || name == "ebpf-health"
+	}
+	if !registered {
+		t.Errorf("Expected ebpf-health collector, got %v", agent.collectors.List())
+	}
+}
+
 func TestAgent_StartStop(t *testing.T) {
 	config := &Config{
 		NodeName:        "test-node",
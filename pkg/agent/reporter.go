@@ -3,9 +3,12 @@ package agent
 import (
 	"context"
 	"fmt"
+	"math"
+	"sync"
 	"time"
 
 	corev1 "k8s.io/api/core/v1"
+	"k8s.io/apimachinery/pkg/api/equality"
 	"k8s.io/apimachinery/pkg/api/errors"
 	metav1 "k8s.io/apimachinery/pkg/apis/meta/v1"
 	"k8s.io/klog/v2"
@@ -16,15 +19,51 @@ import (
 	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
 )
 
+const (
+	// DefaultResyncInterval 强制从 API Server 重新读取并对齐的间隔
+	DefaultResyncInterval = 10 * time.Minute
+
+	// DefaultNoisyInterval 抖动字段（显存用量、健康分）在阈值内变化时的最长上报间隔
+	DefaultNoisyInterval = time.Minute
+
+	// DefaultVRAMDelta 显存用量变化低于该值时视为抖动（bytes）
+	DefaultVRAMDelta = 256 * 1024 * 1024
+
+	// DefaultHealthDelta 健康分变化低于该值时视为抖动
+	DefaultHealthDelta = 2.0
+)
+
 // Reporter CRD 上报器
+//
+// 上报以增量方式进行：与上次成功写入的对象比较，只在有变化时向主资源和
+// status 子资源分别发送 merge patch。显存用量与健康分在阈值内的抖动沿用上次的值，
+// 最长 NoisyInterval 后按实际值上报；Phase、Conditions 状态与设备增减等变化立即上报。
 type Reporter struct {
 	client client.Client
+
+	// ResyncInterval 超过该间隔后重新 Get 对象，纠正他人修改或上报丢失造成的偏差
+	ResyncInterval time.Duration
+	// NoisyInterval 抖动字段的最长上报间隔
+	NoisyInterval time.Duration
+	// VRAMDelta 显存用量的抖动阈值（bytes）
+	VRAMDelta uint64
+	// HealthDelta 健康分的抖动阈值
+	HealthDelta float64
+
+	mu        sync.Mutex
+	last      *v1alpha1.ComputeNode // 上次成功写入的对象，nil 表示需要重新 Get
+	lastSync  time.Time             // 上次从 API Server 读取的时间
+	lastExact time.Time             // 上次按实际值上报抖动字段的时间
 }
 
 // NewReporter 创建上报器
 func NewReporter(c client.Client) *Reporter {
 	return &Reporter{
-		client: c,
+		client:         c,
+		ResyncInterval: DefaultResyncInterval,
+		NoisyInterval:  DefaultNoisyInterval,
+		VRAMDelta:      DefaultVRAMDelta,
+		HealthDelta:    DefaultHealthDelta,
 	}
 }
 
@@ -33,39 +72,170 @@ func (r *Reporter) Report(ctx context.Context, nodeName string, hwType *detector
 	// 构建 ComputeNode 对象
 	cn := r.buildComputeNode(nodeName, hwType, devices, metrics)
 
-	// 尝试获取现有的 ComputeNode
-	existing := &v1alpha1.ComputeNode{}
-	err := r.client.Get(ctx, client.ObjectKey{Name: nodeName}, existing)
+	r.mu.Lock()
+	defer r.mu.Unlock()
 
-	if err != nil {
-		if errors.IsNotFound(err) {
-			// 创建新的 ComputeNode
-			klog.Infof("Creating ComputeNode: %s", nodeName)
-			if err := r.client.Create(ctx, cn); err != nil {
-				return fmt.Errorf("failed to create ComputeNode: %w", err)
+	now := time.Now()
+	base := r.last
+	if base == nil || base.Name != nodeName || now.Sub(r.lastSync) >= r.ResyncInterval {
+		// 尝试获取现有的 ComputeNode
+		existing := &v1alpha1.ComputeNode{}
+		err := r.client.Get(ctx, client.ObjectKey{Name: nodeName}, existing)
+
+		if err != nil {
+			if errors.IsNotFound(err) {
+				return r.create(ctx, cn, now)
 			}
-			return nil
+			return fmt.Errorf("failed to get ComputeNode: %w", err)
 		}
-		return fmt.Errorf("failed to get ComputeNode: %w", err)
+		base = existing
+		r.lastSync = now
+	}
+
+	// 抖动字段在阈值内时沿用上次的值
+	exact := now.Sub(r.lastExact) >= r.NoisyInterval
+	r.stabilize(cn, base, exact)
+
+	if err := r.patch(ctx, base, cn); err != nil {
+		// 下次重新 Get，以服务端状态为基准
+		r.last = nil
+		return err
 	}
 
-	// 更新现有的 ComputeNode
-	existing.Spec = cn.Spec
-	existing.Status = cn.Status
+	r.last = cn
+	if exact {
+		r.lastExact = now
+	}
+	return nil
+}
 
-	klog.V(2).Infof("Updating ComputeNode: %s", nodeName)
-	if err := r.client.Update(ctx, existing); err != nil {
-		return fmt.Errorf("failed to update ComputeNode: %w", err)
+// create 创建 ComputeNode 并写入 status
+// 启用 status 子资源时 Create 会丢弃 status，需要单独写入
+func (r *Reporter) create(ctx context.Context, cn *v1alpha1.ComputeNode, now time.Time) error {
+	klog.Infof("Creating ComputeNode: %s", cn.Name)
+	created := cn.DeepCopy()
+	if err := r.client.Create(ctx, created); err != nil {
+		return fmt.Errorf("failed to create ComputeNode: %w", err)
 	}
 
-	// 更新状态（需要单独调用 Status().Update()）
-	if err := r.client.Status().Update(ctx, existing); err != nil {
+	base := created.DeepCopy()
+	base.Status = v1alpha1.ComputeNodeStatus{}
+	created.Status = cn.Status
+	if err := r.client.Status().Patch(ctx, created, client.MergeFrom(base)); err != nil {
 		return fmt.Errorf("failed to update ComputeNode status: %w", err)
 	}
 
+	r.last = cn
+	r.lastSync = now
+	r.lastExact = now
 	return nil
 }
 
+// patch 将 desired 相对 base 的变化以 merge patch 写入，spec 与 status 分别提交
+func (r *Reporter) patch(ctx context.Context, base, desired *v1alpha1.ComputeNode) error {
+	if !equality.Semantic.DeepEqual(base.Spec, desired.Spec) {
+		obj := base.DeepCopy()
+		obj.Spec = desired.Spec
+		klog.V(2).Infof("Patching ComputeNode spec: %s", desired.Name)
+		if err := r.client.Patch(ctx, obj, client.MergeFrom(base)); err != nil {
+			return fmt.Errorf("failed to update ComputeNode: %w", err)
+		}
+	}
+
+	if !equality.Semantic.DeepEqual(base.Status, desired.Status) {
+		obj := base.DeepCopy()
+		obj.Status = desired.Status
+		klog.V(2).Infof("Patching ComputeNode status: %s", desired.Name)
+		if err := r.client.Status().Patch(ctx, obj, client.MergeFrom(base)); err != nil {
+			return fmt.Errorf("failed to update ComputeNode status: %w", err)
+		}
+	}
+
+	return nil
+}
+
+// stabilize 抑制 desired 中相对 base 的抖动
+// 状态未变的条件保留原 LastTransitionTime；exact 为 false 时，
+// 阈值内的显存用量与健康分变化沿用 base 的值
+func (r *Reporter) stabilize(desired, base *v1alpha1.ComputeNode, exact bool) {
+	baseConditions := make(map[v1alpha1.ComputeNodeConditionType]*v1alpha1.ComputeNodeCondition, len(base.Status.Conditions))
+	for i := range base.Status.Conditions {
+		baseConditions[base.Status.Conditions[i].Type] = &base.Status.Conditions[i]
+	}
+	for i := range desired.Status.Conditions {
+		cond := &desired.Status.Conditions[i]
+		old, ok := baseConditions[cond.Type]
+		if !ok || old.Status != cond.Status {
+			continue
+		}
+		cond.LastTransitionTime = old.LastTransitionTime
+		// Healthy 的消息只携带健康分，变化低于 HealthDelta 时沿用旧消息
+		if !exact && cond.Type == v1alpha1.ComputeNodeConditionHealthy && old.Reason == cond.Reason {
+			newScore, okNew := messageHealthScore(cond.Message)
+			oldScore, okOld := messageHealthScore(old.Message)
+			if okNew && okOld && math.Abs(newScore-oldScore) < r.HealthDelta {
+				cond.Message = old.Message
+			}
+		}
+	}
+
+	if exact {
+		return
+	}
+
+	baseDevices := make(map[string]*v1alpha1.DeviceInfo, len(base.Status.Devices))
+	for i := range base.Status.Devices {
+		baseDevices[base.Status.Devices[i].ID] = &base.Status.Devices[i]
+	}
+	for i := range desired.Status.Devices {
+		dev := &desired.Status.Devices[i]
+		old, ok := baseDevices[dev.ID]
+		if !ok {
+			continue
+		}
+		dev.VRAMUsed = r.holdVRAM(dev.VRAMUsed, old.VRAMUsed)
+		dev.VRAMAllocated = r.holdVRAM(dev.VRAMAllocated, old.VRAMAllocated)
+		if math.Abs(dev.HealthScore-old.HealthScore) < r.HealthDelta {
+			dev.HealthScore = old.HealthScore
+		}
+	}
+
+	baseWorkloads := make(map[string]*v1alpha1.WorkloadUsage, len(base.Status.Workloads))
+	for i := range base.Status.Workloads {
+		baseWorkloads[base.Status.Workloads[i].PodUID] = &base.Status.Workloads[i]
+	}
+	for i := range desired.Status.Workloads {
+		w := &desired.Status.Workloads[i]
+		old, ok := baseWorkloads[w.PodUID]
+		if !ok {
+			continue
+		}
+		w.VRAMUsed = r.holdVRAM(w.VRAMUsed, old.VRAMUsed)
+		w.VRAMPeak = r.holdVRAM(w.VRAMPeak, old.VRAMPeak)
+	}
+}
+
+// messageHealthScore 从 Healthy 条件的消息中解析健康分
+func messageHealthScore(message string) (float64, bool) {
+	var score float64
+	if _, err := fmt.Sscanf(message, "Health score: %f", &score); err != nil {
+		return 0, false
+	}
+	return score, true
+}
+
+// holdVRAM 变化低于 VRAMDelta 时返回旧值
+func (r *Reporter) holdVRAM(value, old uint64) uint64 {
+	diff := value - old
+	if value < old {
+		diff = old - value
+	}
+	if diff < r.VRAMDelta {
+		return old
+	}
+	return value
+}
+
 // buildComputeNode 构建 ComputeNode 对象
 func (r *Reporter) buildComputeNode(nodeName string, hwType *detectors.HardwareType, devices []*detectors.Device, metrics *collectors.Metrics) *v1alpha1.ComputeNode {
 	cn := &v1alpha1.ComputeNode{
@@ -92,6 +262,12 @@ func (r *Reporter) buildComputeNode(nodeName string, hwType *detectors.HardwareT
 		}
 	}
 
+	// 拦截器上报的每设备显存分配
+	allocated := make(map[string]uint64, len(metrics.DeviceMetrics))
+	for _, dm := range metrics.DeviceMetrics {
+		allocated[dm.DeviceID] = dm.VRAMAllocated
+	}
+
 	// 填充设备信息
 	for _, dev := range devices {
 		deviceInfo := v1alpha1.DeviceInfo{
@@ -102,10 +278,66 @@ func (r *Reporter) buildComputeNode(nodeName string, hwType *detectors.HardwareT
 			HealthScore:      dev.HealthScore,
 			PCIEBusID:        dev.PCIEBusID,
 			InterconnectType: string(detectors.LinkTypePCIe), // 默认 PCIe
+			VRAMAllocated:    allocated[dev.ID],
 		}
 		cn.Status.Devices = append(cn.Status.Devices, deviceInfo)
 	}
 
+	// 填充 Pod 级显存使用
+	if metrics.Interceptor != nil {
+		for _, pod := range metrics.Interceptor.Pods {
+			cn.Status.Workloads = append(cn.Status.Workloads, v1alpha1.WorkloadUsage{
+				PodUID:       pod.PodUID,
+				Namespace:    pod.Namespace,
+				Name:         pod.Name,
+				Processes:    int32(pod.Processes),
+				VRAMUsed:     pod.Used,
+				VRAMLimit:    pod.Limit,
+				VRAMPeak:     pod.Peak,
+				FailedAllocs: pod.FailedAllocs,
+			})
+		}
+	}
+
+	// 拦截器未覆盖的 Pod（静态链接、未注入 LD_PRELOAD 等）使用 eBPF 追踪的用量
+	if len(metrics.TracedVRAM) > 0 {
+		reported := make(map[string]bool, len(cn.Status.Workloads))
+		for _, w := range cn.Status.Workloads {
+			reported[w.PodUID] = true
+		}
+		traced := make(map[string]int)
+		for _, c := range metrics.TracedVRAM {
+			if reported[c.PodUID] {
+				continue
+			}
+			i, ok := traced[c.PodUID]
+			if !ok {
+				i = len(cn.Status.Workloads)
+				traced[c.PodUID] = i
+				cn.Status.Workloads = append(cn.Status.Workloads, v1alpha1.WorkloadUsage{PodUID: c.PodUID})
+			}
+			cn.Status.Workloads[i].VRAMUsed += c.Used
+		}
+	}
+
+	// eBPF 追踪的每容器 DMA 带宽，按 Pod 汇总到所有设备
+	if len(metrics.TracedPCIe) > 0 {
+		index := make(map[string]int, len(cn.Status.Workloads))
+		for i, w := range cn.Status.Workloads {
+			index[w.PodUID] = i
+		}
+		for _, c := range metrics.TracedPCIe {
+			i, ok := index[c.PodUID]
+			if !ok {
+				i = len(cn.Status.Workloads)
+				index[c.PodUID] = i
+				cn.Status.Workloads = append(cn.Status.Workloads, v1alpha1.WorkloadUsage{PodUID: c.PodUID})
+			}
+			cn.Status.Workloads[i].PCIeReadBytesPerSec += uint64(c.ReadBytesPerSec)
+			cn.Status.Workloads[i].PCIeWriteBytesPerSec += uint64(c.WriteBytesPerSec)
+		}
+	}
+
 	// 设置条件
 	now := metav1.NewTime(time.Now())
 
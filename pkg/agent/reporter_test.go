@@ -3,7 +3,9 @@ package agent
 import (
 	"context"
 	"fmt"
+	"strings"
 	"testing"
+	"time"
 
 	"k8s.io/apimachinery/pkg/api/errors"
 	"k8s.io/apimachinery/pkg/api/meta"
@@ -24,6 +26,12 @@ type mockClient struct {
 	updateErr    error
 	getErr       error
 	deleteErr    error
+	patchErr     error
+
+	// 记录的调用，用于验证增量上报
+	gets          int
+	patches       []string
+	statusPatches []string
 }
 
 func newMockK8sClient() *mockClient {
@@ -33,6 +41,7 @@ func newMockK8sClient() *mockClient {
 }
 
 func (c *mockClient) Get(ctx context.Context, key client.ObjectKey, obj client.Object, opts ...client.GetOption) error {
+	c.gets++
 	if c.getErr != nil {
 		return c.getErr
 	}
@@ -81,6 +90,19 @@ func (c *mockClient) DeleteAllOf(ctx context.Context, obj client.Object, opts ..
 }
 
 func (c *mockClient) Patch(ctx context.Context, obj client.Object, patch client.Patch, opts ...client.PatchOption) error {
+	if c.patchErr != nil {
+		return c.patchErr
+	}
+	data, err := patch.Data(obj)
+	if err != nil {
+		return err
+	}
+	c.patches = append(c.patches, string(data))
+
+	cn := obj.(*v1alpha1.ComputeNode)
+	if existing, ok := c.computeNodes[cn.Name]; ok {
+		existing.Spec = cn.Spec
+	}
 	return nil
 }
 
@@ -125,6 +147,21 @@ func (s *mockStatusWriter) Update(ctx context.Context, obj client.Object, opts .
 }
 
 func (s *mockStatusWriter) Patch(ctx context.Context, obj client.Object, patch client.Patch, opts ...client.SubResourcePatchOption) error {
+	if s.client.patchErr != nil {
+		return s.client.patchErr
+	}
+	data, err := patch.Data(obj)
+	if err != nil {
+		return err
+	}
+	s.client.statusPatches = append(s.client.statusPatches, string(data))
+
+	cn := obj.(*v1alpha1.ComputeNode)
+	existing, ok := s.client.computeNodes[cn.Name]
+	if !ok {
+		return errors.NewNotFound(schema.GroupResource{}, cn.Name)
+	}
+	existing.Status = *cn.Status.DeepCopy()
 	return nil
 }
 
@@ -469,3 +506,244 @@ func TestDefaultConfig(t *testing.T) {
 		t.Error("UseMock should be false by default")
 	}
 }
+
+func TestReporter_BuildComputeNode_InterceptorUsage(t *testing.T) {
+	c := newMockK8sClient()
+	reporter := NewReporter(c)
+
+	hwType := &detectors.HardwareType{
+		Vendor:          "nvidia",
+		DriverAvailable: true,
+	}
+
+	devices := []*detectors.Device{{ID: "gpu-0"}, {ID: "gpu-1"}}
+
+	metrics := &collectors.Metrics{
+		Health: &collectors.HealthMetrics{Score: 90.0},
+		DeviceMetrics: []collectors.DeviceMetric{
+			{DeviceID: "gpu-0", VRAMAllocated: 6 << 30},
+			{DeviceID: "gpu-1"},
+		},
+		Interceptor: &collectors.InterceptorMetrics{
+			Pods: []collectors.PodVRAMUsage{
+				{PodUID: "uid-a", Namespace: "default", Name: "train", Processes: 2, Used: 6 << 30, Limit: 16 << 30},
+			},
+		},
+	}
+
+	cn := reporter.buildComputeNode("test-node", hwType, devices, metrics)
+
+	if cn.Status.Devices[0].VRAMAllocated != 6<<30 || cn.Status.Devices[1].VRAMAllocated != 0 {
+		t.Errorf("Unexpected per-device allocation: %+v", cn.Status.Devices)
+	}
+	if len(cn.Status.Workloads) != 1 {
+		t.Fatalf("Expected 1 workload, got %d", len(cn.Status.Workloads))
+	}
+	w := cn.Status.Workloads[0]
+	if w.PodUID != "uid-a" || w.Processes != 2 || w.VRAMUsed != 6<<30 || w.VRAMLimit != 16<<30 {
+		t.Errorf("Unexpected workload usage: %+v", w)
+	}
+}
+
+func TestReporter_BuildComputeNode_TracedPCIe(t *testing.T) {
+	reporter := NewReporter(newMockK8sClient())
+	hwType := &detectors.HardwareType{Vendor: "nvidia", DriverAvailable: true}
+	devices := []*detectors.Device{{ID: "gpu-0"}, {ID: "gpu-1"}}
+
+	metrics := &collectors.Metrics{
+		Health: &collectors.HealthMetrics{Score: 90.0},
+		Interceptor: &collectors.InterceptorMetrics{
+			Pods: []collectors.PodVRAMUsage{{PodUID: "uid-a", Processes: 1, Used: 1 << 30}},
+		},
+		TracedPCIe: []collectors.ContainerPCIeUsage{
+			{PodUID: "uid-a", DeviceID: "gpu-0", ReadBytesPerSec: 1000, WriteBytesPerSec: 200},
+			{PodUID: "uid-a", DeviceID: "gpu-1", ReadBytesPerSec: 500},
+			{PodUID: "uid-b", DeviceID: "gpu-0", WriteBytesPerSec: 300},
+		},
+	}
+
+	cn := reporter.buildComputeNode("test-node", hwType, devices, metrics)
+	if len(cn.Status.Workloads) != 2 {
+		t.Fatalf("Expected 2 workloads, got %+v", cn.Status.Workloads)
+	}
+	a, b := cn.Status.Workloads[0], cn.Status.Workloads[1]
+	if a.PodUID != "uid-a" || a.VRAMUsed != 1<<30 || a.PCIeReadBytesPerSec != 1500 || a.PCIeWriteBytesPerSec != 200 {
+		t.Errorf("Unexpected workload %+v", a)
+	}
+	if b.PodUID != "uid-b" || b.PCIeWriteBytesPerSec != 300 {
+		t.Errorf("Unexpected workload %+v", b)
+	}
+}
+
+func newDeltaTestInput(vramUsed uint64, health float64) (*detectors.HardwareType, []*detectors.Device, *collectors.Metrics) {
+	hwType := &detectors.HardwareType{
+		Vendor:          "nvidia",
+		DriverAvailable: true,
+		DriverVersion:   "535.104.05",
+	}
+	devices := []*detectors.Device{
+		{
+			ID:          "gpu-0",
+			Model:       "NVIDIA A100",
+			VRAMTotal:   80 * 1024 * 1024 * 1024,
+			VRAMUsed:    vramUsed,
+			HealthScore: health,
+		},
+	}
+	metrics := &collectors.Metrics{
+		Fingerprint: &collectors.FingerprintMetrics{VRAMTotal: 80 * 1024 * 1024 * 1024},
+		Health:      &collectors.HealthMetrics{Score: health},
+	}
+	return hwType, devices, metrics
+}
+
+func TestReporter_Report_Delta(t *testing.T) {
+	c := newMockK8sClient()
+	reporter := NewReporter(c)
+	ctx := context.Background()
+	const gib = 1024 * 1024 * 1024
+
+	// 创建时单独写入 status
+	hwType, devices, metrics := newDeltaTestInput(10*gib, 95)
+	if err := reporter.Report(ctx, "test-node", hwType, devices, metrics); err != nil {
+		t.Fatalf("Report() failed: %v", err)
+	}
+	if len(c.statusPatches) != 1 {
+		t.Fatalf("Expected status to be written after create, got %d patches", len(c.statusPatches))
+	}
+	if c.computeNodes["test-node"].Status.Phase != v1alpha1.ComputeNodePhaseReady {
+		t.Error("Status should be stored after create")
+	}
+	driverSince := c.computeNodes["test-node"].Status.Conditions[0].LastTransitionTime
+
+	// 无变化：不读取也不写入
+	if err := reporter.Report(ctx, "test-node", hwType, devices, metrics); err != nil {
+		t.Fatalf("Report() failed: %v", err)
+	}
+	if c.gets != 1 || len(c.patches) != 0 || len(c.statusPatches) != 1 {
+		t.Errorf("Unchanged report should not reach the API server: gets=%d patches=%d status=%d",
+			c.gets, len(c.patches), len(c.statusPatches))
+	}
+
+	// 阈值内的抖动被抑制
+	hwType, devices, metrics = newDeltaTestInput(10*gib+64*1024*1024, 94)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if len(c.statusPatches) != 1 {
+		t.Errorf("Small changes should be held, got %d status patches", len(c.statusPatches))
+	}
+
+	// 超过阈值的显存变化只发送 devices
+	hwType, devices, metrics = newDeltaTestInput(20*gib, 94)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if len(c.statusPatches) != 2 {
+		t.Fatalf("VRAM change should be reported, got %d status patches", len(c.statusPatches))
+	}
+	patch := c.statusPatches[1]
+	if !strings.Contains(patch, "devices") || strings.Contains(patch, "conditions") || strings.Contains(patch, "spec") {
+		t.Errorf("Patch should only contain the changed devices, got %s", patch)
+	}
+	if got := c.computeNodes["test-node"].Status.Devices[0].VRAMUsed; got != 20*gib {
+		t.Errorf("Expected VRAMUsed %d, got %d", uint64(20*gib), got)
+	}
+
+	// 健康状态变化立即上报，且更新条件的 LastTransitionTime
+	hwType, devices, metrics = newDeltaTestInput(20*gib, 20)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if len(c.statusPatches) != 3 {
+		t.Fatalf("Health change should be reported immediately, got %d status patches", len(c.statusPatches))
+	}
+	stored := c.computeNodes["test-node"]
+	if stored.Status.Phase != v1alpha1.ComputeNodePhaseUnhealthy {
+		t.Errorf("Expected phase Unhealthy, got %s", stored.Status.Phase)
+	}
+	if cond := stored.Status.Conditions[0]; !cond.LastTransitionTime.Equal(&driverSince) {
+		t.Errorf("Unchanged %s condition should keep its LastTransitionTime", cond.Type)
+	}
+}
+
+func TestReporter_Report_NoisyInterval(t *testing.T) {
+	c := newMockK8sClient()
+	reporter := NewReporter(c)
+	ctx := context.Background()
+
+	hwType, devices, metrics := newDeltaTestInput(10*1024*1024*1024, 95)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+
+	// 超过 NoisyInterval 后按实际值上报
+	hwType, devices, metrics = newDeltaTestInput(10*1024*1024*1024+1024, 95)
+	reporter.lastExact = time.Now().Add(-2 * reporter.NoisyInterval)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if len(c.statusPatches) != 2 {
+		t.Errorf("Held values should be sent after NoisyInterval, got %d status patches", len(c.statusPatches))
+	}
+}
+
+func TestReporter_Report_Resync(t *testing.T) {
+	c := newMockK8sClient()
+	reporter := NewReporter(c)
+	ctx := context.Background()
+
+	hwType, devices, metrics := newDeltaTestInput(0, 95)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+
+	// 写入失败后重新读取
+	c.patchErr = fmt.Errorf("patch error")
+	hwType, devices, metrics = newDeltaTestInput(0, 20)
+	if err := reporter.Report(ctx, "test-node", hwType, devices, metrics); err == nil {
+		t.Fatal("Report() should fail on patch error")
+	}
+	c.patchErr = nil
+	if err := reporter.Report(ctx, "test-node", hwType, devices, metrics); err != nil {
+		t.Fatalf("Report() failed: %v", err)
+	}
+	if c.gets != 2 {
+		t.Errorf("Report after a failed patch should re-read the object, got %d gets", c.gets)
+	}
+
+	// 超过 ResyncInterval 后重新读取
+	reporter.lastSync = time.Now().Add(-2 * reporter.ResyncInterval)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if c.gets != 3 {
+		t.Errorf("Report after ResyncInterval should re-read the object, got %d gets", c.gets)
+	}
+
+	// 对象被删除后重新创建
+	delete(c.computeNodes, "test-node")
+	reporter.lastSync = time.Now().Add(-2 * reporter.ResyncInterval)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if _, ok := c.computeNodes["test-node"]; !ok {
+		t.Error("ComputeNode should be recreated")
+	}
+}
+
+func TestReporter_Report_HealthMessage(t *testing.T) {
+	c := newMockK8sClient()
+	reporter := NewReporter(c)
+	ctx := context.Background()
+
+	healthyMessage := func() string {
+		for _, cond := range c.computeNodes["test-node"].Status.Conditions {
+			if cond.Type == v1alpha1.ComputeNodeConditionHealthy {
+				return cond.Message
+			}
+		}
+		return ""
+	}
+
+	hwType, devices, metrics := newDeltaTestInput(10*1024*1024*1024, 95)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+
+	// 阈值内的变化沿用旧消息
+	hwType, devices, metrics = newDeltaTestInput(10*1024*1024*1024, 94)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if got := healthyMessage(); got != "Health score: 95.0" {
+		t.Errorf("Small score change should keep the message, got %q", got)
+	}
+
+	// 原因未变但分数大幅下降，消息必须更新
+	hwType, devices, metrics = newDeltaTestInput(10*1024*1024*1024, 61)
+	reporter.Report(ctx, "test-node", hwType, devices, metrics)
+	if got := healthyMessage(); got != "Health score: 61.0" {
+		t.Errorf("Large score change should update the message, got %q", got)
+	}
+}
@@ -58,6 +58,9 @@ type ComputeNodeStatus struct {
 
 	// Conditions represent the latest available observations
 	Conditions []ComputeNodeCondition `json:"conditions,omitempty"`
+
+	// Workloads is the per-pod VRAM usage reported by the interceptor
+	Workloads []WorkloadUsage `json:"workloads,omitempty"`
 }
 
 // ComputeNodePhase represents the phase of a compute node
@@ -96,6 +99,44 @@ type DeviceInfo struct {
 
 	// InterconnectType is the interconnect type (NVLink, HCCS, PCIe)
 	InterconnectType string `json:"interconnectType,omitempty"`
+
+	// VRAMAllocated is the VRAM in bytes allocated on this device by
+	// intercepted workloads
+	VRAMAllocated uint64 `json:"vramAllocated,omitempty"`
+}
+
+// WorkloadUsage is the VRAM usage of one pod, summed over its intercepted
+// processes
+type WorkloadUsage struct {
+	// PodUID is the UID of the pod
+	PodUID string `json:"podUID"`
+
+	// Namespace is the namespace of the pod
+	Namespace string `json:"namespace,omitempty"`
+
+	// Name is the name of the pod
+	Name string `json:"name,omitempty"`
+
+	// Processes is the number of intercepted processes in the pod
+	Processes int32 `json:"processes"`
+
+	// VRAMUsed is the VRAM in bytes currently allocated by the pod
+	VRAMUsed uint64 `json:"vramUsed"`
+
+	// VRAMLimit is the VRAM quota in bytes enforced on the pod
+	VRAMLimit uint64 `json:"vramLimit"`
+
+	// VRAMPeak is the peak VRAM usage in bytes
+	VRAMPeak uint64 `json:"vramPeak,omitempty"`
+
+	// FailedAllocs is the number of allocations denied by the quota
+	FailedAllocs uint64 `json:"failedAllocs,omitempty"`
+
+	// PCIeReadBytesPerSec is the device-to-host DMA bandwidth traced by eBPF
+	PCIeReadBytesPerSec uint64 `json:"pcieReadBytesPerSec,omitempty"`
+
+	// PCIeWriteBytesPerSec is the host-to-device DMA bandwidth traced by eBPF
+	PCIeWriteBytesPerSec uint64 `json:"pcieWriteBytesPerSec,omitempty"`
 }
 
 // ComputeNodeCondition describes the state of a compute node at a certain point
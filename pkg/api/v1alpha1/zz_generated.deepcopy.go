@@ -145,6 +145,11 @@ func (in *ComputeNodeStatus) DeepCopyInto(out *ComputeNodeStatus) {
 			(*in)[i].DeepCopyInto(&(*out)[i])
 		}
 	}
+	if in.Workloads != nil {
+		in, out := &in.Workloads, &out.Workloads
+		*out = make([]WorkloadUsage, len(*in))
+		copy(*out, *in)
+	}
 }
 
 // DeepCopy is an autogenerated deepcopy function, copying the receiver, creating a new ComputeNodeStatus.
@@ -171,3 +176,18 @@ func (in *DeviceInfo) DeepCopy() *DeviceInfo {
 	in.DeepCopyInto(out)
 	return out
 }
+
+// DeepCopyInto is an autogenerated deepcopy function, copying the receiver, writing into out. in must be non-nil.
+func (in *WorkloadUsage) DeepCopyInto(out *WorkloadUsage) {
+	*out = *in
+}
+
+// DeepCopy is an autogenerated deepcopy function, copying the receiver, creating a new WorkloadUsage.
+func (in *WorkloadUsage) DeepCopy() *WorkloadUsage {
+	if in == nil {
+		return nil
+	}
+	out := new(WorkloadUsage)
+	in.DeepCopyInto(out)
+	return out
+}
@@ -2,7 +2,14 @@ package collectors
 
 import (
 	"context"
+	"encoding/binary"
+	"math/bits"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"sync"
 	"testing"
+	"time"
 
 	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
 )
@@ -685,3 +692,581 @@ func TestTopologyMetrics_String(t *testing.T) {
 		})
 	}
 }
+
+// writeStatsPage 按 stats_page_t 布局写入一个测试用统计页
+func writeStatsPage(t *testing.T, path string, seq uint64, updated time.Time, podUID, visible string, used map[int]uint64) {
+	t.Helper()
+	writeStatsPageFlags(t, path, seq, updated, podUID, visible, 0, used)
+}
+
+func writeStatsPageFlags(t *testing.T, path string, seq uint64, updated time.Time, podUID, visible string, flags uint32, used map[int]uint64) {
+	t.Helper()
+	b := make([]byte, statsPageSize)
+	le := binary.LittleEndian
+	le.PutUint32(b[0:], statsMagic)
+	le.PutUint32(b[4:], statsVersion)
+	le.PutUint32(b[8:], statsPageSize)
+	le.PutUint32(b[12:], statsMaxDevices)
+	le.PutUint32(b[16:], 42)
+	le.PutUint32(b[20:], flags)
+	le.PutUint64(b[statsSeqOffset:], seq)
+	le.PutUint64(b[32:], uint64(updated.UnixNano()))
+	copy(b[48:], podUID)
+	copy(b[112:], "default")
+	copy(b[176:], "train")
+	copy(b[statsVisibleOffset:], visible)
+	for ordinal, u := range used {
+		d := b[statsHeaderSize+ordinal*statsDeviceSize:]
+		le.PutUint64(d[0:], 16<<30) // quota_limit
+		le.PutUint64(d[8:], u)      // quota_used
+		le.PutUint64(d[16:], u)     // peak_usage
+		le.PutUint64(d[24:], 1)     // total_allocs
+	}
+
+	if err := os.MkdirAll(filepath.Dir(path), 0755); err != nil {
+		t.Fatal(err)
+	}
+	if err := os.WriteFile(path, b, 0644); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestInterceptorCollector_Collect(t *testing.T) {
+	root := t.TempDir()
+	now := time.Now()
+	devices := createTestDevices()
+
+	// 同一 Pod 的两个进程：一个只看到 gpu-1，一个使用默认可见设备
+	writeStatsPage(t, filepath.Join(root, "uid-a", "100"), 2, now, "uid-a", "1", map[int]uint64{0: 4 << 30})
+	writeStatsPage(t, filepath.Join(root, "uid-a", "101"), 4, now, "uid-a", "", map[int]uint64{0: 1 << 30, 1: 2 << 30})
+	// 按 UUID 指定可见设备
+	writeStatsPage(t, filepath.Join(root, "uid-b", "7"), 2, now, "uid-b", "GPU-test-0000", map[int]uint64{0: 3 << 30})
+	// 失效页面与正在写入的页面都应被跳过
+	writeStatsPage(t, filepath.Join(root, "uid-c", "1"), 2, now.Add(-time.Minute), "uid-c", "", map[int]uint64{0: 1 << 30})
+	writeStatsPage(t, filepath.Join(root, "uid-d", "1"), 3, now, "uid-d", "", map[int]uint64{0: 1 << 30})
+
+	c := NewInterceptorCollector(root)
+	defer c.Close()
+
+	metrics, err := c.Collect(context.Background(), devices, nil)
+	if err != nil {
+		t.Fatalf("Collect() failed: %v", err)
+	}
+
+	if len(metrics.Interceptor.Processes) != 3 {
+		t.Fatalf("Expected 3 live processes, got %d", len(metrics.Interceptor.Processes))
+	}
+
+	pods := metrics.Interceptor.Pods
+	if len(pods) != 2 || pods[0].PodUID != "uid-a" || pods[1].PodUID != "uid-b" {
+		t.Fatalf("Unexpected pods: %+v", pods)
+	}
+	if pods[0].Processes != 2 || pods[0].Used != 7<<30 || pods[0].Limit != 48<<30 {
+		t.Errorf("Unexpected uid-a usage: %+v", pods[0])
+	}
+	if pods[0].Namespace != "default" || pods[0].Name != "train" {
+		t.Errorf("Unexpected uid-a identity: %+v", pods[0])
+	}
+
+	allocated := map[string]uint64{}
+	for _, dm := range metrics.DeviceMetrics {
+		allocated[dm.DeviceID] = dm.VRAMAllocated
+	}
+	if allocated["gpu-0"] != 4<<30 { // 1Gi (uid-a) + 3Gi (uid-b)
+		t.Errorf("Expected 4Gi on gpu-0, got %d", allocated["gpu-0"])
+	}
+	if allocated["gpu-1"] != 6<<30 { // 4Gi + 2Gi (uid-a)
+		t.Errorf("Expected 6Gi on gpu-1, got %d", allocated["gpu-1"])
+	}
+}
+
+func TestInterceptorCollector_RemovesAbandonedPages(t *testing.T) {
+	root := t.TempDir()
+	path := filepath.Join(root, "uid-a", "100")
+	writeStatsPage(t, path, 2, time.Now().Add(-time.Hour), "uid-a", "", map[int]uint64{0: 1 << 30})
+
+	c := NewInterceptorCollector(root)
+	defer c.Close()
+
+	metrics, err := c.Collect(context.Background(), createTestDevices(), nil)
+	if err != nil {
+		t.Fatalf("Collect() failed: %v", err)
+	}
+	if len(metrics.Interceptor.Processes) != 0 {
+		t.Errorf("Abandoned page should not be reported")
+	}
+	if _, err := os.Stat(path); !os.IsNotExist(err) {
+		t.Errorf("Abandoned page should be removed")
+	}
+}
+
+func TestInterceptorCollector_MissingRoot(t *testing.T) {
+	c := NewInterceptorCollector(filepath.Join(t.TempDir(), "missing"))
+	metrics, err := c.Collect(context.Background(), createTestDevices(), nil)
+	if err != nil {
+		t.Fatalf("Collect() failed: %v", err)
+	}
+	if len(metrics.Interceptor.Pods) != 0 {
+		t.Errorf("Expected no pods, got %d", len(metrics.Interceptor.Pods))
+	}
+}
+
+func TestInterceptorCollector_PooledQuota(t *testing.T) {
+	root := t.TempDir()
+	now := time.Now()
+
+	// 两个进程共享 16Gi 的配额池，上限只计一次
+	writeStatsPageFlags(t, filepath.Join(root, "uid-a", "100"), 2, now, "uid-a", "", statsFlagPooled, map[int]uint64{0: 4 << 30})
+	writeStatsPageFlags(t, filepath.Join(root, "uid-a", "101"), 2, now, "uid-a", "", statsFlagPooled, map[int]uint64{0: 2 << 30})
+
+	c := NewInterceptorCollector(root)
+	defer c.Close()
+
+	metrics, err := c.Collect(context.Background(), createTestDevices(), nil)
+	if err != nil {
+		t.Fatalf("Collect() failed: %v", err)
+	}
+
+	pods := metrics.Interceptor.Pods
+	if len(pods) != 1 {
+		t.Fatalf("Expected 1 pod, got %d", len(pods))
+	}
+	if pods[0].Used != 6<<30 || pods[0].Limit != 16<<30 {
+		t.Errorf("Expected 6Gi used of a 16Gi pool, got %+v", pods[0])
+	}
+}
+
+func TestInterceptorCollector_UnlimitedDevice(t *testing.T) {
+	root := t.TempDir()
+	path := filepath.Join(root, "uid-a", "100")
+	writeStatsPage(t, path, 2, time.Now(), "uid-a", "", map[int]uint64{0: 1 << 30, 1: 2 << 30})
+
+	// HCS_VRAM_QUOTA=0=16Gi：设备 1 不受限
+	b, err := os.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	binary.LittleEndian.PutUint64(b[statsHeaderSize+statsDeviceSize:], QuotaUnlimited)
+	if err := os.WriteFile(path, b, 0644); err != nil {
+		t.Fatal(err)
+	}
+
+	c := NewInterceptorCollector(root)
+	defer c.Close()
+	metrics, err := c.Collect(context.Background(), createTestDevices(), nil)
+	if err != nil {
+		t.Fatalf("Collect() failed: %v", err)
+	}
+	pods := metrics.Interceptor.Pods
+	if len(pods) != 1 || pods[0].Used != 3<<30 || pods[0].Limit != 16<<30 {
+		t.Errorf("Unlimited device should not count towards the limit, got %+v", pods)
+	}
+}
+
+func TestInterceptorCollector_MemoryPressure(t *testing.T) {
+	root := t.TempDir()
+	now := time.Now()
+
+	path := filepath.Join(root, "uid-a", "100")
+	writeStatsPageFlags(t, path, 2, now, "uid-a", "", statsFlagPressure, map[int]uint64{0: 14 << 30})
+	writeStatsPage(t, filepath.Join(root, "uid-a", "101"), 2, now, "uid-a", "", map[int]uint64{0: 1 << 30})
+
+	// 软上限与统一内存用量写在设备块的末尾两个字段
+	b, err := os.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	binary.LittleEndian.PutUint64(b[statsHeaderSize+48:], 12<<30)
+	binary.LittleEndian.PutUint64(b[statsHeaderSize+56:], 6<<30)
+	if err := os.WriteFile(path, b, 0644); err != nil {
+		t.Fatal(err)
+	}
+
+	c := NewInterceptorCollector(root)
+	defer c.Close()
+
+	metrics, err := c.Collect(context.Background(), createTestDevices(), nil)
+	if err != nil {
+		t.Fatalf("Collect() failed: %v", err)
+	}
+
+	var proc *ProcessVRAMUsage
+	for i := range metrics.Interceptor.Processes {
+		if metrics.Interceptor.Processes[i].PID == 42 && metrics.Interceptor.Processes[i].Pressure {
+			proc = &metrics.Interceptor.Processes[i]
+		}
+	}
+	if proc == nil {
+		t.Fatalf("Expected a process under pressure: %+v", metrics.Interceptor.Processes)
+	}
+	if dev := proc.Devices[0]; dev.SoftLimit != 12<<30 || dev.ManagedUsed != 6<<30 {
+		t.Errorf("Unexpected device pressure fields: %+v", dev)
+	}
+
+	pods := metrics.Interceptor.Pods
+	if len(pods) != 1 || !pods[0].Pressure || pods[0].Managed != 6<<30 {
+		t.Errorf("Expected uid-a under pressure with 6Gi managed, got %+v", pods)
+	}
+}
+
+// stubCollector 可控的测试采集器，以 "health" 名称合并结果
+type stubCollector struct {
+	schedule Schedule
+	calls    chan struct{} // 每次 Collect 开始时发送
+	release  chan struct{} // 非 nil 时 Collect 阻塞到有值
+	err      error
+	score    float64
+}
+
+func (c *stubCollector) Name() string { return "health" }
+
+func (c *stubCollector) Schedule() Schedule { return c.schedule }
+
+func (c *stubCollector) Collect(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology) (*Metrics, error) {
+	if c.calls != nil {
+		c.calls <- struct{}{}
+	}
+	if c.release != nil {
+		<-c.release
+	}
+	if c.err != nil {
+		return nil, c.err
+	}
+	return &Metrics{Health: &HealthMetrics{Score: c.score}}, nil
+}
+
+func TestManager_CollectAll_Deadline(t *testing.T) {
+	slow := &stubCollector{
+		schedule: Schedule{Timeout: 20 * time.Millisecond},
+		calls:    make(chan struct{}, 10),
+		release:  make(chan struct{}),
+		score:    80,
+	}
+	manager := NewManager()
+	manager.Register(NewFingerprintCollector())
+	manager.Register(slow)
+	devices := createTestDevices()
+
+	// 首次超时：其他采集器的结果照常返回，health 没有可用的旧值
+	start := time.Now()
+	metrics, _ := manager.CollectAll(context.Background(), devices, nil)
+	if elapsed := time.Since(start); elapsed > time.Second {
+		t.Errorf("CollectAll should return at the deadline, took %v", elapsed)
+	}
+	if metrics.Fingerprint == nil {
+		t.Error("Fingerprint should not wait for the slow collector")
+	}
+	if metrics.Health != nil {
+		t.Error("Health should be nil before the first successful collection")
+	}
+
+	// 仍在运行时不重复发起
+	manager.CollectAll(context.Background(), devices, nil)
+	if n := len(slow.calls); n != 1 {
+		t.Errorf("Expected 1 Collect call while in flight, got %d", n)
+	}
+	status := manager.Status()[1]
+	if !status.InFlight || status.Timeouts != 2 {
+		t.Errorf("Expected in-flight collector with 2 timeouts, got %+v", status)
+	}
+
+	// 后台调用完成后结果进入缓存
+	slow.release <- struct{}{}
+	deadline := time.Now().Add(time.Second)
+	for manager.Status()[1].InFlight && time.Now().Before(deadline) {
+		time.Sleep(time.Millisecond)
+	}
+	slow.release = nil
+	metrics, _ = manager.CollectAll(context.Background(), devices, nil)
+	if metrics.Health == nil || metrics.Health.Score != 80 {
+		t.Errorf("Expected health score 80, got %+v", metrics.Health)
+	}
+}
+
+func TestManager_CollectAll_LastGoodValue(t *testing.T) {
+	c := &stubCollector{score: 90}
+	manager := NewManager()
+	manager.Register(c)
+	devices := createTestDevices()
+
+	manager.CollectAll(context.Background(), devices, nil)
+
+	c.err = os.ErrDeadlineExceeded
+	metrics, _ := manager.CollectAll(context.Background(), devices, nil)
+	if metrics.Health == nil || metrics.Health.Score != 90 {
+		t.Errorf("Failed collection should keep the last good value, got %+v", metrics.Health)
+	}
+
+	status := manager.Status()[0]
+	if status.Collected != 1 || status.Failures != 1 || status.LastError == nil {
+		t.Errorf("Unexpected status %+v", status)
+	}
+}
+
+func TestManager_CollectAll_MaxStale(t *testing.T) {
+	c := &stubCollector{schedule: Schedule{MaxStale: 50 * time.Millisecond}, score: 90}
+	manager := NewManager()
+	manager.Register(c)
+	devices := createTestDevices()
+
+	manager.CollectAll(context.Background(), devices, nil)
+
+	c.err = os.ErrDeadlineExceeded
+	if metrics, _ := manager.CollectAll(context.Background(), devices, nil); metrics.Health == nil {
+		t.Fatal("Failed collection within MaxStale should keep the last good value")
+	}
+	if manager.Status()[0].StaleSince.IsZero() {
+		t.Error("Status should report when the result went stale")
+	}
+
+	// 持续失败超过 MaxStale 后不再返回旧值
+	time.Sleep(60 * time.Millisecond)
+	if metrics, _ := manager.CollectAll(context.Background(), devices, nil); metrics.Health != nil {
+		t.Errorf("Expected no health data past MaxStale, got %+v", metrics.Health)
+	}
+
+	// 恢复后立即返回新结果
+	c.err = nil
+	c.score = 70
+	metrics, _ := manager.CollectAll(context.Background(), devices, nil)
+	if metrics.Health == nil || metrics.Health.Score != 70 {
+		t.Errorf("Expected health score 70 after recovery, got %+v", metrics.Health)
+	}
+	if !manager.Status()[0].StaleSince.IsZero() {
+		t.Error("StaleSince should be cleared after a successful collection")
+	}
+}
+
+func TestManager_CollectAll_Concurrent(t *testing.T) {
+	// 两个采集器互相等待对方开始，只有并发运行才能在截止时间内完成
+	a := &stubCollector{calls: make(chan struct{}, 1), release: make(chan struct{}), score: 1}
+	b := &topologyStub{}
+	b.started = a.calls
+	b.peer = a.release
+
+	manager := NewManager()
+	manager.SetTimeout(time.Second)
+	manager.Register(a)
+	manager.Register(b)
+
+	metrics, _ := manager.CollectAll(context.Background(), createTestDevices(), nil)
+	if metrics.Health == nil || metrics.Topology == nil {
+		t.Error("Collectors should run concurrently")
+	}
+}
+
+// topologyStub 等待 health 采集器开始后放行它，以 "topology" 名称合并结果
+type topologyStub struct {
+	started chan struct{}
+	peer    chan struct{}
+}
+
+func (c *topologyStub) Name() string { return "topology" }
+
+func (c *topologyStub) Collect(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology) (*Metrics, error) {
+	select {
+	case <-c.started:
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+	c.peer <- struct{}{}
+	return &Metrics{Topology: &TopologyMetrics{}}, nil
+}
+
+func TestManager_CollectAll_RefreshInterval(t *testing.T) {
+	static := &stubCollector{schedule: Schedule{Interval: RefreshOnce}, calls: make(chan struct{}, 10), score: 1}
+	sampled := &stubCollector{calls: make(chan struct{}, 10), score: 2}
+
+	once := NewManager()
+	once.Register(static)
+	every := NewManager()
+	every.Register(sampled)
+
+	devices := createTestDevices()
+	for i := 0; i < 3; i++ {
+		once.CollectAll(context.Background(), devices, nil)
+		every.CollectAll(context.Background(), devices, nil)
+	}
+	if n := len(static.calls); n != 1 {
+		t.Errorf("RefreshOnce collector should run once, ran %d times", n)
+	}
+	if n := len(sampled.calls); n != 3 {
+		t.Errorf("Collector without schedule should run every cycle, ran %d times", n)
+	}
+
+	// 设备清单变化后重新采集
+	once.CollectAll(context.Background(), devices[:1], nil)
+	if n := len(static.calls); n != 2 {
+		t.Errorf("RefreshOnce collector should rerun after inventory change, ran %d times", n)
+	}
+
+	// 固定间隔内复用结果
+	periodic := &stubCollector{schedule: Schedule{Interval: time.Hour}, calls: make(chan struct{}, 10), score: 3}
+	m := NewManager()
+	m.Register(periodic)
+	m.CollectAll(context.Background(), devices, nil)
+	m.CollectAll(context.Background(), devices, nil)
+	if n := len(periodic.calls); n != 1 {
+		t.Errorf("Collector should be reused within its interval, ran %d times", n)
+	}
+}
+
+// bruteForcePlacementScore 枚举所有 k 组合得到的最优得分
+func bruteForcePlacementScore(matrix [][]int, free uint64, k int) int {
+	var devices []int
+	for i := range matrix {
+		if free&(1<<uint(i)) != 0 {
+			devices = append(devices, i)
+		}
+	}
+	best := -1
+	var walk func(start int, current []int)
+	walk = func(start int, current []int) {
+		if len(current) == k {
+			score := 0
+			for i := 0; i < len(current); i++ {
+				for j := i + 1; j < len(current); j++ {
+					score += matrix[current[i]][current[j]]
+				}
+			}
+			if score > best {
+				best = score
+			}
+			return
+		}
+		for i := start; i < len(devices); i++ {
+			walk(i+1, append(current, devices[i]))
+		}
+	}
+	walk(0, nil)
+	return best
+}
+
+// islandMatrix n 个设备分成若干互联岛，岛内高带宽、岛间低带宽
+func islandMatrix(n, islandSize, inner, cross int) [][]int {
+	matrix := make([][]int, n)
+	for i := range matrix {
+		matrix[i] = make([]int, n)
+		for j := range matrix[i] {
+			switch {
+			case i == j:
+			case i/islandSize == j/islandSize:
+				matrix[i][j] = inner
+			default:
+				matrix[i][j] = cross
+			}
+		}
+	}
+	return matrix
+}
+
+func TestPlacementSearch_MatchesBruteForce(t *testing.T) {
+	rng := rand.New(rand.NewSource(1))
+
+	for trial := 0; trial < 50; trial++ {
+		n := 4 + rng.Intn(9)
+		matrix := make([][]int, n)
+		for i := range matrix {
+			matrix[i] = make([]int, n)
+		}
+		for i := 0; i < n; i++ {
+			for j := i + 1; j < n; j++ {
+				bw := []int{0, 16, 32, 64, 300, 600}[rng.Intn(6)]
+				matrix[i][j], matrix[j][i] = bw, bw
+			}
+		}
+
+		search := NewPlacementSearch(matrix)
+		free := search.AllDevices() &^ uint64(rng.Intn(1<<uint(n))) & search.AllDevices()
+		if bits.OnesCount64(free) < 2 {
+			free = search.AllDevices()
+		}
+		for k := 1; k <= bits.OnesCount64(free); k++ {
+			placement := search.Find(free, k)
+			if len(placement) != k {
+				t.Fatalf("n=%d k=%d: expected %d devices, got %v", n, k, k, placement)
+			}
+			for _, dev := range placement {
+				if free&(1<<uint(dev)) == 0 {
+					t.Fatalf("n=%d k=%d: placement %v uses busy device %d", n, k, placement, dev)
+				}
+			}
+			if got, want := search.Score(placement), bruteForcePlacementScore(matrix, free, k); got != want {
+				t.Errorf("n=%d k=%d free=%b: score %d, want %d", n, k, free, got, want)
+			}
+		}
+	}
+}
+
+func TestPlacementSearch_Islands(t *testing.T) {
+	// 16 卡，两个 8 卡 HCCS 岛
+	matrix := islandMatrix(16, 8, 392, 56)
+	search := NewPlacementSearch(matrix)
+
+	placement := search.Find(search.AllDevices(), 8)
+	if len(placement) != 8 {
+		t.Fatalf("Expected 8 devices, got %v", placement)
+	}
+	for _, dev := range placement[1:] {
+		if dev/8 != placement[0]/8 {
+			t.Errorf("8-card placement should stay within one island, got %v", placement)
+			break
+		}
+	}
+
+	// 第一个岛只剩 3 张空闲卡时，4 卡请求应落在第二个岛
+	free := search.AllDevices() &^ 0x1F
+	placement = search.Find(free, 4)
+	for _, dev := range placement {
+		if dev < 8 {
+			t.Errorf("4-card placement should use the fully free island, got %v", placement)
+			break
+		}
+	}
+
+	if search.Find(0x7, 4) != nil {
+		t.Error("Find should return nil when fewer than k devices are free")
+	}
+}
+
+func TestPlacementSearch_Memo(t *testing.T) {
+	search := NewPlacementSearch(islandMatrix(16, 4, 300, 50))
+
+	first := search.Find(search.AllDevices(), 4)
+	first[0] = 99 // 返回值由调用方持有，不影响缓存
+	second := search.Find(search.AllDevices(), 4)
+	if second[0] == 99 {
+		t.Error("Cached placement should not be shared with callers")
+	}
+	if len(search.memo) != 1 {
+		t.Errorf("Expected 1 memo entry, got %d", len(search.memo))
+	}
+
+	var wg sync.WaitGroup
+	for i := 0; i < 8; i++ {
+		wg.Add(1)
+		go func(k int) {
+			defer wg.Done()
+			if p := search.Find(search.AllDevices(), k); len(p) != k {
+				t.Errorf("Expected %d devices, got %v", k, p)
+			}
+		}(i + 1)
+	}
+	wg.Wait()
+}
+
+func TestTopologyCollector_FindOptimalPlacement_SixteenDevices(t *testing.T) {
+	collector := NewTopologyCollector()
+	matrix := islandMatrix(16, 4, 300, 50)
+
+	start := time.Now()
+	placement := collector.FindOptimalPlacement(matrix, 8)
+	if elapsed := time.Since(start); elapsed > time.Second {
+		t.Errorf("16-device search took %v", elapsed)
+	}
+
+	// 最优解为两个完整的 4 卡岛
+	if got, want := NewPlacementSearch(matrix).Score(placement), 2*6*300+16*50; got != want {
+		t.Errorf("Expected score %d, got %d (%v)", want, got, placement)
+	}
+}
@@ -14,6 +14,11 @@ func NewFingerprintCollector() *FingerprintCollector {
 	return &FingerprintCollector{}
 }
 
+// Schedule 指纹只依赖设备清单与拓扑，变化时才重新采集
+func (c *FingerprintCollector) Schedule() Schedule {
+	return Schedule{Interval: RefreshOnce}
+}
+
 // Name 返回采集器名称
 func (c *FingerprintCollector) Name() string {
 	return "fingerprint"
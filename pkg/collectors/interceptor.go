@@ -0,0 +1,404 @@
+package collectors
+
+import (
+	"context"
+	"encoding/binary"
+	"math"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+	"unsafe"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
+)
+
+// 共享统计页布局，与 libhcs_interceptor.c 中的 stats_page_t 保持一致。
+// 页面按本机字节序写入，节点均为小端架构（x86_64 / arm64）。
+const (
+	statsMagic         = 0x54534348 // "HCST"
+	statsVersion       = 1
+	statsHeaderSize    = 512
+	statsDeviceSize    = 64
+	statsMaxDevices    = 16
+	statsPageSize      = statsHeaderSize + statsMaxDevices*statsDeviceSize
+	statsSeqOffset     = 24
+	statsReadRetries   = 64
+	statsStringSize    = 64
+	statsVisibleOffset = 304
+	statsVisibleSize   = 128
+	statsFlagPooled    = 0x1 // quota_limit 为 Pod 共享配额池的上限
+	statsFlagPressure  = 0x2 // 有设备超过软上限（HCS_VRAM_SOFT_LIMIT）
+)
+
+// QuotaUnlimited 未列入按设备配额（如 HCS_VRAM_QUOTA=0=16Gi 中的设备 1）的设备的 QuotaLimit
+const QuotaUnlimited = math.MaxUint64
+
+// DefaultInterceptorStatsDir 拦截器统计页的默认根目录（<root>/<pod>/<pid>）
+const DefaultInterceptorStatsDir = "/dev/shm/hcs"
+
+// InterceptorMetrics 拦截器上报的显存使用情况
+type InterceptorMetrics struct {
+	Processes []ProcessVRAMUsage
+	Pods      []PodVRAMUsage
+}
+
+// ProcessVRAMUsage 单个被拦截进程的显存使用
+type ProcessVRAMUsage struct {
+	PodUID       string
+	PodNamespace string
+	PodName      string
+	Container    string
+	PID          int32
+	Pooled       bool // 与 Pod 内其他进程共享配额池
+	Pressure     bool // 有设备超过软上限，应用应收缩缓存
+	UpdatedAt    time.Time
+	Devices      []DeviceVRAMUsage // 仅包含有过分配的设备
+}
+
+// DeviceVRAMUsage 单个设备上的配额与使用量
+type DeviceVRAMUsage struct {
+	Ordinal      int    // 进程内的设备序号
+	DeviceID     string // 对应的物理设备 ID，无法解析时为空
+	QuotaLimit   uint64 // bytes，QuotaUnlimited 表示不受限
+	Used         uint64 // bytes
+	Peak         uint64 // bytes
+	TotalAllocs  uint64
+	TotalFrees   uint64
+	FailedAllocs uint64
+	SoftLimit    uint64 // bytes，压力水位，0 表示未设置
+	ManagedUsed  uint64 // bytes，cudaMallocManaged 分配量；未开启超分时已计入 Used
+}
+
+// PodVRAMUsage Pod 级聚合的显存使用（对 Pod 内所有进程求和）
+type PodVRAMUsage struct {
+	PodUID       string
+	Namespace    string
+	Name         string
+	Processes    int
+	Used         uint64 // bytes
+	Limit        uint64 // bytes，各进程在已使用设备上的配额之和，不受限的设备不计；共享配额池只计一次
+	Peak         uint64 // bytes，各进程峰值之和（上界）
+	FailedAllocs uint64
+	Managed      uint64 // bytes，统一内存分配量，单独统计以便评估超分
+	Pressure     bool   // 任一进程处于显存压力下
+}
+
+// statsMapping 已映射的统计页
+type statsMapping struct {
+	data []byte
+}
+
+// InterceptorCollector 拦截器共享统计页采集器
+//
+// 拦截器在 HCS_STATS_DIR 下为每个进程发布一个共享内存页，采集器只读映射这些页面，
+// 按 seqlock 协议读取一致的快照，采样本身不需要任何系统调用。
+type InterceptorCollector struct {
+	Root        string        // 统计页根目录
+	StaleAfter  time.Duration // 超过该时间未更新的页面视为失效
+	RemoveAfter time.Duration // 超过该时间未更新的页面被删除（进程崩溃遗留）
+	mu          sync.Mutex
+	mappings    map[string]*statsMapping
+	nowFunc     func() time.Time
+}
+
+// NewInterceptorCollector 创建拦截器统计采集器
+func NewInterceptorCollector(root string) *InterceptorCollector {
+	if root == "" {
+		root = DefaultInterceptorStatsDir
+	}
+	return &InterceptorCollector{
+		Root:        root,
+		StaleAfter:  10 * time.Second,
+		RemoveAfter: 5 * time.Minute,
+		mappings:    make(map[string]*statsMapping),
+		nowFunc:     time.Now,
+	}
+}
+
+// Name 返回采集器名称
+func (c *InterceptorCollector) Name() string {
+	return "interceptor"
+}
+
+// Collect 读取所有进程的统计页并按 Pod、设备聚合
+func (c *InterceptorCollector) Collect(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology) (*Metrics, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	paths, err := filepath.Glob(filepath.Join(c.Root, "*", "*"))
+	if err != nil {
+		return nil, err
+	}
+	c.refreshMappings(paths)
+
+	now := c.nowFunc()
+	result := &InterceptorMetrics{}
+	for _, path := range paths {
+		m, ok := c.mappings[path]
+		if !ok {
+			continue
+		}
+		proc, ok := readStatsPage(m.data)
+		if !ok {
+			continue
+		}
+
+		age := now.Sub(proc.UpdatedAt)
+		if age > c.RemoveAfter {
+			c.unmap(path)
+			os.Remove(path)
+			continue
+		}
+		if age > c.StaleAfter {
+			continue
+		}
+
+		if proc.PodUID == "" {
+			proc.PodUID = filepath.Base(filepath.Dir(path))
+		}
+		resolveDeviceIDs(&proc, readVisibleDevices(m.data), devices)
+		result.Processes = append(result.Processes, proc)
+	}
+
+	result.Pods = aggregatePods(result.Processes)
+
+	metrics := &Metrics{
+		Interceptor:   result,
+		DeviceMetrics: make([]DeviceMetric, 0, len(devices)),
+	}
+	allocated := make(map[string]uint64)
+	for _, proc := range result.Processes {
+		for _, dev := range proc.Devices {
+			if dev.DeviceID != "" {
+				allocated[dev.DeviceID] += dev.Used
+			}
+		}
+	}
+	for _, dev := range devices {
+		metrics.DeviceMetrics = append(metrics.DeviceMetrics, DeviceMetric{
+			DeviceID:      dev.ID,
+			VRAMAllocated: allocated[dev.ID],
+		})
+	}
+
+	return metrics, nil
+}
+
+// Close 解除所有统计页映射
+func (c *InterceptorCollector) Close() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for path := range c.mappings {
+		c.unmap(path)
+	}
+}
+
+// refreshMappings 映射新出现的页面，解除已消失页面的映射
+func (c *InterceptorCollector) refreshMappings(paths []string) {
+	present := make(map[string]bool, len(paths))
+	for _, path := range paths {
+		present[path] = true
+		if _, ok := c.mappings[path]; ok {
+			continue
+		}
+		if data, err := mapStatsPage(path); err == nil {
+			c.mappings[path] = &statsMapping{data: data}
+		}
+	}
+	for path := range c.mappings {
+		if !present[path] {
+			c.unmap(path)
+		}
+	}
+}
+
+func (c *InterceptorCollector) unmap(path string) {
+	if m, ok := c.mappings[path]; ok {
+		syscall.Munmap(m.data)
+		delete(c.mappings, path)
+	}
+}
+
+// mapStatsPage 只读映射一个统计页
+func mapStatsPage(path string) ([]byte, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	info, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+	if !info.Mode().IsRegular() || info.Size() < statsPageSize {
+		return nil, syscall.EINVAL
+	}
+	return syscall.Mmap(int(f.Fd()), 0, statsPageSize, syscall.PROT_READ, syscall.MAP_SHARED)
+}
+
+// readStatsPage 按 seqlock 协议读取一致快照：seq 为奇数表示写入中，
+// 前后两次读到的 seq 不同表示快照被撕裂，需要重试
+func readStatsPage(data []byte) (ProcessVRAMUsage, bool) {
+	le := binary.LittleEndian
+	if le.Uint32(data[0:]) != statsMagic || le.Uint32(data[4:]) != statsVersion {
+		return ProcessVRAMUsage{}, false
+	}
+
+	seqPtr := (*uint64)(unsafe.Pointer(&data[statsSeqOffset]))
+	var snap [statsPageSize]byte
+	for i := 0; i < statsReadRetries; i++ {
+		before := atomic.LoadUint64(seqPtr)
+		if before == 0 {
+			return ProcessVRAMUsage{}, false // 尚未发布第一次数据
+		}
+		if before&1 != 0 {
+			continue
+		}
+		copy(snap[:], data[:statsPageSize])
+		if atomic.LoadUint64(seqPtr) == before {
+			return decodeStatsPage(snap[:]), true
+		}
+	}
+	return ProcessVRAMUsage{}, false
+}
+
+// decodeStatsPage 解析一个一致的统计页快照
+func decodeStatsPage(b []byte) ProcessVRAMUsage {
+	le := binary.LittleEndian
+	proc := ProcessVRAMUsage{
+		PID:          int32(le.Uint32(b[16:])),
+		Pooled:       le.Uint32(b[20:])&statsFlagPooled != 0,
+		Pressure:     le.Uint32(b[20:])&statsFlagPressure != 0,
+		UpdatedAt:    time.Unix(0, int64(le.Uint64(b[32:]))),
+		PodUID:       cString(b[48 : 48+statsStringSize]),
+		PodNamespace: cString(b[112 : 112+statsStringSize]),
+		PodName:      cString(b[176 : 176+statsStringSize]),
+		Container:    cString(b[240 : 240+statsStringSize]),
+	}
+
+	count := int(le.Uint32(b[12:]))
+	if count > statsMaxDevices {
+		count = statsMaxDevices
+	}
+	for i := 0; i < count; i++ {
+		d := b[statsHeaderSize+i*statsDeviceSize:]
+		dev := DeviceVRAMUsage{
+			Ordinal:      i,
+			QuotaLimit:   le.Uint64(d[0:]),
+			Used:         le.Uint64(d[8:]),
+			Peak:         le.Uint64(d[16:]),
+			TotalAllocs:  le.Uint64(d[24:]),
+			TotalFrees:   le.Uint64(d[32:]),
+			FailedAllocs: le.Uint64(d[40:]),
+			SoftLimit:    le.Uint64(d[48:]),
+			ManagedUsed:  le.Uint64(d[56:]),
+		}
+		if dev.TotalAllocs == 0 && dev.FailedAllocs == 0 {
+			continue
+		}
+		proc.Devices = append(proc.Devices, dev)
+	}
+	return proc
+}
+
+// readVisibleDevices 读取进程的 *_VISIBLE_DEVICES（页面创建后不再变化）
+func readVisibleDevices(data []byte) string {
+	return cString(data[statsVisibleOffset : statsVisibleOffset+statsVisibleSize])
+}
+
+// resolveDeviceIDs 将进程内设备序号映射为节点上的设备 ID。
+// 可见设备列表可以是索引（"0,2"）或 UUID；为空或 "all" 时序号即索引。
+func resolveDeviceIDs(proc *ProcessVRAMUsage, visible string, devices []*detectors.Device) {
+	var entries []string
+	if visible != "" && visible != "all" {
+		entries = strings.Split(visible, ",")
+	}
+
+	for i := range proc.Devices {
+		ordinal := proc.Devices[i].Ordinal
+		if entries == nil {
+			if ordinal < len(devices) {
+				proc.Devices[i].DeviceID = devices[ordinal].ID
+			}
+			continue
+		}
+		if ordinal >= len(entries) {
+			continue
+		}
+
+		entry := strings.TrimSpace(entries[ordinal])
+		if idx, err := strconv.Atoi(entry); err == nil {
+			if idx >= 0 && idx < len(devices) {
+				proc.Devices[i].DeviceID = devices[idx].ID
+			}
+			continue
+		}
+		for _, dev := range devices {
+			if entry == dev.UUID || entry == dev.ID {
+				proc.Devices[i].DeviceID = dev.ID
+				break
+			}
+		}
+	}
+}
+
+// aggregatePods 按 Pod 聚合进程统计
+func aggregatePods(processes []ProcessVRAMUsage) []PodVRAMUsage {
+	byUID := make(map[string]*PodVRAMUsage)
+	pooledLimit := make(map[string]uint64) // 共享配额池：取各进程所见上限的最大值
+	for _, proc := range processes {
+		pod, ok := byUID[proc.PodUID]
+		if !ok {
+			pod = &PodVRAMUsage{
+				PodUID:    proc.PodUID,
+				Namespace: proc.PodNamespace,
+				Name:      proc.PodName,
+			}
+			byUID[proc.PodUID] = pod
+		}
+		pod.Processes++
+		pod.Pressure = pod.Pressure || proc.Pressure
+		var limit uint64
+		for _, dev := range proc.Devices {
+			pod.Used += dev.Used
+			pod.Peak += dev.Peak
+			pod.FailedAllocs += dev.FailedAllocs
+			pod.Managed += dev.ManagedUsed
+			if dev.QuotaLimit != QuotaUnlimited {
+				limit += dev.QuotaLimit
+			}
+		}
+		if proc.Pooled {
+			if limit > pooledLimit[proc.PodUID] {
+				pooledLimit[proc.PodUID] = limit
+			}
+		} else {
+			pod.Limit += limit
+		}
+	}
+
+	pods := make([]PodVRAMUsage, 0, len(byUID))
+	for uid, pod := range byUID {
+		pod.Limit += pooledLimit[uid]
+		pods = append(pods, *pod)
+	}
+	sort.Slice(pods, func(i, j int) bool { return pods[i].PodUID < pods[j].PodUID })
+	return pods
+}
+
+// cString 截取以 NUL 结尾的字符串
+func cString(b []byte) string {
+	for i, c := range b {
+		if c == 0 {
+			return string(b[:i])
+		}
+	}
+	return string(b)
+}
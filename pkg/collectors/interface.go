@@ -2,6 +2,7 @@ package collectors
 
 import (
 	"context"
+	"time"
 
 	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
 )
@@ -15,6 +16,29 @@ type Collector interface {
 	Collect(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology) (*Metrics, error)
 }
 
+// RefreshOnce 采集间隔：仅在设备清单或拓扑变化时重新采集
+const RefreshOnce time.Duration = -1
+
+// Schedule 采集器的调度参数
+type Schedule struct {
+	// Interval 两次采集的最小间隔，间隔内复用上次结果；0 表示每个周期都采集
+	Interval time.Duration
+
+	// Timeout 单次采集的截止时间，超时后使用上次成功的结果；0 表示使用 Manager 的默认值
+	Timeout time.Duration
+
+	// MaxStale 采集持续失败时沿用上次结果的最长时间，超过后不再返回该采集器的结果；
+	// 0 表示使用 Manager 的默认值
+	MaxStale time.Duration
+}
+
+// ScheduledCollector 可选接口：采集器声明自己的采集间隔与截止时间
+type ScheduledCollector interface {
+	Collector
+
+	Schedule() Schedule
+}
+
 // Metrics 设备指标（包含所有设备的聚合信息）
 type Metrics struct {
 	// 指纹信息
@@ -26,6 +50,18 @@ type Metrics struct {
 	// 拓扑信息
 	Topology *TopologyMetrics
 
+	// 拦截器上报的容器显存使用
+	Interceptor *InterceptorMetrics
+
+	// 内核遥测管道的运行计数
+	Telemetry *TelemetryMetrics
+
+	// eBPF uprobe 追踪到的每容器显存使用（覆盖绕过拦截器的进程）
+	TracedVRAM []ContainerVRAMUsage
+
+	// eBPF 统计的每容器在各设备上的 DMA 带宽
+	TracedPCIe []ContainerPCIeUsage
+
 	// 每个设备的详细指标
 	DeviceMetrics []DeviceMetric
 }
@@ -35,6 +71,21 @@ type DeviceMetric struct {
 	DeviceID    string
 	Fingerprint *FingerprintMetrics
 	Health      *HealthMetrics
+
+	// 被拦截进程在该设备上分配的显存（bytes）
+	VRAMAllocated uint64
+
+	// 采集间隔内的 DMA 分布
+	PCIe *PCIeMetrics
+}
+
+// PCIeMetrics 单设备的 DMA 映射分布（来自 log2 直方图，取桶上界）
+type PCIeMetrics struct {
+	DMAMappings   uint64
+	DMASizeP50    uint64 // bytes
+	DMASizeP99    uint64 // bytes
+	DMALatencyP50 time.Duration
+	DMALatencyP99 time.Duration
 }
 
 // FingerprintMetrics 算力指纹指标
@@ -64,6 +115,37 @@ type HealthMetrics struct {
 	UtilizationMEM uint32 // 百分比
 }
 
+// TelemetryMetrics eBPF 遥测管道计数（自程序首次加载起累计）
+// 用于根据实际的合并/丢弃量调整采样间隔与 ring buffer 大小
+type TelemetryMetrics struct {
+	HealthEventsEmitted   uint64 // 提交到 ring buffer 的健康事件记录
+	HealthEventsCoalesced uint64 // 因限速合并进后续记录的事件
+	HealthEventsDropped   uint64 // ring buffer 溢出丢弃的记录
+
+	TracedVRAMAllocsUntracked uint64 // vram_allocs 已满未计入 TracedVRAM 的分配
+	TracedVRAMProcsUntracked  uint64 // vram_procs 已满未记录的进程
+}
+
+// ContainerVRAMUsage 按 cgroup 统计的容器显存使用
+type ContainerVRAMUsage struct {
+	PodUID      string
+	ContainerID string
+	CgroupID    uint64
+	Used        uint64 // bytes
+	Allocs      uint64
+	Frees       uint64
+}
+
+// ContainerPCIeUsage 单个容器在单个设备上的 DMA 带宽
+type ContainerPCIeUsage struct {
+	PodUID           string
+	ContainerID      string
+	CgroupID         uint64
+	DeviceID         string
+	ReadBytesPerSec  float64
+	WriteBytesPerSec float64
+}
+
 // TopologyMetrics 拓扑指标
 type TopologyMetrics struct {
 	Peers        []PeerInfo
@@ -2,21 +2,70 @@ package collectors
 
 import (
 	"context"
+	"fmt"
+	"strings"
 	"sync"
+	"time"
 
 	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
 )
 
+const (
+	// DefaultCollectTimeout 单个采集器的默认截止时间
+	DefaultCollectTimeout = 5 * time.Second
+
+	// DefaultMaxStale 采集持续失败时沿用上次结果的默认最长时间
+	DefaultMaxStale = time.Minute
+)
+
 // Manager 采集器管理器
+//
+// CollectAll 并发运行各采集器，每个采集器受自己的截止时间约束：超时或失败时沿用
+// 上次成功的结果，仍未返回的调用在后台继续，完成前不会重复发起。沿用超过 MaxStale
+// 后该采集器的结果为空，由上报方按数据缺失处理，而不是一直上报过时的值。
+// 采集器可通过 ScheduledCollector 声明采集间隔，间隔内直接复用缓存结果。
 type Manager struct {
-	collectors []Collector
+	collectors []*collectorEntry
+	timeout    time.Duration
+	maxStale   time.Duration
 	mu         sync.RWMutex
 }
 
+// collectorEntry 采集器及其最近一次成功的结果
+type collectorEntry struct {
+	collector Collector
+	schedule  Schedule
+
+	mu        sync.Mutex
+	last      *Metrics
+	lastAt    time.Time
+	lastKey   string // 采集时的设备清单
+	lastErr   error
+	stale     time.Time     // 开始沿用旧结果的时间，零值表示结果是最新的
+	inflight  chan struct{} // 非 nil 表示有调用尚未返回
+	timeouts  uint64
+	failures  uint64
+	collected uint64
+}
+
+// CollectorStatus 单个采集器的运行状态
+type CollectorStatus struct {
+	Name        string
+	LastSuccess time.Time // 零值表示从未成功
+	LastError   error     // 最近一次失败的原因，成功后清空
+	StaleSince  time.Time // 开始沿用旧结果的时间，零值表示结果是最新的
+	InFlight    bool      // 有超时的调用仍在运行
+	Collected   uint64    // 成功次数
+	Failures    uint64    // 返回错误的次数
+	Timeouts    uint64    // 超过截止时间的次数
+}
+
 // NewManager 创建采集器管理器
 func NewManager() *Manager {
 	return &Manager{
-		collectors: make([]Collector, 0),
+		collectors: make([]*collectorEntry, 0),
+		timeout:    DefaultCollectTimeout,
+		maxStale:   DefaultMaxStale,
 	}
 }
 
@@ -31,18 +80,51 @@ func NewDefaultManager() *Manager {
 
 // Register 注册采集器
 func (m *Manager) Register(collector Collector) {
+	entry := &collectorEntry{collector: collector}
+	if sc, ok := collector.(ScheduledCollector); ok {
+		entry.schedule = sc.Schedule()
+	}
+
 	m.mu.Lock()
 	defer m.mu.Unlock()
-	m.collectors = append(m.collectors, collector)
+	m.collectors = append(m.collectors, entry)
+}
+
+// SetTimeout 设置未声明截止时间的采集器的默认截止时间
+func (m *Manager) SetTimeout(timeout time.Duration) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.timeout = timeout
+}
+
+// SetMaxStale 设置未声明 MaxStale 的采集器沿用旧结果的最长时间
+func (m *Manager) SetMaxStale(maxStale time.Duration) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	m.maxStale = maxStale
 }
 
 // CollectAll 运行所有采集器并合并结果
 func (m *Manager) CollectAll(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology) (*Metrics, error) {
 	m.mu.RLock()
-	collectors := make([]Collector, len(m.collectors))
-	copy(collectors, m.collectors)
+	entries := make([]*collectorEntry, len(m.collectors))
+	copy(entries, m.collectors)
+	timeout, maxStale := m.timeout, m.maxStale
 	m.mu.RUnlock()
 
+	// 并发采集，结果按注册顺序合并
+	key := inventoryKey(devices, topology)
+	collected := make([]*Metrics, len(entries))
+	var wg sync.WaitGroup
+	for i, entry := range entries {
+		wg.Add(1)
+		go func(idx int, e *collectorEntry) {
+			defer wg.Done()
+			collected[idx] = e.collect(ctx, devices, topology, key, timeout, maxStale)
+		}(i, entry)
+	}
+	wg.Wait()
+
 	result := &Metrics{
 		DeviceMetrics: make([]DeviceMetric, 0, len(devices)),
 	}
@@ -55,32 +137,11 @@ func (m *Manager) CollectAll(ctx context.Context, devices []*detectors.Device, t
 		}
 	}
 
-	// 运行每个采集器
-	for _, collector := range collectors {
-		metrics, err := collector.Collect(ctx, devices, topology)
-		if err != nil {
+	for i, metrics := range collected {
+		if metrics == nil {
 			continue // 单个采集器失败不影响其他采集器
 		}
-
-		// 合并结果
-		switch collector.Name() {
-		case "fingerprint":
-			result.Fingerprint = metrics.Fingerprint
-			for _, dm := range metrics.DeviceMetrics {
-				if existing, ok := deviceMetrics[dm.DeviceID]; ok {
-					existing.Fingerprint = dm.Fingerprint
-				}
-			}
-		case "health":
-			result.Health = metrics.Health
-			for _, dm := range metrics.DeviceMetrics {
-				if existing, ok := deviceMetrics[dm.DeviceID]; ok {
-					existing.Health = dm.Health
-				}
-			}
-		case "topology":
-			result.Topology = metrics.Topology
-		}
+		mergeMetrics(result, deviceMetrics, entries[i].collector.Name(), metrics)
 	}
 
 	// 构建设备指标列表
@@ -93,14 +154,187 @@ func (m *Manager) CollectAll(ctx context.Context, devices []*detectors.Device, t
 	return result, nil
 }
 
+// collect 返回采集器在本周期的结果：缓存仍有效时直接复用，否则发起采集并
+// 最多等待到截止时间；从未成功过或沿用旧结果超过 maxStale 时返回 nil
+func (e *collectorEntry) collect(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology,
+	key string, defaultTimeout, defaultMaxStale time.Duration) *Metrics {
+	timeout := e.schedule.Timeout
+	if timeout <= 0 {
+		timeout = defaultTimeout
+	}
+	maxStale := e.schedule.MaxStale
+	if maxStale <= 0 {
+		maxStale = defaultMaxStale
+	}
+
+	e.mu.Lock()
+	if e.fresh(key) {
+		last := e.last
+		e.mu.Unlock()
+		return last
+	}
+	done := e.inflight
+	if done == nil {
+		done = make(chan struct{})
+		e.inflight = done
+		go e.run(ctx, devices, topology, key, timeout, done)
+	}
+	e.mu.Unlock()
+
+	start := time.Now()
+	timer := time.NewTimer(timeout)
+	defer timer.Stop()
+
+	select {
+	case <-done:
+	case <-timer.C:
+		e.mu.Lock()
+		e.timeouts++
+		e.mu.Unlock()
+	case <-ctx.Done():
+	}
+
+	e.mu.Lock()
+	defer e.mu.Unlock()
+	if e.last == nil || !e.lastAt.Before(start) {
+		return e.last
+	}
+
+	// 本周期没有拿到新结果，沿用旧值直到超过 maxStale
+	if e.stale.IsZero() {
+		e.stale = start
+	}
+	if time.Since(e.stale) >= maxStale {
+		return nil
+	}
+	return e.last
+}
+
+// fresh 缓存结果在当前周期是否仍然有效，调用方持有 e.mu
+func (e *collectorEntry) fresh(key string) bool {
+	if e.last == nil {
+		return false
+	}
+	switch interval := e.schedule.Interval; {
+	case interval == RefreshOnce:
+		return e.lastKey == key
+	case interval > 0:
+		return time.Since(e.lastAt) < interval
+	default:
+		return false
+	}
+}
+
+// run 执行一次采集并更新缓存，超过截止时间后仍会运行到采集器返回
+func (e *collectorEntry) run(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology, key string, timeout time.Duration, done chan struct{}) {
+	ctx, cancel := context.WithTimeout(ctx, timeout)
+	defer cancel()
+
+	metrics, err := e.collector.Collect(ctx, devices, topology)
+
+	e.mu.Lock()
+	defer e.mu.Unlock()
+	if err == nil && metrics != nil {
+		e.last = metrics
+		e.lastAt = time.Now()
+		e.lastKey = key
+		e.lastErr = nil
+		e.stale = time.Time{}
+		e.collected++
+	} else {
+		if err == nil {
+			err = fmt.Errorf("collector returned no metrics")
+		}
+		e.lastErr = err
+		e.failures++
+	}
+	e.inflight = nil
+	close(done)
+}
+
+// inventoryKey 设备清单与拓扑的摘要，变化时 RefreshOnce 采集器重新采集
+func inventoryKey(devices []*detectors.Device, topology *detectors.Topology) string {
+	var b strings.Builder
+	for _, dev := range devices {
+		fmt.Fprintf(&b, "%s/%s/%d/%s;", dev.ID, dev.Model, dev.VRAMTotal, dev.PCIEBusID)
+	}
+	if topology != nil {
+		for _, link := range topology.Links {
+			fmt.Fprintf(&b, "%s-%s/%s/%d;", link.SourceID, link.TargetID, link.Type, link.Bandwidth)
+		}
+	}
+	return b.String()
+}
+
+// mergeMetrics 将单个采集器的结果合并到节点指标
+func mergeMetrics(result *Metrics, deviceMetrics map[string]*DeviceMetric, name string, metrics *Metrics) {
+	switch name {
+	case "fingerprint":
+		result.Fingerprint = metrics.Fingerprint
+		for _, dm := range metrics.DeviceMetrics {
+			if existing, ok := deviceMetrics[dm.DeviceID]; ok {
+				existing.Fingerprint = dm.Fingerprint
+			}
+		}
+	case "health":
+		result.Health = metrics.Health
+		for _, dm := range metrics.DeviceMetrics {
+			if existing, ok := deviceMetrics[dm.DeviceID]; ok {
+				existing.Health = dm.Health
+			}
+		}
+	case "topology":
+		result.Topology = metrics.Topology
+	case "interceptor":
+		result.Interceptor = metrics.Interceptor
+		for _, dm := range metrics.DeviceMetrics {
+			if existing, ok := deviceMetrics[dm.DeviceID]; ok {
+				existing.VRAMAllocated = dm.VRAMAllocated
+			}
+		}
+	case "ebpf-health":
+		result.Telemetry = metrics.Telemetry
+		result.TracedVRAM = metrics.TracedVRAM
+		result.TracedPCIe = metrics.TracedPCIe
+		for _, dm := range metrics.DeviceMetrics {
+			if existing, ok := deviceMetrics[dm.DeviceID]; ok {
+				existing.PCIe = dm.PCIe
+			}
+		}
+	}
+}
+
+// Status 返回各采集器的运行状态
+func (m *Manager) Status() []CollectorStatus {
+	m.mu.RLock()
+	defer m.mu.RUnlock()
+
+	statuses := make([]CollectorStatus, 0, len(m.collectors))
+	for _, e := range m.collectors {
+		e.mu.Lock()
+		statuses = append(statuses, CollectorStatus{
+			Name:        e.collector.Name(),
+			LastSuccess: e.lastAt,
+			LastError:   e.lastErr,
+			StaleSince:  e.stale,
+			InFlight:    e.inflight != nil,
+			Collected:   e.collected,
+			Failures:    e.failures,
+			Timeouts:    e.timeouts,
+		})
+		e.mu.Unlock()
+	}
+	return statuses
+}
+
 // List 列出所有已注册的采集器
 func (m *Manager) List() []string {
 	m.mu.RLock()
 	defer m.mu.RUnlock()
 
 	names := make([]string, 0, len(m.collectors))
-	for _, c := range m.collectors {
-		names = append(names, c.Name())
+	for _, e := range m.collectors {
+		names = append(names, e.collector.Name())
 	}
 	return names
 }
@@ -116,7 +350,9 @@ type CollectorResult struct {
 func (m *Manager) CollectAllParallel(ctx context.Context, devices []*detectors.Device, topology *detectors.Topology) ([]*CollectorResult, error) {
 	m.mu.RLock()
 	collectors := make([]Collector, len(m.collectors))
-	copy(collectors, m.collectors)
+	for i, e := range m.collectors {
+		collectors[i] = e.collector
+	}
 	m.mu.RUnlock()
 
 	results := make([]*CollectorResult, len(collectors))
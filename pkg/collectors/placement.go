@@ -0,0 +1,256 @@
+package collectors
+
+import (
+	"math/bits"
+	"sort"
+	"sync"
+)
+
+const (
+	// MaxPlacementDevices PlacementSearch 支持的最大设备数（空闲设备以 uint64 位图表示）
+	MaxPlacementDevices = 64
+
+	// placementNodeBudget 单次搜索最多展开的节点数，超出后返回已找到的最优解
+	placementNodeBudget = 1 << 18
+
+	// placementMemoSize 缓存的最大条目数，超出后清空
+	placementMemoSize = 4096
+)
+
+// PlacementSearch 在固定的拓扑矩阵上搜索互联带宽总和最大的 k 设备组合
+//
+// 先用多起点贪心得到初始解，再以分支定界求精确解：上界取当前得分加上每个候选设备
+// 与已选设备的带宽及其最大的若干条边，无法超过当前最优时剪枝。
+// 结果按 (空闲设备位图, k) 缓存，同一节点在调度周期内的重复查询直接命中。
+// 可被多个 goroutine 并发使用。
+type PlacementSearch struct {
+	matrix [][]int
+	n      int
+
+	mu   sync.Mutex
+	memo map[placementKey][]int
+}
+
+type placementKey struct {
+	free uint64
+	k    int
+}
+
+// NewPlacementSearch 基于 BuildTopologyMatrix 的结果创建搜索器，matrix 此后不得修改
+// 设备数超过 MaxPlacementDevices 时只考虑前 MaxPlacementDevices 个设备
+func NewPlacementSearch(matrix [][]int) *PlacementSearch {
+	n := len(matrix)
+	if n > MaxPlacementDevices {
+		n = MaxPlacementDevices
+	}
+	return &PlacementSearch{
+		matrix: matrix,
+		n:      n,
+		memo:   make(map[placementKey][]int),
+	}
+}
+
+// AllDevices 返回包含全部设备的位图
+func (s *PlacementSearch) AllDevices() uint64 {
+	if s.n == MaxPlacementDevices {
+		return ^uint64(0)
+	}
+	return (uint64(1) << uint(s.n)) - 1
+}
+
+// Find 在 free 位图标记的空闲设备中选出 k 个设备，返回升序的设备下标
+// 空闲设备不足 k 个或 k <= 0 时返回 nil；返回的切片由调用方持有
+func (s *PlacementSearch) Find(free uint64, k int) []int {
+	free &= s.AllDevices()
+	if k <= 0 || bits.OnesCount64(free) < k {
+		return nil
+	}
+
+	key := placementKey{free: free, k: k}
+	s.mu.Lock()
+	cached, ok := s.memo[key]
+	s.mu.Unlock()
+	if ok {
+		return append([]int(nil), cached...)
+	}
+
+	placement := s.search(free, k)
+
+	s.mu.Lock()
+	if len(s.memo) >= placementMemoSize {
+		s.memo = make(map[placementKey][]int)
+	}
+	s.memo[key] = placement
+	s.mu.Unlock()
+
+	return append([]int(nil), placement...)
+}
+
+// Score 返回放置方案的得分（两两互联带宽总和）
+func (s *PlacementSearch) Score(placement []int) int {
+	score := 0
+	for i := 0; i < len(placement); i++ {
+		for j := i + 1; j < len(placement); j++ {
+			score += s.matrix[placement[i]][placement[j]]
+		}
+	}
+	return score
+}
+
+// placementState 一次分支定界搜索的状态
+type placementState struct {
+	s     *PlacementSearch
+	k     int
+	order []int // 候选设备，按与其他空闲设备的带宽总和降序
+	// prefix[i][m] 设备 order[i] 到其他空闲设备最大的 m 条边之和
+	prefix [][]int
+
+	current   []int
+	gains     []int // gains[i] 设备 order[i] 与 current 的带宽之和
+	best      []int
+	bestScore int
+	nodes     int
+}
+
+func (s *PlacementSearch) search(free uint64, k int) []int {
+	st := &placementState{s: s, k: k}
+
+	// 只在空闲设备上计算度数与边权前缀和
+	degree := make(map[int]int)
+	for f := free; f != 0; f &= f - 1 {
+		i := bits.TrailingZeros64(f)
+		st.order = append(st.order, i)
+		for g := free; g != 0; g &= g - 1 {
+			degree[i] += s.matrix[i][bits.TrailingZeros64(g)]
+		}
+	}
+	sort.SliceStable(st.order, func(a, b int) bool {
+		return degree[st.order[a]] > degree[st.order[b]]
+	})
+
+	st.prefix = make([][]int, len(st.order))
+	for a, i := range st.order {
+		weights := make([]int, 0, len(st.order)-1)
+		for _, j := range st.order {
+			if j != i {
+				weights = append(weights, s.matrix[i][j])
+			}
+		}
+		sort.Sort(sort.Reverse(sort.IntSlice(weights)))
+		st.prefix[a] = make([]int, k)
+		for m := 1; m < k; m++ {
+			st.prefix[a][m] = st.prefix[a][m-1] + weights[m-1]
+		}
+	}
+
+	st.best = st.greedy()
+	st.bestScore = s.Score(st.best)
+
+	if k > 1 {
+		st.gains = make([]int, len(st.order))
+		st.current = make([]int, 0, k)
+		st.branch(0, 0)
+	}
+
+	sort.Ints(st.best)
+	return st.best
+}
+
+// greedy 多起点贪心：从每个候选设备出发，依次加入与已选设备带宽之和最大的设备
+func (st *placementState) greedy() []int {
+	var best []int
+	bestScore := -1
+	selected := make([]bool, len(st.order))
+
+	for start := range st.order {
+		for i := range selected {
+			selected[i] = false
+		}
+		placement := []int{st.order[start]}
+		selected[start] = true
+		score := 0
+
+		for len(placement) < st.k {
+			next, nextGain := -1, -1
+			for a, i := range st.order {
+				if selected[a] {
+					continue
+				}
+				gain := 0
+				for _, j := range placement {
+					gain += st.s.matrix[i][j]
+				}
+				if gain > nextGain {
+					next, nextGain = a, gain
+				}
+			}
+			placement = append(placement, st.order[next])
+			selected[next] = true
+			score += nextGain
+		}
+
+		if score > bestScore {
+			best, bestScore = placement, score
+		}
+		// 单设备时所有起点得分相同
+		if st.k == 1 {
+			break
+		}
+	}
+	return best
+}
+
+// branch 从 order[from:] 中继续选择设备，score 为 current 的得分
+func (st *placementState) branch(from, score int) {
+	need := st.k - len(st.current)
+	if need == 0 {
+		if score > st.bestScore {
+			st.bestScore = score
+			st.best = append(st.best[:0], st.current...)
+		}
+		return
+	}
+	if len(st.order)-from < need {
+		return
+	}
+	st.nodes++
+	if st.nodes > placementNodeBudget {
+		return
+	}
+
+	// 上界（两倍得分）：每个新设备贡献 2×与已选设备的带宽 + 最大的 need-1 条边
+	// 新设备之间的每条边被两端各计一次，因此整体不小于任何补全方案的两倍得分
+	bounds := make([]int, 0, len(st.order)-from)
+	for a := from; a < len(st.order); a++ {
+		bounds = append(bounds, 2*st.gains[a]+st.prefix[a][need-1])
+	}
+	sort.Sort(sort.Reverse(sort.IntSlice(bounds)))
+	bound := 2 * score
+	for _, b := range bounds[:need] {
+		bound += b
+	}
+	if bound <= 2*st.bestScore {
+		return
+	}
+
+	for a := from; a <= len(st.order)-need; a++ {
+		i := st.order[a]
+		gain := st.gains[a]
+
+		st.current = append(st.current, i)
+		for b := a + 1; b < len(st.order); b++ {
+			st.gains[b] += st.s.matrix[i][st.order[b]]
+		}
+
+		st.branch(a+1, score+gain)
+
+		for b := a + 1; b < len(st.order); b++ {
+			st.gains[b] -= st.s.matrix[i][st.order[b]]
+		}
+		st.current = st.current[:len(st.current)-1]
+
+		if st.nodes > placementNodeBudget {
+			return
+		}
+	}
+}
@@ -17,6 +17,11 @@ func NewTopologyCollector() *TopologyCollector {
 	return &TopologyCollector{}
 }
 
+// Schedule 拓扑只依赖设备清单与检测到的链路，变化时才重新采集
+func (c *TopologyCollector) Schedule() Schedule {
+	return Schedule{Interval: RefreshOnce}
+}
+
 // Name 返回采集器名称
 func (c *TopologyCollector) Name() string {
 	return "topology"
@@ -158,6 +163,8 @@ func (c *TopologyCollector) BuildTopologyMatrix(devices []*detectors.Device, top
 }
 
 // FindOptimalPlacement 找到最优的设备放置（基于拓扑亲和性）
+// 设备数不超过 MaxPlacementDevices 时由 PlacementSearch 求精确解，否则使用贪心
+// 需要重复查询同一矩阵（如调度时按空闲设备选择）时直接使用 NewPlacementSearch 以复用缓存
 func (c *TopologyCollector) FindOptimalPlacement(matrix [][]int, requiredDevices int) []int {
 	n := len(matrix)
 	if requiredDevices > n || requiredDevices <= 0 {
@@ -168,87 +175,60 @@ func (c *TopologyCollector) FindOptimalPlacement(matrix [][]int, requiredDevices
 		return []int{0}
 	}
 
-	// 简单贪心算法：找到互联带宽总和最大的设备组合
-	bestPlacement := make([]int, requiredDevices)
-	bestScore := -1
+	if n <= MaxPlacementDevices {
+		search := NewPlacementSearch(matrix)
+		return search.Find(search.AllDevices(), requiredDevices)
+	}
 
-	// 对于小规模问题使用暴力搜索，大规模问题使用贪心
-	if n <= 8 && requiredDevices <= 4 {
-		c.findBestCombination(matrix, requiredDevices, 0, make([]int, 0, requiredDevices), &bestPlacement, &bestScore)
-	} else {
-		// 贪心方法：从第一个设备开始，依次选择与已选设备互联带宽最大的设备
-		selected := make([]bool, n)
-		placement := make([]int, 0, requiredDevices)
+	return c.greedyPlacement(matrix, requiredDevices)
+}
 
-		// 选择第一个设备（带宽总和最大的）
-		maxSum := -1
-		firstDev := 0
+// greedyPlacement 贪心方法：从带宽总和最大的设备开始，依次选择与已选设备互联带宽最大的设备
+func (c *TopologyCollector) greedyPlacement(matrix [][]int, requiredDevices int) []int {
+	n := len(matrix)
+	selected := make([]bool, n)
+	placement := make([]int, 0, requiredDevices)
+
+	// 选择第一个设备（带宽总和最大的）
+	maxSum := -1
+	firstDev := 0
+	for i := 0; i < n; i++ {
+		sum := 0
+		for j := 0; j < n; j++ {
+			sum += matrix[i][j]
+		}
+		if sum > maxSum {
+			maxSum = sum
+			firstDev = i
+		}
+	}
+	placement = append(placement, firstDev)
+	selected[firstDev] = true
+
+	// 依次选择剩余设备
+	for len(placement) < requiredDevices {
+		maxScore := -1
+		nextDev := -1
 		for i := 0; i < n; i++ {
-			sum := 0
-			for j := 0; j < n; j++ {
-				sum += matrix[i][j]
+			if selected[i] {
+				continue
 			}
-			if sum > maxSum {
-				maxSum = sum
-				firstDev = i
+			score := 0
+			for _, dev := range placement {
+				score += matrix[i][dev]
 			}
-		}
-		placement = append(placement, firstDev)
-		selected[firstDev] = true
-
-		// 依次选择剩余设备
-		for len(placement) < requiredDevices {
-			maxScore := -1
-			nextDev := -1
-			for i := 0; i < n; i++ {
-				if selected[i] {
-					continue
-				}
-				score := 0
-				for _, dev := range placement {
-					score += matrix[i][dev]
-				}
-				if score > maxScore {
-					maxScore = score
-					nextDev = i
-				}
-			}
-			if nextDev >= 0 {
-				placement = append(placement, nextDev)
-				selected[nextDev] = true
+			if score > maxScore {
+				maxScore = score
+				nextDev = i
 			}
 		}
-		bestPlacement = placement
-	}
-
-	return bestPlacement
-}
-
-// findBestCombination 递归查找最佳组合
-func (c *TopologyCollector) findBestCombination(matrix [][]int, k, start int, current []int, best *[]int, bestScore *int) {
-	if len(current) == k {
-		score := c.calculatePlacementScore(matrix, current)
-		if score > *bestScore {
-			*bestScore = score
-			copy(*best, current)
+		if nextDev >= 0 {
+			placement = append(placement, nextDev)
+			selected[nextDev] = true
 		}
-		return
 	}
 
-	for i := start; i < len(matrix); i++ {
-		c.findBestCombination(matrix, k, i+1, append(current, i), best, bestScore)
-	}
-}
-
-// calculatePlacementScore 计算放置方案的得分（互联带宽总和）
-func (c *TopologyCollector) calculatePlacementScore(matrix [][]int, placement []int) int {
-	score := 0
-	for i := 0; i < len(placement); i++ {
-		for j := i + 1; j < len(placement); j++ {
-			score += matrix[placement[i]][placement[j]]
-		}
-	}
-	return score
+	return placement
 }
 
 // String 返回拓扑的字符串表示
@@ -3,44 +3,71 @@ package exchange
 import (
 	"fmt"
 	"sync"
+	"sync/atomic"
 )
 
 // Calculator provides exchange rate calculations between hardware models.
 // It enables "compute currency" conversion for cross-vendor scheduling decisions.
+//
+// Model names are interned to ModelIDs when their profile is loaded. Readers
+// work on an immutable rateTable that writers rebuild and publish on every
+// AddProfile/SetBaseModel, so lookups take no locks and GetRate between
+// known models is a matrix index.
 type Calculator struct {
-	mu        sync.RWMutex
+	mu        sync.Mutex                  // serializes writers
 	profiles  map[string]*HardwareProfile // key: vendor/model
 	baseModel string
-	rates     map[string]*ExchangeRate // key: base->target
+
+	// Interned model names; IDs are never reused or removed
+	ids    map[string]ModelID
+	models []*HardwareProfile // latest profile loaded for each model, by ID
+
+	table atomic.Pointer[rateTable]
+}
+
+// ModelID is a model name interned by a Calculator.
+// IDs stay valid for the lifetime of the Calculator that issued them.
+type ModelID int32
+
+// NoModel is the ModelID of a model without a profile.
+const NoModel ModelID = -1
+
+// rateTable is an immutable snapshot of the profiles and the rates between them.
+type rateTable struct {
+	baseModel string
+	base      ModelID // NoModel when the base model has no profile
+	baseFP16  float64
+	baseVRAM  uint64
+
+	ids      map[string]ModelID
+	models   []*HardwareProfile                     // by ModelID
+	vendors  map[string]map[string]*HardwareProfile // vendor -> model -> profile
+	profiles []*HardwareProfile
+
+	// Rates from model i to model j are at [i*n+j]
+	n       int
+	compute []float64
+	memory  []float64
 }
 
 // NewCalculator creates a new exchange rate calculator with builtin profiles.
 func NewCalculator() *Calculator {
-	c := &Calculator{
-		profiles:  make(map[string]*HardwareProfile),
-		baseModel: DefaultBaseModel,
-		rates:     make(map[string]*ExchangeRate),
-	}
+	c := newCalculator(DefaultBaseModel)
 
 	// Load builtin profiles
 	for i := range BuiltinProfiles {
-		p := &BuiltinProfiles[i]
-		c.profiles[p.Key()] = p
+		c.addProfile(&BuiltinProfiles[i])
 	}
 
 	// Pre-calculate exchange rates from builtin profiles
-	c.calculateRates()
+	c.publish()
 
 	return c
 }
 
 // NewCalculatorWithConfig creates a calculator with custom configuration.
 func NewCalculatorWithConfig(config *ProfileConfig) *Calculator {
-	c := &Calculator{
-		profiles:  make(map[string]*HardwareProfile),
-		baseModel: DefaultBaseModel,
-		rates:     make(map[string]*ExchangeRate),
-	}
+	c := newCalculator(DefaultBaseModel)
 
 	if config != nil {
 		if config.BaseModel != "" {
@@ -51,7 +78,7 @@ func NewCalculatorWithConfig(config *ProfileConfig) *Calculator {
 		for i := range config.Profiles {
 			p := &config.Profiles[i]
 			if p.IsValid() {
-				c.profiles[p.Key()] = p
+				c.addProfile(p)
 			}
 		}
 	}
@@ -59,29 +86,115 @@ func NewCalculatorWithConfig(config *ProfileConfig) *Calculator {
 	// Fall back to builtin profiles if none provided
 	if len(c.profiles) == 0 {
 		for i := range BuiltinProfiles {
-			p := &BuiltinProfiles[i]
-			c.profiles[p.Key()] = p
+			c.addProfile(&BuiltinProfiles[i])
 		}
 	}
 
-	c.calculateRates()
+	c.publish()
 	return c
 }
 
-// calculateRates pre-computes exchange rates between all profiles and the base model.
-func (c *Calculator) calculateRates() {
-	baseProfile := c.findProfileByModel(c.baseModel)
-	if baseProfile == nil {
-		return
+func newCalculator(baseModel string) *Calculator {
+	return &Calculator{
+		profiles:  make(map[string]*HardwareProfile),
+		baseModel: baseModel,
+		ids:       make(map[string]ModelID),
 	}
+}
 
-	for _, profile := range c.profiles {
-		if profile.Model == c.baseModel {
-			continue
+// addProfile stores a profile and interns its model. Callers hold mu or own c.
+func (c *Calculator) addProfile(profile *HardwareProfile) {
+	c.profiles[profile.Key()] = profile
+
+	id, ok := c.ids[profile.Model]
+	if !ok {
+		id = ModelID(len(c.models))
+		c.ids[profile.Model] = id
+		c.models = append(c.models, nil)
+	}
+	c.models[id] = profile
+}
+
+// publish builds a new rate table from the current profiles and makes it
+// visible to readers. Callers hold mu or own c.
+func (c *Calculator) publish() {
+	n := len(c.models)
+	t := &rateTable{
+		baseModel: c.baseModel,
+		base:      NoModel,
+		ids:       make(map[string]ModelID, n),
+		models:    append([]*HardwareProfile(nil), c.models...),
+		vendors:   make(map[string]map[string]*HardwareProfile),
+		profiles:  make([]*HardwareProfile, 0, len(c.profiles)),
+		n:         n,
+		compute:   make([]float64, n*n),
+		memory:    make([]float64, n*n),
+	}
+
+	for model, id := range c.ids {
+		t.ids[model] = id
+	}
+	for _, p := range c.profiles {
+		byModel, ok := t.vendors[p.Vendor]
+		if !ok {
+			byModel = make(map[string]*HardwareProfile)
+			t.vendors[p.Vendor] = byModel
 		}
+		byModel[p.Model] = p
+		t.profiles = append(t.profiles, p)
+	}
+
+	if id, ok := t.ids[c.baseModel]; ok {
+		t.base = id
+		t.baseFP16 = t.models[id].FP16TFLOPS
+		t.baseVRAM = t.models[id].VRAMBytes
+	}
+	t.calculateRates(c)
+
+	c.table.Store(t)
+}
+
+// calculateRates pre-computes exchange rates between all pairs of models.
+// Rates between two non-base models go through the base model, so every
+// entry is derived from the base -> target rates.
+func (t *rateTable) calculateRates(c *Calculator) {
+	for i := 0; i < t.n; i++ {
+		t.compute[i*t.n+i] = 1.0
+		t.memory[i*t.n+i] = 1.0
+	}
+	if t.base == NoModel {
+		return
+	}
+
+	// base -> target
+	baseProfile := t.models[t.base]
+	fromBase := make([]*ExchangeRate, t.n)
+	for i, profile := range t.models {
+		fromBase[i] = c.computeRate(baseProfile, profile)
+	}
 
-		rate := c.computeRate(baseProfile, profile)
-		c.rates[rate.Key()] = rate
+	for from := 0; from < t.n; from++ {
+		for to := 0; to < t.n; to++ {
+			if from == to {
+				continue
+			}
+
+			var rate *ExchangeRate
+			if ModelID(from) == t.base {
+				rate = fromBase[to]
+			} else if ModelID(to) == t.base {
+				rate = fromBase[from].Inverse()
+			} else {
+				// from -> base -> to
+				toBase := c.computeRate(t.models[from], baseProfile)
+				rate = &ExchangeRate{
+					ComputeRatio: toBase.ComputeRatio * fromBase[to].ComputeRatio,
+					MemoryRatio:  toBase.MemoryRatio * fromBase[to].MemoryRatio,
+				}
+			}
+			t.compute[from*t.n+to] = rate.ComputeRatio
+			t.memory[from*t.n+to] = rate.MemoryRatio
+		}
 	}
 }
 
@@ -110,38 +223,57 @@ func (c *Calculator) computeRate(base, target *HardwareProfile) *ExchangeRate {
 }
 
 // findProfileByModel finds a profile by model name (searches all vendors).
-func (c *Calculator) findProfileByModel(model string) *HardwareProfile {
-	for _, profile := range c.profiles {
-		if profile.Model == model {
-			return profile
-		}
+// When several vendors share a model name, the most recently loaded profile wins.
+func (t *rateTable) findProfileByModel(model string) *HardwareProfile {
+	if id, ok := t.ids[model]; ok {
+		return t.models[id]
 	}
 	return nil
 }
 
+// findProfile finds a profile by vendor and model, falling back to the model name only.
+func (t *rateTable) findProfile(vendor, model string) *HardwareProfile {
+	if profile, ok := t.vendors[vendor][model]; ok {
+		return profile
+	}
+	return t.findProfileByModel(model)
+}
+
+// ModelID returns the interned ID of a model, or NoModel if it has no profile.
+func (c *Calculator) ModelID(model string) ModelID {
+	if id, ok := c.table.Load().ids[model]; ok {
+		return id
+	}
+	return NoModel
+}
+
+// Rate returns the compute and memory ratios from one model to another.
+// ok is false for unknown IDs and when the base model has no profile.
+func (c *Calculator) Rate(from, to ModelID) (computeRatio, memoryRatio float64, ok bool) {
+	t := c.table.Load()
+	if from < 0 || to < 0 || int(from) >= t.n || int(to) >= t.n {
+		return 0, 0, false
+	}
+	if from != to && t.base == NoModel {
+		return 0, 0, false
+	}
+	i := int(from)*t.n + int(to)
+	return t.compute[i], t.memory[i], true
+}
+
 // GetProfile returns a hardware profile by vendor and model.
 func (c *Calculator) GetProfile(vendor, model string) *HardwareProfile {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
-
-	key := vendor + "/" + model
-	return c.profiles[key]
+	return c.table.Load().vendors[vendor][model]
 }
 
 // GetProfileByModel returns a hardware profile by model name only.
 func (c *Calculator) GetProfileByModel(model string) *HardwareProfile {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
-
-	return c.findProfileByModel(model)
+	return c.table.Load().findProfileByModel(model)
 }
 
 // GetRate returns the exchange rate between two models.
 // If direct rate not found, attempts to calculate through the base model.
 func (c *Calculator) GetRate(fromModel, toModel string) (*ExchangeRate, error) {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
-
 	// Same model - ratio is 1:1
 	if fromModel == toModel {
 		return &ExchangeRate{
@@ -152,98 +284,92 @@ func (c *Calculator) GetRate(fromModel, toModel string) (*ExchangeRate, error) {
 		}, nil
 	}
 
-	// Direct rate from base model
-	if fromModel == c.baseModel {
-		key := fromModel + "->" + toModel
-		if rate, ok := c.rates[key]; ok {
-			return rate, nil
-		}
-	}
-
-	// Inverse rate to base model
-	if toModel == c.baseModel {
-		key := c.baseModel + "->" + fromModel
-		if rate, ok := c.rates[key]; ok {
-			return rate.Inverse(), nil
-		}
-	}
-
-	// Calculate through base model (from -> base -> to)
-	fromProfile := c.findProfileByModel(fromModel)
-	toProfile := c.findProfileByModel(toModel)
-	baseProfile := c.findProfileByModel(c.baseModel)
-
-	if fromProfile == nil {
+	t := c.table.Load()
+	from, ok := t.ids[fromModel]
+	if !ok {
 		return nil, fmt.Errorf("unknown model: %s", fromModel)
 	}
-	if toProfile == nil {
+	to, ok := t.ids[toModel]
+	if !ok {
 		return nil, fmt.Errorf("unknown model: %s", toModel)
 	}
-	if baseProfile == nil {
-		return nil, fmt.Errorf("base model not found: %s", c.baseModel)
+	if t.base == NoModel {
+		return nil, fmt.Errorf("base model not found: %s", t.baseModel)
 	}
 
-	// from -> base rate
-	fromToBase := c.computeRate(fromProfile, baseProfile)
-	// base -> to rate
-	baseToTarget := c.computeRate(baseProfile, toProfile)
-
-	// Combined rate: from -> to = (from -> base) * (base -> to)
+	i := int(from)*t.n + int(to)
 	return &ExchangeRate{
 		BaseModel:    fromModel,
 		TargetModel:  toModel,
-		ComputeRatio: fromToBase.ComputeRatio * baseToTarget.ComputeRatio,
-		MemoryRatio:  fromToBase.MemoryRatio * baseToTarget.MemoryRatio,
+		ComputeRatio: t.compute[i],
+		MemoryRatio:  t.memory[i],
 	}, nil
 }
 
 // NormalizeCompute converts compute power to base model equivalents.
 func (c *Calculator) NormalizeCompute(vendor, model string, deviceCount int) (*NormalizedCompute, error) {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
+	t := c.table.Load()
 
-	profile := c.GetProfile(vendor, model)
-	if profile == nil {
-		// Try by model only
-		profile = c.findProfileByModel(model)
+	normalizedTFLOPS, normalizedVRAM, err := t.normalize(vendor, model, deviceCount)
+	if err != nil {
+		return nil, err
 	}
-	if profile == nil {
-		return nil, fmt.Errorf("unknown hardware: %s/%s", vendor, model)
+
+	return &NormalizedCompute{
+		BaseModel:        t.baseModel,
+		NormalizedTFLOPS: normalizedTFLOPS,
+		NormalizedVRAM:   normalizedVRAM,
+		OriginalModel:    model,
+		OriginalVendor:   vendor,
+	}, nil
+}
+
+// Normalize is NormalizeCompute without building a NormalizedCompute, for
+// scoring hot paths. ok is false for unknown hardware or a missing base model.
+func (c *Calculator) Normalize(vendor, model string, deviceCount int) (normalizedTFLOPS, normalizedVRAM float64, ok bool) {
+	t := c.table.Load()
+	profile := t.findProfile(vendor, model)
+	if profile == nil || t.base == NoModel {
+		return 0, 0, false
 	}
+	normalizedTFLOPS, normalizedVRAM = t.normalizeProfile(profile, deviceCount)
+	return normalizedTFLOPS, normalizedVRAM, true
+}
 
-	baseProfile := c.findProfileByModel(c.baseModel)
-	if baseProfile == nil {
-		return nil, fmt.Errorf("base model not found: %s", c.baseModel)
+func (t *rateTable) normalize(vendor, model string, deviceCount int) (float64, float64, error) {
+	profile := t.findProfile(vendor, model)
+	if profile == nil {
+		return 0, 0, fmt.Errorf("unknown hardware: %s/%s", vendor, model)
+	}
+	if t.base == NoModel {
+		return 0, 0, fmt.Errorf("base model not found: %s", t.baseModel)
 	}
 
-	// Calculate normalized values
-	var normalizedTFLOPS, normalizedVRAM float64
+	normalizedTFLOPS, normalizedVRAM := t.normalizeProfile(profile, deviceCount)
+	return normalizedTFLOPS, normalizedVRAM, nil
+}
 
-	if baseProfile.FP16TFLOPS > 0 {
+// normalizeProfile expresses deviceCount devices of profile in base model units.
+func (t *rateTable) normalizeProfile(profile *HardwareProfile, deviceCount int) (normalizedTFLOPS, normalizedVRAM float64) {
+	if t.baseFP16 > 0 {
 		// Total TFLOPS expressed in base model units
 		totalTFLOPS := profile.FP16TFLOPS * float64(deviceCount)
-		normalizedTFLOPS = totalTFLOPS / baseProfile.FP16TFLOPS
+		normalizedTFLOPS = totalTFLOPS / t.baseFP16
 	}
 
-	if baseProfile.VRAMBytes > 0 {
+	if t.baseVRAM > 0 {
 		// Total VRAM expressed in base model units
 		totalVRAM := profile.VRAMBytes * uint64(deviceCount)
-		normalizedVRAM = float64(totalVRAM) / float64(baseProfile.VRAMBytes)
+		normalizedVRAM = float64(totalVRAM) / float64(t.baseVRAM)
 	}
 
-	return &NormalizedCompute{
-		BaseModel:        c.baseModel,
-		NormalizedTFLOPS: normalizedTFLOPS,
-		NormalizedVRAM:   normalizedVRAM,
-		OriginalModel:    model,
-		OriginalVendor:   vendor,
-	}, nil
+	return normalizedTFLOPS, normalizedVRAM
 }
 
 // ConvertVRAM converts VRAM requirement from base model to target model.
 // Returns the equivalent VRAM in bytes needed on target hardware.
 func (c *Calculator) ConvertVRAM(vramBytes uint64, toModel string) (uint64, error) {
-	rate, err := c.GetRate(c.baseModel, toModel)
+	rate, err := c.GetRate(c.GetBaseModel(), toModel)
 	if err != nil {
 		return 0, err
 	}
@@ -260,7 +386,7 @@ func (c *Calculator) ConvertVRAM(vramBytes uint64, toModel string) (uint64, erro
 // ConvertCompute converts compute requirement from base model to target model.
 // Returns the equivalent number of target devices needed.
 func (c *Calculator) ConvertCompute(baseTFLOPS float64, toModel string) (float64, error) {
-	rate, err := c.GetRate(c.baseModel, toModel)
+	rate, err := c.GetRate(c.GetBaseModel(), toModel)
 	if err != nil {
 		return 0, err
 	}
@@ -282,8 +408,8 @@ func (c *Calculator) AddProfile(profile *HardwareProfile) error {
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
-	c.profiles[profile.Key()] = profile
-	c.calculateRates()
+	c.addProfile(profile)
+	c.publish()
 	return nil
 }
 
@@ -292,42 +418,48 @@ func (c *Calculator) SetBaseModel(model string) error {
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
-	if c.findProfileByModel(model) == nil {
+	if _, ok := c.ids[model]; !ok {
 		return fmt.Errorf("unknown model: %s", model)
 	}
 
 	c.baseModel = model
-	c.calculateRates()
+	c.publish()
 	return nil
 }
 
 // GetBaseModel returns the current base model.
 func (c *Calculator) GetBaseModel() string {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
-	return c.baseModel
+	return c.table.Load().baseModel
 }
 
 // ListProfiles returns all registered hardware profiles.
 func (c *Calculator) ListProfiles() []*HardwareProfile {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
+	t := c.table.Load()
 
-	profiles := make([]*HardwareProfile, 0, len(c.profiles))
-	for _, p := range c.profiles {
-		profiles = append(profiles, p)
-	}
+	profiles := make([]*HardwareProfile, len(t.profiles))
+	copy(profiles, t.profiles)
 	return profiles
 }
 
-// ListRates returns all pre-computed exchange rates.
+// ListRates returns all pre-computed exchange rates from the base model.
 func (c *Calculator) ListRates() []*ExchangeRate {
-	c.mu.RLock()
-	defer c.mu.RUnlock()
+	t := c.table.Load()
+	if t.base == NoModel {
+		return nil
+	}
 
-	rates := make([]*ExchangeRate, 0, len(c.rates))
-	for _, r := range c.rates {
-		rates = append(rates, r)
+	rates := make([]*ExchangeRate, 0, t.n)
+	for to, profile := range t.models {
+		if ModelID(to) == t.base {
+			continue
+		}
+		i := int(t.base)*t.n + to
+		rates = append(rates, &ExchangeRate{
+			BaseModel:    t.baseModel,
+			TargetModel:  profile.Model,
+			ComputeRatio: t.compute[i],
+			MemoryRatio:  t.memory[i],
+		})
 	}
 	return rates
 }
@@ -335,18 +467,18 @@ func (c *Calculator) ListRates() []*ExchangeRate {
 // ScoreNode calculates a normalized score for a node based on its hardware.
 // Higher score = more compute power in base model equivalents.
 func (c *Calculator) ScoreNode(vendor, model string, deviceCount int, availableVRAM uint64) float64 {
-	normalized, err := c.NormalizeCompute(vendor, model, deviceCount)
+	t := c.table.Load()
+	normalizedTFLOPS, _, err := t.normalize(vendor, model, deviceCount)
 	if err != nil {
 		return 0
 	}
 
 	// Combine compute and memory scores
 	// Weight: 70% compute, 30% memory
-	computeScore := normalized.NormalizedTFLOPS * 0.7
+	computeScore := normalizedTFLOPS * 0.7
 
-	baseProfile := c.findProfileByModel(c.baseModel)
-	if baseProfile != nil && baseProfile.VRAMBytes > 0 {
-		memoryScore := (float64(availableVRAM) / float64(baseProfile.VRAMBytes)) * 0.3
+	if t.baseVRAM > 0 {
+		memoryScore := (float64(availableVRAM) / float64(t.baseVRAM)) * 0.3
 		return computeScore + memoryScore
 	}
 
@@ -541,6 +541,137 @@ func TestCalculator_ScoreNode_UnknownHardware(t *testing.T) {
 	}
 }
 
+func TestCalculator_ModelID(t *testing.T) {
+	calc := NewCalculator()
+
+	a100 := calc.ModelID("A100-80GB")
+	rtx := calc.ModelID("RTX4090")
+	if a100 == NoModel || rtx == NoModel || a100 == rtx {
+		t.Fatalf("Builtin models should have distinct IDs, got %d and %d", a100, rtx)
+	}
+	if calc.ModelID("unknown") != NoModel {
+		t.Error("Unknown model should map to NoModel")
+	}
+
+	// IDs survive table rebuilds
+	calc.AddProfile(&HardwareProfile{Vendor: "test", Model: "test-gpu", FP16TFLOPS: 100, VRAMBytes: 16 * 1024 * 1024 * 1024})
+	calc.SetBaseModel("H100-80GB")
+	if calc.ModelID("A100-80GB") != a100 || calc.ModelID("RTX4090") != rtx {
+		t.Error("Model IDs should be stable across AddProfile and SetBaseModel")
+	}
+	if calc.ModelID("test-gpu") == NoModel {
+		t.Error("Added model should be interned")
+	}
+}
+
+func TestCalculator_Rate(t *testing.T) {
+	calc := NewCalculator()
+	models := []string{"A100-80GB", "RTX4090", "910B"}
+
+	for _, from := range models {
+		for _, to := range models {
+			rate, err := calc.GetRate(from, to)
+			if err != nil {
+				t.Fatalf("GetRate(%s, %s) error: %v", from, to, err)
+			}
+			compute, memory, ok := calc.Rate(calc.ModelID(from), calc.ModelID(to))
+			if !ok {
+				t.Fatalf("Rate(%s, %s) not found", from, to)
+			}
+			if compute != rate.ComputeRatio || memory != rate.MemoryRatio {
+				t.Errorf("Rate(%s, %s) = %f/%f, GetRate = %f/%f",
+					from, to, compute, memory, rate.ComputeRatio, rate.MemoryRatio)
+			}
+		}
+	}
+
+	if _, _, ok := calc.Rate(NoModel, calc.ModelID("A100-80GB")); ok {
+		t.Error("Rate with NoModel should not be found")
+	}
+	if _, _, ok := calc.Rate(ModelID(len(BuiltinProfiles)), 0); ok {
+		t.Error("Rate with out of range ID should not be found")
+	}
+}
+
+func TestCalculator_Rate_AfterSetBaseModel(t *testing.T) {
+	calc := NewCalculator()
+	rtx, a100 := calc.ModelID("RTX4090"), calc.ModelID("A100-80GB")
+
+	before, _, _ := calc.Rate(rtx, a100)
+	if err := calc.SetBaseModel("RTX4090"); err != nil {
+		t.Fatalf("SetBaseModel error: %v", err)
+	}
+	after, _, _ := calc.Rate(rtx, a100)
+
+	// RTX4090 -> A100 no longer goes through a third model, but the ratio is the same
+	if diff := before - after; diff > 1e-9 || diff < -1e-9 {
+		t.Errorf("Rate changed with base model: %f -> %f", before, after)
+	}
+
+	normalized, err := calc.NormalizeCompute(VendorNVIDIA, "RTX4090", 1)
+	if err != nil {
+		t.Fatalf("NormalizeCompute error: %v", err)
+	}
+	if normalized.NormalizedTFLOPS != 1.0 {
+		t.Errorf("Base model should normalize to 1.0, got %f", normalized.NormalizedTFLOPS)
+	}
+}
+
+func TestCalculator_Normalize(t *testing.T) {
+	calc := NewCalculator()
+
+	tflops, vram, ok := calc.Normalize(VendorNVIDIA, "RTX4090", 4)
+	if !ok {
+		t.Fatal("Normalize should find RTX4090")
+	}
+	normalized, _ := calc.NormalizeCompute(VendorNVIDIA, "RTX4090", 4)
+	if tflops != normalized.NormalizedTFLOPS || vram != normalized.NormalizedVRAM {
+		t.Errorf("Normalize = %f/%f, NormalizeCompute = %f/%f",
+			tflops, vram, normalized.NormalizedTFLOPS, normalized.NormalizedVRAM)
+	}
+
+	if _, _, ok := calc.Normalize("unknown", "unknown", 1); ok {
+		t.Error("Normalize for unknown hardware should fail")
+	}
+}
+
+func TestCalculator_HotPathAllocations(t *testing.T) {
+	calc := NewCalculator()
+	rtx, a100 := calc.ModelID("RTX4090"), calc.ModelID("A100-80GB")
+
+	allocs := testing.AllocsPerRun(100, func() {
+		calc.Normalize(VendorNVIDIA, "RTX4090", 8)
+		calc.Rate(rtx, a100)
+		calc.ScoreNode(VendorNVIDIA, "RTX4090", 8, 96*1024*1024*1024)
+	})
+	if allocs != 0 {
+		t.Errorf("Scoring hot path allocated %.0f times per run, want 0", allocs)
+	}
+}
+
+func TestCalculator_NoBaseProfile(t *testing.T) {
+	calc := NewCalculatorWithConfig(&ProfileConfig{
+		BaseModel: "missing",
+		Profiles: []HardwareProfile{
+			{Vendor: VendorNVIDIA, Model: "RTX4090", FP16TFLOPS: 165, VRAMBytes: 24 * 1024 * 1024 * 1024},
+			{Vendor: VendorHuawei, Model: "910B", FP16TFLOPS: 320, VRAMBytes: 64 * 1024 * 1024 * 1024},
+		},
+	})
+
+	if _, err := calc.GetRate("RTX4090", "910B"); err == nil {
+		t.Error("GetRate without a base profile should return error")
+	}
+	if _, err := calc.NormalizeCompute(VendorNVIDIA, "RTX4090", 1); err == nil {
+		t.Error("NormalizeCompute without a base profile should return error")
+	}
+	if rates := calc.ListRates(); len(rates) != 0 {
+		t.Errorf("ListRates without a base profile should be empty, got %d", len(rates))
+	}
+	if _, _, ok := calc.Rate(calc.ModelID("RTX4090"), calc.ModelID("RTX4090")); !ok {
+		t.Error("Rate of a model to itself should not need the base profile")
+	}
+}
+
 // =============================================================================
 // Config Tests
 // =============================================================================
@@ -917,6 +1048,8 @@ func TestCalculator_Concurrency(t *testing.T) {
 				calc.GetBaseModel()
 				calc.ListProfiles()
 				calc.ListRates()
+				calc.GetRate("RTX4090", "910B")
+				calc.NormalizeCompute(VendorNVIDIA, "RTX4090", 2)
 			}
 			done <- true
 		}()
@@ -0,0 +1,309 @@
+/*
+ * HCS Interceptor Benchmark
+ *
+ * Measures what libhcs_interceptor.so adds to each allocator call. The
+ * program runs against the mock runtime (mock_runtime.c), once without
+ * LD_PRELOAD for the baseline and once with the interceptor preloaded; the
+ * difference between the two runs is the cost of interception.
+ *
+ * Cases:
+ *   malloc_free  - Allocate and free 4 KiB per iteration, per runtime
+ *   mem_get_info - cudaMemGetInfo, which reads the quota on every call
+ *   mixed        - CUDA, HIP and ACL allocations with a MemGetInfo between
+ *   occupancy    - cudaMalloc/cudaFree with 10 to 65000 allocations live
+ * The first three sweep 1 to 64 threads.
+ *
+ * Output is one JSON object per line on stdout, for example:
+ *   {"bench":"malloc_free","runtime":"cuda","threads":8,"live":0,
+ *    "ops":400000,"errors":0,"ns_per_op":41.2,"mops":194.17,"preload":true}
+ * ns_per_op is the latency of one call as seen by one thread (elapsed time
+ * x threads / calls); mops is the aggregate throughput in million calls per
+ * second; errors counts calls that did not succeed.
+ *
+ * Build and run:
+ *   make bench
+ *
+ * Environment:
+ *   HCS_BENCH_OPS    - Calls per case, split across threads (default: 400000)
+ *   HCS_BENCH_FILTER - Only run cases whose name contains this string
+ *
+ * Copyright (c) 2024 HCS Project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/*
+ * Runtime APIs, implemented in mock_runtime.c (libhcs_mock_runtime.so)
+ */
+
+#define cudaSuccess 0
+#define hipSuccess 0
+#define ACL_SUCCESS 0
+#define ACL_MEM_MALLOC_HUGE_FIRST 0
+#define ACL_HBM_MEM 1
+
+int cudaMalloc(void **devPtr, size_t size);
+int cudaFree(void *devPtr);
+int cudaMemGetInfo(size_t *free, size_t *total);
+int hipMalloc(void **devPtr, size_t size);
+int hipFree(void *devPtr);
+int hipMemGetInfo(size_t *free, size_t *total);
+int aclrtMalloc(void **devPtr, size_t size, int policy);
+int aclrtFree(void *devPtr);
+int aclrtGetMemInfo(int attr, size_t *free, size_t *total);
+
+/* ============================================================================
+ * Configuration
+ * ============================================================================ */
+
+#define BENCH_DEFAULT_OPS 400000
+#define BENCH_ALLOC_SIZE 4096
+#define BENCH_FILL_SIZE 512
+#define BENCH_MIN_ITERATIONS 1000
+
+static const int thread_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+static const int live_counts[] = { 10, 100, 1000, 10000, 65000 };
+
+typedef enum {
+    RT_CUDA,
+    RT_HIP,
+    RT_ACL,
+    RT_COUNT
+} runtime_t;
+
+static const char *const runtime_names[RT_COUNT] = { "cuda", "hip", "acl" };
+
+typedef enum {
+    OP_MALLOC_FREE,
+    OP_MEM_GET_INFO,
+    OP_MIXED
+} bench_op_t;
+
+static long g_ops = BENCH_DEFAULT_OPS;
+static const char *g_filter = NULL;
+static bool g_preload = false;
+
+/* ============================================================================
+ * Runtime Dispatch
+ * ============================================================================ */
+
+static bool rt_malloc(runtime_t rt, void **ptr, size_t size) {
+    switch (rt) {
+    case RT_CUDA: return cudaMalloc(ptr, size) == cudaSuccess;
+    case RT_HIP:  return hipMalloc(ptr, size) == hipSuccess;
+    default:      return aclrtMalloc(ptr, size, ACL_MEM_MALLOC_HUGE_FIRST) == ACL_SUCCESS;
+    }
+}
+
+static bool rt_free(runtime_t rt, void *ptr) {
+    switch (rt) {
+    case RT_CUDA: return cudaFree(ptr) == cudaSuccess;
+    case RT_HIP:  return hipFree(ptr) == hipSuccess;
+    default:      return aclrtFree(ptr) == ACL_SUCCESS;
+    }
+}
+
+static bool rt_mem_get_info(runtime_t rt) {
+    size_t free_mem, total_mem;
+    switch (rt) {
+    case RT_CUDA: return cudaMemGetInfo(&free_mem, &total_mem) == cudaSuccess;
+    case RT_HIP:  return hipMemGetInfo(&free_mem, &total_mem) == hipSuccess;
+    default:      return aclrtGetMemInfo(ACL_HBM_MEM, &free_mem, &total_mem) == ACL_SUCCESS;
+    }
+}
+
+/* ============================================================================
+ * Workers
+ * ============================================================================ */
+
+typedef struct {
+    bench_op_t op;
+    runtime_t runtime;
+    long iterations;
+    pthread_barrier_t *start;
+    long calls;
+    long errors;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+} worker_t;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    long calls = 0, errors = 0;
+    void *ptr;
+
+    pthread_barrier_wait(w->start);
+    w->begin_ns = monotonic_ns();
+
+    for (long i = 0; i < w->iterations; i++) {
+        switch (w->op) {
+        case OP_MALLOC_FREE:
+            if (rt_malloc(w->runtime, &ptr, BENCH_ALLOC_SIZE)) {
+                errors += !rt_free(w->runtime, ptr);
+            } else {
+                errors++;
+            }
+            calls += 2;
+            break;
+        case OP_MEM_GET_INFO:
+            errors += !rt_mem_get_info(w->runtime);
+            calls++;
+            break;
+        case OP_MIXED: {
+            /* Rotate runtimes so every thread touches all three */
+            runtime_t rt = (runtime_t)(i % RT_COUNT);
+            if (rt_malloc(rt, &ptr, BENCH_ALLOC_SIZE)) {
+                errors += !rt_mem_get_info(rt);
+                errors += !rt_free(rt, ptr);
+            } else {
+                errors += 2;
+            }
+            calls += 3;
+            break;
+        }
+        }
+    }
+
+    w->end_ns = monotonic_ns();
+    w->calls = calls;
+    w->errors = errors;
+    return NULL;
+}
+
+/* Run one case on threads threads and print its result line */
+static void run_case(const char *name, bench_op_t op, runtime_t rt, int threads, int live) {
+    worker_t workers[64];
+    pthread_t tids[64];
+    pthread_barrier_t start;
+
+    /* Calls per iteration differ between operations; size the loop so
+     * every case makes about g_ops calls */
+    long per_iteration = op == OP_MALLOC_FREE ? 2 : op == OP_MIXED ? 3 : 1;
+    long iterations = g_ops / per_iteration / threads;
+    if (iterations < BENCH_MIN_ITERATIONS) iterations = BENCH_MIN_ITERATIONS;
+
+    pthread_barrier_init(&start, NULL, (unsigned)threads);
+    for (int i = 0; i < threads; i++) {
+        workers[i] = (worker_t){ .op = op, .runtime = rt, .iterations = iterations, .start = &start };
+        pthread_create(&tids[i], NULL, worker_main, &workers[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    pthread_barrier_destroy(&start);
+
+    /* Workers time themselves: the window runs from the first one to start
+     * until the last one finishes */
+    long calls = 0, errors = 0;
+    uint64_t begin = UINT64_MAX, end = 0;
+    for (int i = 0; i < threads; i++) {
+        calls += workers[i].calls;
+        errors += workers[i].errors;
+        if (workers[i].begin_ns < begin) begin = workers[i].begin_ns;
+        if (workers[i].end_ns > end) end = workers[i].end_ns;
+    }
+    uint64_t elapsed = end > begin ? end - begin : 1;
+
+    double ns_per_op = (double)elapsed * threads / (double)calls;
+    double mops = (double)calls * 1e3 / (double)elapsed;
+    printf("{\"bench\":\"%s\",\"runtime\":\"%s\",\"threads\":%d,\"live\":%d,"
+           "\"ops\":%ld,\"errors\":%ld,\"ns_per_op\":%.1f,\"mops\":%.2f,\"preload\":%s}\n",
+           name, op == OP_MIXED ? "mixed" : runtime_names[rt], threads, live,
+           calls, errors, ns_per_op, mops, g_preload ? "true" : "false");
+    fflush(stdout);
+}
+
+static bool selected(const char *name) {
+    return !g_filter || strstr(name, g_filter) != NULL;
+}
+
+/* ============================================================================
+ * Cases
+ * ============================================================================ */
+
+static void bench_malloc_free(void) {
+    for (int rt = 0; rt < RT_COUNT; rt++) {
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+            run_case("malloc_free", OP_MALLOC_FREE, (runtime_t)rt, thread_counts[t], 0);
+        }
+    }
+}
+
+static void bench_mem_get_info(void) {
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        run_case("mem_get_info", OP_MEM_GET_INFO, RT_CUDA, thread_counts[t], 0);
+    }
+}
+
+static void bench_mixed(void) {
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        run_case("mixed", OP_MIXED, RT_CUDA, thread_counts[t], 0);
+    }
+}
+
+/* Allocation table lookups with the table holding live allocations */
+static void bench_occupancy(void) {
+    int max_live = live_counts[sizeof(live_counts) / sizeof(live_counts[0]) - 1];
+    void **fill = calloc((size_t)max_live, sizeof(void *));
+    if (!fill) return;
+
+    int live = 0;
+    for (size_t l = 0; l < sizeof(live_counts) / sizeof(live_counts[0]); l++) {
+        while (live < live_counts[l] && cudaMalloc(&fill[live], BENCH_FILL_SIZE) == cudaSuccess) {
+            live++;
+        }
+        run_case("occupancy", OP_MALLOC_FREE, RT_CUDA, 1, live);
+    }
+
+    for (int i = 0; i < live; i++) {
+        cudaFree(fill[i]);
+    }
+    free(fill);
+}
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} benches[] = {
+    {"malloc_free", bench_malloc_free},
+    {"mem_get_info", bench_mem_get_info},
+    {"mixed", bench_mixed},
+    {"occupancy", bench_occupancy},
+};
+
+/* ============================================================================
+ * Main
+ * ============================================================================ */
+
+int main(void) {
+    const char *ops = getenv("HCS_BENCH_OPS");
+    if (ops && atol(ops) > 0) {
+        g_ops = atol(ops);
+    }
+    g_filter = getenv("HCS_BENCH_FILTER");
+
+    /* The interceptor's query functions are only there when it is preloaded */
+    g_preload = dlsym(RTLD_DEFAULT, "hcs_get_quota_used") != NULL;
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (selected(benches[i].name)) {
+            benches[i].run();
+        }
+    }
+    return 0;
+}
@@ -5,13 +5,42 @@
  * It uses LD_PRELOAD to hook memory allocation functions and track usage.
  *
  * Supported APIs:
- *   - NVIDIA CUDA: cudaMalloc, cudaFree, cudaMemGetInfo, cudaMallocManaged
- *   - Huawei ACL:  aclrtMalloc, aclrtFree, aclrtGetMemInfo
- *   - AMD/Hygon HIP: hipMalloc, hipFree, hipMemGetInfo
+ *   - NVIDIA CUDA: cudaMalloc, cudaFree, cudaMemGetInfo, cudaMallocManaged,
+ *                  cudaMallocAsync, cudaMallocFromPoolAsync, cudaFreeAsync,
+ *                  cudaSetDevice
+ *   - CUDA driver: cuMemAlloc, cuMemFree, cuMemAllocAsync, cuMemFreeAsync,
+ *                  cuMemCreate, cuMemRelease, cuMemGetInfo, cuGetProcAddress
+ *   - Huawei ACL:  aclrtMalloc, aclrtFree, aclrtGetMemInfo, aclrtSetDevice
+ *   - AMD/Hygon HIP: hipMalloc, hipFree, hipMemGetInfo, hipMallocAsync,
+ *                    hipFreeAsync, hipSetDevice
+ *
+ * Quotas are enforced per device. The device an allocation is charged to is
+ * the calling thread's current device, tracked through the Set*Device hooks
+ * (driver allocations ask cuCtxGetDevice; cuMemCreate names its device).
  *
  * Environment Variables:
- *   HCS_VRAM_QUOTA  - VRAM quota in bytes or human-readable format (e.g., "16Gi")
+ *   HCS_VRAM_QUOTA  - Per-device VRAM quota in bytes or human-readable format.
+ *                     "16Gi" applies to every device; "0=16Gi,1=8Gi" sets
+ *                     individual devices; "8Gi,0=16Gi" mixes both. Devices
+ *                     left out of a per-device list are not limited.
  *   HCS_LOG_LEVEL   - Log level: debug, info, warn, error (default: warn)
+ *   HCS_TRACE_FILE  - Enable binary allocation tracing to <path>.<pid>
+ *   HCS_STATS_DIR   - Publish live counters in a shared page at <dir>/<pid>
+ *   HCS_QUOTA_POOL  - Share one quota among all processes that name the same
+ *                     pool file (e.g. every process in a pod)
+ *   HCS_POOL        - "on" serves requests up to 1 MiB from cached 2 MiB
+ *                     chunks, charged to the quota per chunk
+ *   HCS_STATS_INTERVAL_MS - Stats page refresh interval (default: 50)
+ *   HCS_VRAM_SOFT_LIMIT - Pressure watermark below the quota: "90%" of each
+ *                     device's quota, or sizes in HCS_VRAM_QUOTA syntax.
+ *                     Crossing it signals hcs_pressure_eventfd(), the
+ *                     callback set with hcs_set_pressure_callback() and the
+ *                     stats page, so caching allocators can trim before the
+ *                     hard limit denies them
+ *   HCS_MANAGED_OVERSUBSCRIBE - Factor (e.g. 2) by which cudaMallocManaged
+ *                     may oversubscribe the quota. Managed memory is then
+ *                     capped at factor x quota, device allocations included,
+ *                     instead of being charged to the quota
  *
  * Usage:
  *   LD_PRELOAD=/path/to/libhcs_interceptor.so HCS_VRAM_QUOTA=16Gi ./your_app
@@ -28,7 +57,18 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
 /* ============================================================================
  * Constants and Configuration
@@ -36,13 +76,67 @@
 
 #define HCS_VERSION "0.4.0"
 #define MAX_ALLOCATIONS 65536
+#define MAX_DEVICES 16  /* Higher ordinals share the last device context */
 #define DEFAULT_QUOTA_GB 4
+#define QUOTA_UNLIMITED SIZE_MAX  /* Device left out of a per-device quota spec */
+#define CACHE_LINE_SIZE 64
+
+/* Allocation tracing */
+#define TRACE_RING_SIZE 4096            /* Records per thread, power of two */
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+#define TRACE_DRAIN_INTERVAL_MS 100
+#define TRACE_FILE_MAGIC "HCSTRACE"
+#define TRACE_FILE_VERSION 1
+
+/* Shared stats page */
+#define STATS_MAGIC 0x54534348U         /* "HCST" in little-endian byte order */
+#define STATS_VERSION 1
+#define STATS_DEFAULT_INTERVAL_MS 50
+#define STATS_HEADER_SIZE 512
+#define STATS_FLAG_POOLED 0x1U          /* quota_limit is a shared pool limit */
+#define STATS_FLAG_PRESSURE 0x2U        /* Some device is above its soft limit */
+
+/* Memory pressure. A device stays under pressure until its usage falls
+ * soft_limit >> PRESSURE_HYSTERESIS_SHIFT (1/16) below the watermark, so a
+ * workload hovering at the mark is not signalled on every allocation. */
+#define PRESSURE_HYSTERESIS_SHIFT 4
+
+/* Shared quota pool */
+#define POOL_MAGIC 0x4c4f4f50U          /* "POOL" in little-endian byte order */
+#define POOL_VERSION 1
+#define POOL_MAX_PROCS 256              /* Ledger slots, one per live process */
+#define POOL_RECLAIM_INTERVAL_MS 100    /* Minimum gap between dead-ledger scans */
+
+/* Caching sub-allocator (HCS_POOL=on). Requests up to 1 << SLAB_MAX_SHIFT
+ * bytes are carved out of chunks taken from the real allocator, one
+ * power-of-two size class per chunk. */
+#define SLAB_CHUNK_SHIFT 21             /* 2 MiB chunks */
+#define SLAB_CHUNK_SIZE (1UL << SLAB_CHUNK_SHIFT)
+#define SLAB_MIN_SHIFT 9                /* 512 B, the runtimes' own alignment */
+#define SLAB_MAX_SHIFT 20               /* 1 MiB; larger requests go direct */
+#define SLAB_CLASSES (SLAB_MAX_SHIFT - SLAB_MIN_SHIFT + 1)
+#define SLAB_MAP_WORDS ((SLAB_CHUNK_SIZE >> SLAB_MIN_SHIFT) / 64)
+#define SLAB_MAX_CHUNKS 2048            /* 4 GiB of chunks per process */
+
+/* Allocation table sharding. Shards are picked by the top bits of the
+ * pointer hash; each is sized at twice its even share of MAX_ALLOCATIONS so
+ * a skewed pointer distribution cannot fill one shard long before the rest. */
+#define ALLOC_SHARD_BITS 4
+#define ALLOC_SHARDS (1 << ALLOC_SHARD_BITS)
+#define ALLOC_SHARD_CAPACITY (MAX_ALLOCATIONS / ALLOC_SHARDS * 2)
+#define ALLOC_INDEX_SIZE (ALLOC_SHARD_CAPACITY * 2)  /* Power of two, load <= 50% */
+#define ALLOC_INDEX_MASK (ALLOC_INDEX_SIZE - 1)
 
 /* CUDA error codes */
 #define cudaSuccess 0
 #define cudaErrorMemoryAllocation 2
 #define cudaErrorInvalidValue 1
 
+/* CUDA driver API result codes */
+#define CUDA_SUCCESS 0
+#define CUDA_ERROR_INVALID_VALUE 1
+#define CUDA_ERROR_OUT_OF_MEMORY 2
+
 /* ACL error codes (华为昇腾) */
 #define ACL_SUCCESS 0
 #define ACL_ERROR_RT_MEMORY_ALLOCATION 107000
@@ -53,6 +147,26 @@
 #define hipErrorOutOfMemory 2
 #define hipErrorInvalidValue 1
 
+/* CUDA driver API handle types */
+typedef unsigned long long CUdeviceptr;
+typedef unsigned long long CUmemGenericAllocationHandle;
+
+/* Leading fields of CUmemAllocationProp; only the location is read, so the
+ * rest of the driver's struct is left out. */
+#define CU_MEM_LOCATION_TYPE_DEVICE 1
+typedef struct {
+    int type;
+    int requestedHandleTypes;
+    struct {
+        int type;
+        int id;
+    } location;
+} CUmemAllocationProp;
+
+/* VMM handles share the allocation table with device pointers; the tag bit
+ * keeps a handle value from ever matching a live pointer's key. */
+#define VMM_HANDLE_TAG (1ULL << 63)
+
 /* ACL memory allocation policy */
 typedef enum {
     ACL_MEM_MALLOC_HUGE_FIRST = 0,
@@ -87,81 +201,454 @@ typedef enum {
 typedef struct {
     void *ptr;
     size_t size;
-    bool in_use;
+    int32_t device;     /* Device context the allocation is charged to */
+    union {
+        int32_t next_free;  /* Free-list link (entry index + 1) while unused */
+        int32_t chunk;      /* Sub-allocator chunk (index + 1) while in use,
+                             * 0 for memory straight from the runtime,
+                             * ALLOC_CHUNK_MANAGED for cudaMallocManaged */
+    };
 } allocation_entry_t;
 
+#define ALLOC_CHUNK_MANAGED (-1)
+
+/* Per-device quota context. Each sits on its own cache line so threads
+ * driving different devices never bounce each other's counters. */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) size_t quota_limit;
+    _Atomic size_t quota_used;
+
+    /* Statistics (relaxed atomics, read for reporting only) */
+    _Atomic size_t peak_usage;
+    _Atomic uint64_t total_allocs;
+    _Atomic uint64_t total_frees;
+    _Atomic uint64_t failed_allocs;
+
+    /* Memory pressure and managed memory */
+    size_t soft_limit;            /* Pressure watermark, 0 when off */
+    _Atomic bool pressure;        /* Above soft_limit, cleared with hysteresis */
+    _Atomic size_t managed_used;  /* cudaMallocManaged bytes, live */
+} device_quota_t;
+
+/* One shard of the allocation table: entry pool plus an open-addressing
+ * index keyed by device pointer. Index slots and free-list links hold entry
+ * index + 1 so that the zero-initialised state means "empty". Shards are
+ * cache-line aligned so their locks do not false-share. */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t lock;
+    int32_t free_head;
+    int allocation_count;
+    allocation_entry_t allocations[ALLOC_SHARD_CAPACITY];
+    int32_t alloc_index[ALLOC_INDEX_SIZE];
+} alloc_shard_t;
+
 /* Global quota context */
 typedef struct {
-    pthread_mutex_t lock;
+    /* Quota enforcement, one context per device ordinal */
+    device_quota_t devices[MAX_DEVICES];
 
-    /* Quota configuration */
-    size_t quota_limit;
-    size_t quota_used;
+    /* Allocation tracking, each shard under its own lock */
+    alloc_shard_t shards[ALLOC_SHARDS];
 
-    /* Allocation tracking */
-    allocation_entry_t allocations[MAX_ALLOCATIONS];
-    int allocation_count;
+    /* Configuration */
+    log_level_t log_level;
+    double managed_oversubscribe; /* HCS_MANAGED_OVERSUBSCRIBE, 0 when off */
+    _Atomic bool initialized;     /* Set once hcs_init has run, with release */
+} quota_context_t;
 
-    /* Statistics */
-    size_t peak_usage;
+/* Trace operation codes, stored in trace_record_t.op */
+typedef enum {
+    TRACE_OP_CUDA_MALLOC = 1,
+    TRACE_OP_CUDA_FREE = 2,
+    TRACE_OP_CUDA_MALLOC_MANAGED = 3,
+    TRACE_OP_ACL_MALLOC = 4,
+    TRACE_OP_ACL_FREE = 5,
+    TRACE_OP_HIP_MALLOC = 6,
+    TRACE_OP_HIP_FREE = 7,
+    TRACE_OP_CUDA_MALLOC_ASYNC = 8,
+    TRACE_OP_CUDA_FREE_ASYNC = 9,
+    TRACE_OP_CU_MEM_ALLOC = 10,
+    TRACE_OP_CU_MEM_FREE = 11,
+    TRACE_OP_CU_MEM_CREATE = 12,
+    TRACE_OP_CU_MEM_RELEASE = 13,
+    TRACE_OP_HIP_MALLOC_ASYNC = 14,
+    TRACE_OP_HIP_FREE_ASYNC = 15
+} trace_op_t;
+
+/* Set in trace_record_t.op when the interceptor refused the request */
+#define TRACE_OP_DENIED 0x8000
+
+/* One traced call, written verbatim to the trace file */
+typedef struct {
+    uint64_t ts_ns;     /* CLOCK_MONOTONIC */
+    uint64_t ptr;
+    uint64_t size;
+    int32_t result;     /* Return code handed back to the application */
+    uint16_t op;        /* trace_op_t, possibly with TRACE_OP_DENIED */
+    int16_t device;     /* Charged device, -1 for untracked frees */
+} trace_record_t;
+
+/* Trace file header; records follow back to back */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+} trace_file_header_t;
+
+/* Single-producer/single-consumer ring owned by one application thread.
+ * The owner advances head, the drain thread advances tail. */
+typedef struct trace_ring {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t head;
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t tail;
+    _Atomic uint64_t dropped;
+    _Atomic bool exited;          /* Owner thread is gone; free once drained */
+    struct trace_ring *next;      /* Registry link */
+    trace_record_t records[TRACE_RING_SIZE];
+} trace_ring_t;
+
+/* Tracing state, shared by all threads */
+typedef struct {
+    bool enabled;
+    char path[256];
+    FILE *file;
+    _Atomic(trace_ring_t *) rings;
+    pthread_key_t ring_key;
+    pthread_t drain_thread;
+    pthread_mutex_t drain_lock;   /* Serializes draining and guards stop */
+    pthread_cond_t drain_cond;
+    bool stop;
+    uint64_t records_written;
+    uint64_t records_dropped;
+} trace_context_t;
+
+/* Per-device block of the shared stats page */
+typedef struct {
+    uint64_t quota_limit;
+    uint64_t quota_used;
+    uint64_t peak_usage;
     uint64_t total_allocs;
     uint64_t total_frees;
     uint64_t failed_allocs;
+    uint64_t soft_limit;          /* 0 when no watermark is set */
+    uint64_t managed_used;        /* Included in quota_used unless oversubscribing */
+} stats_device_t;
 
-    /* Configuration */
-    log_level_t log_level;
-    bool initialized;
-} quota_context_t;
+/* Shared stats page. The layout is an ABI shared with the node-agent reader
+ * (pkg/collectors/interceptor.go): fields are only ever appended into the
+ * reserved space, and incompatible changes bump STATS_VERSION. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                /* sizeof(stats_page_t) */
+    uint32_t device_count;
+    int32_t pid;
+    uint32_t flags;               /* STATS_FLAG_* */
+    _Atomic uint64_t seq;         /* Seqlock: odd while an update is in progress */
+    uint64_t update_ns;           /* CLOCK_REALTIME of the last update (heartbeat) */
+    uint64_t start_ns;            /* CLOCK_REALTIME when the page was created */
+    char pod_uid[64];
+    char pod_namespace[64];
+    char pod_name[64];
+    char container_name[64];
+    char visible_devices[128];    /* *_VISIBLE_DEVICES, maps ordinals to devices */
+    uint8_t reserved[STATS_HEADER_SIZE - 432];
+    stats_device_t devices[MAX_DEVICES];
+} stats_page_t;
+
+_Static_assert(offsetof(stats_page_t, seq) == 24, "stats page layout");
+_Static_assert(offsetof(stats_page_t, visible_devices) == 304, "stats page layout");
+_Static_assert(offsetof(stats_page_t, devices) == STATS_HEADER_SIZE, "stats page layout");
+_Static_assert(sizeof(stats_device_t) == 64, "stats page layout");
+
+/* Per-process ledger in the shared quota pool: what one process has charged
+ * to the pool, so the charge can be returned if the process dies. Only the
+ * owning process writes it while it lives. */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic int32_t pid;  /* Owner, 0 when free */
+    _Atomic uint64_t used[MAX_DEVICES];
+} pool_ledger_t;
+
+/* Pool-wide usage of one device, alone on its cache line */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t used;
+} pool_counter_t;
+
+/* Shared quota pool segment. Limits are fixed by the process that creates
+ * it; every process then reserves against the same counters. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                /* sizeof(quota_pool_t) */
+    uint32_t ledger_count;
+    uint64_t limits[MAX_DEVICES];
+    pool_counter_t used[MAX_DEVICES];
+    pool_ledger_t ledgers[POOL_MAX_PROCS];
+} quota_pool_t;
+
+/* This process's view of the pool */
+typedef struct {
+    quota_pool_t *pool;           /* NULL unless HCS_QUOTA_POOL is active */
+    pool_ledger_t *ledger;        /* Our slot, held with an fcntl lock */
+    int fd;
+    int slot;
+    char path[256];
+    pthread_mutex_t lock;         /* Serializes reclaim scans in this process */
+    _Atomic uint64_t last_reclaim_ns;
+} pool_context_t;
+
+/* Runtime a sub-allocator chunk was taken from, and is returned to */
+typedef enum {
+    SLAB_CUDA = 0,
+    SLAB_HIP = 1,
+    SLAB_ACL = 2,
+    SLAB_BACKENDS = 3
+} slab_backend_t;
+
+/* One sub-allocator chunk, carved into equal blocks of one size class */
+typedef struct {
+    void *base;
+    int32_t next;               /* Partial list or slot free-list link (index + 1) */
+    int16_t device;
+    uint8_t backend;            /* slab_backend_t */
+    uint8_t size_class;
+    uint16_t block_count;
+    uint16_t free_blocks;
+    bool listed;                /* On its class's partial list */
+    uint64_t free_map[SLAB_MAP_WORDS];  /* Set bit: block is free */
+} slab_chunk_t;
+
+/* Chunks of one (runtime, device, size class) that still have free blocks */
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t lock;
+    int32_t partial;            /* Head chunk (index + 1), 0 when empty */
+} slab_class_t;
+
+/* Caching sub-allocator state */
+typedef struct {
+    bool enabled;
+    slab_class_t classes[SLAB_BACKENDS][MAX_DEVICES][SLAB_CLASSES];
+    pthread_mutex_t chunk_lock;   /* Guards chunk slot allocation */
+    int32_t chunk_free;           /* Released chunk slots (index + 1) */
+    int32_t chunk_count;          /* Slots handed out so far */
+    slab_chunk_t chunks[SLAB_MAX_CHUNKS];
+} slab_context_t;
+
+/* Stats publishing state */
+typedef struct {
+    bool enabled;
+    char dir[256];
+    char filename[320];
+    stats_page_t *page;
+    long interval_ms;
+    pthread_t thread;
+    pthread_mutex_t lock;         /* Guards stop */
+    pthread_cond_t cond;
+    bool stop;
+} stats_context_t;
+
+/* Pressure callback, see hcs_set_pressure_callback() */
+typedef void (*hcs_pressure_callback_t)(int device, size_t used, size_t soft_limit,
+                                        size_t limit, void *arg);
+
+/* Memory pressure notification targets, both optional */
+typedef struct {
+    _Atomic int eventfd;          /* Created by the first hcs_pressure_eventfd() */
+    _Atomic(hcs_pressure_callback_t) callback;
+    _Atomic(void *) callback_arg;
+} pressure_context_t;
 
 /* ============================================================================
  * Global State
  * ============================================================================ */
 
 static quota_context_t g_ctx = {
-    .lock = PTHREAD_MUTEX_INITIALIZER,
-    .quota_limit = 0,
-    .quota_used = 0,
-    .allocation_count = 0,
-    .peak_usage = 0,
-    .total_allocs = 0,
-    .total_frees = 0,
-    .failed_allocs = 0,
+    .shards = {
+        [0 ... ALLOC_SHARDS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+    },
     .log_level = LOG_WARN,
     .initialized = false
 };
 
+static trace_context_t g_trace = {
+    .enabled = false,
+    .file = NULL,
+    .rings = NULL,
+    .drain_lock = PTHREAD_MUTEX_INITIALIZER,
+    .drain_cond = PTHREAD_COND_INITIALIZER,
+    .stop = false
+};
+
+static pool_context_t g_pool = {
+    .pool = NULL,
+    .fd = -1,
+    .slot = -1,
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static pressure_context_t g_pressure = {
+    .eventfd = -1,
+    .callback = NULL,
+    .callback_arg = NULL
+};
+
+static slab_context_t g_slab = {
+    .enabled = false,
+    .chunk_lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static stats_context_t g_stats = {
+    .enabled = false,
+    .page = NULL,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .stop = false
+};
+
+/* This thread's trace ring, created on its first traced call */
+static _Thread_local trace_ring_t *t_trace_ring = NULL;
+
+/* Device selected by this thread's last successful Set*Device call. All
+ * three runtimes default a new thread to device 0. */
+static _Thread_local int t_current_device = 0;
+
 /* Real CUDA function pointers */
 typedef int (*cudaMalloc_fn)(void **devPtr, size_t size);
 typedef int (*cudaFree_fn)(void *devPtr);
 typedef int (*cudaMemGetInfo_fn)(size_t *free, size_t *total);
 typedef int (*cudaMallocManaged_fn)(void **devPtr, size_t size, unsigned int flags);
-typedef int (*cudaMallocHost_fn)(void **ptr, size_t size);
-typedef int (*cudaFreeHost_fn)(void *ptr);
-
-static cudaMalloc_fn real_cudaMalloc = NULL;
-static cudaFree_fn real_cudaFree = NULL;
-static cudaMemGetInfo_fn real_cudaMemGetInfo = NULL;
-static cudaMallocManaged_fn real_cudaMallocManaged = NULL;
-static cudaMallocHost_fn real_cudaMallocHost = NULL;
-static cudaFreeHost_fn real_cudaFreeHost = NULL;
+typedef int (*cudaMallocAsync_fn)(void **devPtr, size_t size, void *stream);
+typedef int (*cudaMallocFromPoolAsync_fn)(void **devPtr, size_t size, void *memPool, void *stream);
+typedef int (*cudaFreeAsync_fn)(void *devPtr, void *stream);
+typedef int (*cudaSetDevice_fn)(int device);
+
+/* CUDA Driver API function pointers */
+typedef int (*cuMemAlloc_fn)(CUdeviceptr *dptr, size_t bytesize);
+typedef int (*cuMemFree_fn)(CUdeviceptr dptr);
+typedef int (*cuMemAllocAsync_fn)(CUdeviceptr *dptr, size_t bytesize, void *hStream);
+typedef int (*cuMemFreeAsync_fn)(CUdeviceptr dptr, void *hStream);
+typedef int (*cuMemCreate_fn)(CUmemGenericAllocationHandle *handle, size_t size,
+                              const CUmemAllocationProp *prop, unsigned long long flags);
+typedef int (*cuMemRelease_fn)(CUmemGenericAllocationHandle handle);
+typedef int (*cuMemGetInfo_fn)(size_t *free, size_t *total);
+typedef int (*cuCtxGetDevice_fn)(int *device);
+typedef int (*cuGetProcAddress_fn)(const char *symbol, void **pfn, int cudaVersion,
+                                   unsigned long long flags);
+typedef int (*cuGetProcAddress_v2_fn)(const char *symbol, void **pfn, int cudaVersion,
+                                      unsigned long long flags, int *symbolStatus);
 
 /* Real ACL function pointers (华为昇腾) */
 typedef int (*aclrtMalloc_fn)(void **devPtr, size_t size, aclrtMemMallocPolicy policy);
 typedef int (*aclrtFree_fn)(void *devPtr);
 typedef int (*aclrtGetMemInfo_fn)(aclrtMemAttr attr, size_t *free, size_t *total);
-
-static aclrtMalloc_fn real_aclrtMalloc = NULL;
-static aclrtFree_fn real_aclrtFree = NULL;
-static aclrtGetMemInfo_fn real_aclrtGetMemInfo = NULL;
+typedef int (*aclrtSetDevice_fn)(int32_t deviceId);
 
 /* Real HIP function pointers (海光/AMD) */
 typedef int (*hipMalloc_fn)(void **devPtr, size_t size);
 typedef int (*hipFree_fn)(void *devPtr);
 typedef int (*hipMemGetInfo_fn)(size_t *free, size_t *total);
+typedef int (*hipMallocAsync_fn)(void **devPtr, size_t size, void *stream);
+typedef int (*hipFreeAsync_fn)(void *devPtr, void *stream);
+typedef int (*hipSetDevice_fn)(int deviceId);
+
+/* Libraries each runtime may be loaded as, most recent first */
+static const char *const cudart_libs[] = {
+    "libcudart.so.13", "libcudart.so.12", "libcudart.so.11.0", "libcudart.so", NULL
+};
+static const char *const cuda_libs[] = { "libcuda.so.1", "libcuda.so", NULL };
+static const char *const acl_libs[] = { "libascendcl.so", NULL };
+static const char *const hip_libs[] = {
+    "libamdhip64.so.6", "libamdhip64.so.5", "libamdhip64.so", NULL
+};
 
-static hipMalloc_fn real_hipMalloc = NULL;
-static hipFree_fn real_hipFree = NULL;
-static hipMemGetInfo_fn real_hipMemGetInfo = NULL;
+/* Every real function the hooks forward to:
+ *   X(name, symbol, libraries, result when missing, log level when missing,
+ *     parameters, arguments)
+ * Each gets a dispatch slot real_<name>, read with HCS_REAL(name). Slots
+ * start out pointing at a stub that resolves the symbol, publishes it in
+ * the slot and forwards the call, so a runtime dlopen()ed after the
+ * constructor ran is still found. Once resolved, a hook's call is one load
+ * and an indirect call. */
+#define HCS_REAL_FUNCTIONS(X) \
+    X(cudaMalloc, "cudaMalloc", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (void **devPtr, size_t size), (devPtr, size)) \
+    X(cudaFree, "cudaFree", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (void *devPtr), (devPtr)) \
+    X(cudaMemGetInfo, "cudaMemGetInfo", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (size_t *free, size_t *total), (free, total)) \
+    X(cudaMallocManaged, "cudaMallocManaged", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (void **devPtr, size_t size, unsigned int flags), (devPtr, size, flags)) \
+    X(cudaMallocAsync, "cudaMallocAsync", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (void **devPtr, size_t size, void *stream), (devPtr, size, stream)) \
+    X(cudaMallocFromPoolAsync, "cudaMallocFromPoolAsync", cudart_libs, cudaErrorInvalidValue, \
+      LOG_ERROR, (void **devPtr, size_t size, void *memPool, void *stream), \
+      (devPtr, size, memPool, stream)) \
+    X(cudaFreeAsync, "cudaFreeAsync", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (void *devPtr, void *stream), (devPtr, stream)) \
+    X(cudaSetDevice, "cudaSetDevice", cudart_libs, cudaErrorInvalidValue, LOG_ERROR, \
+      (int device), (device)) \
+    X(cuMemAlloc, "cuMemAlloc_v2", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (CUdeviceptr *dptr, size_t bytesize), (dptr, bytesize)) \
+    X(cuMemFree, "cuMemFree_v2", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (CUdeviceptr dptr), (dptr)) \
+    X(cuMemAllocAsync, "cuMemAllocAsync", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (CUdeviceptr *dptr, size_t bytesize, void *hStream), (dptr, bytesize, hStream)) \
+    X(cuMemFreeAsync, "cuMemFreeAsync", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (CUdeviceptr dptr, void *hStream), (dptr, hStream)) \
+    X(cuMemCreate, "cuMemCreate", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (CUmemGenericAllocationHandle *handle, size_t size, const CUmemAllocationProp *prop, \
+       unsigned long long flags), (handle, size, prop, flags)) \
+    X(cuMemRelease, "cuMemRelease", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (CUmemGenericAllocationHandle handle), (handle)) \
+    X(cuMemGetInfo, "cuMemGetInfo_v2", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (size_t *free, size_t *total), (free, total)) \
+    X(cuCtxGetDevice, "cuCtxGetDevice", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_DEBUG, \
+      (int *device), (device)) \
+    X(cuGetProcAddress, "cuGetProcAddress", cuda_libs, CUDA_ERROR_INVALID_VALUE, LOG_ERROR, \
+      (const char *symbol, void **pfn, int cudaVersion, unsigned long long flags), \
+      (symbol, pfn, cudaVersion, flags)) \
+    X(cuGetProcAddress_v2, "cuGetProcAddress_v2", cuda_libs, CUDA_ERROR_INVALID_VALUE, \
+      LOG_ERROR, (const char *symbol, void **pfn, int cudaVersion, unsigned long long flags, \
+                  int *symbolStatus), (symbol, pfn, cudaVersion, flags, symbolStatus)) \
+    X(aclrtMalloc, "aclrtMalloc", acl_libs, ACL_ERROR_INVALID_PARAM, LOG_ERROR, \
+      (void **devPtr, size_t size, aclrtMemMallocPolicy policy), (devPtr, size, policy)) \
+    X(aclrtFree, "aclrtFree", acl_libs, ACL_ERROR_INVALID_PARAM, LOG_ERROR, \
+      (void *devPtr), (devPtr)) \
+    X(aclrtGetMemInfo, "aclrtGetMemInfo", acl_libs, ACL_ERROR_INVALID_PARAM, LOG_ERROR, \
+      (aclrtMemAttr attr, size_t *free, size_t *total), (attr, free, total)) \
+    X(aclrtSetDevice, "aclrtSetDevice", acl_libs, ACL_ERROR_INVALID_PARAM, LOG_ERROR, \
+      (int32_t deviceId), (deviceId)) \
+    X(hipMalloc, "hipMalloc", hip_libs, hipErrorInvalidValue, LOG_ERROR, \
+      (void **devPtr, size_t size), (devPtr, size)) \
+    X(hipFree, "hipFree", hip_libs, hipErrorInvalidValue, LOG_ERROR, \
+      (void *devPtr), (devPtr)) \
+    X(hipMemGetInfo, "hipMemGetInfo", hip_libs, hipErrorInvalidValue, LOG_ERROR, \
+      (size_t *free, size_t *total), (free, total)) \
+    X(hipMallocAsync, "hipMallocAsync", hip_libs, hipErrorInvalidValue, LOG_ERROR, \
+      (void **devPtr, size_t size, void *stream), (devPtr, size, stream)) \
+    X(hipFreeAsync, "hipFreeAsync", hip_libs, hipErrorInvalidValue, LOG_ERROR, \
+      (void *devPtr, void *stream), (devPtr, stream)) \
+    X(hipSetDevice, "hipSetDevice", hip_libs, hipErrorInvalidValue, LOG_ERROR, \
+      (int deviceId), (deviceId))
+
+#define HCS_DECLARE_REAL(name, symbol, libs, fail, level, params, args) \
+    static int stub_##name params; \
+    static _Atomic(name##_fn) real_##name = stub_##name;
+HCS_REAL_FUNCTIONS(HCS_DECLARE_REAL)
+#undef HCS_DECLARE_REAL
+
+#define HCS_REAL(name) atomic_load_explicit(&real_##name, memory_order_acquire)
+
+/* Every hook starts here; after initialization this is a single load */
+static void hcs_init(void);
+#define HCS_ENSURE_INIT() do { \
+    if (__builtin_expect(!atomic_load_explicit(&g_ctx.initialized, memory_order_acquire), 0)) { \
+        hcs_init(); \
+    } \
+} while(0)
+
+/* Depth of runtime allocation calls on this thread. A runtime that reaches
+ * the driver through our driver hooks must not be charged twice. */
+static _Thread_local int t_in_runtime = 0;
 
 /* ============================================================================
  * Utility Functions
@@ -177,8 +664,13 @@ static const char* log_level_str(log_level_t level) {
     }
 }
 
+/* True if messages at level would be printed. Hot paths guard any
+ * argument formatting (format_size and friends) with this, so a disabled
+ * level costs one predictable branch and nothing else. */
+#define HCS_LOG_ENABLED(level) __builtin_expect((level) >= g_ctx.log_level, 0)
+
 #define HCS_LOG(level, fmt, ...) do { \
-    if (level >= g_ctx.log_level) { \
+    if (HCS_LOG_ENABLED(level)) { \
         fprintf(stderr, "[HCS %s] " fmt "\n", log_level_str(level), ##__VA_ARGS__); \
     } \
 } while(0)
@@ -214,6 +706,80 @@ static size_t parse_size_string(const char *str) {
     return (size_t)value;
 }
 
+/* Parse HCS_VRAM_QUOTA into per-device limits. Entries are comma separated:
+ * a bare size sets every device, "<ordinal>=<size>" sets one device. A spec
+ * made only of per-device entries sets the other devices to unlisted.
+ * Returns false if any entry is malformed. */
+static bool parse_quota_spec(const char *spec, size_t unlisted, size_t limits[MAX_DEVICES]) {
+    if (!spec || !*spec) return false;
+
+    char buf[256];
+    if (strlen(spec) >= sizeof(buf)) return false;
+    strcpy(buf, spec);
+
+    bool have_default = false;
+    size_t default_limit = 0;
+    size_t device_limits[MAX_DEVICES];
+    bool device_set[MAX_DEVICES] = { false };
+
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(buf, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+        while (*tok == ' ') tok++;
+
+        char *eq = strchr(tok, '=');
+        if (!eq) {
+            if (*tok < '0' || *tok > '9') return false;
+            default_limit = parse_size_string(tok);
+            have_default = true;
+            continue;
+        }
+
+        char *endptr;
+        long device = strtol(tok, &endptr, 10);
+        while (*endptr == ' ') endptr++;
+        if (endptr == tok || endptr != eq || device < 0 || device >= MAX_DEVICES) {
+            return false;
+        }
+        if (eq[1] < '0' || eq[1] > '9') return false;
+        device_limits[device] = parse_size_string(eq + 1);
+        device_set[device] = true;
+    }
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        limits[i] = device_set[i] ? device_limits[i] : (have_default ? default_limit : unlisted);
+    }
+    return true;
+}
+
+/* Parse HCS_VRAM_SOFT_LIMIT against the enforced limits. "<pct>%" places
+ * the watermark at that share of every limited device's limit; anything
+ * else is a size spec as for HCS_VRAM_QUOTA, capped at each limit. A zero
+ * watermark, the default for unlisted and unlimited devices, disables
+ * pressure signalling for that device. */
+static bool parse_soft_limit_spec(const char *spec, const size_t limits[MAX_DEVICES],
+                                  size_t soft[MAX_DEVICES]) {
+    if (!spec || !*spec) return false;
+
+    size_t len = strlen(spec);
+    if (spec[len - 1] == '%') {
+        char *endptr;
+        double pct = strtod(spec, &endptr);
+        if (endptr == spec || endptr != spec + len - 1 || !(pct > 0 && pct <= 100)) {
+            return false;
+        }
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            soft[i] = limits[i] == QUOTA_UNLIMITED ? 0 : (size_t)((double)limits[i] * pct / 100.0);
+        }
+        return true;
+    }
+
+    if (!parse_quota_spec(spec, 0, soft)) return false;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (soft[i] > limits[i]) soft[i] = limits[i];
+    }
+    return true;
+}
+
 /* Format size for logging */
 static void format_size(size_t bytes, char *buf, size_t buflen) {
     if (bytes >= (1024UL * 1024 * 1024)) {
@@ -241,672 +807,2475 @@ static log_level_t parse_log_level(const char *str) {
 }
 
 /* ============================================================================
- * Allocation Tracking
- * ============================================================================ */
+ * Allocation Tracing
+ * ============================================================================
+ *
+ * With HCS_TRACE_FILE set, every intercepted allocation and free appends a
+ * fixed-size binary record to the calling thread's ring. No locks, no
+ * formatting and no syscalls happen on the hot path: a full ring drops the
+ * record and counts it. A background thread drains all rings to the file
+ * every TRACE_DRAIN_INTERVAL_MS, and the destructor drains what is left. */
+
+#define HCS_TRACE(op, ptr, size, result, device) do { \
+    if (__builtin_expect(g_trace.enabled, 0)) { \
+        trace_record((op), (ptr), (size), (result), (device)); \
+    } \
+} while(0)
 
-/* Find allocation entry by pointer (must hold lock) */
-static int find_allocation(void *ptr) {
-    for (int i = 0; i < g_ctx.allocation_count; i++) {
-        if (g_ctx.allocations[i].in_use && g_ctx.allocations[i].ptr == ptr) {
-            return i;
-        }
-    }
-    return -1;
+static void trace_thread_exit(void *arg) {
+    trace_ring_t *ring = arg;
+
+    /* Later TLS destructors may still free memory; they get a fresh ring */
+    t_trace_ring = NULL;
+    atomic_store_explicit(&ring->exited, true, memory_order_release);
 }
 
-/* Add allocation entry (must hold lock) */
-static bool add_allocation(void *ptr, size_t size) {
-    /* First, try to find an unused slot */
-    for (int i = 0; i < g_ctx.allocation_count; i++) {
-        if (!g_ctx.allocations[i].in_use) {
-            g_ctx.allocations[i].ptr = ptr;
-            g_ctx.allocations[i].size = size;
-            g_ctx.allocations[i].in_use = true;
-            return true;
-        }
-    }
+/* Allocate and register the calling thread's ring */
+static trace_ring_t *trace_ring_create(void) {
+    trace_ring_t *ring = aligned_alloc(CACHE_LINE_SIZE, sizeof(trace_ring_t));
+    if (!ring) return NULL;
+    memset(ring, 0, sizeof(*ring));
 
-    /* No unused slot, append if space available */
-    if (g_ctx.allocation_count < MAX_ALLOCATIONS) {
-        g_ctx.allocations[g_ctx.allocation_count].ptr = ptr;
-        g_ctx.allocations[g_ctx.allocation_count].size = size;
-        g_ctx.allocations[g_ctx.allocation_count].in_use = true;
-        g_ctx.allocation_count++;
-        return true;
+    ring->next = atomic_load_explicit(&g_trace.rings, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&g_trace.rings, &ring->next, ring,
+                                                  memory_order_release,
+                                                  memory_order_relaxed)) {
     }
 
-    return false;
+    pthread_setspecific(g_trace.ring_key, ring);
+    t_trace_ring = ring;
+    return ring;
 }
 
-/* Remove allocation entry (must hold lock) */
-static size_t remove_allocation(void *ptr) {
-    int idx = find_allocation(ptr);
-    if (idx >= 0) {
-        size_t size = g_ctx.allocations[idx].size;
-        g_ctx.allocations[idx].in_use = false;
-        return size;
-    }
-    return 0;
-}
+static void trace_record(uint16_t op, const void *ptr, size_t size, int result, int device) {
+    trace_ring_t *ring = t_trace_ring;
+    if (!ring && !(ring = trace_ring_create())) return;
 
-/* ============================================================================
- * Initialization
- * ============================================================================ */
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= TRACE_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
 
-static void load_real_functions(void) {
-    /* CUDA Runtime API */
-    real_cudaMalloc = (cudaMalloc_fn)dlsym(RTLD_NEXT, "cudaMalloc");
-    real_cudaFree = (cudaFree_fn)dlsym(RTLD_NEXT, "cudaFree");
-    real_cudaMemGetInfo = (cudaMemGetInfo_fn)dlsym(RTLD_NEXT, "cudaMemGetInfo");
-    real_cudaMallocManaged = (cudaMallocManaged_fn)dlsym(RTLD_NEXT, "cudaMallocManaged");
-    real_cudaMallocHost = (cudaMallocHost_fn)dlsym(RTLD_NEXT, "cudaMallocHost");
-    real_cudaFreeHost = (cudaFreeHost_fn)dlsym(RTLD_NEXT, "cudaFreeHost");
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    /* ACL Runtime API (华为昇腾) */
-    real_aclrtMalloc = (aclrtMalloc_fn)dlsym(RTLD_NEXT, "aclrtMalloc");
-    real_aclrtFree = (aclrtFree_fn)dlsym(RTLD_NEXT, "aclrtFree");
-    real_aclrtGetMemInfo = (aclrtGetMemInfo_fn)dlsym(RTLD_NEXT, "aclrtGetMemInfo");
+    trace_record_t *rec = &ring->records[head & TRACE_RING_MASK];
+    rec->ts_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    rec->ptr = (uint64_t)(uintptr_t)ptr;
+    rec->size = size;
+    rec->result = result;
+    rec->op = op;
+    rec->device = (int16_t)device;
 
-    /* HIP Runtime API (海光/AMD) */
-    real_hipMalloc = (hipMalloc_fn)dlsym(RTLD_NEXT, "hipMalloc");
-    real_hipFree = (hipFree_fn)dlsym(RTLD_NEXT, "hipFree");
-    real_hipMemGetInfo = (hipMemGetInfo_fn)dlsym(RTLD_NEXT, "hipMemGetInfo");
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
 }
 
-__attribute__((constructor))
-static void hcs_init(void) {
-    if (g_ctx.initialized) return;
-
-    /* Parse log level */
-    g_ctx.log_level = parse_log_level(getenv("HCS_LOG_LEVEL"));
-
-    /* Parse quota */
-    const char *quota_str = getenv("HCS_VRAM_QUOTA");
-    if (quota_str && *quota_str) {
-        g_ctx.quota_limit = parse_size_string(quota_str);
-    } else {
-        /* Default: 4 GiB */
-        g_ctx.quota_limit = (size_t)DEFAULT_QUOTA_GB * 1024 * 1024 * 1024;
+/* Write everything pending in one ring to the trace file */
+static void trace_drain_ring(trace_ring_t *ring) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while (tail != head) {
+        /* Write up to the end of the buffer, then wrap */
+        uint64_t chunk = TRACE_RING_SIZE - (tail & TRACE_RING_MASK);
+        if (chunk > head - tail) chunk = head - tail;
+        fwrite(&ring->records[tail & TRACE_RING_MASK], sizeof(trace_record_t), chunk, g_trace.file);
+        tail += chunk;
+        g_trace.records_written += chunk;
     }
 
-    /* Load real CUDA functions */
-    load_real_functions();
-
-    g_ctx.initialized = true;
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    g_trace.records_dropped += atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+}
 
-    char quota_buf[32];
-    format_size(g_ctx.quota_limit, quota_buf, sizeof(quota_buf));
-    HCS_LOG(LOG_INFO, "HCS Interceptor v%s initialized, quota=%s", HCS_VERSION, quota_buf);
+/* Drain all rings and retire those whose thread has exited (must hold drain_lock) */
+static void trace_drain_all(void) {
+    trace_ring_t *prev = NULL;
+    trace_ring_t *ring = atomic_load_explicit(&g_trace.rings, memory_order_acquire);
+
+    while (ring) {
+        trace_ring_t *next = ring->next;
+        bool exited = atomic_load_explicit(&ring->exited, memory_order_acquire);
+
+        trace_drain_ring(ring);
+
+        if (exited) {
+            /* New rings are only ever pushed at the head, so unlinking
+             * anything behind it needs no CAS */
+            bool unlinked = true;
+            if (prev) {
+                prev->next = next;
+            } else {
+                trace_ring_t *expected = ring;
+                unlinked = atomic_compare_exchange_strong_explicit(&g_trace.rings, &expected, next,
+                                                                   memory_order_acq_rel,
+                                                                   memory_order_acquire);
+            }
+            if (unlinked) {
+                free(ring);
+                ring = next;
+                continue;
+            }
+        }
 
-    if (!real_cudaMalloc) {
-        HCS_LOG(LOG_WARN, "cudaMalloc not found - CUDA library may not be loaded yet");
+        prev = ring;
+        ring = next;
     }
-}
 
-__attribute__((destructor))
-static void hcs_cleanup(void) {
-    if (!g_ctx.initialized) return;
+    fflush(g_trace.file);
+}
 
-    char used_buf[32], peak_buf[32], limit_buf[32];
-    format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-    format_size(g_ctx.peak_usage, peak_buf, sizeof(peak_buf));
-    format_size(g_ctx.quota_limit, limit_buf, sizeof(limit_buf));
+static void *trace_drain_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_trace.drain_lock);
+    while (!g_trace.stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += TRACE_DRAIN_INTERVAL_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&g_trace.drain_cond, &g_trace.drain_lock, &deadline);
+        trace_drain_all();
+    }
+    pthread_mutex_unlock(&g_trace.drain_lock);
 
-    HCS_LOG(LOG_INFO, "HCS Interceptor shutdown: allocs=%" PRIu64 ", frees=%" PRIu64 ", failed=%" PRIu64 ", peak=%s, final=%s, limit=%s",
-            g_ctx.total_allocs, g_ctx.total_frees, g_ctx.failed_allocs,
-            peak_buf, used_buf, limit_buf);
+    return NULL;
 }
 
-/* ============================================================================
- * CUDA API Interception
- * ============================================================================ */
-
-/* cudaMalloc interception */
-int cudaMalloc(void **devPtr, size_t size) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+/* Open <path>.<pid> and start the drain thread */
+static bool trace_start(void) {
+    char filename[300];
+    snprintf(filename, sizeof(filename), "%s.%d", g_trace.path, (int)getpid());
 
-    /* Lazy load real function */
-    if (!real_cudaMalloc) {
-        real_cudaMalloc = (cudaMalloc_fn)dlsym(RTLD_NEXT, "cudaMalloc");
-        if (!real_cudaMalloc) {
-            HCS_LOG(LOG_ERROR, "Failed to find real cudaMalloc");
-            return cudaErrorInvalidValue;
-        }
+    g_trace.file = fopen(filename, "wb");
+    if (!g_trace.file) {
+        HCS_LOG(LOG_WARN, "Cannot open trace file %s, tracing disabled", filename);
+        return false;
     }
 
-    pthread_mutex_lock(&g_ctx.lock);
+    trace_file_header_t header = { .version = TRACE_FILE_VERSION,
+                                   .record_size = sizeof(trace_record_t) };
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, g_trace.file);
+
+    g_trace.stop = false;
+    g_trace.records_written = 0;
+    g_trace.records_dropped = 0;
+    if (pthread_create(&g_trace.drain_thread, NULL, trace_drain_main, NULL) != 0) {
+        fclose(g_trace.file);
+        g_trace.file = NULL;
+        HCS_LOG(LOG_WARN, "Cannot start trace drain thread, tracing disabled");
+        return false;
+    }
 
-    /* Check quota */
-    if (g_ctx.quota_used + size > g_ctx.quota_limit) {
-        g_ctx.failed_allocs++;
+    HCS_LOG(LOG_INFO, "Allocation tracing to %s", filename);
+    return true;
+}
 
-        char req_buf[32], used_buf[32], limit_buf[32];
-        format_size(size, req_buf, sizeof(req_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        format_size(g_ctx.quota_limit, limit_buf, sizeof(limit_buf));
+/* After fork only the calling thread survives: forget the parent's records
+ * and rings, and trace the child into its own file */
+static void trace_atfork_child(void) {
+    pthread_mutex_init(&g_trace.drain_lock, NULL);
+    pthread_cond_init(&g_trace.drain_cond, NULL);
+
+    trace_ring_t *ring = atomic_load_explicit(&g_trace.rings, memory_order_relaxed);
+    while (ring) {
+        atomic_store_explicit(&ring->tail,
+                              atomic_load_explicit(&ring->head, memory_order_relaxed),
+                              memory_order_relaxed);
+        if (ring != t_trace_ring) {
+            atomic_store_explicit(&ring->exited, true, memory_order_relaxed);
+        }
+        ring = ring->next;
+    }
 
-        HCS_LOG(LOG_WARN, "cudaMalloc DENIED: requested=%s, used=%s, limit=%s",
-                req_buf, used_buf, limit_buf);
+    if (g_trace.file) {
+        fclose(g_trace.file);
+        g_trace.file = NULL;
+    }
+    g_trace.enabled = trace_start();
+}
 
-        pthread_mutex_unlock(&g_ctx.lock);
-        return cudaErrorMemoryAllocation;
+static void trace_init(const char *path) {
+    if (!path || !*path) return;
+    if (strlen(path) >= sizeof(g_trace.path)) {
+        HCS_LOG(LOG_WARN, "HCS_TRACE_FILE path too long, tracing disabled");
+        return;
     }
+    strcpy(g_trace.path, path);
 
-    pthread_mutex_unlock(&g_ctx.lock);
+    if (pthread_key_create(&g_trace.ring_key, trace_thread_exit) != 0) return;
+    if (!trace_start()) return;
 
-    /* Call real cudaMalloc */
-    int result = real_cudaMalloc(devPtr, size);
+    pthread_atfork(NULL, NULL, trace_atfork_child);
+    g_trace.enabled = true;
+}
 
-    if (result == cudaSuccess && devPtr && *devPtr) {
-        pthread_mutex_lock(&g_ctx.lock);
+/* Stop the drain thread and flush every remaining record */
+static void trace_shutdown(void) {
+    if (!g_trace.enabled) return;
+    g_trace.enabled = false;
 
-        /* Update quota */
-        g_ctx.quota_used += size;
-        g_ctx.total_allocs++;
+    pthread_mutex_lock(&g_trace.drain_lock);
+    g_trace.stop = true;
+    pthread_cond_signal(&g_trace.drain_cond);
+    pthread_mutex_unlock(&g_trace.drain_lock);
+    pthread_join(g_trace.drain_thread, NULL);
 
-        /* Update peak */
-        if (g_ctx.quota_used > g_ctx.peak_usage) {
-            g_ctx.peak_usage = g_ctx.quota_used;
-        }
+    trace_drain_all();
+    fclose(g_trace.file);
+    g_trace.file = NULL;
 
-        /* Track allocation */
-        if (!add_allocation(*devPtr, size)) {
-            HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
-        }
+    HCS_LOG(LOG_INFO, "Allocation trace: %" PRIu64 " records written, %" PRIu64 " dropped",
+            g_trace.records_written, g_trace.records_dropped);
+}
 
-        char size_buf[32], used_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        HCS_LOG(LOG_DEBUG, "cudaMalloc: size=%s, ptr=%p, total_used=%s",
-                size_buf, *devPtr, used_buf);
+/* ============================================================================
+ * Allocation Tracking
+ * ============================================================================ */
 
-        pthread_mutex_unlock(&g_ctx.lock);
-    }
+/* Hash a device pointer. Device pointers are heavily aligned, so the low
+ * bits carry no entropy; a 64-bit finalizer mixes the high bits down. The
+ * top bits select the shard and the low bits the home slot within it. */
+static inline uint64_t alloc_hash(const void *ptr) {
+    uint64_t h = (uint64_t)(uintptr_t)ptr;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
 
-    return result;
+static inline alloc_shard_t *alloc_shard(uint64_t hash) {
+    return &g_ctx.shards[hash >> (64 - ALLOC_SHARD_BITS)];
 }
 
-/* cudaFree interception */
-int cudaFree(void *devPtr) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+static inline uint32_t alloc_home(uint64_t hash) {
+    return (uint32_t)hash & ALLOC_INDEX_MASK;
+}
 
-    /* Lazy load real function */
-    if (!real_cudaFree) {
-        real_cudaFree = (cudaFree_fn)dlsym(RTLD_NEXT, "cudaFree");
-        if (!real_cudaFree) {
-            HCS_LOG(LOG_ERROR, "Failed to find real cudaFree");
-            return cudaErrorInvalidValue;
-        }
-    }
+/* Find the index slot holding ptr, or -1 (must hold shard lock) */
+static int find_allocation(alloc_shard_t *shard, void *ptr, uint64_t hash) {
+    uint32_t slot = alloc_home(hash);
 
-    /* NULL pointer is valid for cudaFree */
-    if (!devPtr) {
-        return real_cudaFree(devPtr);
+    /* The index is never more than half full, so probing always ends */
+    while (shard->alloc_index[slot] != 0) {
+        if (shard->allocations[shard->alloc_index[slot] - 1].ptr == ptr) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & ALLOC_INDEX_MASK;
     }
+    return -1;
+}
 
-    pthread_mutex_lock(&g_ctx.lock);
-
-    /* Find and remove allocation */
-    size_t size = remove_allocation(devPtr);
-    if (size > 0) {
-        if (g_ctx.quota_used >= size) {
-            g_ctx.quota_used -= size;
-        } else {
-            g_ctx.quota_used = 0;
+/* Add allocation entry (must hold shard lock) */
+static bool shard_add(alloc_shard_t *shard, void *ptr, size_t size, int device,
+                      int32_t chunk, uint64_t hash) {
+    uint32_t slot = alloc_home(hash);
+
+    while (shard->alloc_index[slot] != 0) {
+        allocation_entry_t *entry = &shard->allocations[shard->alloc_index[slot] - 1];
+        if (entry->ptr == ptr) {
+            /* Runtime handed the address out again without a free we saw */
+            entry->size = size;
+            entry->device = device;
+            entry->chunk = chunk;
+            return true;
         }
-        g_ctx.total_frees++;
+        slot = (slot + 1) & ALLOC_INDEX_MASK;
+    }
 
-        char size_buf[32], used_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        HCS_LOG(LOG_DEBUG, "cudaFree: size=%s, ptr=%p, total_used=%s",
-                size_buf, devPtr, used_buf);
+    /* Take a released entry first, otherwise extend the pool */
+    int32_t idx;
+    if (shard->free_head != 0) {
+        idx = shard->free_head - 1;
+        shard->free_head = shard->allocations[idx].next_free;
+    } else if (shard->allocation_count < ALLOC_SHARD_CAPACITY) {
+        idx = shard->allocation_count++;
     } else {
-        HCS_LOG(LOG_DEBUG, "cudaFree: ptr=%p (not tracked)", devPtr);
+        return false;
     }
 
-    pthread_mutex_unlock(&g_ctx.lock);
-
-    return real_cudaFree(devPtr);
+    shard->allocations[idx].ptr = ptr;
+    shard->allocations[idx].size = size;
+    shard->allocations[idx].device = device;
+    shard->allocations[idx].chunk = chunk;
+    shard->alloc_index[slot] = idx + 1;
+    return true;
 }
 
-/* cudaMemGetInfo interception - return virtualized memory info */
-int cudaMemGetInfo(size_t *free, size_t *total) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+/* Remove allocation entry (must hold shard lock) */
+static size_t shard_remove(alloc_shard_t *shard, void *ptr, int *device, int32_t *chunk,
+                           uint64_t hash) {
+    int found = find_allocation(shard, ptr, hash);
+    if (found < 0) {
+        return 0;
+    }
 
-    /* Lazy load real function */
-    if (!real_cudaMemGetInfo) {
-        real_cudaMemGetInfo = (cudaMemGetInfo_fn)dlsym(RTLD_NEXT, "cudaMemGetInfo");
-        if (!real_cudaMemGetInfo) {
-            HCS_LOG(LOG_ERROR, "Failed to find real cudaMemGetInfo");
-            return cudaErrorInvalidValue;
+    uint32_t hole = (uint32_t)found;
+    int32_t idx = shard->alloc_index[hole] - 1;
+    size_t size = shard->allocations[idx].size;
+    *device = shard->allocations[idx].device;
+    *chunk = shard->allocations[idx].chunk;
+
+    shard->allocations[idx].ptr = NULL;
+    shard->allocations[idx].next_free = shard->free_head;
+    shard->free_head = idx + 1;
+
+    /* Backward-shift deletion: pull later members of the probe run into
+     * the hole so lookups never need tombstones. An entry may move only if
+     * its home slot does not lie cyclically between the hole and itself. */
+    uint32_t next = (hole + 1) & ALLOC_INDEX_MASK;
+    while (shard->alloc_index[next] != 0) {
+        uint32_t home = alloc_home(alloc_hash(shard->allocations[shard->alloc_index[next] - 1].ptr));
+        if (((next - home) & ALLOC_INDEX_MASK) >= ((next - hole) & ALLOC_INDEX_MASK)) {
+            shard->alloc_index[hole] = shard->alloc_index[next];
+            hole = next;
         }
+        next = (next + 1) & ALLOC_INDEX_MASK;
     }
+    shard->alloc_index[hole] = 0;
 
-    /* Get real memory info first to check for errors */
-    int result = real_cudaMemGetInfo(free, total);
-    if (result != cudaSuccess) {
-        return result;
-    }
+    return size;
+}
+
+/* Track a new allocation in its shard; chunk is non-zero for blocks handed
+ * out by the sub-allocator */
+static bool add_allocation(void *ptr, size_t size, int device, int32_t chunk) {
+    uint64_t hash = alloc_hash(ptr);
+    alloc_shard_t *shard = alloc_shard(hash);
 
-    /* Return virtualized values */
-    pthread_mutex_lock(&g_ctx.lock);
+    pthread_mutex_lock(&shard->lock);
+    bool tracked = shard_add(shard, ptr, size, device, chunk, hash);
+    pthread_mutex_unlock(&shard->lock);
 
-    *total = g_ctx.quota_limit;
-    *free = (g_ctx.quota_limit > g_ctx.quota_used) ?
-            (g_ctx.quota_limit - g_ctx.quota_used) : 0;
+    return tracked;
+}
 
-    char free_buf[32], total_buf[32];
-    format_size(*free, free_buf, sizeof(free_buf));
-    format_size(*total, total_buf, sizeof(total_buf));
-    HCS_LOG(LOG_DEBUG, "cudaMemGetInfo: free=%s, total=%s (virtualized)",
-            free_buf, total_buf);
+/* Stop tracking ptr; returns its size, owning device and sub-allocator
+ * chunk, or 0 if it was not tracked */
+static size_t remove_allocation(void *ptr, int *device, int32_t *chunk) {
+    uint64_t hash = alloc_hash(ptr);
+    alloc_shard_t *shard = alloc_shard(hash);
 
-    pthread_mutex_unlock(&g_ctx.lock);
+    pthread_mutex_lock(&shard->lock);
+    size_t size = shard_remove(shard, ptr, device, chunk, hash);
+    pthread_mutex_unlock(&shard->lock);
 
-    return cudaSuccess;
+    return size;
 }
 
-/* cudaMallocManaged interception */
-int cudaMallocManaged(void **devPtr, size_t size, unsigned int flags) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
-
-    /* Lazy load real function */
-    if (!real_cudaMallocManaged) {
-        real_cudaMallocManaged = (cudaMallocManaged_fn)dlsym(RTLD_NEXT, "cudaMallocManaged");
-        if (!real_cudaMallocManaged) {
-            HCS_LOG(LOG_ERROR, "Failed to find real cudaMallocManaged");
-            return cudaErrorInvalidValue;
-        }
-    }
+/* Exported query functions, defined at the end of the file */
+size_t hcs_get_quota_used(void);
+size_t hcs_get_quota_limit(void);
+size_t hcs_get_peak_usage(void);
+void hcs_get_stats(uint64_t *allocs, uint64_t *frees, uint64_t *failed);
 
-    pthread_mutex_lock(&g_ctx.lock);
+/* Caching sub-allocator entry points used ahead of its definition */
+static size_t slab_trim(int device);
+static void slab_free(int32_t chunk, void *ptr);
+static void slab_reset(void);
+static void slab_init(const char *mode);
 
-    /* Check quota */
-    if (g_ctx.quota_used + size > g_ctx.quota_limit) {
-        g_ctx.failed_allocs++;
+/* ============================================================================
+ * Shared Quota Pool
+ * ============================================================================
+ *
+ * With HCS_QUOTA_POOL set, every process naming the same file reserves
+ * against one set of per-device counters in a shared mapping, so a pod that
+ * forks workers gets one quota rather than one per process. Reserve and
+ * release stay single atomics on the shared counters; no lock or syscall is
+ * taken on the allocation path.
+ *
+ * Each process also owns a ledger slot recording what it has charged. The
+ * slot is held with an fcntl record lock, which the kernel drops when the
+ * process dies, whatever PID namespace it lived in. A slot that can be
+ * locked but still has charges belongs to a dead process, and its charges
+ * are returned to the pool. Such slots are reclaimed when a process claims a
+ * slot, and when an allocation is denied. */
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
-        char req_buf[32], used_buf[32], limit_buf[32];
-        format_size(size, req_buf, sizeof(req_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        format_size(g_ctx.quota_limit, limit_buf, sizeof(limit_buf));
+/* Non-blocking (F_SETLK) or blocking (F_SETLKW) record lock on the pool file */
+static int pool_lock(int cmd, short type, off_t start, off_t len) {
+    struct flock fl = {
+        .l_type = type,
+        .l_whence = SEEK_SET,
+        .l_start = start,
+        .l_len = len
+    };
+    return fcntl(g_pool.fd, cmd, &fl);
+}
 
-        HCS_LOG(LOG_WARN, "cudaMallocManaged DENIED: requested=%s, used=%s, limit=%s",
-                req_buf, used_buf, limit_buf);
+static inline off_t pool_slot_offset(int slot) {
+    return (off_t)(offsetof(quota_pool_t, ledgers) + (size_t)slot * sizeof(pool_ledger_t));
+}
 
-        pthread_mutex_unlock(&g_ctx.lock);
-        return cudaErrorMemoryAllocation;
+/* Return a dead process's charges to the pool (caller holds the slot lock) */
+static uint64_t pool_drain_ledger(pool_ledger_t *ledger) {
+    uint64_t total = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        uint64_t used = atomic_exchange_explicit(&ledger->used[i], 0, memory_order_relaxed);
+        if (used) {
+            atomic_fetch_sub_explicit(&g_pool.pool->used[i].used, used, memory_order_relaxed);
+            total += used;
+        }
     }
+    atomic_store_explicit(&ledger->pid, 0, memory_order_relaxed);
+    return total;
+}
 
-    pthread_mutex_unlock(&g_ctx.lock);
-
-    /* Call real cudaMallocManaged */
-    int result = real_cudaMallocManaged(devPtr, size, flags);
+/* Reclaim every slot whose owner has exited. Returns the bytes returned. */
+static uint64_t pool_reclaim_dead(void) {
+    uint64_t reclaimed = 0;
 
-    if (result == cudaSuccess && devPtr && *devPtr) {
-        pthread_mutex_lock(&g_ctx.lock);
+    pthread_mutex_lock(&g_pool.lock);
+    for (int slot = 0; slot < POOL_MAX_PROCS; slot++) {
+        if (slot == g_pool.slot) continue;
 
-        g_ctx.quota_used += size;
-        g_ctx.total_allocs++;
+        pool_ledger_t *ledger = &g_pool.pool->ledgers[slot];
+        if (atomic_load_explicit(&ledger->pid, memory_order_relaxed) == 0) continue;
 
-        if (g_ctx.quota_used > g_ctx.peak_usage) {
-            g_ctx.peak_usage = g_ctx.quota_used;
+        /* Locking only succeeds if no live process holds the slot */
+        if (pool_lock(F_SETLK, F_WRLCK, pool_slot_offset(slot), sizeof(pool_ledger_t)) != 0) {
+            continue;
         }
+        reclaimed += pool_drain_ledger(ledger);
+        pool_lock(F_SETLK, F_UNLCK, pool_slot_offset(slot), sizeof(pool_ledger_t));
+    }
+    pthread_mutex_unlock(&g_pool.lock);
 
-        if (!add_allocation(*devPtr, size)) {
-            HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
-        }
+    if (reclaimed && HCS_LOG_ENABLED(LOG_INFO)) {
+        char buf[32];
+        format_size(reclaimed, buf, sizeof(buf));
+        HCS_LOG(LOG_INFO, "Reclaimed %s from exited processes in quota pool", buf);
+    }
+    return reclaimed;
+}
 
-        char size_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        HCS_LOG(LOG_DEBUG, "cudaMallocManaged: size=%s, ptr=%p", size_buf, *devPtr);
+/* Take the first slot no live process holds, inheriting nothing from it */
+static bool pool_claim_slot(void) {
+    for (int slot = 0; slot < POOL_MAX_PROCS; slot++) {
+        if (pool_lock(F_SETLK, F_WRLCK, pool_slot_offset(slot), sizeof(pool_ledger_t)) != 0) {
+            continue;
+        }
 
-        pthread_mutex_unlock(&g_ctx.lock);
+        pool_ledger_t *ledger = &g_pool.pool->ledgers[slot];
+        pool_drain_ledger(ledger);
+        atomic_store_explicit(&ledger->pid, (int32_t)getpid(), memory_order_relaxed);
+        g_pool.ledger = ledger;
+        g_pool.slot = slot;
+        return true;
     }
-
-    return result;
+    return false;
 }
 
-/* ============================================================================
- * ACL API Interception (华为昇腾)
- * ============================================================================ */
-
-/* aclrtMalloc interception */
-int aclrtMalloc(void **devPtr, size_t size, aclrtMemMallocPolicy policy) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+/* CAS size bytes onto a pool counter without passing limit */
+static bool pool_try_charge(_Atomic uint64_t *counter, uint64_t limit, size_t size) {
+    uint64_t used = atomic_load_explicit(counter, memory_order_relaxed);
+    do {
+        if (used > limit || size > limit - used) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(counter, &used, used + size,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+    return true;
+}
 
-    /* Lazy load real function */
-    if (!real_aclrtMalloc) {
-        real_aclrtMalloc = (aclrtMalloc_fn)dlsym(RTLD_NEXT, "aclrtMalloc");
-        if (!real_aclrtMalloc) {
-            HCS_LOG(LOG_ERROR, "Failed to find real aclrtMalloc");
-            return ACL_ERROR_INVALID_PARAM;
+/* Charge size bytes of device to the pool and to our ledger. A denial
+ * triggers one reclaim scan, rate limited so a full pool is not rescanned
+ * on every retry. */
+static bool pool_reserve(quota_pool_t *pool, int device, size_t size) {
+    _Atomic uint64_t *counter = &pool->used[device].used;
+
+    if (!pool_try_charge(counter, pool->limits[device], size)) {
+        uint64_t now = monotonic_ns();
+        uint64_t last = atomic_load_explicit(&g_pool.last_reclaim_ns, memory_order_relaxed);
+        if (now - last < (uint64_t)POOL_RECLAIM_INTERVAL_MS * 1000000ULL ||
+            !atomic_compare_exchange_strong_explicit(&g_pool.last_reclaim_ns, &last, now,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed) ||
+            pool_reclaim_dead() == 0 ||
+            !pool_try_charge(counter, pool->limits[device], size)) {
+            return false;
         }
     }
 
-    pthread_mutex_lock(&g_ctx.lock);
-
-    /* Check quota */
-    if (g_ctx.quota_used + size > g_ctx.quota_limit) {
-        g_ctx.failed_allocs++;
-
-        char req_buf[32], used_buf[32], limit_buf[32];
-        format_size(size, req_buf, sizeof(req_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        format_size(g_ctx.quota_limit, limit_buf, sizeof(limit_buf));
+    atomic_fetch_add_explicit(&g_pool.ledger->used[device], size, memory_order_relaxed);
+    return true;
+}
 
-        HCS_LOG(LOG_WARN, "aclrtMalloc DENIED: requested=%s, used=%s, limit=%s",
-                req_buf, used_buf, limit_buf);
+static inline void pool_release(int device, size_t size) {
+    quota_pool_t *pool = g_pool.pool;
+    if (!pool) return;
+    atomic_fetch_sub_explicit(&g_pool.ledger->used[device], size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&pool->used[device].used, size, memory_order_relaxed);
+}
 
-        pthread_mutex_unlock(&g_ctx.lock);
-        return ACL_ERROR_RT_MEMORY_ALLOCATION;
+/* Open or create the pool file and map it. The first process to lock the
+ * header initializes the limits from its own quota. */
+static bool pool_attach(const size_t limits[MAX_DEVICES]) {
+    g_pool.fd = open(g_pool.path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (g_pool.fd < 0) {
+        HCS_LOG(LOG_WARN, "Cannot open quota pool %s, using a per-process quota", g_pool.path);
+        return false;
     }
+    /* Processes in different containers may run as different users */
+    fchmod(g_pool.fd, 0666);
 
-    pthread_mutex_unlock(&g_ctx.lock);
-
-    /* Call real aclrtMalloc */
-    int result = real_aclrtMalloc(devPtr, size, policy);
+    pool_lock(F_SETLKW, F_WRLCK, 0, (off_t)offsetof(quota_pool_t, ledgers));
 
-    if (result == ACL_SUCCESS && devPtr && *devPtr) {
-        pthread_mutex_lock(&g_ctx.lock);
+    struct stat st;
+    bool ok = fstat(g_pool.fd, &st) == 0;
+    if (ok && st.st_size == 0) {
+        ok = ftruncate(g_pool.fd, sizeof(quota_pool_t)) == 0;
+    } else if (ok && st.st_size != (off_t)sizeof(quota_pool_t)) {
+        ok = false;
+    }
 
-        /* Update quota */
-        g_ctx.quota_used += size;
-        g_ctx.total_allocs++;
+    quota_pool_t *pool = MAP_FAILED;
+    if (ok) {
+        pool = mmap(NULL, sizeof(quota_pool_t), PROT_READ | PROT_WRITE, MAP_SHARED, g_pool.fd, 0);
+        ok = pool != MAP_FAILED;
+    }
 
-        /* Update peak */
-        if (g_ctx.quota_used > g_ctx.peak_usage) {
-            g_ctx.peak_usage = g_ctx.quota_used;
+    if (ok && pool->magic == 0) {
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            pool->limits[i] = limits[i];
         }
+        pool->version = POOL_VERSION;
+        pool->size = sizeof(quota_pool_t);
+        pool->ledger_count = POOL_MAX_PROCS;
+        pool->magic = POOL_MAGIC;
+    } else if (ok && (pool->magic != POOL_MAGIC || pool->version != POOL_VERSION)) {
+        ok = false;
+    } else if (ok && memcmp(pool->limits, limits, sizeof(pool->limits)) != 0) {
+        HCS_LOG(LOG_WARN, "HCS_VRAM_QUOTA differs from quota pool %s, using the pool's limits",
+                g_pool.path);
+    }
 
-        /* Track allocation */
-        if (!add_allocation(*devPtr, size)) {
-            HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
-        }
+    pool_lock(F_SETLK, F_UNLCK, 0, (off_t)offsetof(quota_pool_t, ledgers));
 
-        char size_buf[32], used_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        HCS_LOG(LOG_DEBUG, "aclrtMalloc: size=%s, ptr=%p, total_used=%s",
-                size_buf, *devPtr, used_buf);
+    if (!ok) {
+        if (pool != MAP_FAILED) munmap(pool, sizeof(quota_pool_t));
+        close(g_pool.fd);
+        g_pool.fd = -1;
+        HCS_LOG(LOG_WARN, "Incompatible quota pool %s, using a per-process quota", g_pool.path);
+        return false;
+    }
 
-        pthread_mutex_unlock(&g_ctx.lock);
+    g_pool.pool = pool;
+    if (!pool_claim_slot()) {
+        g_pool.pool = NULL;
+        munmap(pool, sizeof(quota_pool_t));
+        close(g_pool.fd);
+        g_pool.fd = -1;
+        HCS_LOG(LOG_WARN, "Quota pool %s has no free ledger slot, using a per-process quota",
+                g_pool.path);
+        return false;
     }
 
-    return result;
+    pool_reclaim_dead();
+    return true;
 }
 
-/* aclrtFree interception */
-int aclrtFree(void *devPtr) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+/* Drop the inherited allocation table and cached chunks: the parent still
+ * owns those device allocations and their pool charges, and a free in the
+ * child must not return them a second time */
+static void alloc_table_reset(void) {
+    for (int i = 0; i < ALLOC_SHARDS; i++) {
+        alloc_shard_t *shard = &g_ctx.shards[i];
+        pthread_mutex_init(&shard->lock, NULL);
+        shard->free_head = 0;
+        shard->allocation_count = 0;
+        memset(shard->alloc_index, 0, sizeof(shard->alloc_index));
+    }
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        atomic_store_explicit(&g_ctx.devices[i].quota_used, 0, memory_order_relaxed);
+        atomic_store_explicit(&g_ctx.devices[i].managed_used, 0, memory_order_relaxed);
+        atomic_store_explicit(&g_ctx.devices[i].pressure, false, memory_order_relaxed);
+    }
+    slab_reset();
+}
 
-    /* Lazy load real function */
-    if (!real_aclrtFree) {
-        real_aclrtFree = (aclrtFree_fn)dlsym(RTLD_NEXT, "aclrtFree");
-        if (!real_aclrtFree) {
-            HCS_LOG(LOG_ERROR, "Failed to find real aclrtFree");
-            return ACL_ERROR_INVALID_PARAM;
+/* Record locks are not inherited across fork, so the child claims its own
+ * ledger slot; the parent keeps its slot and its charges */
+static void pool_atfork_child(void) {
+    if (!g_pool.pool) return;
+
+    pthread_mutex_init(&g_pool.lock, NULL);
+    alloc_table_reset();
+
+    g_pool.ledger = NULL;
+    g_pool.slot = -1;
+    if (!pool_claim_slot()) {
+        /* Without a ledger the child cannot be charged safely: deny
+         * everything rather than overrun the pod's quota */
+        HCS_LOG(LOG_WARN, "Quota pool %s has no free ledger slot in child %d, denying allocations",
+                g_pool.path, (int)getpid());
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            g_ctx.devices[i].quota_limit = 0;
         }
+        g_pool.pool = NULL;
     }
+}
 
-    /* NULL pointer check */
-    if (!devPtr) {
-        return real_aclrtFree(devPtr);
+static void pool_init(const char *path, const size_t limits[MAX_DEVICES]) {
+    if (!path || !*path) return;
+    if (strlen(path) >= sizeof(g_pool.path)) {
+        HCS_LOG(LOG_WARN, "HCS_QUOTA_POOL path too long, using a per-process quota");
+        return;
     }
+    strcpy(g_pool.path, path);
 
-    pthread_mutex_lock(&g_ctx.lock);
-
-    /* Find and remove allocation */
-    size_t size = remove_allocation(devPtr);
-    if (size > 0) {
-        if (g_ctx.quota_used >= size) {
-            g_ctx.quota_used -= size;
-        } else {
-            g_ctx.quota_used = 0;
-        }
-        g_ctx.total_frees++;
+    if (!pool_attach(limits)) return;
 
-        char size_buf[32], used_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        HCS_LOG(LOG_DEBUG, "aclrtFree: size=%s, ptr=%p, total_used=%s",
-                size_buf, devPtr, used_buf);
-    } else {
-        HCS_LOG(LOG_DEBUG, "aclrtFree: ptr=%p (not tracked)", devPtr);
+    /* Local limits mirror the pool's, for reporting */
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        g_ctx.devices[i].quota_limit = g_pool.pool->limits[i];
     }
+    pthread_atfork(NULL, NULL, pool_atfork_child);
 
-    pthread_mutex_unlock(&g_ctx.lock);
-
-    return real_aclrtFree(devPtr);
+    HCS_LOG(LOG_INFO, "Sharing quota pool %s (ledger slot %d)", g_pool.path, g_pool.slot);
 }
 
-/* aclrtGetMemInfo interception - return virtualized memory info */
-int aclrtGetMemInfo(aclrtMemAttr attr, size_t *free, size_t *total) {
-    /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+/* Return our charges and give up the ledger slot on clean exit. Frees that
+ * arrive later, from other libraries' destructors, are only counted
+ * locally: the pool already has that memory back. */
+static void pool_shutdown(void) {
+    if (!g_pool.pool) return;
 
-    /* Lazy load real function */
-    if (!real_aclrtGetMemInfo) {
-        real_aclrtGetMemInfo = (aclrtGetMemInfo_fn)dlsym(RTLD_NEXT, "aclrtGetMemInfo");
-        if (!real_aclrtGetMemInfo) {
-            HCS_LOG(LOG_ERROR, "Failed to find real aclrtGetMemInfo");
-            return ACL_ERROR_INVALID_PARAM;
-        }
-    }
+    pool_drain_ledger(g_pool.ledger);
+    pool_lock(F_SETLK, F_UNLCK, pool_slot_offset(g_pool.slot), sizeof(pool_ledger_t));
+    g_pool.pool = NULL;
+}
+
+/* ============================================================================
+ * Quota Accounting
+ * ============================================================================ */
+
+/* Context for a device ordinal; out-of-range ordinals share the last one */
+static inline device_quota_t *device_quota(int device) {
+    if (device < 0) device = 0;
+    if (device >= MAX_DEVICES) device = MAX_DEVICES - 1;
+    return &g_ctx.devices[device];
+}
+
+/* Relaxed load of a device's current usage, for reporting */
+static inline size_t quota_used_now(const device_quota_t *dq) {
+    return atomic_load_explicit(&dq->quota_used, memory_order_relaxed);
+}
+
+/* Usage the quota is enforced against: the whole pool when pooled,
+ * otherwise this process */
+static inline size_t quota_enforced_used(const device_quota_t *dq) {
+    if (g_pool.pool) {
+        return atomic_load_explicit(&g_pool.pool->used[dq - g_ctx.devices].used,
+                                    memory_order_relaxed);
+    }
+    return quota_used_now(dq);
+}
+
+/* Bump a statistics counter */
+static inline void stat_inc(_Atomic uint64_t *counter) {
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+/* Tell the application a device crossed its soft limit. Runs on the
+ * allocating thread with no interceptor lock held, once per crossing. */
+static void pressure_notify(device_quota_t *dq, size_t used) {
+    int device = (int)(dq - g_ctx.devices);
+
+    int efd = atomic_load_explicit(&g_pressure.eventfd, memory_order_acquire);
+    if (efd >= 0) {
+        uint64_t one = 1;
+        /* Non-blocking: fails only while the counter is already saturated */
+        ssize_t n = write(efd, &one, sizeof(one));
+        (void)n;
+    }
+
+    hcs_pressure_callback_t callback =
+        atomic_load_explicit(&g_pressure.callback, memory_order_acquire);
+    if (callback) {
+        callback(device, used, dq->soft_limit, dq->quota_limit,
+                 atomic_load_explicit(&g_pressure.callback_arg, memory_order_relaxed));
+    }
+
+    if (HCS_LOG_ENABLED(LOG_INFO)) {
+        char used_buf[32], soft_buf[32], limit_buf[32];
+        format_size(used, used_buf, sizeof(used_buf));
+        format_size(dq->soft_limit, soft_buf, sizeof(soft_buf));
+        format_size(dq->quota_limit, limit_buf, sizeof(limit_buf));
+        HCS_LOG(LOG_INFO, "Memory pressure: device=%d, used=%s, soft_limit=%s, limit=%s",
+                device, used_buf, soft_buf, limit_buf);
+    }
+}
+
+/* Enter pressure once usage reaches the soft limit. The exchange lets
+ * exactly one of several racing allocators signal the crossing. */
+static inline void pressure_raise(device_quota_t *dq) {
+    if (dq->soft_limit == 0 || atomic_load_explicit(&dq->pressure, memory_order_relaxed)) {
+        return;
+    }
+    size_t used = quota_enforced_used(dq);
+    if (used >= dq->soft_limit &&
+        !atomic_exchange_explicit(&dq->pressure, true, memory_order_relaxed)) {
+        pressure_notify(dq, used);
+    }
+}
+
+/* Leave pressure once usage is back below the soft limit by the hysteresis
+ * margin */
+static inline void pressure_clear(device_quota_t *dq) {
+    if (!atomic_load_explicit(&dq->pressure, memory_order_relaxed)) return;
+    size_t low = dq->soft_limit - (dq->soft_limit >> PRESSURE_HYSTERESIS_SHIFT);
+    if (quota_enforced_used(dq) < low) {
+        atomic_store_explicit(&dq->pressure, false, memory_order_relaxed);
+    }
+}
+
+/* Charge size bytes to the device. The check and the charge are a single
+ * CAS, so concurrent callers can never jointly push quota_used past
+ * quota_limit. Returns false if the request does not fit. When pooled, the
+ * limit is checked against the shared pool instead and quota_used only
+ * tracks this process's share. */
+static bool quota_try_reserve(device_quota_t *dq, size_t size) {
+    quota_pool_t *pool = g_pool.pool;
+    size_t next;
+
+    if (pool) {
+        if (!pool_reserve(pool, (int)(dq - g_ctx.devices), size)) {
+            return false;
+        }
+        next = atomic_fetch_add_explicit(&dq->quota_used, size, memory_order_relaxed) + size;
+    } else {
+        size_t used = atomic_load_explicit(&dq->quota_used, memory_order_relaxed);
+        do {
+            if (used > dq->quota_limit || size > dq->quota_limit - used) {
+                return false;
+            }
+            next = used + size;
+        } while (!atomic_compare_exchange_weak_explicit(&dq->quota_used, &used, next,
+                                                        memory_order_relaxed,
+                                                        memory_order_relaxed));
+    }
+
+    size_t peak = atomic_load_explicit(&dq->peak_usage, memory_order_relaxed);
+    while (next > peak &&
+           !atomic_compare_exchange_weak_explicit(&dq->peak_usage, &peak, next,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+
+    return true;
+}
+
+/* Reserve size bytes before calling the real allocator. Chunks cached by the
+ * sub-allocator count against the quota, so a request that does not fit
+ * first hands the idle ones back. */
+static bool quota_reserve(device_quota_t *dq, size_t size) {
+    if (!quota_try_reserve(dq, size) &&
+        !(slab_trim((int)(dq - g_ctx.devices)) > 0 && quota_try_reserve(dq, size))) {
+        return false;
+    }
+    pressure_raise(dq);
+    return true;
+}
+
+/* Return a reservation: on free, or when the real allocator failed */
+static inline void quota_release(device_quota_t *dq, size_t size) {
+    atomic_fetch_sub_explicit(&dq->quota_used, size, memory_order_relaxed);
+    pool_release((int)(dq - g_ctx.devices), size);
+    pressure_clear(dq);
+}
+
+/* Replace the runtime's free/total with the device's quota. A device with
+ * no quota reports the runtime's own values. */
+static void quota_mem_info(device_quota_t *dq, size_t *free, size_t *total) {
+    if (dq->quota_limit == QUOTA_UNLIMITED) return;
+
+    size_t used = quota_enforced_used(dq);
+    *total = dq->quota_limit;
+    *free = (dq->quota_limit > used) ? (dq->quota_limit - used) : 0;
+}
+
+/* Charge a cudaMallocManaged request. Managed pages migrate on demand and
+ * can be evicted to host memory, so with HCS_MANAGED_OVERSUBSCRIBE they are
+ * not charged to the quota but capped, together with the device
+ * allocations, at that multiple of it. Either way they are tallied in
+ * managed_used. */
+static bool managed_reserve(device_quota_t *dq, size_t size) {
+    if (g_ctx.managed_oversubscribe <= 0) {
+        if (!quota_reserve(dq, size)) return false;
+        atomic_fetch_add_explicit(&dq->managed_used, size, memory_order_relaxed);
+        return true;
+    }
+
+    double cap_bytes = (double)dq->quota_limit * g_ctx.managed_oversubscribe;
+    size_t cap = cap_bytes >= (double)SIZE_MAX ? SIZE_MAX : (size_t)cap_bytes;
+    size_t managed = atomic_load_explicit(&dq->managed_used, memory_order_relaxed);
+    do {
+        size_t used = quota_enforced_used(dq);
+        if (used > cap || managed > cap - used || size > cap - used - managed) {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&dq->managed_used, &managed, managed + size,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+    return true;
+}
+
+/* Return a managed reservation */
+static inline void managed_release(device_quota_t *dq, size_t size) {
+    atomic_fetch_sub_explicit(&dq->managed_used, size, memory_order_relaxed);
+    if (g_ctx.managed_oversubscribe <= 0) {
+        quota_release(dq, size);
+    }
+}
+
+/* ============================================================================
+ * Shared Stats Page
+ * ============================================================================
+ *
+ * With HCS_STATS_DIR set, a background thread copies the per-device counters
+ * into a small file-backed shared mapping every HCS_STATS_INTERVAL_MS. The
+ * node-agent maps the same file read-only and samples it without calling
+ * into this process. The publisher is the only writer, so a sequence counter
+ * is enough to let readers detect and retry torn reads. The hot path is not
+ * touched at all. */
+
+static uint64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Copy an optional environment variable into a fixed page field */
+static void stats_copy_env(char *dst, size_t len, const char *name) {
+    const char *value = getenv(name);
+    if (value) {
+        snprintf(dst, len, "%s", value);
+    }
+}
+
+/* Write the counters under the seqlock. Readers load seq, copy the page and
+ * reload seq; an odd or changed value means the copy must be retried. */
+static void stats_publish(void) {
+    stats_page_t *page = g_stats.page;
+    uint64_t seq = atomic_load_explicit(&page->seq, memory_order_relaxed);
+    uint32_t flags = g_pool.pool ? STATS_FLAG_POOLED : 0;
+
+    atomic_store_explicit(&page->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        device_quota_t *dq = &g_ctx.devices[i];
+        stats_device_t *sd = &page->devices[i];
+        sd->quota_limit = dq->quota_limit;
+        sd->quota_used = quota_used_now(dq);
+        sd->peak_usage = atomic_load_explicit(&dq->peak_usage, memory_order_relaxed);
+        sd->total_allocs = atomic_load_explicit(&dq->total_allocs, memory_order_relaxed);
+        sd->total_frees = atomic_load_explicit(&dq->total_frees, memory_order_relaxed);
+        sd->failed_allocs = atomic_load_explicit(&dq->failed_allocs, memory_order_relaxed);
+        sd->soft_limit = dq->soft_limit;
+        sd->managed_used = atomic_load_explicit(&dq->managed_used, memory_order_relaxed);
+
+        /* Frees by other processes in the pool never reach our release
+         * path, so re-check the watermark here too */
+        pressure_clear(dq);
+        if (atomic_load_explicit(&dq->pressure, memory_order_relaxed)) {
+            flags |= STATS_FLAG_PRESSURE;
+        }
+    }
+    page->flags = flags;
+    page->update_ns = realtime_ns();
+
+    atomic_store_explicit(&page->seq, seq + 2, memory_order_release);
+}
+
+static void *stats_publisher_main(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_stats.lock);
+    while (!g_stats.stop) {
+        stats_publish();
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += g_stats.interval_ms / 1000;
+        deadline.tv_nsec += (g_stats.interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&g_stats.cond, &g_stats.lock, &deadline);
+    }
+    pthread_mutex_unlock(&g_stats.lock);
+
+    return NULL;
+}
+
+/* Create <dir>/<pid> (or <dir>/<container>-<pid>), map it and start the
+ * publisher thread */
+static bool stats_start(void) {
+    if (mkdir(g_stats.dir, 0755) != 0 && errno != EEXIST) {
+        HCS_LOG(LOG_WARN, "Cannot create stats directory %s, stats page disabled", g_stats.dir);
+        return false;
+    }
+
+    const char *container = getenv("HCS_CONTAINER_NAME");
+    if (container && *container) {
+        snprintf(g_stats.filename, sizeof(g_stats.filename), "%s/%s-%d",
+                 g_stats.dir, container, (int)getpid());
+    } else {
+        snprintf(g_stats.filename, sizeof(g_stats.filename), "%s/%d",
+                 g_stats.dir, (int)getpid());
+    }
+
+    int fd = open(g_stats.filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        HCS_LOG(LOG_WARN, "Cannot open stats page %s, stats page disabled", g_stats.filename);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(stats_page_t)) != 0) {
+        close(fd);
+        unlink(g_stats.filename);
+        HCS_LOG(LOG_WARN, "Cannot size stats page %s, stats page disabled", g_stats.filename);
+        return false;
+    }
+    void *addr = mmap(NULL, sizeof(stats_page_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        unlink(g_stats.filename);
+        HCS_LOG(LOG_WARN, "Cannot map stats page %s, stats page disabled", g_stats.filename);
+        return false;
+    }
+
+    /* Static fields are written once, before the first update makes seq
+     * non-zero; readers ignore a page whose seq is still 0 */
+    stats_page_t *page = addr;
+    page->version = STATS_VERSION;
+    page->size = sizeof(stats_page_t);
+    page->device_count = MAX_DEVICES;
+    page->pid = (int32_t)getpid();
+    page->start_ns = realtime_ns();
+    page->flags = g_pool.pool ? STATS_FLAG_POOLED : 0;
+    stats_copy_env(page->pod_uid, sizeof(page->pod_uid), "HCS_POD_UID");
+    stats_copy_env(page->pod_namespace, sizeof(page->pod_namespace), "HCS_POD_NAMESPACE");
+    stats_copy_env(page->pod_name, sizeof(page->pod_name), "HCS_POD_NAME");
+    stats_copy_env(page->container_name, sizeof(page->container_name), "HCS_CONTAINER_NAME");
+
+    static const char *const visible_vars[] = {
+        "CUDA_VISIBLE_DEVICES", "NVIDIA_VISIBLE_DEVICES", "HIP_VISIBLE_DEVICES",
+        "ASCEND_RT_VISIBLE_DEVICES", "ASCEND_VISIBLE_DEVICES"
+    };
+    for (size_t i = 0; i < sizeof(visible_vars) / sizeof(visible_vars[0]); i++) {
+        const char *value = getenv(visible_vars[i]);
+        if (value && *value) {
+            snprintf(page->visible_devices, sizeof(page->visible_devices), "%s", value);
+            break;
+        }
+    }
+    page->magic = STATS_MAGIC;
+
+    g_stats.page = page;
+    g_stats.stop = false;
+    if (pthread_create(&g_stats.thread, NULL, stats_publisher_main, NULL) != 0) {
+        munmap(page, sizeof(stats_page_t));
+        unlink(g_stats.filename);
+        g_stats.page = NULL;
+        HCS_LOG(LOG_WARN, "Cannot start stats publisher thread, stats page disabled");
+        return false;
+    }
+
+    HCS_LOG(LOG_INFO, "Publishing stats to %s every %ld ms", g_stats.filename, g_stats.interval_ms);
+    return true;
+}
+
+/* The child inherits the parent's mapping but not its publisher thread:
+ * drop the mapping without unlinking it and publish under the child's pid */
+static void stats_atfork_child(void) {
+    if (!g_stats.enabled) return;
+
+    pthread_mutex_init(&g_stats.lock, NULL);
+    pthread_cond_init(&g_stats.cond, NULL);
+
+    munmap(g_stats.page, sizeof(stats_page_t));
+    g_stats.page = NULL;
+    g_stats.enabled = stats_start();
+}
+
+static void stats_init(const char *dir) {
+    if (!dir || !*dir) return;
+    if (strlen(dir) >= sizeof(g_stats.dir)) {
+        HCS_LOG(LOG_WARN, "HCS_STATS_DIR path too long, stats page disabled");
+        return;
+    }
+    strcpy(g_stats.dir, dir);
+
+    g_stats.interval_ms = STATS_DEFAULT_INTERVAL_MS;
+    const char *interval = getenv("HCS_STATS_INTERVAL_MS");
+    if (interval && *interval) {
+        char *end;
+        long ms = strtol(interval, &end, 10);
+        if (*end == '\0' && ms > 0) {
+            g_stats.interval_ms = ms;
+        } else {
+            HCS_LOG(LOG_WARN, "Invalid HCS_STATS_INTERVAL_MS \"%s\", using %d",
+                    interval, STATS_DEFAULT_INTERVAL_MS);
+        }
+    }
+
+    if (!stats_start()) return;
+
+    pthread_atfork(NULL, NULL, stats_atfork_child);
+    g_stats.enabled = true;
+}
+
+/* Stop the publisher and remove the page; a page left behind by a crashed
+ * process goes stale and is collected by the reader */
+static void stats_shutdown(void) {
+    if (!g_stats.enabled) return;
+    g_stats.enabled = false;
+
+    pthread_mutex_lock(&g_stats.lock);
+    g_stats.stop = true;
+    pthread_cond_signal(&g_stats.cond);
+    pthread_mutex_unlock(&g_stats.lock);
+    pthread_join(g_stats.thread, NULL);
+
+    unlink(g_stats.filename);
+    munmap(g_stats.page, sizeof(stats_page_t));
+    g_stats.page = NULL;
+}
+
+/* ============================================================================
+ * Initialization
+ * ============================================================================ */
+
+/* Find the next definition of symbol after this library. A runtime that
+ * was dlopen()ed RTLD_LOCAL is outside the scope RTLD_NEXT searches, so its
+ * libraries are also looked up by soname if already loaded. Sonames double
+ * as symbol version names (cudaMalloc@@libcudart.so.12), and that version
+ * is preferred over whatever the library's default happens to be. */
+static void *resolve_symbol(const char *symbol, const char *const *libs) {
+    void *fn = dlsym(RTLD_NEXT, symbol);
+    if (fn) return fn;
+
+    for (int i = 0; libs[i]; i++) {
+        void *handle = dlopen(libs[i], RTLD_LAZY | RTLD_NOLOAD);
+        if (!handle) continue;
+
+        fn = dlvsym(handle, symbol, libs[i]);
+        if (!fn) fn = dlsym(handle, symbol);
+        dlclose(handle);  /* Drop the reference NOLOAD took; the library stays */
+        if (fn) return fn;
+    }
+
+    return NULL;
+}
+
+#define HCS_DEFINE_STUB(name, symbol, libs, fail, level, params, args) \
+    static int stub_##name params { \
+        name##_fn fn = (name##_fn)resolve_symbol(symbol, libs); \
+        if (!fn) { \
+            HCS_LOG(level, "Failed to find real %s", symbol); \
+            return fail; \
+        } \
+        atomic_store_explicit(&real_##name, fn, memory_order_release); \
+        return fn args; \
+    }
+HCS_REAL_FUNCTIONS(HCS_DEFINE_STUB)
+#undef HCS_DEFINE_STUB
+
+/* Resolve every real function the runtime libraries loaded so far provide.
+ * The rest keep their stubs and resolve on first use. */
+static void load_real_functions(void) {
+#define HCS_LOAD_REAL(name, symbol, libs, fail, level, params, args) \
+    { \
+        void *fn = resolve_symbol(symbol, libs); \
+        if (fn) atomic_store_explicit(&real_##name, (name##_fn)fn, memory_order_release); \
+    }
+    HCS_REAL_FUNCTIONS(HCS_LOAD_REAL)
+#undef HCS_LOAD_REAL
+}
+
+static void hcs_init_once(void) {
+    /* Parse log level */
+    g_ctx.log_level = parse_log_level(getenv("HCS_LOG_LEVEL"));
+
+    /* Parse quota */
+    size_t limits[MAX_DEVICES];
+    const char *quota_str = getenv("HCS_VRAM_QUOTA");
+    bool parsed = quota_str && *quota_str && parse_quota_spec(quota_str, QUOTA_UNLIMITED, limits);
+    if (!parsed) {
+        if (quota_str && *quota_str) {
+            HCS_LOG(LOG_WARN, "Invalid HCS_VRAM_QUOTA \"%s\", using default", quota_str);
+        }
+        /* Default: 4 GiB per device */
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            limits[i] = (size_t)DEFAULT_QUOTA_GB * 1024 * 1024 * 1024;
+        }
+    }
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        g_ctx.devices[i].quota_limit = limits[i];
+    }
+
+    /* Optional quota shared with other processes */
+    pool_init(getenv("HCS_QUOTA_POOL"), limits);
+
+    /* Optional pressure watermark, relative to the limits actually enforced */
+    const char *soft_str = getenv("HCS_VRAM_SOFT_LIMIT");
+    if (soft_str && *soft_str) {
+        size_t enforced[MAX_DEVICES], soft[MAX_DEVICES];
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            enforced[i] = g_ctx.devices[i].quota_limit;
+        }
+        if (parse_soft_limit_spec(soft_str, enforced, soft)) {
+            for (int i = 0; i < MAX_DEVICES; i++) {
+                g_ctx.devices[i].soft_limit = soft[i];
+            }
+        } else {
+            HCS_LOG(LOG_WARN, "Invalid HCS_VRAM_SOFT_LIMIT \"%s\", pressure signalling disabled",
+                    soft_str);
+        }
+    }
+
+    /* Optional managed memory oversubscription */
+    const char *managed_str = getenv("HCS_MANAGED_OVERSUBSCRIBE");
+    if (managed_str && *managed_str) {
+        char *endptr;
+        double factor = strtod(managed_str, &endptr);
+        if (endptr != managed_str && *endptr == '\0' && factor >= 1) {
+            g_ctx.managed_oversubscribe = factor;
+        } else {
+            HCS_LOG(LOG_WARN, "Invalid HCS_MANAGED_OVERSUBSCRIBE \"%s\", managed memory is charged to the quota",
+                    managed_str);
+        }
+    }
+
+    /* Optional caching sub-allocator for small requests */
+    slab_init(getenv("HCS_POOL"));
+
+    /* Load real CUDA functions */
+    load_real_functions();
+
+    /* Optional binary allocation trace */
+    trace_init(getenv("HCS_TRACE_FILE"));
+
+    atomic_store_explicit(&g_ctx.initialized, true, memory_order_release);
+
+    /* Optional shared stats page, started last so it never reads a
+     * half-initialized quota context */
+    stats_init(getenv("HCS_STATS_DIR"));
+
+    if (HCS_LOG_ENABLED(LOG_INFO)) {
+        char quota_buf[32] = "unlimited";
+        if (g_ctx.devices[0].quota_limit != QUOTA_UNLIMITED) {
+            format_size(g_ctx.devices[0].quota_limit, quota_buf, sizeof(quota_buf));
+        }
+        HCS_LOG(LOG_INFO, "HCS Interceptor v%s initialized, quota=%s (device 0), spec=%s",
+                HCS_VERSION, quota_buf, parsed ? quota_str : "default");
+    }
+
+    if (HCS_REAL(cudaMalloc) == stub_cudaMalloc) {
+        HCS_LOG(LOG_WARN, "cudaMalloc not found - CUDA library may not be loaded yet");
+    }
+}
+
+/* Runs from the constructor, or from the first hook called before it (for
+ * example by another library's constructor). pthread_once makes concurrent
+ * first calls wait for one initialization. */
+__attribute__((constructor))
+static void hcs_init(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, hcs_init_once);
+}
+
+__attribute__((destructor))
+static void hcs_cleanup(void) {
+    if (!atomic_load_explicit(&g_ctx.initialized, memory_order_acquire)) return;
+
+    stats_shutdown();
+    trace_shutdown();
+    pool_shutdown();
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        device_quota_t *dq = &g_ctx.devices[i];
+        uint64_t allocs = atomic_load_explicit(&dq->total_allocs, memory_order_relaxed);
+        uint64_t failed = atomic_load_explicit(&dq->failed_allocs, memory_order_relaxed);
+        if (allocs == 0 && failed == 0) continue;
+
+        if (HCS_LOG_ENABLED(LOG_INFO)) {
+            char used_buf[32], peak_buf[32], limit_buf[32];
+            format_size(quota_used_now(dq), used_buf, sizeof(used_buf));
+            format_size(atomic_load_explicit(&dq->peak_usage, memory_order_relaxed),
+                        peak_buf, sizeof(peak_buf));
+            format_size(dq->quota_limit, limit_buf, sizeof(limit_buf));
+
+            HCS_LOG(LOG_INFO, "HCS Interceptor device %d: allocs=%" PRIu64 ", frees=%" PRIu64 ", failed=%" PRIu64 ", peak=%s, final=%s, limit=%s",
+                    i, allocs, atomic_load_explicit(&dq->total_frees, memory_order_relaxed),
+                    failed, peak_buf, used_buf, limit_buf);
+        }
+    }
+
+    uint64_t allocs, frees, failed;
+    hcs_get_stats(&allocs, &frees, &failed);
+
+    HCS_LOG(LOG_INFO, "HCS Interceptor shutdown: allocs=%" PRIu64 ", frees=%" PRIu64 ", failed=%" PRIu64,
+            allocs, frees, failed);
+}
+
+/* ============================================================================
+ * Shared Allocation Paths
+ * ============================================================================ */
+
+/* The allocation hooks differ only in the real call and its error codes,
+ * so they share the quota steps below. */
+
+/* Reserve size on device ahead of the real call. A denial is counted, logged
+ * and traced with err as its result. */
+static bool hook_reserve(const char *api, uint16_t op, int device, size_t size, int err) {
+    device_quota_t *dq = device_quota(device);
+    if (quota_reserve(dq, size)) return true;
+
+    stat_inc(&dq->failed_allocs);
+
+    if (HCS_LOG_ENABLED(LOG_WARN)) {
+        char req_buf[32], used_buf[32], limit_buf[32];
+        format_size(size, req_buf, sizeof(req_buf));
+        format_size(quota_used_now(dq), used_buf, sizeof(used_buf));
+        format_size(dq->quota_limit, limit_buf, sizeof(limit_buf));
+
+        HCS_LOG(LOG_WARN, "%s DENIED: device=%d, requested=%s, used=%s, limit=%s",
+                api, device, req_buf, used_buf, limit_buf);
+    }
+
+    HCS_TRACE(op | TRACE_OP_DENIED, NULL, size, err, device);
+    return false;
+}
+
+/* Finish an allocation reserved by hook_reserve. A NULL key means the real
+ * call failed and rolls the reservation back; otherwise key is tracked so
+ * the matching free credits the same device. */
+static void hook_commit(const char *api, uint16_t op, int device, size_t size, int result, void *key) {
+    device_quota_t *dq = device_quota(device);
+
+    if (!key) {
+        quota_release(dq, size);
+        HCS_TRACE(op, NULL, size, result, device);
+        return;
+    }
+
+    stat_inc(&dq->total_allocs);
+
+    if (!add_allocation(key, size, device, 0)) {
+        HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
+    }
+
+    HCS_TRACE(op, key, size, result, device);
+
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char size_buf[32], used_buf[32];
+        format_size(size, size_buf, sizeof(size_buf));
+        format_size(quota_used_now(dq), used_buf, sizeof(used_buf));
+        HCS_LOG(LOG_DEBUG, "%s: device=%d, size=%s, ptr=%p, total_used=%s",
+                api, device, size_buf, key, used_buf);
+    }
+}
+
+/* Stop tracking key and credit the device it was charged to. Returns the
+ * size released, 0 for keys that were never tracked. *cached is set for a
+ * sub-allocator block, which goes back to its chunk: the caller must not
+ * pass it to the runtime. */
+static size_t hook_release(const char *api, void *key, int *device, bool *cached) {
+    int32_t chunk = 0;
+    *device = -1;
+    size_t size = remove_allocation(key, device, &chunk);
+    *cached = chunk > 0;
+
+    if (chunk > 0) {
+        slab_free(chunk, key);
+        stat_inc(&device_quota(*device)->total_frees);
+        HCS_LOG(LOG_DEBUG, "%s: device=%d, ptr=%p (cached)", api, *device, key);
+    } else if (size > 0) {
+        device_quota_t *dq = device_quota(*device);
+        if (chunk == ALLOC_CHUNK_MANAGED) {
+            managed_release(dq, size);
+        } else {
+            quota_release(dq, size);
+        }
+        stat_inc(&dq->total_frees);
+
+        if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+            char size_buf[32], used_buf[32];
+            format_size(size, size_buf, sizeof(size_buf));
+            format_size(quota_used_now(dq), used_buf, sizeof(used_buf));
+            HCS_LOG(LOG_DEBUG, "%s: device=%d, size=%s, ptr=%p, total_used=%s",
+                    api, *device, size_buf, key, used_buf);
+        }
+    } else {
+        HCS_LOG(LOG_DEBUG, "%s: ptr=%p (not tracked)", api, key);
+    }
+
+    return size;
+}
+
+/* Device of the calling thread's current context, for driver calls that do
+ * not name one. Without a driver to ask, the runtime's current device. */
+static int driver_current_device(void) {
+    int device;
+    if (HCS_REAL(cuCtxGetDevice)(&device) == CUDA_SUCCESS) {
+        return device;
+    }
+    return t_current_device;
+}
+
+/* Allocation table key for a VMM handle */
+static inline void *vmm_handle_key(CUmemGenericAllocationHandle handle) {
+    return (void *)(uintptr_t)(handle | VMM_HANDLE_TAG);
+}
+
+/* ============================================================================
+ * Caching Sub-Allocator
+ * ============================================================================
+ *
+ * With HCS_POOL=on, cudaMalloc, hipMalloc and aclrtMalloc requests of up to
+ * 1 MiB are served from 2 MiB chunks taken from the real allocator, so an
+ * application that allocates every small tensor separately stops paying a
+ * runtime round trip per call. Each chunk holds blocks of one power-of-two
+ * size class and a bitmap of the free ones. Quota is charged per chunk when
+ * it is taken from the runtime, so reported usage includes cached blocks.
+ *
+ * Blocks are tracked in the allocation table like any other allocation,
+ * with their chunk recorded in the entry, so every free hook recognises
+ * them. A freed block goes straight back to its chunk; fully free chunks
+ * stay cached until an allocation is denied, which hands them back to the
+ * runtime and retries.
+ *
+ * A block freed by cudaFree is reused without the device synchronization
+ * the real cudaFree implies. The mode is opt-in for that reason. */
+
+/* Size class serving size, or -1 when the request is not sub-allocated */
+static inline int slab_class_index(size_t size) {
+    if (size == 0 || size > (1UL << SLAB_MAX_SHIFT)) return -1;
+    if (size <= (1UL << SLAB_MIN_SHIFT)) return 0;
+    return (64 - __builtin_clzll((unsigned long long)(size - 1))) - SLAB_MIN_SHIFT;
+}
+
+static int slab_runtime_alloc(int backend, void **ptr) {
+    switch (backend) {
+    case SLAB_HIP:
+        return HCS_REAL(hipMalloc)(ptr, SLAB_CHUNK_SIZE);
+    case SLAB_ACL:
+        return HCS_REAL(aclrtMalloc)(ptr, SLAB_CHUNK_SIZE, ACL_MEM_MALLOC_HUGE_FIRST);
+    default: {
+        t_in_runtime++;
+        int result = HCS_REAL(cudaMalloc)(ptr, SLAB_CHUNK_SIZE);
+        t_in_runtime--;
+        return result;
+    }
+    }
+}
+
+static void slab_runtime_free(int backend, void *ptr) {
+    switch (backend) {
+    case SLAB_HIP:
+        HCS_REAL(hipFree)(ptr);
+        break;
+    case SLAB_ACL:
+        HCS_REAL(aclrtFree)(ptr);
+        break;
+    default:
+        HCS_REAL(cudaFree)(ptr);
+        break;
+    }
+}
+
+/* Claim a chunk slot; returns index + 1, or 0 when all are in use */
+static int32_t slab_chunk_claim(void) {
+    int32_t idx = 0;
+
+    pthread_mutex_lock(&g_slab.chunk_lock);
+    if (g_slab.chunk_free != 0) {
+        idx = g_slab.chunk_free;
+        g_slab.chunk_free = g_slab.chunks[idx - 1].next;
+    } else if (g_slab.chunk_count < SLAB_MAX_CHUNKS) {
+        idx = ++g_slab.chunk_count;
+    }
+    pthread_mutex_unlock(&g_slab.chunk_lock);
+
+    return idx;
+}
+
+static void slab_chunk_unclaim(int32_t idx) {
+    pthread_mutex_lock(&g_slab.chunk_lock);
+    g_slab.chunks[idx - 1].next = g_slab.chunk_free;
+    g_slab.chunk_free = idx;
+    pthread_mutex_unlock(&g_slab.chunk_lock);
+}
+
+/* Take the lowest free block of a chunk (must hold its class lock and the
+ * chunk must have a free block) */
+static void *slab_chunk_take(slab_chunk_t *c) {
+    int w = 0;
+    while (c->free_map[w] == 0) {
+        w++;
+    }
+    int bit = __builtin_ctzll(c->free_map[w]);
+    c->free_map[w] &= c->free_map[w] - 1;
+    c->free_blocks--;
+
+    size_t block = (size_t)w * 64 + (size_t)bit;
+    return (char *)c->base + (block << (SLAB_MIN_SHIFT + c->size_class));
+}
+
+/* Take a new chunk of class sc from the runtime, charging it to the quota,
+ * and hand out its first block. Returns 0, the failed runtime result
+ * (already traced), or -1 when no chunk slot is free or the chunk does not
+ * fit the quota. A request that fits but its chunk does not then goes to
+ * the runtime directly, where it is charged, and denied, at its own size. */
+static int slab_grow(int backend, int device, int sc, const char *api, uint16_t op,
+                     int err, int32_t *chunk, void **block) {
+    device_quota_t *dq = device_quota(device);
+
+    int32_t idx = slab_chunk_claim();
+    if (idx == 0) {
+        return -1;
+    }
+
+    if (!quota_try_reserve(dq, SLAB_CHUNK_SIZE)) {
+        slab_chunk_unclaim(idx);
+        return -1;
+    }
+    pressure_raise(dq);
+
+    void *base = NULL;
+    int result = slab_runtime_alloc(backend, &base);
+    if (result != 0 || !base) {
+        quota_release(dq, SLAB_CHUNK_SIZE);
+        slab_chunk_unclaim(idx);
+        result = result != 0 ? result : err;
+        HCS_TRACE(op, NULL, SLAB_CHUNK_SIZE, result, device);
+        return result;
+    }
+
+    slab_chunk_t *c = &g_slab.chunks[idx - 1];
+    c->base = base;
+    c->device = (int16_t)device;
+    c->backend = (uint8_t)backend;
+    c->size_class = (uint8_t)sc;
+    c->block_count = (uint16_t)(SLAB_CHUNK_SIZE >> (SLAB_MIN_SHIFT + sc));
+    memset(c->free_map, 0, sizeof(c->free_map));
+    for (int b = 0; b < c->block_count; b += 64) {
+        int n = c->block_count - b;
+        c->free_map[b / 64] = n >= 64 ? ~0ULL : (1ULL << n) - 1;
+    }
+    c->free_blocks = c->block_count;
+    *block = slab_chunk_take(c);
+    *chunk = idx;
+
+    /* Publish the rest of the chunk to other threads */
+    slab_class_t *cls = &g_slab.classes[backend][device][sc];
+    pthread_mutex_lock(&cls->lock);
+    c->listed = c->free_blocks > 0;
+    if (c->listed) {
+        c->next = cls->partial;
+        cls->partial = idx;
+    }
+    pthread_mutex_unlock(&cls->lock);
+
+    HCS_LOG(LOG_DEBUG, "%s: new %lu KiB chunk for %lu B blocks, device=%d, base=%p",
+            api, SLAB_CHUNK_SIZE >> 10, 1UL << (SLAB_MIN_SHIFT + sc), device, base);
+    return 0;
+}
+
+/* Serve an allocation from the sub-allocator. Returns false when the
+ * request is not sub-allocated and must go to the runtime directly;
+ * otherwise *result holds the code to hand back. */
+static bool slab_malloc(int backend, int device, size_t size, void **ptr,
+                        const char *api, uint16_t op, int err, int *result) {
+    if (!g_slab.enabled || !ptr) return false;
+
+    int sc = slab_class_index(size);
+    if (sc < 0 || device < 0 || device >= MAX_DEVICES) return false;
+
+    slab_class_t *cls = &g_slab.classes[backend][device][sc];
+    int32_t idx = 0;
+    void *block = NULL;
+
+    pthread_mutex_lock(&cls->lock);
+    if (cls->partial != 0) {
+        idx = cls->partial;
+        slab_chunk_t *c = &g_slab.chunks[idx - 1];
+        block = slab_chunk_take(c);
+        if (c->free_blocks == 0) {
+            cls->partial = c->next;
+            c->listed = false;
+        }
+    }
+    pthread_mutex_unlock(&cls->lock);
+
+    if (!block) {
+        int grown = slab_grow(backend, device, sc, api, op, err, &idx, &block);
+        if (grown == -1) {
+            return false;
+        }
+        if (grown != 0) {
+            *result = grown;
+            return true;
+        }
+    }
+
+    /* An untracked block would reach the runtime's free as an interior
+     * pointer, so a full table sends the request to the runtime instead */
+    if (!add_allocation(block, size, device, idx)) {
+        slab_free(idx, block);
+        HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
+        return false;
+    }
+
+    device_quota_t *dq = device_quota(device);
+    stat_inc(&dq->total_allocs);
+
+    *ptr = block;
+    *result = 0;
+    HCS_TRACE(op, block, size, 0, device);
+
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char size_buf[32], used_buf[32];
+        format_size(size, size_buf, sizeof(size_buf));
+        format_size(quota_used_now(dq), used_buf, sizeof(used_buf));
+        HCS_LOG(LOG_DEBUG, "%s: device=%d, size=%s, ptr=%p, total_used=%s (cached)",
+                api, device, size_buf, block, used_buf);
+    }
+
+    return true;
+}
+
+/* Return a block to its chunk. The chunk stays charged and cached. */
+static void slab_free(int32_t chunk, void *ptr) {
+    slab_chunk_t *c = &g_slab.chunks[chunk - 1];
+    slab_class_t *cls = &g_slab.classes[c->backend][c->device][c->size_class];
+    size_t block = ((uintptr_t)ptr - (uintptr_t)c->base) >> (SLAB_MIN_SHIFT + c->size_class);
+
+    pthread_mutex_lock(&cls->lock);
+    c->free_map[block / 64] |= 1ULL << (block % 64);
+    c->free_blocks++;
+    if (!c->listed) {
+        c->next = cls->partial;
+        cls->partial = chunk;
+        c->listed = true;
+    }
+    pthread_mutex_unlock(&cls->lock);
+}
+
+/* Hand every fully free chunk of a device back to the runtime and credit
+ * its quota. Returns the bytes released. */
+static size_t slab_trim(int device) {
+    if (!g_slab.enabled || device < 0 || device >= MAX_DEVICES) return 0;
+
+    size_t released = 0;
+    for (int backend = 0; backend < SLAB_BACKENDS; backend++) {
+        for (int sc = 0; sc < SLAB_CLASSES; sc++) {
+            slab_class_t *cls = &g_slab.classes[backend][device][sc];
+            int32_t empty = 0;
+
+            /* Unlink empty chunks under the lock; nothing can free into
+             * them, since none of their blocks is handed out */
+            pthread_mutex_lock(&cls->lock);
+            int32_t *link = &cls->partial;
+            while (*link != 0) {
+                int32_t idx = *link;
+                slab_chunk_t *c = &g_slab.chunks[idx - 1];
+                if (c->free_blocks == c->block_count) {
+                    *link = c->next;
+                    c->listed = false;
+                    c->next = empty;
+                    empty = idx;
+                } else {
+                    link = &c->next;
+                }
+            }
+            pthread_mutex_unlock(&cls->lock);
+
+            while (empty != 0) {
+                slab_chunk_t *c = &g_slab.chunks[empty - 1];
+                int32_t next = c->next;
+                slab_runtime_free(backend, c->base);
+                quota_release(device_quota(device), SLAB_CHUNK_SIZE);
+                released += SLAB_CHUNK_SIZE;
+                slab_chunk_unclaim(empty);
+                empty = next;
+            }
+        }
+    }
+
+    if (released > 0 && HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char released_buf[32];
+        format_size(released, released_buf, sizeof(released_buf));
+        HCS_LOG(LOG_DEBUG, "Trimmed %s of cached chunks on device %d", released_buf, device);
+    }
+
+    return released;
+}
+
+/* Forget all chunks (forked child: they belong to the parent) */
+static void slab_reset(void) {
+    pthread_mutex_init(&g_slab.chunk_lock, NULL);
+    g_slab.chunk_free = 0;
+    g_slab.chunk_count = 0;
+    for (int b = 0; b < SLAB_BACKENDS; b++) {
+        for (int d = 0; d < MAX_DEVICES; d++) {
+            for (int sc = 0; sc < SLAB_CLASSES; sc++) {
+                pthread_mutex_init(&g_slab.classes[b][d][sc].lock, NULL);
+                g_slab.classes[b][d][sc].partial = 0;
+            }
+        }
+    }
+}
+
+static void slab_init(const char *mode) {
+    if (!mode || (strcasecmp(mode, "on") != 0 && strcasecmp(mode, "true") != 0 &&
+                  strcmp(mode, "1") != 0)) {
+        return;
+    }
+
+    slab_reset();
+    g_slab.enabled = true;
+    HCS_LOG(LOG_INFO, "Caching sub-allocator enabled: %lu MiB chunks, blocks up to %lu KiB",
+            SLAB_CHUNK_SIZE >> 20, (1UL << SLAB_MAX_SHIFT) >> 10);
+}
+
+/* ============================================================================
+ * CUDA API Interception
+ * ============================================================================ */
+
+/* cudaMalloc interception */
+int cudaMalloc(void **devPtr, size_t size) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Small requests come from the caching sub-allocator when enabled */
+    int device = t_current_device;
+    int result;
+    if (slab_malloc(SLAB_CUDA, device, size, devPtr, "cudaMalloc", TRACE_OP_CUDA_MALLOC,
+                    cudaErrorMemoryAllocation, &result)) {
+        return result;
+    }
+
+    if (!hook_reserve("cudaMalloc", TRACE_OP_CUDA_MALLOC, device, size, cudaErrorMemoryAllocation)) {
+        return cudaErrorMemoryAllocation;
+    }
+
+    t_in_runtime++;
+    result = HCS_REAL(cudaMalloc)(devPtr, size);
+    t_in_runtime--;
+    hook_commit("cudaMalloc", TRACE_OP_CUDA_MALLOC, device, size, result,
+                (result == cudaSuccess && devPtr) ? *devPtr : NULL);
+    return result;
+}
+
+/* cudaFree interception */
+int cudaFree(void *devPtr) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* NULL pointer is valid for cudaFree */
+    if (!devPtr) {
+        return HCS_REAL(cudaFree)(devPtr);
+    }
+
+    /* Find and remove allocation; credit the device it was charged to */
+    int device;
+    bool cached;
+    size_t size = hook_release("cudaFree", devPtr, &device, &cached);
+
+    int result = cached ? cudaSuccess : HCS_REAL(cudaFree)(devPtr);
+    HCS_TRACE(TRACE_OP_CUDA_FREE, devPtr, size, result, device);
+    return result;
+}
+
+/* cudaMemGetInfo interception - return virtualized memory info */
+int cudaMemGetInfo(size_t *free, size_t *total) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
     /* Get real memory info first to check for errors */
-    int result = real_aclrtGetMemInfo(attr, free, total);
-    if (result != ACL_SUCCESS) {
+    int result = HCS_REAL(cudaMemGetInfo)(free, total);
+    if (result != cudaSuccess) {
+        return result;
+    }
+
+    /* Return virtualized values for the current device */
+    device_quota_t *dq = device_quota(t_current_device);
+    quota_mem_info(dq, free, total);
+
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char free_buf[32], total_buf[32];
+        format_size(*free, free_buf, sizeof(free_buf));
+        format_size(*total, total_buf, sizeof(total_buf));
+        HCS_LOG(LOG_DEBUG, "cudaMemGetInfo: free=%s, total=%s (virtualized)",
+                free_buf, total_buf);
+    }
+
+    return cudaSuccess;
+}
+
+/* cudaMallocManaged interception */
+int cudaMallocManaged(void **devPtr, size_t size, unsigned int flags) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Reserve quota up front; rolled back below if the real call fails */
+    int device = t_current_device;
+    device_quota_t *dq = device_quota(device);
+    if (!managed_reserve(dq, size)) {
+        stat_inc(&dq->failed_allocs);
+
+        if (HCS_LOG_ENABLED(LOG_WARN)) {
+            char req_buf[32], used_buf[32], managed_buf[32], limit_buf[32];
+            format_size(size, req_buf, sizeof(req_buf));
+            format_size(quota_used_now(dq), used_buf, sizeof(used_buf));
+            format_size(atomic_load_explicit(&dq->managed_used, memory_order_relaxed),
+                        managed_buf, sizeof(managed_buf));
+            format_size(dq->quota_limit, limit_buf, sizeof(limit_buf));
+
+            HCS_LOG(LOG_WARN, "cudaMallocManaged DENIED: device=%d, requested=%s, used=%s, managed=%s, limit=%s",
+                    device, req_buf, used_buf, managed_buf, limit_buf);
+        }
+
+        HCS_TRACE(TRACE_OP_CUDA_MALLOC_MANAGED | TRACE_OP_DENIED, NULL, size, cudaErrorMemoryAllocation, device);
+        return cudaErrorMemoryAllocation;
+    }
+
+    /* Call real cudaMallocManaged */
+    t_in_runtime++;
+    int result = HCS_REAL(cudaMallocManaged)(devPtr, size, flags);
+    t_in_runtime--;
+
+    if (result != cudaSuccess || !devPtr || !*devPtr) {
+        managed_release(dq, size);
+        HCS_TRACE(TRACE_OP_CUDA_MALLOC_MANAGED, NULL, size, result, device);
         return result;
     }
 
-    /* Return virtualized values */
-    pthread_mutex_lock(&g_ctx.lock);
+    stat_inc(&dq->total_allocs);
+
+    /* Track allocation; the free credits it back as managed memory */
+    if (!add_allocation(*devPtr, size, device, ALLOC_CHUNK_MANAGED)) {
+        HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
+    }
+
+    HCS_TRACE(TRACE_OP_CUDA_MALLOC_MANAGED, *devPtr, size, result, device);
+
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char size_buf[32];
+        format_size(size, size_buf, sizeof(size_buf));
+        HCS_LOG(LOG_DEBUG, "cudaMallocManaged: size=%s, ptr=%p", size_buf, *devPtr);
+    }
+
+    return result;
+}
+
+/* cudaMallocAsync interception - stream-ordered allocation from the device's
+ * default pool. Quota follows live allocations, so memory the pool keeps
+ * cached after cudaFreeAsync (and hands back on cudaMemPoolTrimTo) is never
+ * charged. */
+int cudaMallocAsync(void **devPtr, size_t size, void *stream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
-    *total = g_ctx.quota_limit;
-    *free = (g_ctx.quota_limit > g_ctx.quota_used) ?
-            (g_ctx.quota_limit - g_ctx.quota_used) : 0;
+    int device = t_current_device;
+    if (!hook_reserve("cudaMallocAsync", TRACE_OP_CUDA_MALLOC_ASYNC, device, size,
+                      cudaErrorMemoryAllocation)) {
+        return cudaErrorMemoryAllocation;
+    }
 
-    char free_buf[32], total_buf[32];
-    format_size(*free, free_buf, sizeof(free_buf));
-    format_size(*total, total_buf, sizeof(total_buf));
-    HCS_LOG(LOG_DEBUG, "aclrtGetMemInfo: free=%s, total=%s (virtualized)",
-            free_buf, total_buf);
+    t_in_runtime++;
+    int result = HCS_REAL(cudaMallocAsync)(devPtr, size, stream);
+    t_in_runtime--;
+    hook_commit("cudaMallocAsync", TRACE_OP_CUDA_MALLOC_ASYNC, device, size, result,
+                (result == cudaSuccess && devPtr) ? *devPtr : NULL);
+    return result;
+}
 
-    pthread_mutex_unlock(&g_ctx.lock);
+/* cudaMallocFromPoolAsync interception - charged to the current device like
+ * cudaMallocAsync */
+int cudaMallocFromPoolAsync(void **devPtr, size_t size, void *memPool, void *stream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
-    return ACL_SUCCESS;
+    int device = t_current_device;
+    if (!hook_reserve("cudaMallocFromPoolAsync", TRACE_OP_CUDA_MALLOC_ASYNC, device, size,
+                      cudaErrorMemoryAllocation)) {
+        return cudaErrorMemoryAllocation;
+    }
+
+    t_in_runtime++;
+    int result = HCS_REAL(cudaMallocFromPoolAsync)(devPtr, size, memPool, stream);
+    t_in_runtime--;
+    hook_commit("cudaMallocFromPoolAsync", TRACE_OP_CUDA_MALLOC_ASYNC, device, size, result,
+                (result == cudaSuccess && devPtr) ? *devPtr : NULL);
+    return result;
+}
+
+/* cudaFreeAsync interception - credited when the free is enqueued, since no
+ * later allocation can be handed the memory before the stream reaches it */
+int cudaFreeAsync(void *devPtr, void *stream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    if (!devPtr) {
+        return HCS_REAL(cudaFreeAsync)(devPtr, stream);
+    }
+
+    int device;
+    bool cached;
+    size_t size = hook_release("cudaFreeAsync", devPtr, &device, &cached);
+
+    int result = cached ? cudaSuccess : HCS_REAL(cudaFreeAsync)(devPtr, stream);
+    HCS_TRACE(TRACE_OP_CUDA_FREE_ASYNC, devPtr, size, result, device);
+    return result;
+}
+
+/* cudaSetDevice interception - remember the thread's current device */
+int cudaSetDevice(int device) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    int result = HCS_REAL(cudaSetDevice)(device);
+    if (result == cudaSuccess) {
+        t_current_device = (int)device;
+        HCS_LOG(LOG_DEBUG, "cudaSetDevice: device=%d", t_current_device);
+    }
+
+    return result;
 }
 
 /* ============================================================================
- * HIP API Interception (海光/AMD)
+ * CUDA Driver API Interception
  * ============================================================================ */
 
-/* hipMalloc interception */
-int hipMalloc(void **devPtr, size_t size) {
+/* cuda.h #defines cuMemAlloc, cuMemFree and cuMemGetInfo to their _v2
+ * entry points, so those are the symbols applications link against. Should
+ * the runtime's own allocations reach these hooks, t_in_runtime lets them
+ * through uncharged, since the runtime hook already charged them. */
+
+/* cuMemAlloc interception */
+int cuMemAlloc_v2(CUdeviceptr *dptr, size_t bytesize) {
     /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+    HCS_ENSURE_INIT();
 
-    /* Lazy load real function */
-    if (!real_hipMalloc) {
-        real_hipMalloc = (hipMalloc_fn)dlsym(RTLD_NEXT, "hipMalloc");
-        if (!real_hipMalloc) {
-            HCS_LOG(LOG_ERROR, "Failed to find real hipMalloc");
-            return hipErrorInvalidValue;
-        }
+    /* Reached from a runtime allocation that has already been charged */
+    if (t_in_runtime) {
+        return HCS_REAL(cuMemAlloc)(dptr, bytesize);
     }
 
-    pthread_mutex_lock(&g_ctx.lock);
+    int device = driver_current_device();
+    if (!hook_reserve("cuMemAlloc", TRACE_OP_CU_MEM_ALLOC, device, bytesize,
+                      CUDA_ERROR_OUT_OF_MEMORY)) {
+        return CUDA_ERROR_OUT_OF_MEMORY;
+    }
 
-    /* Check quota */
-    if (g_ctx.quota_used + size > g_ctx.quota_limit) {
-        g_ctx.failed_allocs++;
+    int result = HCS_REAL(cuMemAlloc)(dptr, bytesize);
+    hook_commit("cuMemAlloc", TRACE_OP_CU_MEM_ALLOC, device, bytesize, result,
+                (result == CUDA_SUCCESS && dptr) ? (void *)(uintptr_t)*dptr : NULL);
+    return result;
+}
 
-        char req_buf[32], used_buf[32], limit_buf[32];
-        format_size(size, req_buf, sizeof(req_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        format_size(g_ctx.quota_limit, limit_buf, sizeof(limit_buf));
+/* cuMemFree interception */
+int cuMemFree_v2(CUdeviceptr dptr) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
-        HCS_LOG(LOG_WARN, "hipMalloc DENIED: requested=%s, used=%s, limit=%s",
-                req_buf, used_buf, limit_buf);
+    if (!dptr) {
+        return HCS_REAL(cuMemFree)(dptr);
+    }
 
-        pthread_mutex_unlock(&g_ctx.lock);
-        return hipErrorOutOfMemory;
+    int device;
+    bool cached;
+    size_t size = hook_release("cuMemFree", (void *)(uintptr_t)dptr, &device, &cached);
+
+    int result = cached ? CUDA_SUCCESS : HCS_REAL(cuMemFree)(dptr);
+    HCS_TRACE(TRACE_OP_CU_MEM_FREE, (void *)(uintptr_t)dptr, size, result, device);
+    return result;
+}
+
+/* cuMemAllocAsync interception - stream-ordered, same semantics as
+ * cudaMallocAsync */
+int cuMemAllocAsync(CUdeviceptr *dptr, size_t bytesize, void *hStream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Reached from a runtime allocation that has already been charged */
+    if (t_in_runtime) {
+        return HCS_REAL(cuMemAllocAsync)(dptr, bytesize, hStream);
     }
 
-    pthread_mutex_unlock(&g_ctx.lock);
+    int device = driver_current_device();
+    if (!hook_reserve("cuMemAllocAsync", TRACE_OP_CU_MEM_ALLOC, device, bytesize,
+                      CUDA_ERROR_OUT_OF_MEMORY)) {
+        return CUDA_ERROR_OUT_OF_MEMORY;
+    }
 
-    /* Call real hipMalloc */
-    int result = real_hipMalloc(devPtr, size);
+    int result = HCS_REAL(cuMemAllocAsync)(dptr, bytesize, hStream);
+    hook_commit("cuMemAllocAsync", TRACE_OP_CU_MEM_ALLOC, device, bytesize, result,
+                (result == CUDA_SUCCESS && dptr) ? (void *)(uintptr_t)*dptr : NULL);
+    return result;
+}
 
-    if (result == hipSuccess && devPtr && *devPtr) {
-        pthread_mutex_lock(&g_ctx.lock);
+/* cuMemFreeAsync interception */
+int cuMemFreeAsync(CUdeviceptr dptr, void *hStream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
-        /* Update quota */
-        g_ctx.quota_used += size;
-        g_ctx.total_allocs++;
+    if (!dptr) {
+        return HCS_REAL(cuMemFreeAsync)(dptr, hStream);
+    }
 
-        /* Update peak */
-        if (g_ctx.quota_used > g_ctx.peak_usage) {
-            g_ctx.peak_usage = g_ctx.quota_used;
-        }
+    int device;
+    bool cached;
+    size_t size = hook_release("cuMemFreeAsync", (void *)(uintptr_t)dptr, &device, &cached);
 
-        /* Track allocation */
-        if (!add_allocation(*devPtr, size)) {
-            HCS_LOG(LOG_WARN, "Failed to track allocation (table full)");
-        }
+    int result = cached ? CUDA_SUCCESS : HCS_REAL(cuMemFreeAsync)(dptr, hStream);
+    HCS_TRACE(TRACE_OP_CU_MEM_FREE, (void *)(uintptr_t)dptr, size, result, device);
+    return result;
+}
 
-        char size_buf[32], used_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        HCS_LOG(LOG_DEBUG, "hipMalloc: size=%s, ptr=%p, total_used=%s",
-                size_buf, *devPtr, used_buf);
+/* cuMemCreate interception - physical memory for the VMM API. It is charged
+ * here, once, to the device the allocation properties name; cuMemMap and
+ * cuMemUnmap only change where it is visible and are not accounted. */
+int cuMemCreate(CUmemGenericAllocationHandle *handle, size_t size,
+                const CUmemAllocationProp *prop, unsigned long long flags) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Host-located (pinned) VMM memory does not count against VRAM, and a
+     * runtime allocation reaching the driver has already been charged */
+    if (!prop || prop->location.type != CU_MEM_LOCATION_TYPE_DEVICE || t_in_runtime) {
+        return HCS_REAL(cuMemCreate)(handle, size, prop, flags);
+    }
 
-        pthread_mutex_unlock(&g_ctx.lock);
+    int device = prop->location.id;
+    if (!hook_reserve("cuMemCreate", TRACE_OP_CU_MEM_CREATE, device, size,
+                      CUDA_ERROR_OUT_OF_MEMORY)) {
+        return CUDA_ERROR_OUT_OF_MEMORY;
     }
 
+    int result = HCS_REAL(cuMemCreate)(handle, size, prop, flags);
+    hook_commit("cuMemCreate", TRACE_OP_CU_MEM_CREATE, device, size, result,
+                (result == CUDA_SUCCESS && handle) ? vmm_handle_key(*handle) : NULL);
     return result;
 }
 
-/* hipFree interception */
-int hipFree(void *devPtr) {
+/* cuMemRelease interception */
+int cuMemRelease(CUmemGenericAllocationHandle handle) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Host-located handles were never tracked and come back as size 0 */
+    int device;
+    bool cached;
+    void *key = vmm_handle_key(handle);
+    size_t size = hook_release("cuMemRelease", key, &device, &cached);
+
+    int result = HCS_REAL(cuMemRelease)(handle);
+    HCS_TRACE(TRACE_OP_CU_MEM_RELEASE, key, size, result, device);
+    return result;
+}
+
+/* cuMemGetInfo interception - return virtualized memory info */
+int cuMemGetInfo_v2(size_t *free, size_t *total) {
     /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+    HCS_ENSURE_INIT();
+
+    /* Get real memory info first to check for errors */
+    int result = HCS_REAL(cuMemGetInfo)(free, total);
+    if (result != CUDA_SUCCESS) {
+        return result;
+    }
 
-    /* Lazy load real function */
-    if (!real_hipFree) {
-        real_hipFree = (hipFree_fn)dlsym(RTLD_NEXT, "hipFree");
-        if (!real_hipFree) {
-            HCS_LOG(LOG_ERROR, "Failed to find real hipFree");
-            return hipErrorInvalidValue;
+    /* Return virtualized values for the context's device */
+    device_quota_t *dq = device_quota(driver_current_device());
+    quota_mem_info(dq, free, total);
+
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char free_buf[32], total_buf[32];
+        format_size(*free, free_buf, sizeof(free_buf));
+        format_size(*total, total_buf, sizeof(total_buf));
+        HCS_LOG(LOG_DEBUG, "cuMemGetInfo: free=%s, total=%s (virtualized)",
+                free_buf, total_buf);
+    }
+
+    return CUDA_SUCCESS;
+}
+
+int cuGetProcAddress(const char *symbol, void **pfn, int cudaVersion,
+                     unsigned long long flags);
+int cuGetProcAddress_v2(const char *symbol, void **pfn, int cudaVersion,
+                        unsigned long long flags, int *symbolStatus);
+
+/* Driver entry points with a hook here, by the name cuGetProcAddress is
+ * asked for. The driver picks the ABI variant from the caller's CUDA
+ * version, so only the variant a hook implements is replaced. */
+static const struct {
+    const char *name;
+    const char *variant;
+    void *hook;
+} proc_address_hooks[] = {
+    {"cuMemAlloc", "cuMemAlloc_v2", (void *)cuMemAlloc_v2},
+    {"cuMemFree", "cuMemFree_v2", (void *)cuMemFree_v2},
+    {"cuMemAllocAsync", "cuMemAllocAsync", (void *)cuMemAllocAsync},
+    {"cuMemFreeAsync", "cuMemFreeAsync", (void *)cuMemFreeAsync},
+    {"cuMemCreate", "cuMemCreate", (void *)cuMemCreate},
+    {"cuMemRelease", "cuMemRelease", (void *)cuMemRelease},
+    {"cuMemGetInfo", "cuMemGetInfo_v2", (void *)cuMemGetInfo_v2},
+    {"cuGetProcAddress", "cuGetProcAddress_v2", (void *)cuGetProcAddress_v2},
+    {"cuGetProcAddress", "cuGetProcAddress", (void *)cuGetProcAddress},
+};
+
+/* Swap a driver entry point for its hook when it is the variant the hook
+ * forwards to. Entry points are looked up once by the libraries that use
+ * them, so the extra symbol lookup stays off the allocation path. */
+static void *proc_address_hook(const char *symbol, void *fn) {
+    for (size_t i = 0; i < sizeof(proc_address_hooks) / sizeof(proc_address_hooks[0]); i++) {
+        if (strcmp(symbol, proc_address_hooks[i].name) == 0 &&
+            fn == resolve_symbol(proc_address_hooks[i].variant, cuda_libs)) {
+            HCS_LOG(LOG_DEBUG, "cuGetProcAddress: %s -> hook", proc_address_hooks[i].variant);
+            return proc_address_hooks[i].hook;
         }
     }
+    return fn;
+}
+
+/* cuGetProcAddress interception - libraries that fetch driver entry points
+ * at run time (cuGetProcAddress, or cudaGetDriverEntryPoint through the
+ * runtime's own export) would otherwise bypass the hooks above */
+int cuGetProcAddress(const char *symbol, void **pfn, int cudaVersion,
+                     unsigned long long flags) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    int result = HCS_REAL(cuGetProcAddress)(symbol, pfn, cudaVersion, flags);
+    if (result == CUDA_SUCCESS && symbol && pfn && *pfn) {
+        *pfn = proc_address_hook(symbol, *pfn);
+    }
+    return result;
+}
+
+/* cuGetProcAddress_v2 interception - what cuda.h maps cuGetProcAddress to
+ * from CUDA 12 on */
+int cuGetProcAddress_v2(const char *symbol, void **pfn, int cudaVersion,
+                        unsigned long long flags, int *symbolStatus) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    int result = HCS_REAL(cuGetProcAddress_v2)(symbol, pfn, cudaVersion, flags, symbolStatus);
+    if (result == CUDA_SUCCESS && symbol && pfn && *pfn) {
+        *pfn = proc_address_hook(symbol, *pfn);
+    }
+    return result;
+}
+
+/* ============================================================================
+ * ACL API Interception (华为昇腾)
+ * ============================================================================ */
+
+/* aclrtMalloc interception */
+int aclrtMalloc(void **devPtr, size_t size, aclrtMemMallocPolicy policy) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Small requests under the default policy come from the caching
+     * sub-allocator when enabled; its chunks use that policy */
+    int device = t_current_device;
+    int result;
+    if (policy == ACL_MEM_MALLOC_HUGE_FIRST &&
+        slab_malloc(SLAB_ACL, device, size, devPtr, "aclrtMalloc", TRACE_OP_ACL_MALLOC,
+                    ACL_ERROR_RT_MEMORY_ALLOCATION, &result)) {
+        return result;
+    }
+
+    if (!hook_reserve("aclrtMalloc", TRACE_OP_ACL_MALLOC, device, size, ACL_ERROR_RT_MEMORY_ALLOCATION)) {
+        return ACL_ERROR_RT_MEMORY_ALLOCATION;
+    }
+
+    result = HCS_REAL(aclrtMalloc)(devPtr, size, policy);
+    hook_commit("aclrtMalloc", TRACE_OP_ACL_MALLOC, device, size, result,
+                (result == ACL_SUCCESS && devPtr) ? *devPtr : NULL);
+    return result;
+}
+
+/* aclrtFree interception */
+int aclrtFree(void *devPtr) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
     /* NULL pointer check */
     if (!devPtr) {
-        return real_hipFree(devPtr);
+        return HCS_REAL(aclrtFree)(devPtr);
     }
 
-    pthread_mutex_lock(&g_ctx.lock);
+    /* Find and remove allocation; credit the device it was charged to */
+    int device;
+    bool cached;
+    size_t size = hook_release("aclrtFree", devPtr, &device, &cached);
 
-    /* Find and remove allocation */
-    size_t size = remove_allocation(devPtr);
-    if (size > 0) {
-        if (g_ctx.quota_used >= size) {
-            g_ctx.quota_used -= size;
-        } else {
-            g_ctx.quota_used = 0;
-        }
-        g_ctx.total_frees++;
+    int result = cached ? ACL_SUCCESS : HCS_REAL(aclrtFree)(devPtr);
+    HCS_TRACE(TRACE_OP_ACL_FREE, devPtr, size, result, device);
+    return result;
+}
 
-        char size_buf[32], used_buf[32];
-        format_size(size, size_buf, sizeof(size_buf));
-        format_size(g_ctx.quota_used, used_buf, sizeof(used_buf));
-        HCS_LOG(LOG_DEBUG, "hipFree: size=%s, ptr=%p, total_used=%s",
-                size_buf, devPtr, used_buf);
-    } else {
-        HCS_LOG(LOG_DEBUG, "hipFree: ptr=%p (not tracked)", devPtr);
+/* aclrtGetMemInfo interception - return virtualized memory info */
+int aclrtGetMemInfo(aclrtMemAttr attr, size_t *free, size_t *total) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Get real memory info first to check for errors */
+    int result = HCS_REAL(aclrtGetMemInfo)(attr, free, total);
+    if (result != ACL_SUCCESS) {
+        return result;
     }
 
-    pthread_mutex_unlock(&g_ctx.lock);
+    /* Return virtualized values for the current device */
+    device_quota_t *dq = device_quota(t_current_device);
+    quota_mem_info(dq, free, total);
+
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char free_buf[32], total_buf[32];
+        format_size(*free, free_buf, sizeof(free_buf));
+        format_size(*total, total_buf, sizeof(total_buf));
+        HCS_LOG(LOG_DEBUG, "aclrtGetMemInfo: free=%s, total=%s (virtualized)",
+                free_buf, total_buf);
+    }
 
-    return real_hipFree(devPtr);
+    return ACL_SUCCESS;
 }
 
-/* hipMemGetInfo interception - return virtualized memory info */
-int hipMemGetInfo(size_t *free, size_t *total) {
+/* aclrtSetDevice interception - remember the thread's current device */
+int aclrtSetDevice(int32_t deviceId) {
     /* Ensure initialization */
-    if (!g_ctx.initialized) hcs_init();
+    HCS_ENSURE_INIT();
 
-    /* Lazy load real function */
-    if (!real_hipMemGetInfo) {
-        real_hipMemGetInfo = (hipMemGetInfo_fn)dlsym(RTLD_NEXT, "hipMemGetInfo");
-        if (!real_hipMemGetInfo) {
-            HCS_LOG(LOG_ERROR, "Failed to find real hipMemGetInfo");
-            return hipErrorInvalidValue;
-        }
+    int result = HCS_REAL(aclrtSetDevice)(deviceId);
+    if (result == ACL_SUCCESS) {
+        t_current_device = (int)deviceId;
+        HCS_LOG(LOG_DEBUG, "aclrtSetDevice: device=%d", t_current_device);
+    }
+
+    return result;
+}
+
+/* ============================================================================
+ * HIP API Interception (海光/AMD)
+ * ============================================================================ */
+
+/* hipMalloc interception */
+int hipMalloc(void **devPtr, size_t size) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* Small requests come from the caching sub-allocator when enabled */
+    int device = t_current_device;
+    int result;
+    if (slab_malloc(SLAB_HIP, device, size, devPtr, "hipMalloc", TRACE_OP_HIP_MALLOC,
+                    hipErrorOutOfMemory, &result)) {
+        return result;
+    }
+
+    if (!hook_reserve("hipMalloc", TRACE_OP_HIP_MALLOC, device, size, hipErrorOutOfMemory)) {
+        return hipErrorOutOfMemory;
+    }
+
+    result = HCS_REAL(hipMalloc)(devPtr, size);
+    hook_commit("hipMalloc", TRACE_OP_HIP_MALLOC, device, size, result,
+                (result == hipSuccess && devPtr) ? *devPtr : NULL);
+    return result;
+}
+
+/* hipFree interception */
+int hipFree(void *devPtr) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    /* NULL pointer check */
+    if (!devPtr) {
+        return HCS_REAL(hipFree)(devPtr);
     }
 
+    /* Find and remove allocation; credit the device it was charged to */
+    int device;
+    bool cached;
+    size_t size = hook_release("hipFree", devPtr, &device, &cached);
+
+    int result = cached ? hipSuccess : HCS_REAL(hipFree)(devPtr);
+    HCS_TRACE(TRACE_OP_HIP_FREE, devPtr, size, result, device);
+    return result;
+}
+
+/* hipMemGetInfo interception - return virtualized memory info */
+int hipMemGetInfo(size_t *free, size_t *total) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
     /* Get real memory info first to check for errors */
-    int result = real_hipMemGetInfo(free, total);
+    int result = HCS_REAL(hipMemGetInfo)(free, total);
     if (result != hipSuccess) {
         return result;
     }
 
-    /* Return virtualized values */
-    pthread_mutex_lock(&g_ctx.lock);
+    /* Return virtualized values for the current device */
+    device_quota_t *dq = device_quota(t_current_device);
+    quota_mem_info(dq, free, total);
 
-    *total = g_ctx.quota_limit;
-    *free = (g_ctx.quota_limit > g_ctx.quota_used) ?
-            (g_ctx.quota_limit - g_ctx.quota_used) : 0;
+    if (HCS_LOG_ENABLED(LOG_DEBUG)) {
+        char free_buf[32], total_buf[32];
+        format_size(*free, free_buf, sizeof(free_buf));
+        format_size(*total, total_buf, sizeof(total_buf));
+        HCS_LOG(LOG_DEBUG, "hipMemGetInfo: free=%s, total=%s (virtualized)",
+                free_buf, total_buf);
+    }
+
+    return hipSuccess;
+}
 
-    char free_buf[32], total_buf[32];
-    format_size(*free, free_buf, sizeof(free_buf));
-    format_size(*total, total_buf, sizeof(total_buf));
-    HCS_LOG(LOG_DEBUG, "hipMemGetInfo: free=%s, total=%s (virtualized)",
-            free_buf, total_buf);
+/* hipMallocAsync interception - stream-ordered, same semantics as
+ * cudaMallocAsync */
+int hipMallocAsync(void **devPtr, size_t size, void *stream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
 
-    pthread_mutex_unlock(&g_ctx.lock);
+    int device = t_current_device;
+    if (!hook_reserve("hipMallocAsync", TRACE_OP_HIP_MALLOC_ASYNC, device, size,
+                      hipErrorOutOfMemory)) {
+        return hipErrorOutOfMemory;
+    }
 
-    return hipSuccess;
+    int result = HCS_REAL(hipMallocAsync)(devPtr, size, stream);
+    hook_commit("hipMallocAsync", TRACE_OP_HIP_MALLOC_ASYNC, device, size, result,
+                (result == hipSuccess && devPtr) ? *devPtr : NULL);
+    return result;
+}
+
+/* hipFreeAsync interception */
+int hipFreeAsync(void *devPtr, void *stream) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    if (!devPtr) {
+        return HCS_REAL(hipFreeAsync)(devPtr, stream);
+    }
+
+    int device;
+    bool cached;
+    size_t size = hook_release("hipFreeAsync", devPtr, &device, &cached);
+
+    int result = cached ? hipSuccess : HCS_REAL(hipFreeAsync)(devPtr, stream);
+    HCS_TRACE(TRACE_OP_HIP_FREE_ASYNC, devPtr, size, result, device);
+    return result;
+}
+
+/* hipSetDevice interception - remember the thread's current device */
+int hipSetDevice(int deviceId) {
+    /* Ensure initialization */
+    HCS_ENSURE_INIT();
+
+    int result = HCS_REAL(hipSetDevice)(deviceId);
+    if (result == hipSuccess) {
+        t_current_device = (int)deviceId;
+        HCS_LOG(LOG_DEBUG, "hipSetDevice: device=%d", t_current_device);
+    }
+
+    return result;
 }
 
 /* ============================================================================
  * Query Functions (for external tools)
  * ============================================================================ */
 
-/* Get current quota usage (exported for debugging) */
+/* Get current quota usage of the calling thread's device (exported for debugging) */
 size_t hcs_get_quota_used(void) {
-    pthread_mutex_lock(&g_ctx.lock);
-    size_t used = g_ctx.quota_used;
-    pthread_mutex_unlock(&g_ctx.lock);
-    return used;
+    return quota_used_now(device_quota(t_current_device));
 }
 
-/* Get quota limit (exported for debugging) */
+/* Get quota limit of the calling thread's device (exported for debugging) */
 size_t hcs_get_quota_limit(void) {
-    return g_ctx.quota_limit;
+    return device_quota(t_current_device)->quota_limit;
 }
 
-/* Get peak usage (exported for debugging) */
+/* Get peak usage of the calling thread's device (exported for debugging) */
 size_t hcs_get_peak_usage(void) {
-    pthread_mutex_lock(&g_ctx.lock);
-    size_t peak = g_ctx.peak_usage;
-    pthread_mutex_unlock(&g_ctx.lock);
-    return peak;
+    return atomic_load_explicit(&device_quota(t_current_device)->peak_usage,
+                                memory_order_relaxed);
+}
+
+/* Get per-device usage and limit (exported for debugging) */
+void hcs_get_device_quota(int device, size_t *used, size_t *limit, size_t *peak) {
+    device_quota_t *dq = device_quota(device);
+    if (used) *used = quota_used_now(dq);
+    if (limit) *limit = dq->quota_limit;
+    if (peak) *peak = atomic_load_explicit(&dq->peak_usage, memory_order_relaxed);
+}
+
+/* Get a device's soft limit and live managed memory (exported for debugging) */
+void hcs_get_device_pressure(int device, size_t *soft_limit, size_t *managed_used) {
+    device_quota_t *dq = device_quota(device);
+    if (soft_limit) *soft_limit = dq->soft_limit;
+    if (managed_used) *managed_used = atomic_load_explicit(&dq->managed_used, memory_order_relaxed);
 }
 
-/* Get statistics (exported for debugging) */
+/* Get statistics summed over all devices (exported for debugging) */
 void hcs_get_stats(uint64_t *allocs, uint64_t *frees, uint64_t *failed) {
-    pthread_mutex_lock(&g_ctx.lock);
-    if (allocs) *allocs = g_ctx.total_allocs;
-    if (frees) *frees = g_ctx.total_frees;
-    if (failed) *failed = g_ctx.failed_allocs;
-    pthread_mutex_unlock(&g_ctx.lock);
+    uint64_t a = 0, f = 0, x = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        a += atomic_load_explicit(&g_ctx.devices[i].total_allocs, memory_order_relaxed);
+        f += atomic_load_explicit(&g_ctx.devices[i].total_frees, memory_order_relaxed);
+        x += atomic_load_explicit(&g_ctx.devices[i].failed_allocs, memory_order_relaxed);
+    }
+    if (allocs) *allocs = a;
+    if (frees) *frees = f;
+    if (failed) *failed = x;
+}
+
+/* ============================================================================
+ * Memory Pressure API (for frameworks, looked up with dlsym)
+ * ============================================================================ */
+
+/* 1 while the device is above its soft limit, 0 otherwise */
+int hcs_memory_pressure(int device) {
+    return atomic_load_explicit(&device_quota(device)->pressure, memory_order_relaxed) ? 1 : 0;
+}
+
+/* Register a function called each time a device crosses its soft limit,
+ * NULL to unregister. It runs synchronously on the allocating thread, which
+ * may hold the application allocator's own locks: it should only record the
+ * event or wake a thread that trims, never free or allocate device memory
+ * itself. Set it before allocating from other threads, since the callback
+ * and arg are not swapped as a pair. */
+void hcs_set_pressure_callback(hcs_pressure_callback_t callback, void *arg) {
+    atomic_store_explicit(&g_pressure.callback_arg, arg, memory_order_relaxed);
+    atomic_store_explicit(&g_pressure.callback, callback, memory_order_release);
+}
+
+/* Return an eventfd that counts soft limit crossings, creating it on the
+ * first call. Non-blocking and close-on-exec, owned by the interceptor: poll
+ * it and read it to reset, never close it. If a device is already under
+ * pressure when the descriptor is created it starts readable. Returns -1
+ * where eventfd is unavailable. */
+int hcs_pressure_eventfd(void) {
+#ifdef __linux__
+    int efd = atomic_load_explicit(&g_pressure.eventfd, memory_order_acquire);
+    if (efd >= 0) return efd;
+
+    int created = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (created < 0) return -1;
+
+    int expected = -1;
+    if (!atomic_compare_exchange_strong_explicit(&g_pressure.eventfd, &expected, created,
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire)) {
+        close(created);
+        return expected;
+    }
+
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (atomic_load_explicit(&g_ctx.devices[i].pressure, memory_order_relaxed)) {
+            uint64_t one = 1;
+            ssize_t n = write(created, &one, sizeof(one));
+            (void)n;
+            break;
+        }
+    }
+    return created;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/* ============================================================================
+ * Parser Self-Test (make test-parse)
+ * ============================================================================ */
+
+#ifdef TEST_PARSE_SIZE
+
+static int parse_failures = 0;
+
+static void expect_size(const char *str, size_t expected) {
+    size_t got = parse_size_string(str);
+    if (got != expected) {
+        printf("  [FAIL] parse_size_string(\"%s\") = %zu, want %zu\n", str, got, expected);
+        parse_failures++;
+    } else {
+        printf("  [PASS] parse_size_string(\"%s\") = %zu\n", str, got);
+    }
+}
+
+static void expect_spec(const char *spec, bool ok, size_t dev0, size_t dev1, size_t dev7) {
+    size_t limits[MAX_DEVICES];
+    bool got = parse_quota_spec(spec, QUOTA_UNLIMITED, limits);
+    bool pass = (got == ok) &&
+                (!ok || (limits[0] == dev0 && limits[1] == dev1 && limits[7] == dev7));
+    if (!pass) {
+        printf("  [FAIL] parse_quota_spec(\"%s\")\n", spec);
+        parse_failures++;
+    } else {
+        printf("  [PASS] parse_quota_spec(\"%s\")\n", spec);
+    }
+}
+
+static void expect_soft(const char *spec, bool ok, size_t dev0, size_t dev1) {
+    const size_t limits[MAX_DEVICES] = { 16UL << 30, 8UL << 30 };
+    size_t soft[MAX_DEVICES];
+    bool got = parse_soft_limit_spec(spec, limits, soft);
+    bool pass = (got == ok) && (!ok || (soft[0] == dev0 && soft[1] == dev1 && soft[2] == 0));
+    if (!pass) {
+        printf("  [FAIL] parse_soft_limit_spec(\"%s\")\n", spec);
+        parse_failures++;
+    } else {
+        printf("  [PASS] parse_soft_limit_spec(\"%s\")\n", spec);
+    }
+}
+
+int main(void) {
+    const size_t GiB = 1024UL * 1024 * 1024;
+    const size_t MiB = 1024UL * 1024;
+
+    expect_size("1024", 1024);
+    expect_size("16Gi", 16 * GiB);
+    expect_size("4G", 4000UL * 1000 * 1000);
+    expect_size("512Mi", 512 * MiB);
+    expect_size("1.5Gi", 3 * GiB / 2);
+    expect_size("", 0);
+
+    expect_spec("16Gi", true, 16 * GiB, 16 * GiB, 16 * GiB);
+    expect_spec("0=16Gi,1=8Gi", true, 16 * GiB, 8 * GiB, QUOTA_UNLIMITED);
+    expect_spec("4Gi, 1=8Gi", true, 4 * GiB, 8 * GiB, 4 * GiB);
+    expect_spec("1=8Gi,2Gi", true, 2 * GiB, 8 * GiB, 2 * GiB);
+    expect_spec("16=1Gi", false, 0, 0, 0);
+    expect_spec("x=1Gi", false, 0, 0, 0);
+    expect_spec("0=", false, 0, 0, 0);
+    expect_spec("Gi", false, 0, 0, 0);
+
+    expect_soft("75%", true, 12 * GiB, 6 * GiB);
+    expect_soft("12Gi", true, 12 * GiB, 8 * GiB);
+    expect_soft("1=4Gi", true, 0, 4 * GiB);
+    expect_soft("0%", false, 0, 0);
+    expect_soft("150%", false, 0, 0);
+    expect_soft("x%", false, 0, 0);
+
+    printf("%s\n", parse_failures == 0 ? "All parser tests passed" : "Parser tests FAILED");
+    return parse_failures == 0 ? 0 : 1;
 }
+
+#endif /* TEST_PARSE_SIZE */
@@ -0,0 +1,224 @@
+/*
+ * HCS Mock GPU Runtime
+ *
+ * Stand-in for libcudart, libamdhip64 and libascendcl used by the interceptor
+ * tests and benchmarks. It is built as a separate shared library so that,
+ * with libhcs_interceptor.so preloaded, the test program's calls resolve to
+ * the interceptor first and reach these implementations through
+ * dlsym(RTLD_NEXT), exactly as with the real runtimes.
+ *
+ * Build:
+ *   gcc -shared -fPIC -o libhcs_mock_runtime.so mock_runtime.c
+ *
+ * Copyright (c) 2024 HCS Project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define cudaSuccess 0
+#define cudaErrorInvalidValue 1
+#define cudaErrorMemoryAllocation 2
+#define cudaErrorInvalidDevice 101
+
+#define CUDA_SUCCESS 0
+#define CUDA_ERROR_INVALID_VALUE 1
+#define CUDA_ERROR_OUT_OF_MEMORY 2
+#define CUDA_ERROR_NOT_FOUND 500
+
+#define hipSuccess 0
+#define hipErrorOutOfMemory 2
+#define hipErrorInvalidDevice 101
+
+#define ACL_SUCCESS 0
+#define ACL_ERROR_RT_MEMORY_ALLOCATION 107000
+#define ACL_ERROR_INVALID_PARAM 107001
+
+#define MOCK_DEVICE_COUNT 8
+
+typedef int cudaError_t;
+typedef int CUresult;
+typedef unsigned long long CUdeviceptr;
+typedef unsigned long long CUmemGenericAllocationHandle;
+typedef struct CUmemAllocationProp CUmemAllocationProp;
+
+static size_t mock_allocated = 0;
+static size_t mock_total = 16UL * 1024 * 1024 * 1024;  /* 16 GiB */
+
+cudaError_t cudaMalloc(void **devPtr, size_t size) {
+    /* Plain host memory stands in for device memory */
+    *devPtr = malloc(size);
+    if (*devPtr) {
+        __atomic_fetch_add(&mock_allocated, size, __ATOMIC_RELAXED);
+        return cudaSuccess;
+    }
+    return cudaErrorMemoryAllocation;
+}
+
+cudaError_t cudaFree(void *devPtr) {
+    if (devPtr) {
+        free(devPtr);
+    }
+    return cudaSuccess;
+}
+
+/*
+ * Stream-ordered calls complete immediately. They must not call cudaMalloc
+ * or cudaFree, which resolve to the preloaded interceptor and would be
+ * charged a second time.
+ */
+
+/* Managed memory is plain host memory as well */
+cudaError_t cudaMallocManaged(void **devPtr, size_t size, unsigned int flags) {
+    (void)flags;
+    *devPtr = malloc(size);
+    return *devPtr ? cudaSuccess : cudaErrorMemoryAllocation;
+}
+
+cudaError_t cudaMallocAsync(void **devPtr, size_t size, void *stream) {
+    (void)stream;
+    *devPtr = malloc(size);
+    return *devPtr ? cudaSuccess : cudaErrorMemoryAllocation;
+}
+
+cudaError_t cudaFreeAsync(void *devPtr, void *stream) {
+    (void)stream;
+    free(devPtr);
+    return cudaSuccess;
+}
+
+/*
+ * Driver API. cuCtxGetDevice is left out so that the interceptor falls back
+ * to the runtime's current device, as it does without a driver context.
+ */
+
+CUresult cuMemAlloc_v2(CUdeviceptr *dptr, size_t bytesize) {
+    void *ptr = malloc(bytesize);
+    if (!ptr) {
+        return CUDA_ERROR_OUT_OF_MEMORY;
+    }
+    *dptr = (CUdeviceptr)(uintptr_t)ptr;
+    return CUDA_SUCCESS;
+}
+
+CUresult cuMemFree_v2(CUdeviceptr dptr) {
+    free((void *)(uintptr_t)dptr);
+    return CUDA_SUCCESS;
+}
+
+/* A VMM handle is simply the address of the backing host memory */
+CUresult cuMemCreate(CUmemGenericAllocationHandle *handle, size_t size,
+                     const CUmemAllocationProp *prop, unsigned long long flags) {
+    (void)prop;
+    if (flags != 0) {
+        return CUDA_ERROR_INVALID_VALUE;
+    }
+    void *ptr = malloc(size);
+    if (!ptr) {
+        return CUDA_ERROR_OUT_OF_MEMORY;
+    }
+    *handle = (CUmemGenericAllocationHandle)(uintptr_t)ptr;
+    return CUDA_SUCCESS;
+}
+
+CUresult cuMemRelease(CUmemGenericAllocationHandle handle) {
+    free((void *)(uintptr_t)handle);
+    return CUDA_SUCCESS;
+}
+
+/* Driver entry points as cuGetProcAddress hands them out. The hidden
+ * aliases give this library's own addresses: taking &cuMemAlloc_v2 here
+ * would bind to the preloaded interceptor instead. */
+extern __typeof(cuMemAlloc_v2) mock_cuMemAlloc_v2
+    __attribute__((alias("cuMemAlloc_v2"), visibility("hidden")));
+extern __typeof(cuMemFree_v2) mock_cuMemFree_v2
+    __attribute__((alias("cuMemFree_v2"), visibility("hidden")));
+
+CUresult cuGetProcAddress_v2(const char *symbol, void **pfn, int cudaVersion,
+                             unsigned long long flags, int *symbolStatus) {
+    (void)cudaVersion;
+    (void)flags;
+    if (symbolStatus) {
+        *symbolStatus = 0;
+    }
+    if (strcmp(symbol, "cuMemAlloc") == 0) {
+        *pfn = (void *)mock_cuMemAlloc_v2;
+    } else if (strcmp(symbol, "cuMemFree") == 0) {
+        *pfn = (void *)mock_cuMemFree_v2;
+    } else {
+        *pfn = NULL;
+        return CUDA_ERROR_NOT_FOUND;
+    }
+    return CUDA_SUCCESS;
+}
+
+cudaError_t cudaMemGetInfo(size_t *free, size_t *total) {
+    *total = mock_total;
+    *free = mock_total - __atomic_load_n(&mock_allocated, __ATOMIC_RELAXED);
+    return cudaSuccess;
+}
+
+cudaError_t cudaSetDevice(int device) {
+    if (device < 0 || device >= MOCK_DEVICE_COUNT) {
+        return cudaErrorInvalidDevice;
+    }
+    return cudaSuccess;
+}
+
+const char* cudaGetErrorString(cudaError_t error) {
+    switch (error) {
+        case cudaSuccess: return "cudaSuccess";
+        case cudaErrorMemoryAllocation: return "cudaErrorMemoryAllocation";
+        default: return "Unknown error";
+    }
+}
+
+/*
+ * HIP and ACL, backed by host memory like the CUDA calls. Only the entry
+ * points the interceptor hooks are provided.
+ */
+
+int hipMalloc(void **devPtr, size_t size) {
+    *devPtr = malloc(size);
+    return *devPtr ? hipSuccess : hipErrorOutOfMemory;
+}
+
+int hipFree(void *devPtr) {
+    free(devPtr);
+    return hipSuccess;
+}
+
+int hipMemGetInfo(size_t *free, size_t *total) {
+    *total = mock_total;
+    *free = mock_total;
+    return hipSuccess;
+}
+
+int hipSetDevice(int deviceId) {
+    return deviceId >= 0 && deviceId < MOCK_DEVICE_COUNT ? hipSuccess : hipErrorInvalidDevice;
+}
+
+int aclrtMalloc(void **devPtr, size_t size, int policy) {
+    (void)policy;
+    *devPtr = malloc(size);
+    return *devPtr ? ACL_SUCCESS : ACL_ERROR_RT_MEMORY_ALLOCATION;
+}
+
+int aclrtFree(void *devPtr) {
+    free(devPtr);
+    return ACL_SUCCESS;
+}
+
+int aclrtGetMemInfo(int attr, size_t *free, size_t *total) {
+    (void)attr;
+    *total = mock_total;
+    *free = mock_total;
+    return ACL_SUCCESS;
+}
+
+int aclrtSetDevice(int32_t deviceId) {
+    return deviceId >= 0 && deviceId < MOCK_DEVICE_COUNT ? ACL_SUCCESS : ACL_ERROR_INVALID_PARAM;
+}
@@ -5,7 +5,7 @@
  *
  * Build:
  *   With CUDA:    gcc -o test test_interceptor.c -I/usr/local/cuda/include -lcudart
- *   Mock mode:    gcc -DHCS_MOCK_CUDA -o test test_interceptor.c
+ *   Mock mode:    gcc -DHCS_MOCK_CUDA -o test test_interceptor.c -L. -lhcs_mock_runtime
  *
  * Run:
  *   HCS_VRAM_QUOTA=1Gi LD_PRELOAD=./libhcs_interceptor.so ./test
@@ -14,15 +14,23 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 #ifdef HCS_MOCK_CUDA
 
 /*
- * Mock CUDA API for testing without actual CUDA installation
+ * Mock CUDA API, implemented in mock_runtime.c (libhcs_mock_runtime.so)
  */
 
 #define cudaSuccess 0
@@ -30,47 +38,53 @@
 
 typedef int cudaError_t;
 
-/* Mock implementations - these will be intercepted by LD_PRELOAD */
-static size_t mock_allocated = 0;
-static size_t mock_total = 16UL * 1024 * 1024 * 1024;  /* 16 GiB */
-
-cudaError_t cudaMalloc(void **devPtr, size_t size) {
-    /* This will be intercepted by libhcs_interceptor.so */
-    /* If not intercepted, just allocate regular memory for testing */
-    *devPtr = malloc(size);
-    if (*devPtr) {
-        mock_allocated += size;
-        return cudaSuccess;
-    }
-    return cudaErrorMemoryAllocation;
-}
-
-cudaError_t cudaFree(void *devPtr) {
-    /* This will be intercepted by libhcs_interceptor.so */
-    if (devPtr) {
-        free(devPtr);
-    }
-    return cudaSuccess;
-}
-
-cudaError_t cudaMemGetInfo(size_t *free, size_t *total) {
-    /* This will be intercepted by libhcs_interceptor.so */
-    *total = mock_total;
-    *free = mock_total - mock_allocated;
-    return cudaSuccess;
-}
-
-const char* cudaGetErrorString(cudaError_t error) {
-    switch (error) {
-        case cudaSuccess: return "cudaSuccess";
-        case cudaErrorMemoryAllocation: return "cudaErrorMemoryAllocation";
-        default: return "Unknown error";
-    }
-}
+cudaError_t cudaMalloc(void **devPtr, size_t size);
+cudaError_t cudaFree(void *devPtr);
+cudaError_t cudaMemGetInfo(size_t *free, size_t *total);
+cudaError_t cudaSetDevice(int device);
+const char* cudaGetErrorString(cudaError_t error);
+cudaError_t cudaMallocAsync(void **devPtr, size_t size, void *stream);
+cudaError_t cudaFreeAsync(void *devPtr, void *stream);
+cudaError_t cudaMallocManaged(void **devPtr, size_t size, unsigned int flags);
+
+#define cudaMemAttachGlobal 0x01
+
+/* Driver API, also mocked */
+#define CUDA_SUCCESS 0
+#define CU_MEM_ALLOCATION_TYPE_PINNED 1
+#define CU_MEM_LOCATION_TYPE_DEVICE 1
+
+typedef int CUresult;
+typedef unsigned long long CUdeviceptr;
+typedef unsigned long long CUmemGenericAllocationHandle;
+
+typedef struct {
+    int type;
+    int requestedHandleTypes;
+    struct {
+        int type;
+        int id;
+    } location;
+    void *win32HandleMetaData;
+    unsigned char reserved[16];
+} CUmemAllocationProp;
+
+#define cuMemAlloc cuMemAlloc_v2
+#define cuMemFree cuMemFree_v2
+#define cuGetProcAddress cuGetProcAddress_v2
+
+CUresult cuMemAlloc_v2(CUdeviceptr *dptr, size_t bytesize);
+CUresult cuMemFree_v2(CUdeviceptr dptr);
+CUresult cuMemCreate(CUmemGenericAllocationHandle *handle, size_t size,
+                     const CUmemAllocationProp *prop, unsigned long long flags);
+CUresult cuMemRelease(CUmemGenericAllocationHandle handle);
+CUresult cuGetProcAddress_v2(const char *symbol, void **pfn, int cudaVersion,
+                             unsigned long long flags, int *symbolStatus);
 
 #else
 
 /* Use real CUDA */
+#include <cuda.h>
 #include <cuda_runtime.h>
 
 #endif
@@ -231,6 +245,462 @@ void test_multiple_allocations(void) {
     }
 }
 
+void test_allocation_churn(void) {
+    printf("\n=== Test: Allocation Table Churn ===\n");
+
+    #define NUM_CHURN 20000
+    static void *ptrs[NUM_CHURN];
+    size_t free_before, free_after, total_mem;
+    int successful_allocs = 0;
+
+    cudaMemGetInfo(&free_before, &total_mem);
+
+    /* Fill the table well past the point where a linear scan would hurt */
+    for (int i = 0; i < NUM_CHURN; i++) {
+        if (cudaMalloc(&ptrs[i], 4096) == cudaSuccess && ptrs[i] != NULL) {
+            successful_allocs++;
+        }
+    }
+    TEST_ASSERT(successful_allocs == NUM_CHURN, "20000 tracked allocations succeed");
+
+    /* Free every other entry, then reallocate into the released slots */
+    for (int i = 0; i < NUM_CHURN; i += 2) {
+        cudaFree(ptrs[i]);
+        ptrs[i] = NULL;
+    }
+    for (int i = 0; i < NUM_CHURN; i += 2) {
+        cudaMalloc(&ptrs[i], 8192);
+    }
+
+    /* Free in reverse order; every byte must be credited back */
+    for (int i = NUM_CHURN - 1; i >= 0; i--) {
+        if (ptrs[i]) {
+            cudaFree(ptrs[i]);
+        }
+    }
+
+    cudaMemGetInfo(&free_after, &total_mem);
+    TEST_ASSERT(free_after == free_before, "Quota fully released after churn");
+}
+
+#define RACE_THREADS 8
+#define RACE_ATTEMPTS 256
+
+static void *race_ptrs[RACE_THREADS][RACE_ATTEMPTS];
+static int race_success[RACE_THREADS];
+
+static void *race_worker(void *arg) {
+    int id = (int)(intptr_t)arg;
+    for (int i = 0; i < RACE_ATTEMPTS; i++) {
+        if (cudaMalloc(&race_ptrs[id][i], 1 * MiB) == cudaSuccess) {
+            race_success[id]++;
+        } else {
+            race_ptrs[id][i] = NULL;
+        }
+    }
+    return NULL;
+}
+
+void test_concurrent_quota(void) {
+    printf("\n=== Test: Concurrent Quota Reservation ===\n");
+
+    size_t free_mem, total_mem;
+    cudaMemGetInfo(&free_mem, &total_mem);
+
+    /* 8 threads race for 2048 MiB against a 1 GiB quota */
+    pthread_t threads[RACE_THREADS];
+    for (int t = 0; t < RACE_THREADS; t++) {
+        pthread_create(&threads[t], NULL, race_worker, (void *)(intptr_t)t);
+    }
+    for (int t = 0; t < RACE_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    size_t granted = 0;
+    for (int t = 0; t < RACE_THREADS; t++) {
+        granted += (size_t)race_success[t] * MiB;
+    }
+
+    printf("  Granted: %zu MiB of %zu MiB free\n", granted / MiB, free_mem / MiB);
+    TEST_ASSERT(granted <= free_mem, "Concurrent allocations never exceed quota");
+    TEST_ASSERT(granted == free_mem, "Concurrent allocations fill the quota exactly");
+
+    for (int t = 0; t < RACE_THREADS; t++) {
+        for (int i = 0; i < RACE_ATTEMPTS; i++) {
+            if (race_ptrs[t][i]) {
+                cudaFree(race_ptrs[t][i]);
+            }
+        }
+    }
+
+    size_t free_after;
+    cudaMemGetInfo(&free_after, &total_mem);
+    TEST_ASSERT(free_after == free_mem, "Quota fully released after concurrent frees");
+}
+
+void test_per_device_quota(void) {
+    printf("\n=== Test: Per-Device Quota ===\n");
+
+    void *dev0_ptr = NULL, *dev1_ptr = NULL;
+    size_t free_mem, total_mem;
+    cudaError_t err;
+
+    /* Each device gets its own 1 GiB quota */
+    err = cudaSetDevice(1);
+    TEST_ASSERT(err == cudaSuccess, "cudaSetDevice(1) succeeds");
+    err = cudaMalloc(&dev1_ptr, 700 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "700 MiB on device 1 succeeds");
+
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(total_mem - free_mem == 700 * MiB, "Device 1 reports its own usage");
+
+    cudaSetDevice(0);
+    err = cudaMalloc(&dev0_ptr, 700 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "700 MiB on device 0 succeeds alongside device 1");
+
+    /* Freeing from another device credits the device that was charged */
+    cudaFree(dev1_ptr);
+    cudaSetDevice(1);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == total_mem, "Device 1 fully released by free from device 0");
+
+    cudaSetDevice(0);
+    cudaFree(dev0_ptr);
+}
+
+void test_unlisted_device(void) {
+    printf("\n=== Test: Device Left Out of a Per-Device Quota ===\n");
+
+    const char *spec = getenv("HCS_VRAM_QUOTA");
+    if (!spec || strcmp(spec, "1=1Gi") != 0) {
+        printf("  HCS_VRAM_QUOTA is not \"1=1Gi\", skipping\n");
+        return;
+    }
+
+    void *ptr = NULL, *denied = NULL;
+    size_t free_mem, total_mem;
+    cudaError_t err;
+
+    /* Device 0 is not listed: no quota, the runtime's own memory info */
+    cudaSetDevice(0);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(total_mem == 16UL * 1024 * MiB, "Unlisted device reports the runtime's memory");
+    err = cudaMalloc(&ptr, 2048 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "Unlisted device is not limited");
+    cudaFree(ptr);
+
+    cudaSetDevice(1);
+    err = cudaMalloc(&denied, 2048 * MiB);
+    TEST_ASSERT(err == cudaErrorMemoryAllocation, "Listed device keeps its quota");
+
+    cudaSetDevice(0);
+}
+
+/* Stats page layout (see stats_page_t in libhcs_interceptor.c) */
+void test_async_and_driver_allocation(void) {
+    printf("\n=== Test: Stream-Ordered and Driver Allocation ===\n");
+
+    void *ptr = NULL, *denied = NULL;
+    CUdeviceptr dptr = 0;
+    CUmemGenericAllocationHandle handle = 0;
+    size_t free_before, free_mem, total_mem;
+    cudaError_t err;
+    CUresult res;
+
+    cudaMemGetInfo(&free_before, &total_mem);
+
+    err = cudaMallocAsync(&ptr, 200 * MiB, NULL);
+    TEST_ASSERT(err == cudaSuccess, "200 MiB cudaMallocAsync succeeds");
+
+    res = cuMemAlloc(&dptr, 200 * MiB);
+    TEST_ASSERT(res == CUDA_SUCCESS, "200 MiB cuMemAlloc succeeds");
+
+    CUmemAllocationProp prop;
+    memset(&prop, 0, sizeof(prop));
+    prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+    prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    prop.location.id = 0;
+    res = cuMemCreate(&handle, 200 * MiB, &prop, 0);
+    TEST_ASSERT(res == CUDA_SUCCESS, "200 MiB cuMemCreate succeeds");
+
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_before - free_mem == 600 * MiB,
+                "Async, driver and VMM allocations are charged to the quota");
+
+    err = cudaMallocAsync(&denied, free_mem + MiB, NULL);
+    TEST_ASSERT(err == cudaErrorMemoryAllocation, "cudaMallocAsync beyond quota is denied");
+
+    cudaFreeAsync(ptr, NULL);
+    cuMemFree(dptr);
+    cuMemRelease(handle);
+
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == free_before, "Async, driver and VMM frees release the quota");
+}
+
+void test_proc_address(void) {
+    printf("\n=== Test: Driver Entry Points via cuGetProcAddress ===\n");
+
+    CUresult (*mem_alloc)(CUdeviceptr *dptr, size_t bytesize) = NULL;
+    CUresult (*mem_free)(CUdeviceptr dptr) = NULL;
+    CUdeviceptr dptr = 0;
+    size_t free_before, free_mem, total_mem;
+    CUresult res;
+
+    res = cuGetProcAddress("cuMemAlloc", (void **)&mem_alloc, 12000, 0, NULL);
+    TEST_ASSERT(res == CUDA_SUCCESS && mem_alloc != NULL, "cuGetProcAddress finds cuMemAlloc");
+    res = cuGetProcAddress("cuMemFree", (void **)&mem_free, 12000, 0, NULL);
+    TEST_ASSERT(res == CUDA_SUCCESS && mem_free != NULL, "cuGetProcAddress finds cuMemFree");
+    if (!mem_alloc || !mem_free) {
+        return;
+    }
+
+    cudaMemGetInfo(&free_before, &total_mem);
+    res = mem_alloc(&dptr, 100 * MiB);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(res == CUDA_SUCCESS && free_before - free_mem == 100 * MiB,
+                "Allocation through a fetched entry point is charged");
+
+    mem_free(dptr);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == free_before, "Free through a fetched entry point is credited");
+}
+
+#define STATS_PAGE_SIZE 1536
+#define STATS_SEQ_OFFSET 24
+#define STATS_DEVICE_OFFSET(dev) (512 + (dev) * 64)
+
+/* Read device 0's quota_used from a stats page using the seqlock protocol */
+static uint64_t stats_read_used(const unsigned char *page) {
+    const volatile uint64_t *seq = (const volatile uint64_t *)(page + STATS_SEQ_OFFSET);
+    uint64_t before, after, used;
+
+    do {
+        before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        memcpy(&used, page + STATS_DEVICE_OFFSET(0) + 8, sizeof(used));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+
+    return used;
+}
+
+void test_stats_page(void) {
+    printf("\n=== Test: Shared Stats Page ===\n");
+
+    const char *dir = getenv("HCS_STATS_DIR");
+    if (!dir) {
+        printf("  HCS_STATS_DIR not set, skipping\n");
+        return;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%d", dir, (int)getpid());
+    int fd = open(path, O_RDONLY);
+    TEST_ASSERT(fd >= 0, "Stats page exists for this process");
+    if (fd < 0) return;
+
+    const unsigned char *page = mmap(NULL, STATS_PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    TEST_ASSERT(page != MAP_FAILED, "Stats page can be mapped read-only");
+    if (page == MAP_FAILED) return;
+
+    TEST_ASSERT(memcmp(page, "HCST", 4) == 0, "Stats page carries the HCST magic");
+
+    void *ptr = NULL;
+    cudaMalloc(&ptr, 100 * MiB);
+    usleep(200 * 1000);
+    TEST_ASSERT(stats_read_used(page) == 100 * MiB, "Stats page reflects a new allocation");
+
+    cudaFree(ptr);
+    usleep(200 * 1000);
+    TEST_ASSERT(stats_read_used(page) == 0, "Stats page reflects the free");
+
+    munmap((void *)page, STATS_PAGE_SIZE);
+}
+
+void test_quota_pool(void) {
+    printf("\n=== Test: Shared Quota Pool ===\n");
+
+    if (!getenv("HCS_QUOTA_POOL")) {
+        printf("  HCS_QUOTA_POOL not set, skipping\n");
+        return;
+    }
+
+    void *parent_ptr = NULL;
+    cudaError_t err = cudaMalloc(&parent_ptr, 600 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "Parent allocates 600 MiB from the pool");
+
+    /* The child shares the pool, then exits without freeing, as if it
+     * had crashed */
+    pid_t pid = fork();
+    if (pid == 0) {
+        int failures = 0;
+        size_t free_mem, total_mem;
+        void *ptr = NULL;
+
+        cudaMemGetInfo(&free_mem, &total_mem);
+        if (total_mem - free_mem != 600 * MiB) failures |= 1;
+        if (cudaMalloc(&ptr, 600 * MiB) == cudaSuccess) failures |= 2;
+        if (cudaMalloc(&ptr, 300 * MiB) != cudaSuccess) failures |= 4;
+        _exit(failures);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    int failures = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    TEST_ASSERT(failures >= 0 && !(failures & 1), "Child sees the parent's usage in the pool");
+    TEST_ASSERT(failures >= 0 && !(failures & 2), "Child is denied what the pool cannot hold");
+    TEST_ASSERT(failures >= 0 && !(failures & 4), "Child allocates what is left of the pool");
+
+    /* 600 + 300 MiB are charged; the dead child's share must come back */
+    void *ptr = NULL;
+    err = cudaMalloc(&ptr, 400 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "Exited child's charges are reclaimed");
+
+    cudaFree(ptr);
+    cudaFree(parent_ptr);
+
+    size_t free_mem, total_mem;
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == total_mem, "Pool fully released");
+}
+
+void test_caching_pool(void) {
+    printf("\n=== Test: Caching Sub-Allocator ===\n");
+
+    if (!getenv("HCS_POOL")) {
+        printf("  HCS_POOL not set, skipping\n");
+        return;
+    }
+
+    void *a = NULL, *b = NULL, *c = NULL, *big = NULL;
+    size_t free_before, free_mem, total_mem;
+    cudaError_t err;
+
+    cudaMemGetInfo(&free_before, &total_mem);
+
+    err = cudaMalloc(&a, 4096);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(err == cudaSuccess && free_before - free_mem == 2 * MiB,
+                "First small allocation charges one 2 MiB chunk");
+
+    err = cudaMalloc(&b, 3000);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(err == cudaSuccess && free_before - free_mem == 2 * MiB,
+                "Second small allocation comes from the same chunk");
+    TEST_ASSERT(b != a && (char *)b - (char *)a == 4096,
+                "Blocks of one size class are packed in the chunk");
+
+    cudaFree(a);
+    err = cudaMalloc(&c, 4096);
+    TEST_ASSERT(err == cudaSuccess && c == a, "A freed block is reused");
+
+    cudaFree(b);
+    cudaFree(c);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_before - free_mem == 2 * MiB, "Free chunks stay cached");
+
+    /* The whole quota only fits once the cached chunk is handed back */
+    err = cudaMalloc(&big, free_before);
+    TEST_ASSERT(err == cudaSuccess, "Denied allocation trims cached chunks and succeeds");
+    cudaFree(big);
+
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == free_before, "Quota fully released after trim");
+
+    /* A small request whose chunk no longer fits is charged at its own size */
+    err = cudaMalloc(&big, free_before - 1 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "Large allocation leaves less than a chunk");
+    err = cudaMalloc(&a, 4096);
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(err == cudaSuccess && free_mem == 1 * MiB - 4096,
+                "Small allocation falls back to the runtime when its chunk does not fit");
+    cudaFree(a);
+    cudaFree(big);
+
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == free_before, "Quota fully released after fallback");
+}
+
+static int pressure_calls = 0;
+static int pressure_device = -1;
+
+static void on_pressure(int device, size_t used, size_t soft_limit, size_t limit, void *arg) {
+    (void)used;
+    (void)soft_limit;
+    (void)limit;
+    pressure_calls++;
+    pressure_device = device;
+    *(int *)arg = 1;
+}
+
+void test_memory_pressure(void) {
+    printf("\n=== Test: Memory Pressure ===\n");
+
+    if (!getenv("HCS_VRAM_SOFT_LIMIT") || !getenv("HCS_MANAGED_OVERSUBSCRIBE")) {
+        printf("  HCS_VRAM_SOFT_LIMIT/HCS_MANAGED_OVERSUBSCRIBE not set, skipping\n");
+        return;
+    }
+
+    /* Frameworks find the API at run time, the interceptor being optional */
+    void (*set_callback)(void (*)(int, size_t, size_t, size_t, void *), void *) =
+        (void (*)(void (*)(int, size_t, size_t, size_t, void *), void *))
+            dlsym(RTLD_DEFAULT, "hcs_set_pressure_callback");
+    int (*pressure_eventfd)(void) = (int (*)(void))dlsym(RTLD_DEFAULT, "hcs_pressure_eventfd");
+    int (*under_pressure)(int) = (int (*)(int))dlsym(RTLD_DEFAULT, "hcs_memory_pressure");
+    TEST_ASSERT(set_callback && pressure_eventfd && under_pressure,
+                "Pressure API is exported");
+    if (!set_callback || !pressure_eventfd || !under_pressure) return;
+
+    int flagged = 0;
+    set_callback(on_pressure, &flagged);
+    int efd = pressure_eventfd();
+    TEST_ASSERT(efd >= 0 && pressure_eventfd() == efd, "Pressure eventfd is created once");
+
+    /* 1 GiB quota, 75% watermark at 768 MiB */
+    uint64_t count = 0;
+    void *base = NULL, *over = NULL, *more = NULL;
+    cudaMalloc(&base, 700 * MiB);
+    TEST_ASSERT(pressure_calls == 0 && read(efd, &count, sizeof(count)) < 0,
+                "No signal below the soft limit");
+
+    cudaError_t err = cudaMalloc(&over, 100 * MiB);
+    TEST_ASSERT(err == cudaSuccess, "Allocation past the soft limit still succeeds");
+    TEST_ASSERT(pressure_calls == 1 && pressure_device == 0 && flagged,
+                "Crossing the soft limit calls the callback");
+    TEST_ASSERT(read(efd, &count, sizeof(count)) == sizeof(count) && count == 1,
+                "Crossing the soft limit signals the eventfd");
+    TEST_ASSERT(under_pressure(0) == 1, "Device reports pressure");
+
+    cudaMalloc(&more, 10 * MiB);
+    TEST_ASSERT(pressure_calls == 1, "Further allocations do not signal again");
+
+    /* Pressure clears 1/16 below the watermark, at 720 MiB */
+    cudaFree(more);
+    TEST_ASSERT(under_pressure(0) == 1, "Pressure holds above the hysteresis margin");
+    cudaFree(over);
+    TEST_ASSERT(under_pressure(0) == 0, "Pressure clears below the margin");
+
+    /* Oversubscribed managed memory: capped at 2 GiB with the device memory */
+    size_t free_mem, total_mem;
+    void *managed = NULL, *denied = NULL;
+    err = cudaMallocManaged(&managed, 1 * GiB, cudaMemAttachGlobal);
+    TEST_ASSERT(err == cudaSuccess, "Managed allocation may exceed the quota");
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(total_mem - free_mem == 700 * MiB, "Managed memory is not charged to the quota");
+    err = cudaMallocManaged(&denied, 400 * MiB, cudaMemAttachGlobal);
+    TEST_ASSERT(err == cudaErrorMemoryAllocation, "Managed memory is capped by the oversubscription factor");
+    TEST_ASSERT(pressure_calls == 1, "Managed memory does not raise pressure");
+
+    cudaFree(managed);
+    cudaFree(base);
+    set_callback(NULL, NULL);
+
+    cudaMemGetInfo(&free_mem, &total_mem);
+    TEST_ASSERT(free_mem == total_mem, "Quota fully released");
+}
+
 void test_null_free(void) {
     printf("\n=== Test: NULL Free ===\n");
 
@@ -245,10 +715,29 @@ void test_null_free(void) {
  * Main
  * ============================================================================ */
 
+static const struct {
+    const char *name;
+    void (*run)(void);
+} tests[] = {
+    {"basic_allocation", test_basic_allocation},
+    {"quota_enforcement", test_quota_enforcement},
+    {"memory_info_virtualization", test_memory_info_virtualization},
+    {"multiple_allocations", test_multiple_allocations},
+    {"allocation_churn", test_allocation_churn},
+    {"concurrent_quota", test_concurrent_quota},
+    {"per_device_quota", test_per_device_quota},
+    {"unlisted_device", test_unlisted_device},
+    {"async_and_driver_allocation", test_async_and_driver_allocation},
+    {"proc_address", test_proc_address},
+    {"stats_page", test_stats_page},
+    {"quota_pool", test_quota_pool},
+    {"caching_pool", test_caching_pool},
+    {"memory_pressure", test_memory_pressure},
+    {"null_free", test_null_free},
+};
+
+/* Usage: test_interceptor [test_name...]; runs every test by default */
 int main(int argc, char **argv) {
-    (void)argc;
-    (void)argv;
-
     printf("HCS Interceptor Test Suite\n");
     printf("==========================\n");
 
@@ -275,11 +764,17 @@ int main(int argc, char **argv) {
     }
 
     /* Run tests */
-    test_basic_allocation();
-    test_quota_enforcement();
-    test_memory_info_virtualization();
-    test_multiple_allocations();
-    test_null_free();
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool selected = argc < 2;
+        for (int a = 1; a < argc; a++) {
+            if (strcmp(argv[a], tests[i].name) == 0) {
+                selected = true;
+            }
+        }
+        if (selected) {
+            tests[i].run();
+        }
+    }
 
     /* Summary */
     printf("\n==========================\n");
@@ -3,244 +3,211 @@ package ebpf
 import (
 	"math"
 	"sync"
+	"sync/atomic"
 	"time"
 )
 
 // HealthAnalyzer 健康分析器，进行趋势分析和预测性健康评分
+//
+// 每个设备的状态独立加锁（deviceState），设备表以写时复制方式通过原子指针发布：
+// 事件写入与快照读取只在各自设备上竞争，查找设备不加全局锁。
+// 设备表只在注册新设备或重置设备时替换（regMu 串行化）。
 type HealthAnalyzer struct {
+	devices atomic.Pointer[map[uint32]*deviceState]
+	regMu   sync.Mutex
+
+	// 默认阈值
+	defaultThresholds *DetectionThresholds
+}
+
+// deviceState 单设备的分析状态
+type deviceState struct {
 	mu sync.RWMutex
 
-	// 每设备的事件缓冲区
-	gpuBuffers    map[uint32]*EventBuffer
-	pcieBuffers   map[uint32]*EventBuffer
-	healthBuffers map[uint32]*EventBuffer
+	// 分析窗口（写入时增量维护统计值）
+	gpu    *gpuWindow
+	pcie   *pcieWindow
+	health *healthWindow
 
-	// 学习的基线值
-	baselines map[uint32]*BaselineMetrics
+	// 学习的基线值，收到首个 GPU 事件后有效
+	baseline    BaselineMetrics
+	hasBaseline bool
 
 	// 检测阈值
-	thresholds map[uint32]*DetectionThresholds
-
-	// 默认阈值
-	defaultThresholds *DetectionThresholds
+	threshold atomic.Pointer[DetectionThresholds]
 }
 
 // NewHealthAnalyzer 创建新的健康分析器
 func NewHealthAnalyzer() *HealthAnalyzer {
-	return &HealthAnalyzer{
-		gpuBuffers:         make(map[uint32]*EventBuffer),
-		pcieBuffers:        make(map[uint32]*EventBuffer),
-		healthBuffers:      make(map[uint32]*EventBuffer),
-		baselines:          make(map[uint32]*BaselineMetrics),
-		thresholds:         make(map[uint32]*DetectionThresholds),
-		defaultThresholds:  DefaultThresholds(),
+	a := &HealthAnalyzer{
+		defaultThresholds: DefaultThresholds(),
+	}
+	devices := make(map[uint32]*deviceState)
+	a.devices.Store(&devices)
+	return a
+}
+
+// device 查找设备状态（无锁）
+func (a *HealthAnalyzer) device(deviceID uint32) *deviceState {
+	return (*a.devices.Load())[deviceID]
+}
+
+// RegisterDevice 注册设备，已注册时直接返回现有状态
+// 通常由 EBPFManager.AddDevices 在设备发现时调用一次；首次收到未注册设备的事件时也会注册
+func (a *HealthAnalyzer) RegisterDevice(deviceID uint32) *deviceState {
+	if st := a.device(deviceID); st != nil {
+		return st
+	}
+
+	a.regMu.Lock()
+	defer a.regMu.Unlock()
+
+	current := *a.devices.Load()
+	if st, ok := current[deviceID]; ok {
+		return st
 	}
+
+	st := &deviceState{
+		gpu:    newGPUWindow(AnalysisWindow),
+		pcie:   newPCIeWindow(AnalysisWindow),
+		health: newHealthWindow(AnalysisWindow),
+	}
+	st.threshold.Store(a.defaultThresholds)
+
+	next := make(map[uint32]*deviceState, len(current)+1)
+	for id, existing := range current {
+		next[id] = existing
+	}
+	next[deviceID] = st
+	a.devices.Store(&next)
+	return st
 }
 
 // AddGPUEvent 添加 GPU 事件
 func (a *HealthAnalyzer) AddGPUEvent(event GPUEvent) {
-	a.mu.Lock()
-	defer a.mu.Unlock()
+	st := a.RegisterDevice(event.DeviceID)
 
-	if _, ok := a.gpuBuffers[event.DeviceID]; !ok {
-		a.gpuBuffers[event.DeviceID] = NewEventBuffer(AnalysisWindow)
-		a.baselines[event.DeviceID] = &BaselineMetrics{}
-		a.thresholds[event.DeviceID] = DefaultThresholds()
-	}
-	a.gpuBuffers[event.DeviceID].Add(event)
+	st.mu.Lock()
+	defer st.mu.Unlock()
+
+	st.gpu.add(event)
+	st.updateBaseline(event.Timestamp)
 }
 
 // AddPCIeEvent 添加 PCIe 事件
 func (a *HealthAnalyzer) AddPCIeEvent(event PCIeEvent) {
-	a.mu.Lock()
-	defer a.mu.Unlock()
+	st := a.RegisterDevice(event.DeviceID)
 
-	if _, ok := a.pcieBuffers[event.DeviceID]; !ok {
-		a.pcieBuffers[event.DeviceID] = NewEventBuffer(AnalysisWindow)
-	}
-	a.pcieBuffers[event.DeviceID].Add(event)
+	st.mu.Lock()
+	defer st.mu.Unlock()
+
+	st.pcie.add(event)
 }
 
 // AddHealthEvent 添加健康事件
 func (a *HealthAnalyzer) AddHealthEvent(event HealthEvent) {
-	a.mu.Lock()
-	defer a.mu.Unlock()
+	st := a.RegisterDevice(event.DeviceID)
 
-	if _, ok := a.healthBuffers[event.DeviceID]; !ok {
-		a.healthBuffers[event.DeviceID] = NewEventBuffer(AnalysisWindow)
-	}
-	a.healthBuffers[event.DeviceID].Add(event)
+	st.mu.Lock()
+	defer st.mu.Unlock()
+
+	st.health.add(event)
 }
 
 // GetSnapshot 获取设备的健康快照
+// 所有统计量在写入时增量维护，这里只读取，代价与窗口大小无关
 func (a *HealthAnalyzer) GetSnapshot(deviceID uint32) *DeviceHealthSnapshot {
-	a.mu.RLock()
-	defer a.mu.RUnlock()
+	st := a.device(deviceID)
+	if st == nil {
+		return a.emptySnapshot(deviceID)
+	}
 
+	st.mu.RLock()
+	defer st.mu.RUnlock()
+	return a.snapshotLocked(deviceID, st)
+}
+
+// emptySnapshot 未注册设备的快照
+func (a *HealthAnalyzer) emptySnapshot(deviceID uint32) *DeviceHealthSnapshot {
 	snapshot := &DeviceHealthSnapshot{
-		DeviceID:  deviceID,
-		Timestamp: time.Now(),
+		DeviceID:    deviceID,
+		Timestamp:   time.Now(),
 		HealthScore: 100.0,
-		Confidence: 0.5,
+		Confidence:  0.5,
+	}
+	snapshot.HealthScore = a.computeHealthScore(snapshot, nil)
+	return snapshot
+}
+
+// snapshotLocked 生成快照，调用方须持有 st 的读锁
+func (a *HealthAnalyzer) snapshotLocked(deviceID uint32, st *deviceState) *DeviceHealthSnapshot {
+	snapshot := &DeviceHealthSnapshot{
+		DeviceID:    deviceID,
+		Timestamp:   time.Now(),
+		HealthScore: 100.0,
+		Confidence:  0.5,
 	}
 
 	// 获取最新的 GPU 事件
-	if buf, ok := a.gpuBuffers[deviceID]; ok && buf.Count() > 0 {
-		events := buf.GetAll()
-		if len(events) > 0 {
-			latest := events[len(events)-1].(GPUEvent)
-			snapshot.CoreClock = latest.CoreClock
-			snapshot.MemoryClock = latest.MemoryClock
-			snapshot.Temperature = latest.Temperature
-			snapshot.Power = latest.Power
-			snapshot.Utilization = latest.Utilization
-
-			// 检查降频
-			snapshot.IsThrottling = latest.ThrottlingFlags != 0
-			if latest.ThrottlingFlags&0x01 != 0 {
-				snapshot.ThrottleReason = ThrottleReasonPower
-			} else if latest.ThrottlingFlags&0x02 != 0 {
-				snapshot.ThrottleReason = ThrottleReasonThermal
-			}
-
-			// 计算趋势
-			snapshot.TemperatureTrend = a.computeTemperatureTrend(events)
-			snapshot.PowerTrend = a.computePowerTrend(events)
+	if w := st.gpu; w.Len() > 0 {
+		latest := w.latest
+		snapshot.CoreClock = latest.CoreClock
+		snapshot.MemoryClock = latest.MemoryClock
+		snapshot.Temperature = latest.Temperature
+		snapshot.Power = latest.Power
+		snapshot.Utilization = latest.Utilization
+
+		// 检查降频；gpu_monitor 目前不采集降频标志，ThrottlingFlags 恒为 0
+		snapshot.IsThrottling = latest.ThrottlingFlags != 0
+		if latest.ThrottlingFlags&0x01 != 0 {
+			snapshot.ThrottleReason = ThrottleReasonPower
+		} else if latest.ThrottlingFlags&0x02 != 0 {
+			snapshot.ThrottleReason = ThrottleReasonThermal
 		}
+
+		// 趋势（写入时增量维护）
+		snapshot.TemperatureTrend = w.temperature.slope()
+		snapshot.PowerTrend = w.power.slope()
 	}
 
 	// 获取 PCIe 带宽
-	if buf, ok := a.pcieBuffers[deviceID]; ok && buf.Count() > 0 {
-		events := buf.GetAll()
-		snapshot.PCIeBandwidth = a.computePCIeBandwidth(events)
+	if w := st.pcie; w.Len() > 0 {
+		snapshot.PCIeBandwidth = a.computePCIeBandwidth(w)
 	}
 
 	// 统计健康事件
-	if buf, ok := a.healthBuffers[deviceID]; ok && buf.Count() > 0 {
-		events := buf.GetAll()
-		a.countHealthEvents(events, snapshot)
-		snapshot.ECCErrorRate = a.computeECCErrorRate(events)
+	if w := st.health; w.Len() > 0 {
+		snapshot.ECCSingleBitCount = w.eccSingleBit
+		snapshot.ECCDoubleBitCount = w.eccDoubleBit
+		snapshot.PageRetireCount = w.pageRetire
+		snapshot.ECCErrorRate = w.eccErrorRate()
 	}
 
 	// 计算健康分
-	snapshot.HealthScore = a.ComputeHealthScore(snapshot)
-
-	// 更新基线
-	a.updateBaseline(deviceID, snapshot)
+	snapshot.HealthScore = a.computeHealthScore(snapshot, st)
 
 	return snapshot
 }
 
-// computeTemperatureTrend 计算温度趋势 (°C/sec)
-func (a *HealthAnalyzer) computeTemperatureTrend(events []interface{}) float64 {
-	if len(events) < 2 {
-		return 0
-	}
-
-	// 简单线性回归
-	n := float64(len(events))
-	var sumX, sumY, sumXY, sumX2 float64
-
-	for i, evt := range events {
-		e := evt.(GPUEvent)
-		x := float64(i)
-		y := float64(e.Temperature)
-		sumX += x
-		sumY += y
-		sumXY += x * y
-		sumX2 += x * x
-	}
-
-	slope := (n*sumXY - sumX*sumY) / (n*sumX2 - sumX*sumX)
-	return slope // 每个采样周期的温度变化
-}
-
-// computePowerTrend 计算功耗趋势 (W/sec)
-func (a *HealthAnalyzer) computePowerTrend(events []interface{}) float64 {
-	if len(events) < 2 {
-		return 0
-	}
-
-	n := float64(len(events))
-	var sumX, sumY, sumXY, sumX2 float64
-
-	for i, evt := range events {
-		e := evt.(GPUEvent)
-		x := float64(i)
-		y := float64(e.Power)
-		sumX += x
-		sumY += y
-		sumXY += x * y
-		sumX2 += x * x
-	}
-
-	slope := (n*sumXY - sumX*sumY) / (n*sumX2 - sumX*sumX)
-	return slope
-}
-
 // computePCIeBandwidth 计算 PCIe 带宽 (GB/s)
-func (a *HealthAnalyzer) computePCIeBandwidth(events []interface{}) float64 {
-	if len(events) == 0 {
-		return 0
-	}
-
-	var totalRead, totalWrite uint64
-	for _, evt := range events {
-		e := evt.(PCIeEvent)
-		totalRead += e.ReadBytes
-		totalWrite += e.WriteBytes
-	}
-
-	// 简化计算：假设事件间隔为 1 秒
-	totalBytes := totalRead + totalWrite
-	return float64(totalBytes) / (1024 * 1024 * 1024) // GB
+func (a *HealthAnalyzer) computePCIeBandwidth(w *pcieWindow) float64 {
+	return w.bytesPerSecond() / (1024 * 1024 * 1024)
 }
 
-// countHealthEvents 统计健康事件
-func (a *HealthAnalyzer) countHealthEvents(events []interface{}, snapshot *DeviceHealthSnapshot) {
-	for _, evt := range events {
-		e := evt.(HealthEvent)
-		switch e.Type {
-		case EventECCSingleBit:
-			snapshot.ECCSingleBitCount += uint64(e.Count)
-		case EventECCDoubleBit:
-			snapshot.ECCDoubleBitCount += uint64(e.Count)
-		case EventPageRetire:
-			snapshot.PageRetireCount += uint64(e.Count)
-		}
-	}
-}
-
-// computeECCErrorRate 计算 ECC 错误率 (errors/sec)
-func (a *HealthAnalyzer) computeECCErrorRate(events []interface{}) float64 {
-	if len(events) < 2 {
-		return 0
-	}
-
-	// 计算时间跨度
-	first := events[0].(HealthEvent).Timestamp
-	last := events[len(events)-1].(HealthEvent).Timestamp
-	duration := last.Sub(first).Seconds()
-	if duration <= 0 {
-		return 0
-	}
-
-	// 统计总错误数
-	var count uint64
-	for _, evt := range events {
-		e := evt.(HealthEvent)
-		if e.Type == EventECCSingleBit || e.Type == EventECCDoubleBit {
-			count += uint64(e.Count)
-		}
+// ComputeHealthScore 计算综合健康分 (0-100)
+func (a *HealthAnalyzer) ComputeHealthScore(snapshot *DeviceHealthSnapshot) float64 {
+	st := a.device(snapshot.DeviceID)
+	if st != nil {
+		st.mu.RLock()
+		defer st.mu.RUnlock()
 	}
-
-	return float64(count) / duration
+	return a.computeHealthScore(snapshot, st)
 }
 
-// ComputeHealthScore 计算综合健康分 (0-100)
-func (a *HealthAnalyzer) ComputeHealthScore(snapshot *DeviceHealthSnapshot) float64 {
+// computeHealthScore 计算健康分，st 非空时调用方须持有其读锁
+func (a *HealthAnalyzer) computeHealthScore(snapshot *DeviceHealthSnapshot, st *deviceState) float64 {
 	score := 100.0
-	threshold := a.getThreshold(snapshot.DeviceID)
+	threshold := a.thresholdOf(st)
 
 	// 温度评分 (0-25分)
 	if snapshot.Temperature > threshold.TemperatureCritical {
@@ -269,8 +236,8 @@ func (a *HealthAnalyzer) ComputeHealthScore(snapshot *DeviceHealthSnapshot) floa
 	}
 
 	// 时钟降频惩罚 (0-10分)
-	baseline := a.getBaseline(snapshot.DeviceID)
-	if baseline != nil && baseline.AverageClock > 0 {
+	if st != nil && st.hasBaseline && st.baseline.AverageClock > 0 {
+		baseline := &st.baseline
 		degradation := baseline.AverageClock - float64(snapshot.CoreClock)
 		if degradation > threshold.ClockDegradation {
 			score -= 10
@@ -282,11 +249,16 @@ func (a *HealthAnalyzer) ComputeHealthScore(snapshot *DeviceHealthSnapshot) floa
 
 // IsPredictiveFailure 预测是否即将发生故障
 func (a *HealthAnalyzer) IsPredictiveFailure(deviceID uint32) (bool, string) {
-	a.mu.RLock()
-	defer a.mu.RUnlock()
+	st := a.device(deviceID)
+	if st == nil {
+		return false, ""
+	}
+
+	st.mu.RLock()
+	defer st.mu.RUnlock()
 
-	snapshot := a.GetSnapshot(deviceID)
-	threshold := a.getThreshold(deviceID)
+	snapshot := a.snapshotLocked(deviceID, st)
+	threshold := a.thresholdOf(st)
 
 	reasons := []string{}
 
@@ -306,8 +278,8 @@ func (a *HealthAnalyzer) IsPredictiveFailure(deviceID uint32) (bool, string) {
 	}
 
 	// 严重时钟降频
-	baseline := a.getBaseline(deviceID)
-	if baseline != nil && baseline.AverageClock > 0 {
+	if st.hasBaseline && st.baseline.AverageClock > 0 {
+		baseline := &st.baseline
 		degradation := baseline.AverageClock - float64(snapshot.CoreClock)
 		if degradation > threshold.ClockDegradation*2 {
 			reasons = append(reasons, "severe_clock_degradation")
@@ -322,72 +294,83 @@ func (a *HealthAnalyzer) IsPredictiveFailure(deviceID uint32) (bool, string) {
 	return len(reasons) > 0, ""
 }
 
-// getThreshold 获取设备的检测阈值
-func (a *HealthAnalyzer) getThreshold(deviceID uint32) *DetectionThresholds {
-	if t, ok := a.thresholds[deviceID]; ok {
-		return t
+// thresholdOf 获取设备的检测阈值
+func (a *HealthAnalyzer) thresholdOf(st *deviceState) *DetectionThresholds {
+	if st != nil {
+		if t := st.threshold.Load(); t != nil {
+			return t
+		}
 	}
 	return a.defaultThresholds
 }
 
-// getBaseline 获取设备的基线
-func (a *HealthAnalyzer) getBaseline(deviceID uint32) *BaselineMetrics {
-	return a.baselines[deviceID]
-}
-
-// updateBaseline 更新设备的运行基线
-func (a *HealthAnalyzer) updateBaseline(deviceID uint32, snapshot *DeviceHealthSnapshot) {
-	baseline := a.baselines[deviceID]
-	if baseline == nil {
-		baseline = &BaselineMetrics{}
-		a.baselines[deviceID] = baseline
-	}
-
-	// 指数移动平均
-	alpha := 0.1
-	baseline.AverageTemperature = alpha*float64(snapshot.Temperature) + (1-alpha)*baseline.AverageTemperature
-	baseline.AveragePower = alpha*float64(snapshot.Power) + (1-alpha)*baseline.AveragePower
-	baseline.AverageClock = alpha*float64(snapshot.CoreClock) + (1-alpha)*baseline.AverageClock
-
-	baseline.SampleCount++
-	baseline.LastUpdated = time.Now()
+// updateBaseline 用窗口的指数加权估计刷新设备基线，调用方须持有写锁
+func (st *deviceState) updateBaseline(ts time.Time) {
+	w := st.gpu
+	st.baseline.AverageTemperature = w.baseTemperature.mean
+	st.baseline.AveragePower = w.basePower.mean
+	st.baseline.AverageClock = w.baseClock.mean
+	st.baseline.StdDevTemp = w.baseTemperature.stdDev()
+	st.baseline.StdDevPower = w.basePower.stdDev()
+
+	st.baseline.SampleCount++
+	st.baseline.LastUpdated = ts
+	st.hasBaseline = true
 }
 
 // SetThreshold 设置设备的检测阈值
 func (a *HealthAnalyzer) SetThreshold(deviceID uint32, threshold *DetectionThresholds) {
-	a.mu.Lock()
-	defer a.mu.Unlock()
-	a.thresholds[deviceID] = threshold
+	a.RegisterDevice(deviceID).threshold.Store(threshold)
 }
 
 // GetBaseline 获取设备的基线（外部调用）
 func (a *HealthAnalyzer) GetBaseline(deviceID uint32) (*BaselineMetrics, bool) {
-	a.mu.RLock()
-	defer a.mu.RUnlock()
-	baseline, ok := a.baselines[deviceID]
-	return baseline, ok
+	st := a.device(deviceID)
+	if st == nil {
+		return nil, false
+	}
+
+	st.mu.RLock()
+	defer st.mu.RUnlock()
+	if !st.hasBaseline {
+		return nil, false
+	}
+	// 返回副本，基线在写入路径上持续更新
+	copied := st.baseline
+	return &copied, true
 }
 
 // ResetDevice 重置设备的分析状态
 func (a *HealthAnalyzer) ResetDevice(deviceID uint32) {
-	a.mu.Lock()
-	defer a.mu.Unlock()
-
-	delete(a.gpuBuffers, deviceID)
-	delete(a.pcieBuffers, deviceID)
-	delete(a.healthBuffers, deviceID)
-	delete(a.baselines, deviceID)
-	delete(a.thresholds, deviceID)
+	a.regMu.Lock()
+	defer a.regMu.Unlock()
+
+	current := *a.devices.Load()
+	if _, ok := current[deviceID]; !ok {
+		return
+	}
+
+	next := make(map[uint32]*deviceState, len(current))
+	for id, st := range current {
+		if id != deviceID {
+			next[id] = st
+		}
+	}
+	a.devices.Store(&next)
 }
 
-// GetAllDeviceIDs 获取所有已分析的设备 ID
+// GetAllDeviceIDs 获取所有已收到 GPU 事件的设备 ID
 func (a *HealthAnalyzer) GetAllDeviceIDs() []uint32 {
-	a.mu.RLock()
-	defer a.mu.RUnlock()
-
-	ids := make([]uint32, 0, len(a.gpuBuffers))
-	for id := range a.gpuBuffers {
-		ids = append(ids, id)
+	devices := *a.devices.Load()
+
+	ids := make([]uint32, 0, len(devices))
+	for id, st := range devices {
+		st.mu.RLock()
+		hasGPU := st.gpu.Len() > 0
+		st.mu.RUnlock()
+		if hasGPU {
+			ids = append(ids, id)
+		}
 	}
 	return ids
 }
@@ -3,8 +3,8 @@ package ebpf
 import (
 	"context"
 	"fmt"
-	"strconv"
 	"sync"
+	"time"
 
 	"github.com/zrs-products/hetero-compute-router/pkg/collectors"
 	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
@@ -62,11 +62,14 @@ func (c *EBPFHealthCollector) Collect(ctx context.Context, devices []*detectors.
 
 	totalScore := 0.0
 	deviceCount := 0
+	histograms := c.manager.GetPCIeHistograms()
+	deviceNames := make(map[uint32]string, len(devices))
 
 	// 为每个设备创建指标
 	for _, dev := range devices {
-		deviceID := c.parseDeviceID(dev.ID)
-		if deviceID == 0 {
+		// 与 AddDevices 使用同一编号，gpu-0 对应内核中的设备 0
+		deviceID, ok := parseDeviceIndex(dev.ID)
+		if !ok {
 			continue
 		}
 
@@ -92,6 +95,17 @@ func (c *EBPFHealthCollector) Collect(ctx context.Context, devices []*detectors.
 			},
 		}
 
+		if hist, ok := histograms[deviceID]; ok && hist.Size.Count() > 0 {
+			dm.PCIe = &collectors.PCIeMetrics{
+				DMAMappings:   hist.Size.Count(),
+				DMASizeP50:    hist.Size.Quantile(0.5),
+				DMASizeP99:    hist.Size.Quantile(0.99),
+				DMALatencyP50: time.Duration(hist.Latency.Quantile(0.5)),
+				DMALatencyP99: time.Duration(hist.Latency.Quantile(0.99)),
+			}
+		}
+		deviceNames[deviceID] = dev.ID
+
 		metrics.DeviceMetrics = append(metrics.DeviceMetrics, dm)
 
 		totalScore += snapshot.HealthScore
@@ -109,33 +123,32 @@ func (c *EBPFHealthCollector) Collect(ctx context.Context, devices []*detectors.
 		metrics.Health.Score = totalScore / float64(deviceCount)
 	}
 
-	return metrics, nil
-}
-
-// parseDeviceID 从设备 ID 字符串解析数字 ID
-func (c *EBPFHealthCollector) parseDeviceID(id string) uint32 {
-	// 支持 "gpu-0", "dcu-0", "npu-0" 等格式
-	var num int
-	if n, err := fmt.Sscanf(id, "gpu-%d", &num); n == 1 && err == nil {
-		return uint32(num)
+	stats := c.manager.GetHealthEventStats()
+	vramStats := c.manager.GetVRAMTrackerStats()
+	metrics.Telemetry = &collectors.TelemetryMetrics{
+		HealthEventsEmitted:       stats.Emitted,
+		HealthEventsCoalesced:     stats.Coalesced,
+		HealthEventsDropped:       stats.Dropped,
+		TracedVRAMAllocsUntracked: vramStats.AllocsUntracked,
+		TracedVRAMProcsUntracked:  vramStats.ProcsUntracked,
 	}
-	if n, err := fmt.Sscanf(id, "dcu-%d", &num); n == 1 && err == nil {
-		return uint32(num)
-	}
-	if n, err := fmt.Sscanf(id, "npu-%d", &num); n == 1 && err == nil {
-		return uint32(num)
-	}
-
-	// 尝试从最后提取数字
-	for i := len(id) - 1; i >= 0; i-- {
-		if id[i] == '-' {
-			if num, err := strconv.Atoi(id[i+1:]); err == nil {
-				return uint32(num)
-			}
+	metrics.TracedVRAM = c.manager.GetContainerVRAMUsage()
+	for _, bw := range c.manager.GetPCIeCgroupBandwidth() {
+		name, ok := deviceNames[bw.DeviceID]
+		if !ok {
+			continue
 		}
+		metrics.TracedPCIe = append(metrics.TracedPCIe, collectors.ContainerPCIeUsage{
+			PodUID:           bw.PodUID,
+			ContainerID:      bw.ContainerID,
+			CgroupID:         bw.CgroupID,
+			DeviceID:         name,
+			ReadBytesPerSec:  bw.ReadBytesPerSec,
+			WriteBytesPerSec: bw.WriteBytesPerSec,
+		})
 	}
 
-	return 0
+	return metrics, nil
 }
 
 // Close 关闭采集器
@@ -30,6 +30,35 @@ type EBPFManager struct {
 	// 分析器
 	analyzer *HealthAnalyzer
 
+	// 内核聚合 GPU 指标的读取源（由加载器设置）及上次读取的累计值
+	gpuStats  GPUStatsSource
+	gpuCursor map[uint32]GPUDeviceStats
+
+	// PCIe 计数的读取源（由加载器设置）及上次读取的累计值
+	pcieStats  PCIeStatsSource
+	pcieCursor map[uint32]PCIeDeviceStats
+
+	// DMA 直方图与按 cgroup 计数的读取源（由加载器设置），以及按调用间隔做差的游标
+	pcieDetail       PCIeDetailSource
+	pcieMu           sync.Mutex
+	pcieDetailCursor pcieDetailCursor
+
+	// 内核设备注册表（由加载器设置）及已写入注册表的设备
+	registry   DeviceRegistry
+	registered map[uint32]bool
+
+	// 健康事件提交计数的读取源与限速合并计数的刷新器（由加载器设置）
+	healthStats HealthEventStatsSource
+	healthFlush HealthThrottleFlusher
+
+	// 每 cgroup 显存使用的读取源（由加载器设置）及 cgroup 到 Pod 的解析
+	vramUsage VRAMUsageSource
+	cgroups   *cgroupResolver
+
+	// 已加载的 eBPF 程序，以及 ring buffer 消费协程的退出信号
+	loader     programLoader
+	healthDone chan struct{}
+
 	// 控制通道
 	ctx    context.Context
 	cancel context.CancelFunc
@@ -51,6 +80,59 @@ type Config struct {
 	BufferSize int
 	// 是否在 eBPF 不可用时回退到轮询模式
 	FallbackToPolling bool
+	// bpffs 中固定 map 和 link 的目录
+	PinPath string
+	// 按类型覆盖健康事件的内核限速间隔，未设置的类型使用 GPUSampleInterval，0 表示不限速
+	HealthEventIntervals map[HealthEventType]time.Duration
+	// 是否加载 vram_tracker，通过 uprobe 按 cgroup 统计显存（不经过 LD_PRELOAD 拦截器）
+	VRAMTracing bool
+	// 挂载 VRAM uprobe 的运行时库路径，为空时在 VRAMLibraryDirs 中查找
+	VRAMLibraries []string
+	// 查找运行时库的目录，为空时使用宿主机常见目录；容器内运行时指向宿主机目录的挂载点
+	VRAMLibraryDirs []string
+	// cgroup v2 挂载点，用于将 cgroup id 解析为 Pod，为空时使用 /sys/fs/cgroup
+	// 容器内运行时需指向宿主机 cgroup 树的挂载点
+	CgroupRoot string
+}
+
+// programLoader 已加载并附加的 eBPF 程序集
+type programLoader interface {
+	GPUStatsSource
+	PCIeStatsSource
+	PCIeDetailSource
+	DeviceRegistry
+	HealthEventStatsSource
+	HealthThrottleFlusher
+	VRAMUsageSource
+	// ConfigureHealthThrottle 写入 health_throttle_cfg
+	ConfigureHealthThrottle(cfg HealthThrottleConfig) error
+	// ConsumeHealthEvents 阻塞读取 health_events ring buffer，直到 Close
+	ConsumeHealthEvents(handle func(HealthEvent)) error
+	Close() error
+}
+
+// GPUStatsSource 内核聚合 GPU 指标的读取接口
+// 由 eBPF 加载器基于 gpu_stats_map 实现，一次批量返回每设备的 per-CPU 聚合值
+type GPUStatsSource interface {
+	ReadGPUStats() (map[uint32][]GPUDeviceStats, error)
+}
+
+// PCIeStatsSource PCIe 计数的读取接口
+// 由 eBPF 加载器基于 pcie_stats_map 实现，一次批量返回每设备的 per-CPU 计数
+type PCIeStatsSource interface {
+	ReadPCIeStats() (map[uint32][]PCIeDeviceStats, error)
+}
+
+// HealthEventStatsSource 健康事件提交计数的读取接口
+// 由 eBPF 加载器基于 health_event_stats 实现
+type HealthEventStatsSource interface {
+	ReadHealthEventStats() (HealthEventStats, error)
+}
+
+// HealthThrottleFlusher 提交限速期间合并、且之后没有新事件带出的计数
+// 由 eBPF 加载器运行 flush_health_throttle 实现，记录经 ring buffer 送达
+type HealthThrottleFlusher interface {
+	FlushHealthThrottle() error
 }
 
 // DefaultConfig 返回默认配置
@@ -61,7 +143,16 @@ func DefaultConfig() *Config {
 		PCIeSampleInterval: 100 * time.Millisecond,
 		BufferSize:        1000,
 		FallbackToPolling: true,
+		PinPath:           "/sys/fs/bpf/hcs",
+	}
+}
+
+// cgroupRoot 返回 cgroup 树根目录
+func (c *Config) cgroupRoot() string {
+	if c.CgroupRoot != "" {
+		return c.CgroupRoot
 	}
+	return sysfsCgroup
 }
 
 // NewEBPFManager 创建新的 eBPF 管理器
@@ -77,6 +168,13 @@ func NewEBPFManager(config *Config) (*EBPFManager, error) {
 		healthEvents: make(chan HealthEvent, config.BufferSize),
 		snapshots:   make(map[uint32]*DeviceHealthSnapshot),
 		analyzer:    NewHealthAnalyzer(),
+		gpuCursor:   make(map[uint32]GPUDeviceStats),
+		pcieCursor:  make(map[uint32]PCIeDeviceStats),
+		registered:  make(map[uint32]bool),
+		cgroups:     newCgroupResolver(config.cgroupRoot()),
+		pcieDetailCursor: pcieDetailCursor{
+			hist: make(map[uint32]PCIeDeviceHistogram),
+		},
 		config:      config,
 	}
 
@@ -141,29 +239,35 @@ func (m *EBPFManager) Start() error {
 }
 
 // loadPrograms 加载 eBPF 程序
+// 加载器同时作为 GPU/PCIe 聚合 map 的读取源和设备注册表；
+// 健康事件由单独的协程直接从 ring buffer 解码后送入分析器，不经过 channel
 func (m *EBPFManager) loadPrograms() error {
-	// 这里应该编译和加载 eBPF 程序
-	// 由于需要 clang 和特定的内核头文件，这里只做框架
-
-	// 实际实现会:
-	// 1. 编译 .c 文件为 .o
-	// 2. 使用 cilium/ebpf 加载
-	// 3. 附加到 tracepoints
-
-	// 目前返回错误，触发回退
-	return fmt.Errorf("eBPF programs not compiled")
-}
-
-// attachTracepoints 附加到内核 tracepoints
-func (m *EBPFManager) attachTracepoints() error {
-	// 附加到 NVIDIA GPU tracepoints (如果存在)
-	// /sys/kernel/debug/tracing/events/nvml/
+	loader, err := newProgramLoader(m.config)
+	if err != nil {
+		return err
+	}
 
-	// 附加到 AMD GPU tracepoints (如果存在)
-	// /sys/kernel/debug/tracing/events/amdgpu/
+	// 限速配置随采样间隔下发，突发事件在内核中按周期合并
+	throttle := NewHealthThrottleConfig(m.config.GPUSampleInterval, m.config.HealthEventIntervals)
+	if err := loader.ConfigureHealthThrottle(throttle); err != nil {
+		loader.Close()
+		return fmt.Errorf("failed to configure health event throttle: %w", err)
+	}
 
-	// 附加到 PCIe tracepoints
-	// /sys/kernel/debug/tracing/events/irq/
+	m.loader = loader
+	m.gpuStats = loader
+	m.pcieStats = loader
+	m.pcieDetail = loader
+	m.registry = loader
+	m.healthStats = loader
+	m.healthFlush = loader
+	m.vramUsage = loader
+
+	m.healthDone = make(chan struct{})
+	go func() {
+		defer close(m.healthDone)
+		loader.ConsumeHealthEvents(m.analyzer.AddHealthEvent)
+	}()
 
 	return nil
 }
@@ -215,29 +319,90 @@ func (m *EBPFManager) processPCIeEvents() {
 }
 
 // processHealthEvents 处理健康事件
+// 每个采样周期刷新一次内核限速状态：突发结束后仍在合并中的计数最迟
+// 在限速间隔之后一个采样周期内送达分析器，而不是等到下一次同类事件
 func (m *EBPFManager) processHealthEvents() {
 	defer m.wg.Done()
 
+	ticker := time.NewTicker(m.config.GPUSampleInterval)
+	defer ticker.Stop()
+
 	for {
 		select {
 		case <-m.ctx.Done():
 			return
 		case event := <-m.healthEvents:
 			m.analyzer.AddHealthEvent(event)
+		case <-ticker.C:
+			m.flushHealthThrottle()
 		}
 	}
 }
 
-// readGPUMap 从 eBPF map 读取 GPU 数据
+// flushHealthThrottle 提交已过限速间隔的合并计数
+func (m *EBPFManager) flushHealthThrottle() {
+	m.mu.RLock()
+	flusher := m.healthFlush
+	m.mu.RUnlock()
+
+	if flusher == nil {
+		return
+	}
+	flusher.FlushHealthThrottle()
+}
+
+// readGPUMap 从 eBPF map 批量读取 GPU 聚合数据
+// 每个采样周期每设备只生成一条包含全部指标的事件
 func (m *EBPFManager) readGPUMap() {
-	// 实际实现会从 BPF map 读取数据
-	// 这里只是框架
+	if m.gpuStats == nil {
+		return
+	}
+
+	stats, err := m.gpuStats.ReadGPUStats()
+	if err != nil {
+		return
+	}
+
+	now := time.Now()
+	for deviceID, perCPU := range stats {
+		merged := MergeGPUStats(perCPU)
+		var prev *GPUDeviceStats
+		if p, ok := m.gpuCursor[deviceID]; ok {
+			prev = &p
+		}
+		m.gpuCursor[deviceID] = merged
+
+		if event, fresh := merged.IntervalEvent(deviceID, prev, now); fresh {
+			m.analyzer.AddGPUEvent(event)
+		}
+	}
 }
 
-// readPCIeMap 从 eBPF map 读取 PCIe 数据
+// readPCIeMap 从 eBPF map 批量读取 PCIe 计数
+// 内核计数只增不减，这里按设备汇总 per-CPU 值并与上次读取做差
 func (m *EBPFManager) readPCIeMap() {
-	// 实际实现会从 BPF map 读取数据
-	// 这里只是框架
+	if m.pcieStats == nil {
+		return
+	}
+
+	stats, err := m.pcieStats.ReadPCIeStats()
+	if err != nil {
+		return
+	}
+
+	now := time.Now()
+	for deviceID, perCPU := range stats {
+		sum := SumPCIeStats(perCPU)
+		var prev *PCIeDeviceStats
+		if p, ok := m.pcieCursor[deviceID]; ok {
+			prev = &p
+		}
+		m.pcieCursor[deviceID] = sum
+
+		if event, fresh := sum.IntervalEvent(deviceID, prev, now); fresh {
+			m.analyzer.AddPCIeEvent(event)
+		}
+	}
 }
 
 // GetSnapshot 获取设备健康快照
@@ -248,10 +413,15 @@ func (m *EBPFManager) GetSnapshot(deviceID uint32) *DeviceHealthSnapshot {
 // GetAllSnapshots 获取所有设备快照
 func (m *EBPFManager) GetAllSnapshots() map[uint32]*DeviceHealthSnapshot {
 	m.mu.RLock()
-	defer m.mu.RUnlock()
-
-	result := make(map[uint32]*DeviceHealthSnapshot)
+	ids := make([]uint32, 0, len(m.snapshots))
 	for id := range m.snapshots {
+		ids = append(ids, id)
+	}
+	m.mu.RUnlock()
+
+	// 快照为 O(1) 读取，不持有管理器锁，避免阻塞 AddDevices
+	result := make(map[uint32]*DeviceHealthSnapshot, len(ids))
+	for _, id := range ids {
 		result[id] = m.GetSnapshot(id)
 	}
 	return result
@@ -263,15 +433,20 @@ func (m *EBPFManager) IsPredictiveFailure(deviceID uint32) (bool, string) {
 }
 
 // AddDevices 添加要监控的设备
+// 加载器就绪后同时把设备写入内核注册表，未注册的设备在内核中直接丢弃
 func (m *EBPFManager) AddDevices(devices []*detectors.Device) {
 	m.mu.Lock()
 	defer m.mu.Unlock()
 
 	for _, dev := range devices {
-		// 解析设备 ID
-		var deviceID uint32
-		fmt.Sscanf(dev.ID, "gpu-%d", &deviceID)
-		fmt.Sscanf(dev.ID, "dcu-%d", &deviceID)
+		// 无法解析编号的设备不监控，避免与设备 0 共用快照和注册表项
+		deviceID, ok := parseDeviceIndex(dev.ID)
+		if !ok {
+			continue
+		}
+
+		// 设备只注册一次，之后的事件写入不再修改分析器的设备表
+		m.analyzer.RegisterDevice(deviceID)
 
 		// 初始化快照
 		if _, ok := m.snapshots[deviceID]; !ok {
@@ -282,6 +457,12 @@ func (m *EBPFManager) AddDevices(devices []*detectors.Device) {
 				HealthScore: dev.HealthScore,
 			}
 		}
+
+		if m.registry != nil && !m.registered[deviceID] && dev.PCIEBusID != "" {
+			if err := m.registerDevice(deviceID, dev.PCIEBusID); err == nil {
+				m.registered[deviceID] = true
+			}
+		}
 	}
 }
 
@@ -307,9 +488,24 @@ func (m *EBPFManager) Stop() error {
 }
 
 // unloadPrograms 卸载 eBPF 程序
+// 只释放句柄：固定在 bpffs 中的 map 和 link 保留，重启后计数继续累计
 func (m *EBPFManager) unloadPrograms() error {
-	// 实际实现会分离 tracepoints 并关闭程序
-	return nil
+	if m.loader == nil {
+		return nil
+	}
+
+	err := m.loader.Close()
+	<-m.healthDone
+
+	m.loader = nil
+	m.gpuStats = nil
+	m.pcieStats = nil
+	m.pcieDetail = nil
+	m.registry = nil
+	m.healthStats = nil
+	m.healthFlush = nil
+	m.vramUsage = nil
+	return err
 }
 
 // IsEnabled 返回是否启用了 eBPF
@@ -319,6 +515,23 @@ func (m *EBPFManager) IsEnabled() bool {
 	return m.enabled
 }
 
+// GetHealthEventStats 返回内核健康事件的提交、合并与丢弃计数
+// 计数固定在 bpffs 中，跨进程重启累计；eBPF 未加载时返回零值
+func (m *EBPFManager) GetHealthEventStats() HealthEventStats {
+	m.mu.RLock()
+	source := m.healthStats
+	m.mu.RUnlock()
+
+	if source == nil {
+		return HealthEventStats{}
+	}
+	stats, err := source.ReadHealthEventStats()
+	if err != nil {
+		return HealthEventStats{}
+	}
+	return stats
+}
+
 // GetAnalyzer 获取分析器（用于 Collector 集成）
 func (m *EBPFManager) GetAnalyzer() *HealthAnalyzer {
 	return m.analyzer
@@ -1,8 +1,18 @@
 package ebpf
 
 import (
+	"context"
+	"encoding/binary"
+	"math"
+	"os"
+	"path/filepath"
+	"sync"
+	"syscall"
 	"testing"
 	"time"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/collectors"
+	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
 )
 
 func TestHealthScoreThresholds(t *testing.T) {
@@ -281,3 +291,910 @@ func TestDefaultConfig(t *testing.T) {
 		t.Errorf("Expected BufferSize 1000, got %d", config.BufferSize)
 	}
 }
+
+func TestMergeGPUStats(t *testing.T) {
+	var cpu0, cpu1, cpu2 GPUDeviceStats
+	cpu0.Metrics[GPUMetricTemperature] = GPUMetricStats{Sum: 120, Count: 2, LastTimestamp: 10, Last: 70, Min: 50, Max: 70}
+	cpu1.Metrics[GPUMetricTemperature] = GPUMetricStats{Sum: 60, Count: 1, LastTimestamp: 20, Last: 60, Min: 60, Max: 60}
+	// cpu2 没有采样，其零值不能影响 Min
+	cpu2.Metrics[GPUMetricPower] = GPUMetricStats{Sum: 250000, Count: 1, LastTimestamp: 5, Last: 250000, Min: 250000, Max: 250000}
+
+	merged := MergeGPUStats([]GPUDeviceStats{cpu0, cpu1, cpu2})
+
+	temp := merged.Metrics[GPUMetricTemperature]
+	if temp.Sum != 180 || temp.Count != 3 {
+		t.Errorf("Expected sum 180 count 3, got sum %d count %d", temp.Sum, temp.Count)
+	}
+	if temp.Min != 50 || temp.Max != 70 {
+		t.Errorf("Expected min 50 max 70, got min %d max %d", temp.Min, temp.Max)
+	}
+	if temp.Last != 60 {
+		t.Errorf("Expected last value from newest CPU (60), got %d", temp.Last)
+	}
+	if merged.Metrics[GPUMetricPower].Min != 250000 {
+		t.Errorf("Expected power min 250000, got %d", merged.Metrics[GPUMetricPower].Min)
+	}
+}
+
+func TestGPUDeviceStats_IntervalEvent(t *testing.T) {
+	var prev, cur GPUDeviceStats
+	prev.Metrics[GPUMetricCoreClock] = GPUMetricStats{Sum: 3000, Count: 2, Last: 1500}
+	prev.Metrics[GPUMetricPower] = GPUMetricStats{Sum: 200000, Count: 1, Last: 200000}
+	cur = prev
+	cur.Metrics[GPUMetricCoreClock] = GPUMetricStats{Sum: 5400, Count: 4, Last: 1100}
+
+	event, fresh := cur.IntervalEvent(1, &prev, time.Now())
+	if !fresh {
+		t.Fatal("Expected fresh event")
+	}
+	if event.CoreClock != 1200 {
+		t.Errorf("Expected interval mean clock 1200, got %d", event.CoreClock)
+	}
+	// 区间内无新功耗采样，沿用最近值
+	if event.Power != 200000 {
+		t.Errorf("Expected carried-forward power 200000, got %d", event.Power)
+	}
+
+	if _, fresh := cur.IntervalEvent(1, &cur, time.Now()); fresh {
+		t.Error("Expected no event without new samples")
+	}
+}
+
+// fakeGPUStats 测试用的 GPUStatsSource
+type fakeGPUStats struct {
+	stats map[uint32][]GPUDeviceStats
+}
+
+func (f *fakeGPUStats) ReadGPUStats() (map[uint32][]GPUDeviceStats, error) {
+	return f.stats, nil
+}
+
+func TestEBPFManager_ReadGPUMap(t *testing.T) {
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+
+	var clock, temp GPUDeviceStats
+	clock.Metrics[GPUMetricCoreClock] = GPUMetricStats{Sum: 1500, Count: 1, LastTimestamp: 1, Last: 1500, Min: 1500, Max: 1500}
+	temp.Metrics[GPUMetricTemperature] = GPUMetricStats{Sum: 65, Count: 1, LastTimestamp: 2, Last: 65, Min: 65, Max: 65}
+	source := &fakeGPUStats{stats: map[uint32][]GPUDeviceStats{3: {clock, temp}}}
+	m.gpuStats = source
+
+	m.readGPUMap()
+
+	// 不同 CPU 上的时钟和温度采样合并为一份完整快照
+	snapshot := m.GetSnapshot(3)
+	if snapshot.CoreClock != 1500 || snapshot.Temperature != 65 {
+		t.Errorf("Expected clock 1500 and temperature 65, got %d and %d", snapshot.CoreClock, snapshot.Temperature)
+	}
+
+	// 再次读取时没有新采样，不应追加事件
+	m.readGPUMap()
+	if n := m.analyzer.device(3).gpu.Len(); n != 1 {
+		t.Errorf("Expected 1 buffered event, got %d", n)
+	}
+}
+
+// fakePCIeStats 测试用的 PCIeStatsSource
+type fakePCIeStats struct {
+	stats map[uint32][]PCIeDeviceStats
+}
+
+func (f *fakePCIeStats) ReadPCIeStats() (map[uint32][]PCIeDeviceStats, error) {
+	return f.stats, nil
+}
+
+func TestEBPFManager_ReadPCIeMap(t *testing.T) {
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+
+	source := &fakePCIeStats{stats: map[uint32][]PCIeDeviceStats{
+		2: {{ReadBytes: 100, WriteBytes: 10, LastUpdate: 1}, {ReadBytes: 50, ReplayCount: 1, LastUpdate: 2}},
+	}}
+	m.pcieStats = source
+
+	m.readPCIeMap()
+
+	st := m.analyzer.device(2)
+	if st == nil || st.pcie.Len() != 1 {
+		t.Fatal("Expected 1 PCIe event after first read")
+	}
+	w := st.pcie
+	if r, _ := w.readBytes.Latest(); r != 150 {
+		t.Errorf("Expected per-CPU read sum 150, got %d", r)
+	}
+	if wr, _ := w.writeBytes.Latest(); wr != 10 {
+		t.Errorf("Expected per-CPU write sum 10, got %d", wr)
+	}
+
+	// 累计计数增长后只上报增量
+	source.stats[2][1].WriteBytes = 40
+	m.readPCIeMap()
+	if w.Len() != 2 {
+		t.Fatalf("Expected 2 PCIe events, got %d", w.Len())
+	}
+	r, _ := w.readBytes.Latest()
+	wr, _ := w.writeBytes.Latest()
+	if r != 0 || wr != 40 {
+		t.Errorf("Expected delta 0/40, got %d/%d", r, wr)
+	}
+
+	// 无新流量时不追加事件
+	m.readPCIeMap()
+	if w.Len() != 2 {
+		t.Errorf("Expected no event without new traffic, got %d events", w.Len())
+	}
+}
+
+func TestParseBDF(t *testing.T) {
+	tests := []struct {
+		busID  string
+		domain uint32
+		bus    uint32
+		devfn  uint32
+	}{
+		{"0000:3b:00.0", 0, 0x3b, 0},
+		{"00000001:AF:01.2", 1, 0xaf, 1<<3 | 2},
+		{"18:1f.7", 0, 0x18, 0x1f<<3 | 7},
+	}
+
+	for _, tt := range tests {
+		domain, bus, devfn, err := parseBDF(tt.busID)
+		if err != nil {
+			t.Errorf("parseBDF(%q) error = %v", tt.busID, err)
+			continue
+		}
+		if domain != tt.domain || bus != tt.bus || devfn != tt.devfn {
+			t.Errorf("parseBDF(%q) = %x/%x/%x, want %x/%x/%x", tt.busID, domain, bus, devfn, tt.domain, tt.bus, tt.devfn)
+		}
+	}
+
+	if _, _, _, err := parseBDF("gpu-0"); err == nil {
+		t.Error("Expected error for invalid bus ID")
+	}
+}
+
+// fakeRegistry 测试用的 DeviceRegistry
+type fakeRegistry struct {
+	devices map[DeviceKey]uint32
+	ranges  map[uint32]AddressRange
+}
+
+func (f *fakeRegistry) RegisterDevice(key DeviceKey, index uint32) error {
+	f.devices[key] = index
+	return nil
+}
+
+func (f *fakeRegistry) RegisterRange(index uint32, r AddressRange) error {
+	f.ranges[index] = r
+	return nil
+}
+
+func TestParseDeviceIndex(t *testing.T) {
+	tests := []struct {
+		id   string
+		want uint32
+		ok   bool
+	}{
+		{"gpu-0", 0, true},
+		{"dcu-3", 3, true},
+		{"npu-7", 7, true},
+		{"GPU-abc", 0, false},
+		{"gpu", 0, false},
+		{"npu-", 0, false},
+	}
+	for _, tt := range tests {
+		got, ok := parseDeviceIndex(tt.id)
+		if got != tt.want || ok != tt.ok {
+			t.Errorf("parseDeviceIndex(%q) = %d, %v, want %d, %v", tt.id, got, ok, tt.want, tt.ok)
+		}
+	}
+}
+
+func TestEBPFManager_AddDevicesAscend(t *testing.T) {
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+
+	// 每个 NPU 使用自己的编号，无法解析的 ID 被跳过
+	m.AddDevices([]*detectors.Device{{ID: "npu-0"}, {ID: "npu-1"}, {ID: "npu-2"}, {ID: "bogus"}})
+	if len(m.snapshots) != 3 {
+		t.Fatalf("Expected 3 snapshots, got %d", len(m.snapshots))
+	}
+	for _, id := range []uint32{0, 1, 2} {
+		if _, ok := m.snapshots[id]; !ok {
+			t.Errorf("Expected snapshot for npu-%d", id)
+		}
+	}
+}
+
+func TestEBPFManager_AddDevicesRegistersIdentities(t *testing.T) {
+	root := t.TempDir()
+	oldPCI, oldThermal, oldNVIDIA := sysfsPCIDevices, sysfsThermal, procNVIDIAGPUs
+	sysfsPCIDevices = filepath.Join(root, "bus/pci/devices")
+	sysfsThermal = filepath.Join(root, "class/thermal")
+	procNVIDIAGPUs = filepath.Join(root, "proc/driver/nvidia/gpus")
+	defer func() { sysfsPCIDevices, sysfsThermal, procNVIDIAGPUs = oldPCI, oldThermal, oldNVIDIA }()
+
+	// 构造 sysfs：根端口 0000:00:01.0 下挂 GPU 0001:3b:00.0
+	port := filepath.Join(root, "devices/pci0000:00/0000:00:01.0")
+	gpu := filepath.Join(port, "0001:3b:00.0")
+	mustWrite := func(path, data string) {
+		if err := os.MkdirAll(filepath.Dir(path), 0755); err != nil {
+			t.Fatal(err)
+		}
+		if err := os.WriteFile(path, []byte(data), 0644); err != nil {
+			t.Fatal(err)
+		}
+	}
+	mustWrite(filepath.Join(port, "config"), "")
+	mustWrite(filepath.Join(port, "irq"), "24\n")
+	mustWrite(filepath.Join(gpu, "irq"), "0\n")
+	mustWrite(filepath.Join(gpu, "msi_irqs/130"), "msix")
+	mustWrite(filepath.Join(gpu, "resource"),
+		"0x00000000fb000000 0x00000000fbffffff 0x0000000000040200\n"+
+			"0x0000038000000000 0x00000387ffffffff 0x000000000014220c\n"+
+			"0x0000000000000000 0x0000000000000000 0x0000000000000000\n")
+	mustWrite(filepath.Join(gpu, "drm/card2/dev"), "226:2\n")
+	mustWrite(filepath.Join(procNVIDIAGPUs, "0001:3b:00.0/information"),
+		"Model: \t\t NVIDIA A100-SXM4-80GB\nIRQ:   \t\t 130\nDevice Minor: \t 3\n")
+	mustWrite(filepath.Join(root, "class/thermal/thermal_zone4/type"), "gpu")
+	for _, link := range [][2]string{
+		{gpu, filepath.Join(sysfsPCIDevices, "0001:3b:00.0")},
+		{gpu, filepath.Join(sysfsThermal, "thermal_zone4/device")},
+	} {
+		if err := os.MkdirAll(filepath.Dir(link[1]), 0755); err != nil {
+			t.Fatal(err)
+		}
+		if err := os.Symlink(link[0], link[1]); err != nil {
+			t.Fatal(err)
+		}
+	}
+
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	reg := &fakeRegistry{devices: make(map[DeviceKey]uint32), ranges: make(map[uint32]AddressRange)}
+	m.registry = reg
+
+	m.AddDevices([]*detectors.Device{{ID: "gpu-5", PCIEBusID: "00000001:3B:00.0"}})
+
+	want := []DeviceKey{
+		{Kind: DeviceKeyPCI, Domain: 1, ID: 0x3b << 8},
+		{Kind: DeviceKeyIRQ, ID: 130},
+		{Kind: DeviceKeyIRQ, ID: 24},
+		{Kind: DeviceKeyThermalZone, ID: 4},
+		{Kind: DeviceKeyNVIDIAMinor, ID: 3},
+		{Kind: DeviceKeyDRMMinor, ID: 2},
+	}
+	for _, key := range want {
+		if idx, ok := reg.devices[key]; !ok || idx != 5 {
+			t.Errorf("Expected %+v registered as device 5, got %d (present=%v)", key, idx, ok)
+		}
+	}
+	if len(reg.devices) != len(want) {
+		t.Errorf("Expected %d registry entries, got %d", len(want), len(reg.devices))
+	}
+	if r := reg.ranges[5]; r.Start != 0x38000000000 || r.End != 0x38800000000 {
+		t.Errorf("Expected largest memory BAR, got %#x-%#x", r.Start, r.End)
+	}
+}
+
+func TestDecodeHealthEvent(t *testing.T) {
+	raw := make([]byte, healthEventSize)
+	binary.LittleEndian.PutUint32(raw[0:], 7)
+	raw[16] = 1 // EVENT_ECC_DB
+	binary.LittleEndian.PutUint32(raw[20:], 3)
+	binary.LittleEndian.PutUint64(raw[24:], 0xdead000)
+
+	var e HealthEvent
+	if !decodeHealthEvent(raw, &e) {
+		t.Fatal("decodeHealthEvent() = false")
+	}
+	if e.DeviceID != 7 || e.Type != EventECCDoubleBit || e.Count != 3 || e.Address != 0xdead000 {
+		t.Errorf("Unexpected decoded event %+v", e)
+	}
+
+	raw[16] = 42
+	if decodeHealthEvent(raw, &e) {
+		t.Error("Expected unknown event type to be rejected")
+	}
+	if decodeHealthEvent(raw[:8], &e) {
+		t.Error("Expected short record to be rejected")
+	}
+}
+
+func TestRing(t *testing.T) {
+	r := NewRing[int](3)
+	for i := 1; i <= 3; i++ {
+		if _, evicted := r.Push(i); evicted {
+			t.Errorf("Unexpected eviction while filling at %d", i)
+		}
+	}
+
+	old, evicted := r.Push(4)
+	if !evicted || old != 1 {
+		t.Errorf("Expected eviction of 1, got %d (evicted=%v)", old, evicted)
+	}
+
+	var got []int
+	r.Do(func(v int) { got = append(got, v) })
+	if len(got) != 3 || got[0] != 2 || got[2] != 4 {
+		t.Errorf("Expected [2 3 4], got %v", got)
+	}
+	if v, _ := r.Oldest(); v != 2 {
+		t.Errorf("Expected oldest 2, got %d", v)
+	}
+	if v, _ := r.Latest(); v != 4 {
+		t.Errorf("Expected latest 4, got %d", v)
+	}
+}
+
+// directSlope 对窗口直接做最小二乘回归（x 为秒），作为增量结果的对照
+func directSlope(ts []int64, ys []float64) float64 {
+	n := float64(len(ys))
+	var sumX, sumY, sumXY, sumX2 float64
+	for i, y := range ys {
+		x := float64(ts[i]-ts[0]) / 1e9
+		sumX += x
+		sumY += y
+		sumXY += x * y
+		sumX2 += x * x
+	}
+	return (n*sumXY - sumX*sumY) / (n*sumX2 - sumX*sumX)
+}
+
+func TestTrendSeries_MatchesDirectRegression(t *testing.T) {
+	const window = 7
+	s := newTrendSeries(window)
+	var ts []int64
+	var ys []float64
+	now := time.Now().UnixNano()
+
+	for i := 0; i < 50; i++ {
+		// 不等间隔采样：100ms 基础间隔加抖动
+		now += int64(100+(i*13)%40) * int64(time.Millisecond)
+		y := float64((i*37)%23) + float64(i)*0.5
+		s.push(now, y)
+		ts = append(ts, now)
+		ys = append(ys, y)
+
+		start := len(ys) - window
+		if start < 0 {
+			start = 0
+		}
+		if len(ys)-start < 2 {
+			continue
+		}
+		want := directSlope(ts[start:], ys[start:])
+		if got := s.slope(); math.Abs(got-want) > 1e-6*math.Max(1, math.Abs(want)) {
+			t.Fatalf("sample %d: slope %v, want %v", i, got, want)
+		}
+	}
+}
+
+func TestEWStats_WarmupMatchesWelford(t *testing.T) {
+	var s ewStats
+	samples := []float64{40, 42, 44, 46, 48}
+	for _, x := range samples {
+		s.add(x, 0.1)
+	}
+
+	// 样本数少于 1/alpha 时为算术均值与总体方差
+	if math.Abs(s.mean-44) > 1e-9 {
+		t.Errorf("Expected mean 44, got %v", s.mean)
+	}
+	if math.Abs(s.variance-8) > 1e-9 {
+		t.Errorf("Expected variance 8, got %v", s.variance)
+	}
+}
+
+func TestHealthAnalyzer_TrendAndBandwidthUseTime(t *testing.T) {
+	analyzer := NewHealthAnalyzer()
+	base := time.Now()
+
+	// 每 100ms 升温 1°C，即 10°C/s
+	for i := 0; i < 10; i++ {
+		ts := base.Add(time.Duration(i) * 100 * time.Millisecond)
+		analyzer.AddGPUEvent(GPUEvent{DeviceID: 1, Timestamp: ts, Temperature: uint32(40 + i)})
+		analyzer.AddPCIeEvent(PCIeEvent{DeviceID: 1, Timestamp: ts, ReadBytes: 1 << 29})
+	}
+
+	snapshot := analyzer.GetSnapshot(1)
+	if math.Abs(snapshot.TemperatureTrend-10) > 1e-6 {
+		t.Errorf("Expected temperature trend 10°C/s, got %v", snapshot.TemperatureTrend)
+	}
+	// 每 100ms 0.5 GiB，即 5 GiB/s
+	if math.Abs(snapshot.PCIeBandwidth-5) > 1e-6 {
+		t.Errorf("Expected PCIe bandwidth 5 GB/s, got %v", snapshot.PCIeBandwidth)
+	}
+
+	baseline, ok := analyzer.GetBaseline(1)
+	if !ok || baseline.SampleCount != 10 || baseline.StdDevTemp == 0 {
+		t.Errorf("Expected baseline updated on ingest, got %+v", baseline)
+	}
+}
+
+func TestHealthWindow_EvictionUpdatesCounts(t *testing.T) {
+	w := newHealthWindow(2)
+	base := time.Now()
+
+	w.add(HealthEvent{Type: EventECCDoubleBit, Count: 5, Timestamp: base})
+	w.add(HealthEvent{Type: EventECCSingleBit, Count: 2, Timestamp: base.Add(time.Second)})
+	w.add(HealthEvent{Type: EventPageRetire, Count: 1, Timestamp: base.Add(2 * time.Second)})
+
+	if w.eccDoubleBit != 0 || w.eccSingleBit != 2 || w.pageRetire != 1 {
+		t.Errorf("Expected counts db=0 sb=2 retire=1, got db=%d sb=%d retire=%d", w.eccDoubleBit, w.eccSingleBit, w.pageRetire)
+	}
+	if rate := w.eccErrorRate(); math.Abs(rate-2) > 1e-9 {
+		t.Errorf("Expected ECC rate 2/s, got %v", rate)
+	}
+}
+
+func TestHealthAnalyzer_ConcurrentIngestAndSnapshot(t *testing.T) {
+	analyzer := NewHealthAnalyzer()
+	const devices = 4
+	for id := uint32(0); id < devices; id++ {
+		analyzer.RegisterDevice(id)
+	}
+
+	var wg sync.WaitGroup
+	base := time.Now()
+	for id := uint32(0); id < devices; id++ {
+		wg.Add(2)
+		go func(id uint32) {
+			defer wg.Done()
+			for i := 0; i < 200; i++ {
+				ts := base.Add(time.Duration(i) * time.Millisecond)
+				analyzer.AddGPUEvent(GPUEvent{DeviceID: id, Timestamp: ts, Temperature: 50})
+				analyzer.AddHealthEvent(HealthEvent{DeviceID: id, Timestamp: ts, Type: EventECCSingleBit, Count: 1})
+			}
+		}(id)
+		go func(id uint32) {
+			defer wg.Done()
+			for i := 0; i < 200; i++ {
+				analyzer.GetSnapshot(id)
+				analyzer.IsPredictiveFailure(id)
+			}
+		}(id)
+	}
+	// 并发注册新设备不影响已有设备
+	analyzer.RegisterDevice(devices)
+	wg.Wait()
+
+	for id := uint32(0); id < devices; id++ {
+		if s := analyzer.GetSnapshot(id); s.Temperature != 50 || s.ECCSingleBitCount != AnalysisWindow {
+			t.Errorf("device %d: unexpected snapshot %+v", id, s)
+		}
+	}
+}
+
+func TestNewHealthThrottleConfig(t *testing.T) {
+	cfg := NewHealthThrottleConfig(100*time.Millisecond, map[HealthEventType]time.Duration{
+		EventGPUReset: 0,
+	})
+
+	if got := cfg.MinIntervalNs[0]; got != uint64(100*time.Millisecond) {
+		t.Errorf("Expected ECC single-bit interval 100ms, got %d", got)
+	}
+	// 覆盖为 0 的类型不限速
+	if got := cfg.MinIntervalNs[3]; got != 0 {
+		t.Errorf("Expected GPU reset unthrottled, got %d", got)
+	}
+	if got := NewHealthThrottleConfig(0, nil); got != (HealthThrottleConfig{}) {
+		t.Errorf("Expected zero interval to disable throttling, got %+v", got)
+	}
+}
+
+// fakeHealthEventStats 测试用的 HealthEventStatsSource
+type fakeHealthEventStats struct {
+	stats HealthEventStats
+}
+
+func (f *fakeHealthEventStats) ReadHealthEventStats() (HealthEventStats, error) {
+	return f.stats, nil
+}
+
+func TestEBPFHealthCollector_ExportsEventStats(t *testing.T) {
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	c := &EBPFHealthCollector{manager: m}
+
+	// 未加载 eBPF 时计数为零
+	metrics, err := c.Collect(nil, nil, nil)
+	if err != nil {
+		t.Fatalf("Collect() error = %v", err)
+	}
+	if metrics.Telemetry == nil || metrics.Telemetry.HealthEventsDropped != 0 {
+		t.Errorf("Expected zero telemetry, got %+v", metrics.Telemetry)
+	}
+
+	m.healthStats = &fakeHealthEventStats{stats: HealthEventStats{Emitted: 10, Coalesced: 90, Dropped: 2}}
+	metrics, _ = c.Collect(nil, nil, nil)
+	tm := metrics.Telemetry
+	if tm.HealthEventsEmitted != 10 || tm.HealthEventsCoalesced != 90 || tm.HealthEventsDropped != 2 {
+		t.Errorf("Unexpected telemetry %+v", tm)
+	}
+}
+
+// fakeHealthFlusher 测试用的 HealthThrottleFlusher
+type fakeHealthFlusher struct {
+	mu      sync.Mutex
+	flushes int
+}
+
+func (f *fakeHealthFlusher) FlushHealthThrottle() error {
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	f.flushes++
+	return nil
+}
+
+func (f *fakeHealthFlusher) count() int {
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	return f.flushes
+}
+
+func TestEBPFManager_FlushesHealthThrottle(t *testing.T) {
+	config := DefaultConfig()
+	config.GPUSampleInterval = 5 * time.Millisecond
+	m, err := NewEBPFManager(config)
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+
+	flusher := &fakeHealthFlusher{}
+	m.mu.Lock()
+	m.healthFlush = flusher
+	m.mu.Unlock()
+
+	if err := m.Start(); err != nil {
+		t.Fatalf("Start() error = %v", err)
+	}
+	defer m.Stop()
+
+	// 每个采样周期刷新一次，不依赖新的健康事件
+	deadline := time.Now().Add(2 * time.Second)
+	for flusher.count() < 3 && time.Now().Before(deadline) {
+		time.Sleep(5 * time.Millisecond)
+	}
+	if n := flusher.count(); n < 3 {
+		t.Errorf("Expected periodic flushes, got %d", n)
+	}
+}
+
+func TestParseCgroupOwner(t *testing.T) {
+	const uid = "0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f0"
+	const cid = "3b2a1908f7e6d5c43b2a1908f7e6d5c43b2a1908f7e6d5c43b2a1908f7e6d5c4"
+	tests := []struct {
+		path string
+		want cgroupOwner
+	}{
+		{
+			path: "/sys/fs/cgroup/kubepods.slice/kubepods-burstable.slice/kubepods-burstable-pod0f1e2d3c_4b5a_6978_8796_a5b4c3d2e1f0.slice/cri-containerd-" + cid + ".scope",
+			want: cgroupOwner{PodUID: uid, ContainerID: cid},
+		},
+		{
+			path: "/sys/fs/cgroup/kubepods/besteffort/pod" + uid + "/" + cid,
+			want: cgroupOwner{PodUID: uid, ContainerID: cid},
+		},
+		{
+			path: "/sys/fs/cgroup/kubepods/besteffort/pod" + uid,
+			want: cgroupOwner{PodUID: uid},
+		},
+		{
+			path: "/sys/fs/cgroup/system.slice/containerd.service",
+		},
+	}
+
+	for _, tt := range tests {
+		if got := parseCgroupOwner(tt.path); got != tt.want {
+			t.Errorf("parseCgroupOwner(%q) = %+v, want %+v", tt.path, got, tt.want)
+		}
+	}
+}
+
+func TestVRAMTargets(t *testing.T) {
+	dir := t.TempDir()
+	lib := filepath.Join(dir, "libcuda.so.550.54.15")
+	if err := os.WriteFile(lib, nil, 0644); err != nil {
+		t.Fatal(err)
+	}
+	os.Symlink(lib, filepath.Join(dir, "libcuda.so.1"))
+	os.WriteFile(filepath.Join(dir, "libfoo.so"), nil, 0644)
+
+	orig := vramLibraryDirs
+	vramLibraryDirs = []string{dir}
+	defer func() { vramLibraryDirs = orig }()
+
+	targets := vramTargets(nil, nil)
+	if len(targets) != 1 || targets[0].runtime.library != "libcuda.so" {
+		t.Fatalf("Expected one libcuda target, got %+v", targets)
+	}
+
+	// 配置的目录替代默认目录
+	if targets := vramTargets(nil, []string{t.TempDir()}); len(targets) != 0 {
+		t.Errorf("Expected no target in an empty library dir, got %+v", targets)
+	}
+
+	// 指向同一文件的路径只挂载一次，未知库被忽略
+	targets = vramTargets([]string{filepath.Join(dir, "libcuda.so.1"), lib, filepath.Join(dir, "libfoo.so")}, nil)
+	if len(targets) != 1 {
+		t.Errorf("Expected duplicate and unknown libraries to be skipped, got %+v", targets)
+	}
+}
+
+// fakeVRAMUsage 测试用的 VRAMUsageSource
+type fakeVRAMUsage struct {
+	usage   map[uint64]VRAMCgroupUsage
+	deleted []uint64
+	stats   VRAMTrackerStats
+	allocs  []uint32 // vram_allocs 中各条目的 tgid
+}
+
+func (f *fakeVRAMUsage) ReadVRAMUsage() (map[uint64]VRAMCgroupUsage, error) {
+	return f.usage, nil
+}
+
+func (f *fakeVRAMUsage) DeleteVRAMUsage(id uint64) error {
+	f.deleted = append(f.deleted, id)
+	return nil
+}
+
+func (f *fakeVRAMUsage) ReadVRAMTrackerStats() (VRAMTrackerStats, error) {
+	return f.stats, nil
+}
+
+func (f *fakeVRAMUsage) PruneVRAMAllocs(alive func(tgid uint32) bool) (int, error) {
+	kept := f.allocs[:0]
+	for _, tgid := range f.allocs {
+		if alive(tgid) {
+			kept = append(kept, tgid)
+		}
+	}
+	pruned := len(f.allocs) - len(kept)
+	f.allocs = kept
+	return pruned, nil
+}
+
+func TestEBPFManager_GetContainerVRAMUsage(t *testing.T) {
+	const uid = "0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f0"
+	root := t.TempDir()
+	podDir := filepath.Join(root, "kubepods", "pod"+uid)
+	if err := os.MkdirAll(podDir, 0755); err != nil {
+		t.Fatal(err)
+	}
+	info, _ := os.Stat(podDir)
+	podID := info.Sys().(*syscall.Stat_t).Ino
+	info, _ = os.Stat(root)
+	rootID := info.Sys().(*syscall.Stat_t).Ino
+
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	if usage := m.GetContainerVRAMUsage(); usage != nil {
+		t.Errorf("Expected nil without VRAM tracing, got %+v", usage)
+	}
+
+	source := &fakeVRAMUsage{usage: map[uint64]VRAMCgroupUsage{
+		podID:  {Bytes: 1 << 30, Allocs: 3, Frees: 1},
+		rootID: {Bytes: 4096, Allocs: 1},
+		1:      {Bytes: -512, Frees: 1}, // 已销毁的 cgroup
+	}}
+	m.vramUsage = source
+	m.cgroups = newCgroupResolver(root)
+	m.cgroups.minRescan = 0
+
+	usage := m.GetContainerVRAMUsage()
+	if len(usage) != 1 || usage[0].PodUID != uid || usage[0].Used != 1<<30 || usage[0].Allocs != 3 {
+		t.Errorf("Unexpected usage %+v", usage)
+	}
+	if len(source.deleted) != 1 || source.deleted[0] != 1 {
+		t.Errorf("Expected destroyed cgroup to be deleted, got %v", source.deleted)
+	}
+}
+
+func TestEBPFHealthCollector_TracedVRAMThroughManager(t *testing.T) {
+	const uid = "0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f0"
+	root := t.TempDir()
+	podDir := filepath.Join(root, "kubepods", "pod"+uid)
+	if err := os.MkdirAll(podDir, 0755); err != nil {
+		t.Fatal(err)
+	}
+	info, _ := os.Stat(podDir)
+	podID := info.Sys().(*syscall.Stat_t).Ino
+
+	// CgroupRoot 指向宿主机 cgroup 树的挂载点
+	config := DefaultConfig()
+	config.CgroupRoot = root
+	config.VRAMTracing = true
+	m, err := NewEBPFManager(config)
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	m.vramUsage = &fakeVRAMUsage{usage: map[uint64]VRAMCgroupUsage{
+		podID: {Bytes: 2 << 30, Allocs: 4},
+	}}
+
+	manager := collectors.NewManager()
+	manager.Register(&EBPFHealthCollector{manager: m})
+	devices := []*detectors.Device{{ID: "gpu-0"}}
+
+	metrics, err := manager.CollectAll(context.Background(), devices, nil)
+	if err != nil {
+		t.Fatalf("CollectAll() error = %v", err)
+	}
+	if len(metrics.TracedVRAM) != 1 || metrics.TracedVRAM[0].PodUID != uid || metrics.TracedVRAM[0].Used != 2<<30 {
+		t.Errorf("Expected traced VRAM for pod %s, got %+v", uid, metrics.TracedVRAM)
+	}
+}
+
+func TestEBPFManager_VRAMTrackerStats(t *testing.T) {
+	proc := t.TempDir()
+	if err := os.Mkdir(filepath.Join(proc, "100"), 0755); err != nil {
+		t.Fatal(err)
+	}
+	orig := procDir
+	procDir = proc
+	defer func() { procDir = orig }()
+
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	if stats := m.GetVRAMTrackerStats(); stats != (VRAMTrackerStats{}) {
+		t.Errorf("Expected zero stats without VRAM tracing, got %+v", stats)
+	}
+
+	source := &fakeVRAMUsage{
+		stats:  VRAMTrackerStats{AllocsUntracked: 7, ProcsUntracked: 1},
+		allocs: []uint32{100, 200, 100, 300},
+	}
+	m.vramUsage = source
+	m.cgroups = newCgroupResolver(t.TempDir())
+
+	if stats := m.GetVRAMTrackerStats(); stats.AllocsUntracked != 7 || stats.ProcsUntracked != 1 {
+		t.Errorf("Unexpected stats %+v", stats)
+	}
+
+	// 读取使用量时清理已退出进程（200、300）的分配
+	m.GetContainerVRAMUsage()
+	if len(source.allocs) != 2 || source.allocs[0] != 100 || source.allocs[1] != 100 {
+		t.Errorf("Expected allocs of exited processes to be pruned, got %v", source.allocs)
+	}
+}
+
+func TestLog2Histogram_Quantile(t *testing.T) {
+	var h Log2Histogram
+	if h.Quantile(0.5) != 0 {
+		t.Error("Expected 0 for empty histogram")
+	}
+
+	h[12] = 90 // 4 KiB 映射
+	h[21] = 10 // 2 MiB 映射
+	if got := h.Quantile(0.5); got != 1<<13 {
+		t.Errorf("Expected p50 upper bound 8192, got %d", got)
+	}
+	if got := h.Quantile(0.99); got != 1<<22 {
+		t.Errorf("Expected p99 upper bound 4 MiB, got %d", got)
+	}
+}
+
+// fakePCIeDetail 测试用的 PCIeDetailSource
+type fakePCIeDetail struct {
+	hist  map[uint32][]PCIeDeviceHistogram
+	bytes map[PCIeCgroupKey][]PCIeCgroupBytes
+}
+
+func (f *fakePCIeDetail) ReadPCIeHistograms() (map[uint32][]PCIeDeviceHistogram, error) {
+	return f.hist, nil
+}
+
+func (f *fakePCIeDetail) ReadPCIeCgroupBytes() (map[PCIeCgroupKey][]PCIeCgroupBytes, error) {
+	return f.bytes, nil
+}
+
+func TestEBPFManager_PCIeDetailIntervals(t *testing.T) {
+	const uid = "0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f0"
+	root := t.TempDir()
+	podDir := filepath.Join(root, "kubepods", "pod"+uid)
+	if err := os.MkdirAll(podDir, 0755); err != nil {
+		t.Fatal(err)
+	}
+	info, _ := os.Stat(podDir)
+	cgroupID := info.Sys().(*syscall.Stat_t).Ino
+
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	m.cgroups = newCgroupResolver(root)
+
+	var cpu0, cpu1 PCIeDeviceHistogram
+	cpu0.Size[12] = 3
+	cpu1.Size[12] = 2
+	key := PCIeCgroupKey{CgroupID: cgroupID, DeviceID: 1}
+	source := &fakePCIeDetail{
+		hist:  map[uint32][]PCIeDeviceHistogram{1: {cpu0, cpu1}},
+		bytes: map[PCIeCgroupKey][]PCIeCgroupBytes{key: {{WriteBytes: 1 << 20}}},
+	}
+	m.pcieDetail = source
+
+	if h := m.GetPCIeHistograms()[1]; h.Size[12] != 5 {
+		t.Errorf("Expected per-CPU histograms to be summed, got %d", h.Size[12])
+	}
+	if bw := m.GetPCIeCgroupBandwidth(); bw != nil {
+		t.Errorf("Expected first read to only set the baseline, got %+v", bw)
+	}
+
+	// 第二次读取只返回区间增量
+	cpu1.Size[12] = 4
+	source.hist[1] = []PCIeDeviceHistogram{cpu0, cpu1}
+	source.bytes[key] = []PCIeCgroupBytes{{WriteBytes: 1 << 20}, {WriteBytes: 1 << 20}}
+	m.pcieDetailCursor.bytesRead = m.pcieDetailCursor.bytesRead.Add(-time.Second)
+
+	if h := m.GetPCIeHistograms()[1]; h.Size[12] != 2 {
+		t.Errorf("Expected interval histogram of 2, got %d", h.Size[12])
+	}
+	bw := m.GetPCIeCgroupBandwidth()
+	if len(bw) != 1 || bw[0].PodUID != uid || bw[0].DeviceID != 1 {
+		t.Fatalf("Unexpected bandwidth %+v", bw)
+	}
+	if bw[0].WriteBytesPerSec < 0.9*(1<<20) || bw[0].WriteBytesPerSec > 1<<20 {
+		t.Errorf("Expected ~1 MiB/s, got %.0f", bw[0].WriteBytesPerSec)
+	}
+}
+
+func TestEBPFHealthCollector_PCIeForDeviceZero(t *testing.T) {
+	const uid = "0f1e2d3c-4b5a-6978-8796-a5b4c3d2e1f0"
+	root := t.TempDir()
+	podDir := filepath.Join(root, "kubepods", "pod"+uid)
+	if err := os.MkdirAll(podDir, 0755); err != nil {
+		t.Fatal(err)
+	}
+	info, _ := os.Stat(podDir)
+	cgroupID := info.Sys().(*syscall.Stat_t).Ino
+
+	m, err := NewEBPFManager(DefaultConfig())
+	if err != nil {
+		t.Fatalf("NewEBPFManager() error = %v", err)
+	}
+	m.cgroups = newCgroupResolver(root)
+
+	var hist PCIeDeviceHistogram
+	hist.Size[12] = 3
+	key := PCIeCgroupKey{CgroupID: cgroupID, DeviceID: 0}
+	source := &fakePCIeDetail{
+		hist:  map[uint32][]PCIeDeviceHistogram{0: {hist}},
+		bytes: map[PCIeCgroupKey][]PCIeCgroupBytes{key: {{ReadBytes: 1 << 20}}},
+	}
+	m.pcieDetail = source
+	m.GetPCIeCgroupBandwidth()
+	source.bytes[key] = []PCIeCgroupBytes{{ReadBytes: 2 << 20}}
+	m.pcieDetailCursor.bytesRead = m.pcieDetailCursor.bytesRead.Add(-time.Second)
+
+	// gpu-0 是合法设备，不能被当作解析失败丢弃
+	c := &EBPFHealthCollector{manager: m}
+	metrics, err := c.Collect(context.Background(), []*detectors.Device{{ID: "gpu-0"}, {ID: "bogus"}}, nil)
+	if err != nil {
+		t.Fatalf("Collect() error = %v", err)
+	}
+	if len(metrics.DeviceMetrics) != 1 || metrics.DeviceMetrics[0].DeviceID != "gpu-0" {
+		t.Fatalf("Expected only gpu-0 metrics, got %+v", metrics.DeviceMetrics)
+	}
+	if pcie := metrics.DeviceMetrics[0].PCIe; pcie == nil || pcie.DMAMappings != 3 {
+		t.Errorf("Expected gpu-0 DMA histogram, got %+v", pcie)
+	}
+	if len(metrics.TracedPCIe) != 1 || metrics.TracedPCIe[0].DeviceID != "gpu-0" || metrics.TracedPCIe[0].PodUID != uid {
+		t.Errorf("Expected traced PCIe for gpu-0, got %+v", metrics.TracedPCIe)
+	}
+}
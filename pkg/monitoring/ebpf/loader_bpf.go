@@ -0,0 +1,542 @@
+//go:build hcs_bpf
+
+package ebpf
+
+//go:generate go run github.com/cilium/ebpf/cmd/bpf2go -cc clang -cflags "-O2 -g -Wall -mcpu=v3" -tags hcs_bpf -target amd64,arm64 gpuMonitor programs/gpu_monitor.c -- -I./programs
+//go:generate go run github.com/cilium/ebpf/cmd/bpf2go -cc clang -cflags "-O2 -g -Wall -mcpu=v3" -tags hcs_bpf -target amd64,arm64 pcieMonitor programs/pcie_monitor.c -- -I./programs
+//go:generate go run github.com/cilium/ebpf/cmd/bpf2go -cc clang -cflags "-O2 -g -Wall -mcpu=v3" -tags hcs_bpf -target amd64,arm64 healthEvents programs/health_events.c -- -I./programs
+//go:generate go run github.com/cilium/ebpf/cmd/bpf2go -cc clang -cflags "-O2 -g -Wall -mcpu=v3" -tags hcs_bpf -target amd64,arm64 vramTracker programs/vram_tracker.c -- -I./programs
+
+import (
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+
+	"github.com/cilium/ebpf"
+	"github.com/cilium/ebpf/features"
+	"github.com/cilium/ebpf/link"
+	"github.com/cilium/ebpf/ringbuf"
+	"github.com/cilium/ebpf/rlimit"
+	"k8s.io/klog/v2"
+)
+
+// bpfLoader 基于 cilium/ebpf 的程序加载器
+// 程序均以 CO-RE 方式编译（bpf2go 生成 loadGpuMonitor 等函数），
+// 带 LIBBPF_PIN_BY_NAME 的 map 与 link 固定在 pinPath 下，进程重启后计数不丢失；
+// vram_tracker 仅在 Config.VRAMTracing 时加载
+type bpfLoader struct {
+	pinPath     string
+	collections []*ebpf.Collection
+	links       []link.Link
+
+	gpuStats   *ebpf.Map
+	pcieStats  *ebpf.Map
+	pcieHist   *ebpf.Map
+	pcieCgroup *ebpf.Map
+	registry   *ebpf.Map
+	ranges     *ebpf.Map
+	throttle   *ebpf.Map
+	eventStats *ebpf.Map
+	flush      *ebpf.Program
+	vramUsage  *ebpf.Map
+	vramAllocs *ebpf.Map
+	vramStats  *ebpf.Map
+	healthRing *ringbuf.Reader
+}
+
+// newProgramLoader 加载并附加全部 eBPF 程序
+func newProgramLoader(config *Config) (programLoader, error) {
+	pinPath := config.PinPath
+	if err := rlimit.RemoveMemlock(); err != nil {
+		return nil, fmt.Errorf("failed to remove memlock limit: %w", err)
+	}
+	if err := os.MkdirAll(filepath.Join(pinPath, "links"), 0700); err != nil {
+		return nil, fmt.Errorf("failed to create pin path: %w", err)
+	}
+
+	l := &bpfLoader{pinPath: pinPath}
+	programs := []struct {
+		name string
+		load func() (*ebpf.CollectionSpec, error)
+	}{
+		{"gpu_monitor", loadGpuMonitor},
+		{"pcie_monitor", loadPcieMonitor},
+		{"health_events", loadHealthEvents},
+	}
+	if config.VRAMTracing {
+		programs = append(programs, struct {
+			name string
+			load func() (*ebpf.CollectionSpec, error)
+		}{"vram_tracker", loadVramTracker})
+	}
+
+	maps := make(map[string]*ebpf.Map)
+	known := make(map[string]bool)
+	for _, p := range programs {
+		spec, err := p.load()
+		if err != nil {
+			l.Close()
+			return nil, fmt.Errorf("failed to load %s spec: %w", p.name, err)
+		}
+		if p.name == "health_events" && features.HaveProgramType(ebpf.Syscall) != nil {
+			// 5.14 之前的内核没有 syscall 程序：合并计数只随下一条同类事件送达
+			delete(spec.Programs, "flush_health_throttle")
+		}
+
+		coll, err := newCollection(spec, pinPath)
+		if err != nil {
+			l.Close()
+			return nil, fmt.Errorf("failed to load %s: %w", p.name, err)
+		}
+		l.collections = append(l.collections, coll)
+
+		for name, prog := range coll.Programs {
+			known[name] = true
+			section := spec.Programs[name].SectionName
+			switch kind, _, _ := strings.Cut(section, "/"); kind {
+			case "uprobe", "uretprobe", "syscall":
+				// uprobe 按库单独挂载，syscall 程序由用户态按需运行
+				continue
+			}
+			// 内核没有对应 tracepoint/函数时跳过该挂载点
+			if err := l.attach(name, section, prog); err != nil {
+				klog.Warningf("eBPF: skipping %s (%s): %v", name, section, err)
+			}
+		}
+		if p.name == "health_events" {
+			l.flush = coll.Programs["flush_health_throttle"]
+		}
+		if p.name == "vram_tracker" {
+			if l.attachVRAMProbes(coll, config.VRAMLibraries, config.VRAMLibraryDirs) {
+				l.vramUsage = coll.Maps["vram_cgroup_usage"]
+				l.vramAllocs = coll.Maps["vram_allocs"]
+				l.vramStats = coll.Maps["vram_tracker_stats"]
+			} else {
+				klog.Warning("eBPF: no VRAM allocation symbol could be probed, VRAM tracing disabled")
+			}
+		}
+		for name, m := range coll.Maps {
+			maps[name] = m
+		}
+	}
+
+	if len(l.links) == 0 {
+		l.Close()
+		return nil, fmt.Errorf("no eBPF attach points available on this kernel")
+	}
+	l.unpinStaleLinks(known)
+
+	l.gpuStats = maps["gpu_stats_map"]
+	l.pcieStats = maps["pcie_stats_map"]
+	l.pcieHist = maps["pcie_hist_map"]
+	l.pcieCgroup = maps["pcie_cgroup_map"]
+	l.registry = maps["hcs_device_registry"]
+	l.ranges = maps["hcs_device_ranges"]
+	l.throttle = maps["health_throttle_cfg"]
+	l.eventStats = maps["health_event_stats"]
+	if l.gpuStats == nil || l.pcieStats == nil || l.pcieHist == nil || l.pcieCgroup == nil ||
+		l.registry == nil || l.ranges == nil ||
+		l.throttle == nil || l.eventStats == nil || maps["health_events"] == nil {
+		l.Close()
+		return nil, fmt.Errorf("eBPF objects are missing required maps")
+	}
+
+	ring, err := ringbuf.NewReader(maps["health_events"])
+	if err != nil {
+		l.Close()
+		return nil, fmt.Errorf("failed to open health_events ring buffer: %w", err)
+	}
+	l.healthRing = ring
+
+	return l, nil
+}
+
+// attach 按 ELF section 名附加程序，并把 link 固定到 pinPath/links
+// 已固定且程序未变化的 link 直接复用，无需重新附加
+func (l *bpfLoader) attach(name, section string, prog *ebpf.Program) error {
+	pin := filepath.Join(l.pinPath, "links", name)
+
+	if old, err := link.LoadPinnedLink(pin, nil); err == nil {
+		if sameProgram(old, prog) {
+			l.links = append(l.links, old)
+			return nil
+		}
+		if err := old.Update(prog); err == nil {
+			l.links = append(l.links, old)
+			return nil
+		}
+		// 程序已升级且 link 不支持原地替换：分离旧程序后重新附加
+		old.Unpin()
+		old.Close()
+	}
+
+	kind, target, _ := strings.Cut(section, "/")
+	var lk link.Link
+	var err error
+	switch kind {
+	case "tp", "tracepoint":
+		group, event, ok := strings.Cut(target, "/")
+		if !ok {
+			return fmt.Errorf("invalid tracepoint section %q", section)
+		}
+		lk, err = link.Tracepoint(group, event, prog, nil)
+	case "kprobe":
+		lk, err = link.Kprobe(target, prog, nil)
+	case "kretprobe":
+		lk, err = link.Kretprobe(target, prog, nil)
+	default:
+		return fmt.Errorf("unsupported section %q", section)
+	}
+	if err != nil {
+		return err
+	}
+
+	// 旧内核上 perf-event link 不支持固定，此时退化为每次启动重新附加
+	_ = lk.Pin(pin)
+	l.links = append(l.links, lk)
+	return nil
+}
+
+// newCollection 加载程序集，复用 pinPath 下已固定的 map
+// 升级后 map 定义变化（类型、键值大小等）时旧的固定 map 无法复用，
+// 删除这些固定文件后重新加载；对应的累计计数从零开始
+func newCollection(spec *ebpf.CollectionSpec, pinPath string) (*ebpf.Collection, error) {
+	opts := ebpf.CollectionOptions{Maps: ebpf.MapOptions{PinPath: pinPath}}
+	coll, err := ebpf.NewCollectionWithOptions(spec, opts)
+	if err == nil || !errors.Is(err, ebpf.ErrMapIncompatible) {
+		return coll, err
+	}
+
+	for name, ms := range spec.Maps {
+		if ms.Pinning != ebpf.PinByName {
+			continue
+		}
+		pin := filepath.Join(pinPath, name)
+		old, err := ebpf.LoadPinnedMap(pin, nil)
+		if err != nil {
+			continue
+		}
+		incompatible := ms.Compatible(old) != nil
+		old.Close()
+		if incompatible {
+			klog.Warningf("eBPF: pinned map %s does not match the new definition, replacing it", name)
+			if err := os.Remove(pin); err != nil {
+				return nil, fmt.Errorf("failed to remove incompatible pinned map %s: %w", name, err)
+			}
+		}
+	}
+	return ebpf.NewCollectionWithOptions(spec, opts)
+}
+
+// unpinStaleLinks 分离 pinPath/links 下不再属于任何已加载程序的 link
+// 程序在升级中被删除时，其固定的 link 会让旧程序一直挂载在内核中
+func (l *bpfLoader) unpinStaleLinks(known map[string]bool) {
+	dir := filepath.Join(l.pinPath, "links")
+	entries, err := os.ReadDir(dir)
+	if err != nil {
+		return
+	}
+	for _, e := range entries {
+		if known[e.Name()] {
+			continue
+		}
+		lk, err := link.LoadPinnedLink(filepath.Join(dir, e.Name()), nil)
+		if err != nil {
+			continue
+		}
+		klog.Infof("eBPF: detaching stale pinned link %s", e.Name())
+		lk.Unpin()
+		lk.Close()
+	}
+}
+
+// attachVRAMProbes 在运行时库的分配/释放符号上挂载 uprobe，至少挂载一个时返回 true
+// uprobe link 不支持固定，每次启动重新挂载；库中不存在的符号跳过
+func (l *bpfLoader) attachVRAMProbes(coll *ebpf.Collection, libraries, dirs []string) bool {
+	enter := coll.Programs["vram_alloc_enter"]
+	exit := coll.Programs["vram_alloc_exit"]
+	free := coll.Programs["vram_free"]
+	if enter == nil || exit == nil || free == nil {
+		return false
+	}
+
+	attached := false
+	for _, target := range vramTargets(libraries, dirs) {
+		ex, err := link.OpenExecutable(target.path)
+		if err != nil {
+			continue
+		}
+		for _, sym := range target.runtime.allocs {
+			up, err := ex.Uprobe(sym, enter, nil)
+			if err != nil {
+				continue
+			}
+			ret, err := ex.Uretprobe(sym, exit, nil)
+			if err != nil {
+				up.Close()
+				continue
+			}
+			l.links = append(l.links, up, ret)
+			attached = true
+		}
+		for _, sym := range target.runtime.frees {
+			if lk, err := ex.Uprobe(sym, free, nil); err == nil {
+				l.links = append(l.links, lk)
+			}
+		}
+	}
+	return attached
+}
+
+// sameProgram 判断已固定 link 上的程序与新加载的程序是否相同
+func sameProgram(lk link.Link, prog *ebpf.Program) bool {
+	info, err := lk.Info()
+	if err != nil {
+		return false
+	}
+	old, err := ebpf.NewProgramFromID(info.Program)
+	if err != nil {
+		return false
+	}
+	defer old.Close()
+
+	oldInfo, err := old.Info()
+	if err != nil {
+		return false
+	}
+	newInfo, err := prog.Info()
+	if err != nil {
+		return false
+	}
+	return oldInfo.Tag == newInfo.Tag
+}
+
+// ReadGPUStats 一次遍历 gpu_stats_map，返回每设备的 per-CPU 聚合值
+func (l *bpfLoader) ReadGPUStats() (map[uint32][]GPUDeviceStats, error) {
+	result := make(map[uint32][]GPUDeviceStats)
+	var key uint32
+	var values []GPUDeviceStats
+
+	it := l.gpuStats.Iterate()
+	for it.Next(&key, &values) {
+		result[key] = values
+		values = nil
+	}
+	return result, it.Err()
+}
+
+// ReadPCIeStats 一次遍历 pcie_stats_map，返回每设备的 per-CPU 计数
+func (l *bpfLoader) ReadPCIeStats() (map[uint32][]PCIeDeviceStats, error) {
+	result := make(map[uint32][]PCIeDeviceStats)
+	var key uint32
+	var values []PCIeDeviceStats
+
+	it := l.pcieStats.Iterate()
+	for it.Next(&key, &values) {
+		result[key] = values
+		values = nil
+	}
+	return result, it.Err()
+}
+
+// ReadPCIeHistograms 一次遍历 pcie_hist_map，返回每设备的 per-CPU 直方图
+func (l *bpfLoader) ReadPCIeHistograms() (map[uint32][]PCIeDeviceHistogram, error) {
+	result := make(map[uint32][]PCIeDeviceHistogram)
+	var key uint32
+	var values []PCIeDeviceHistogram
+
+	it := l.pcieHist.Iterate()
+	for it.Next(&key, &values) {
+		result[key] = values
+		values = nil
+	}
+	return result, it.Err()
+}
+
+// ReadPCIeCgroupBytes 一次遍历 pcie_cgroup_map，返回每 (cgroup, 设备) 的 per-CPU 字节数
+func (l *bpfLoader) ReadPCIeCgroupBytes() (map[PCIeCgroupKey][]PCIeCgroupBytes, error) {
+	result := make(map[PCIeCgroupKey][]PCIeCgroupBytes)
+	var key PCIeCgroupKey
+	var values []PCIeCgroupBytes
+
+	it := l.pcieCgroup.Iterate()
+	for it.Next(&key, &values) {
+		result[key] = values
+		values = nil
+	}
+	return result, it.Err()
+}
+
+// RegisterDevice 写入 hcs_device_registry
+func (l *bpfLoader) RegisterDevice(key DeviceKey, index uint32) error {
+	return l.registry.Update(key, index, ebpf.UpdateAny)
+}
+
+// RegisterRange 写入 hcs_device_ranges
+func (l *bpfLoader) RegisterRange(index uint32, r AddressRange) error {
+	return l.ranges.Update(index, r, ebpf.UpdateAny)
+}
+
+// ConfigureHealthThrottle 写入 health_throttle_cfg
+func (l *bpfLoader) ConfigureHealthThrottle(cfg HealthThrottleConfig) error {
+	return l.throttle.Update(uint32(0), cfg, ebpf.UpdateAny)
+}
+
+// FlushHealthThrottle 通过 BPF_PROG_RUN 运行 flush_health_throttle
+// 合并计数的领取须与内核中的 submit_health_event 原子互斥，用户态无法对 map 值做原子交换，
+// 因此遍历与提交都在内核中完成
+func (l *bpfLoader) FlushHealthThrottle() error {
+	if l.flush == nil {
+		return nil
+	}
+	_, err := l.flush.Run(&ebpf.RunOptions{})
+	return err
+}
+
+// ReadHealthEventStats 读取 health_event_stats 并汇总 per-CPU 计数
+func (l *bpfLoader) ReadHealthEventStats() (HealthEventStats, error) {
+	var stats HealthEventStats
+	counters := []*uint64{&stats.Emitted, &stats.Coalesced, &stats.Dropped}
+
+	var values []uint64
+	for i, counter := range counters {
+		if err := l.eventStats.Lookup(uint32(i), &values); err != nil {
+			return HealthEventStats{}, err
+		}
+		for _, v := range values {
+			*counter += v
+		}
+	}
+	return stats, nil
+}
+
+// ReadVRAMUsage 一次遍历 vram_cgroup_usage
+func (l *bpfLoader) ReadVRAMUsage() (map[uint64]VRAMCgroupUsage, error) {
+	result := make(map[uint64]VRAMCgroupUsage)
+	if l.vramUsage == nil {
+		return result, nil
+	}
+
+	var key uint64
+	var value VRAMCgroupUsage
+	it := l.vramUsage.Iterate()
+	for it.Next(&key, &value) {
+		result[key] = value
+	}
+	return result, it.Err()
+}
+
+// DeleteVRAMUsage 删除 vram_cgroup_usage 中的条目
+func (l *bpfLoader) DeleteVRAMUsage(cgroupID uint64) error {
+	if l.vramUsage == nil {
+		return nil
+	}
+	err := l.vramUsage.Delete(cgroupID)
+	if errors.Is(err, ebpf.ErrKeyNotExist) {
+		return nil
+	}
+	return err
+}
+
+// vramAllocKey 与 vram_tracker.c 中 struct vram_alloc_key 布局一致
+type vramAllocKey struct {
+	Tgid uint32
+	_    uint32
+	Addr uint64
+}
+
+// ReadVRAMTrackerStats 读取 vram_tracker_stats 并汇总 per-CPU 计数
+func (l *bpfLoader) ReadVRAMTrackerStats() (VRAMTrackerStats, error) {
+	var stats VRAMTrackerStats
+	if l.vramStats == nil {
+		return stats, nil
+	}
+	counters := []*uint64{&stats.AllocsUntracked, &stats.ProcsUntracked}
+
+	var values []uint64
+	for i, counter := range counters {
+		if err := l.vramStats.Lookup(uint32(i), &values); err != nil {
+			return VRAMTrackerStats{}, err
+		}
+		for _, v := range values {
+			*counter += v
+		}
+	}
+	return stats, nil
+}
+
+// PruneVRAMAllocs 遍历 vram_allocs，删除已退出进程的条目
+// 遍历结束后再删除，避免删除当前 key 使迭代从头开始
+func (l *bpfLoader) PruneVRAMAllocs(alive func(tgid uint32) bool) (int, error) {
+	if l.vramAllocs == nil {
+		return 0, nil
+	}
+
+	var key vramAllocKey
+	var value [24]byte
+	var stale []vramAllocKey
+	checked := make(map[uint32]bool)
+
+	it := l.vramAllocs.Iterate()
+	for it.Next(&key, &value) {
+		live, ok := checked[key.Tgid]
+		if !ok {
+			live = alive(key.Tgid)
+			checked[key.Tgid] = live
+		}
+		if !live {
+			stale = append(stale, key)
+		}
+	}
+	if err := it.Err(); err != nil {
+		return 0, err
+	}
+
+	pruned := 0
+	for _, k := range stale {
+		if err := l.vramAllocs.Delete(k); err == nil {
+			pruned++
+		} else if !errors.Is(err, ebpf.ErrKeyNotExist) {
+			return pruned, err
+		}
+	}
+	return pruned, nil
+}
+
+// ConsumeHealthEvents 从 mmap 的 ring buffer 读取健康事件
+// 记录缓冲区复用，直接解码为 HealthEvent 后交给 handle，直到 Close
+func (l *bpfLoader) ConsumeHealthEvents(handle func(HealthEvent)) error {
+	var rec ringbuf.Record
+	var event HealthEvent
+
+	for {
+		if err := l.healthRing.ReadInto(&rec); err != nil {
+			if errors.Is(err, ringbuf.ErrClosed) {
+				return nil
+			}
+			return err
+		}
+		if decodeHealthEvent(rec.RawSample, &event) {
+			handle(event)
+		}
+	}
+}
+
+// Close 释放程序、map 与 link 的句柄
+// 已固定的 map 和 link 保留在 bpffs 中，程序继续运行，下次启动时复用
+func (l *bpfLoader) Close() error {
+	if l.healthRing != nil {
+		l.healthRing.Close()
+	}
+	for _, lk := range l.links {
+		lk.Close()
+	}
+	for _, coll := range l.collections {
+		coll.Close()
+	}
+	l.links = nil
+	l.collections = nil
+	return nil
+}
@@ -0,0 +1,10 @@
+//go:build !hcs_bpf
+
+package ebpf
+
+import "fmt"
+
+// newProgramLoader 未以 hcs_bpf 标签构建时 eBPF 程序不可用，调用方回退到轮询模式
+func newProgramLoader(config *Config) (programLoader, error) {
+	return nil, fmt.Errorf("eBPF programs not compiled (build with -tags hcs_bpf)")
+}
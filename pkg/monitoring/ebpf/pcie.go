@@ -0,0 +1,132 @@
+package ebpf
+
+import (
+	"sort"
+	"time"
+)
+
+// PCIeDetailSource DMA 直方图与按 cgroup 计数的读取接口
+// 由 eBPF 加载器基于 pcie_hist_map / pcie_cgroup_map 实现，返回 per-CPU 累计值
+type PCIeDetailSource interface {
+	ReadPCIeHistograms() (map[uint32][]PCIeDeviceHistogram, error)
+	ReadPCIeCgroupBytes() (map[PCIeCgroupKey][]PCIeCgroupBytes, error)
+}
+
+// CgroupPCIeBandwidth 单个容器在单个设备上的 DMA 带宽
+type CgroupPCIeBandwidth struct {
+	PodUID           string
+	ContainerID      string
+	CgroupID         uint64
+	DeviceID         uint32
+	ReadBytesPerSec  float64
+	WriteBytesPerSec float64
+}
+
+// pcieDetailCursor 上一次读取的累计值，用于按调用间隔做差
+type pcieDetailCursor struct {
+	hist      map[uint32]PCIeDeviceHistogram
+	bytes     map[PCIeCgroupKey]PCIeCgroupBytes
+	bytesRead time.Time
+}
+
+// GetPCIeHistograms 返回自上次调用以来每设备的 DMA 大小与延迟直方图
+// 内核直方图只增不减，这里汇总 per-CPU 值后与上次读取做差；首次调用返回累计值
+func (m *EBPFManager) GetPCIeHistograms() map[uint32]PCIeDeviceHistogram {
+	m.mu.RLock()
+	source := m.pcieDetail
+	m.mu.RUnlock()
+
+	if source == nil {
+		return nil
+	}
+	stats, err := source.ReadPCIeHistograms()
+	if err != nil {
+		return nil
+	}
+
+	m.pcieMu.Lock()
+	defer m.pcieMu.Unlock()
+
+	result := make(map[uint32]PCIeDeviceHistogram, len(stats))
+	for deviceID, perCPU := range stats {
+		sum := SumPCIeHistograms(perCPU)
+		prev := m.pcieDetailCursor.hist[deviceID]
+		result[deviceID] = PCIeDeviceHistogram{
+			Size:    sum.Size.since(&prev.Size),
+			Latency: sum.Latency.since(&prev.Latency),
+		}
+		m.pcieDetailCursor.hist[deviceID] = sum
+	}
+	return result
+}
+
+// GetPCIeCgroupBandwidth 返回自上次调用以来每个 Pod 容器在各设备上的 DMA 带宽
+// 首次调用只建立基准；非 Pod 的 cgroup 被忽略
+func (m *EBPFManager) GetPCIeCgroupBandwidth() []CgroupPCIeBandwidth {
+	m.mu.RLock()
+	source := m.pcieDetail
+	m.mu.RUnlock()
+
+	if source == nil {
+		return nil
+	}
+	stats, err := source.ReadPCIeCgroupBytes()
+	if err != nil {
+		return nil
+	}
+	now := time.Now()
+
+	m.pcieMu.Lock()
+	cursor := &m.pcieDetailCursor
+	elapsed := now.Sub(cursor.bytesRead).Seconds()
+	first := cursor.bytesRead.IsZero()
+	prev := cursor.bytes
+	cursor.bytes = make(map[PCIeCgroupKey]PCIeCgroupBytes, len(stats))
+	cursor.bytesRead = now
+	for key, perCPU := range stats {
+		cursor.bytes[key] = SumPCIeCgroupBytes(perCPU)
+	}
+	current := cursor.bytes
+	m.pcieMu.Unlock()
+
+	if first || elapsed <= 0 {
+		return nil
+	}
+
+	var result []CgroupPCIeBandwidth
+	for key, cur := range current {
+		p, ok := prev[key]
+		// LRU 淘汰后重建的条目从 0 开始计数
+		if !ok || cur.ReadBytes < p.ReadBytes || cur.WriteBytes < p.WriteBytes {
+			p = PCIeCgroupBytes{}
+		}
+		read, write := cur.ReadBytes-p.ReadBytes, cur.WriteBytes-p.WriteBytes
+		if read == 0 && write == 0 {
+			continue
+		}
+
+		owner, _ := m.cgroups.resolve(key.CgroupID)
+		if owner.PodUID == "" {
+			continue
+		}
+		result = append(result, CgroupPCIeBandwidth{
+			PodUID:           owner.PodUID,
+			ContainerID:      owner.ContainerID,
+			CgroupID:         key.CgroupID,
+			DeviceID:         key.DeviceID,
+			ReadBytesPerSec:  float64(read) / elapsed,
+			WriteBytesPerSec: float64(write) / elapsed,
+		})
+	}
+
+	sort.Slice(result, func(i, j int) bool {
+		if result[i].PodUID != result[j].PodUID {
+			return result[i].PodUID < result[j].PodUID
+		}
+		if result[i].ContainerID != result[j].ContainerID {
+			return result[i].ContainerID < result[j].ContainerID
+		}
+		return result[i].DeviceID < result[j].DeviceID
+	})
+	return result
+}
@@ -7,7 +7,15 @@
  * - Power usage (mW)
  * - Temperature (Celsius)
  * - Utilization (%)
- * - Throttling flags
+ *
+ * The tracepoints name devices by driver number (NVIDIA minor, DRM card
+ * index); every sample is resolved to its HCS device index through
+ * hcs_device_registry, and samples from unregistered devices (a BMC VGA
+ * on card0, for instance) are dropped.
+ *
+ * Samples are aggregated in-kernel into a per-device, per-CPU map
+ * (last/min/max/sum/count per metric) that userspace reads in batches,
+ * rather than emitting one ring-buffer record per tracepoint hit.
  *
  * Supports:
  * - NVIDIA GPUs via nvml tracepoints
@@ -19,90 +27,130 @@
 #include <bpf/bpf_helpers.h>
 #include <bpf/bpf_tracing.h>
 
-/* GPU event structure */
-struct gpu_event {
-	__u32 device_id;
-	__u64 timestamp;
-	__u32 core_clock;
-	__u32 mem_clock;
-	__u32 power;
-	__u32 temperature;
-	__u32 utilization;
-	__u8 throttling_flags;
+#include "hcs_devices.h"
+
+/* Metrics aggregated per device (index into gpu_device_stats.metrics) */
+enum gpu_metric {
+	GPU_METRIC_CORE_CLOCK = 0,
+	GPU_METRIC_MEM_CLOCK,
+	GPU_METRIC_POWER,
+	GPU_METRIC_TEMPERATURE,
+	GPU_METRIC_UTILIZATION,
+	GPU_METRIC_MAX,
 };
 
-/* BPF map for GPU events */
-struct {
-	__uint(type, BPF_MAP_TYPE_RINGBUF);
-	__uint(max_entries, 256 * 1024);
-} gpu_events SEC(".maps");
+#define GPU_MAX_DEVICES HCS_MAX_DEVICES
+
+/* Running aggregate of one metric on one CPU.
+ * count == 0 means no sample has been seen on this CPU yet; min/max are
+ * only meaningful once count is non-zero.
+ */
+struct gpu_metric_stats {
+	__u64 sum;
+	__u64 count;
+	__u64 last_ts;
+	__u32 last;
+	__u32 min;
+	__u32 max;
+	__u32 pad;
+};
+
+/* Per-device aggregate, one copy per CPU */
+struct gpu_device_stats {
+	struct gpu_metric_stats metrics[GPU_METRIC_MAX];
+};
 
-/* Per-CPU buffer for event submission */
+/* Per-device, per-CPU aggregate map.
+ * Tracepoint hits only update the slot of the CPU they run on, so there
+ * is no cross-CPU contention and no ring-buffer wakeup per hit.
+ * Userspace reads the map in batches at GPUSampleInterval and merges the
+ * per-CPU copies (sum/count added, min/max folded, last taken from the
+ * newest last_ts). Counters are cumulative and never reset in-kernel.
+ */
 struct {
-	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
-	__uint(max_entries, 1);
+	__uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+	__uint(max_entries, GPU_MAX_DEVICES);
 	__type(key, __u32);
-	__type(value, struct gpu_event);
-} gpu_event_buf SEC(".maps");
-
-/* Throttling flags */
-#define THROTTLE_POWER  0x01
-#define THROTTLE_THERMAL 0x02
-#define THROTTLE_RELIABILITY 0x04
-
-/* Submit GPU event to ring buffer */
-static __always_inline int submit_gpu_event(__u32 device_id,
-					    __u32 core_clock,
-					    __u32 mem_clock,
-					    __u32 power,
-					    __u32 temperature,
-					    __u32 utilization,
-					    __u8 throttling_flags)
+	__type(value, struct gpu_device_stats);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} gpu_stats_map SEC(".maps");
+
+/* Look up this CPU's aggregate for a device, creating it on first use */
+static __always_inline struct gpu_device_stats *lookup_gpu_stats(__u32 device_id)
 {
-	struct gpu_event *e;
-	__u32 key = 0;
-	__u64 flags;
+	struct gpu_device_stats *stats;
+	struct gpu_device_stats zero = {};
+
+	stats = bpf_map_lookup_elem(&gpu_stats_map, &device_id);
+	if (stats)
+		return stats;
+
+	/* Losing the insert race to another CPU is fine: either way the
+	 * entry exists afterwards and this CPU's copy starts zeroed.
+	 */
+	bpf_map_update_elem(&gpu_stats_map, &device_id, &zero, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&gpu_stats_map, &device_id);
+}
 
-	e = bpf_map_lookup_elem(&gpu_event_buf, &key);
-	if (!e)
-		return 0;
+/* Fold one sample into a metric aggregate */
+static __always_inline void update_metric(struct gpu_metric_stats *m,
+					  __u32 value, __u64 now)
+{
+	if (m->count == 0 || value < m->min)
+		m->min = value;
+	if (m->count == 0 || value > m->max)
+		m->max = value;
+	m->last = value;
+	m->last_ts = now;
+	m->sum += value;
+	m->count++;
+}
+
+/* Record one metric sample for a device */
+static __always_inline int record_gpu_metric(__u32 device_id,
+					     enum gpu_metric metric,
+					     __u32 value)
+{
+	struct gpu_device_stats *stats;
 
-	e->device_id = device_id;
-	e->timestamp = bpf_ktime_get_ns();
-	e->core_clock = core_clock;
-	e->mem_clock = mem_clock;
-	e->power = power;
-	e->temperature = temperature;
-	e->utilization = utilization;
-	e->throttling_flags = throttling_flags;
+	if (metric >= GPU_METRIC_MAX)
+		return 0;
 
-	flags = BPF_F_CURRENT_CPU;
-	bpf_ringbuf_output(&gpu_events, e, sizeof(*e), flags);
+	stats = lookup_gpu_stats(device_id);
+	if (!stats)
+		return 0;
 
+	update_metric(&stats->metrics[metric], value, bpf_ktime_get_ns());
 	return 0;
 }
 
-/* NVIDIA GPU activity tracepoint */
+/* NVIDIA GPU activity tracepoint, gpu_id is the device minor */
 SEC("tp/nvml/nvml_gpu_activity")
 int handle_nvml_activity(struct trace_event_raw_nvml_gpu_activity *ctx)
 {
-	__u32 device_id = ctx->gpu_id;
 	__u32 utilization = ctx->utilization;
+	__u32 device_id;
 
-	/* Read additional metrics from sysfs */
-	submit_gpu_event(device_id, 0, 0, 0, 0, utilization, 0);
+	if (hcs_lookup(HCS_KEY_NVIDIA_MINOR, 0, ctx->gpu_id, &device_id))
+		return 0;
+
+	record_gpu_metric(device_id, GPU_METRIC_UTILIZATION, utilization);
 	return 0;
 }
 
-/* AMD GPU clock tracepoint */
+/* AMD GPU clock tracepoint, dev_id is the DRM card index */
 SEC("tp/amdgpu/amdgpu_gpu_clock")
 int handle_amdgpu_clock(struct trace_event_raw_amdgpu_gpu_clock *ctx)
 {
-	__u32 device_id = ctx->dev_id;
 	__u32 core_clock = ctx->sclk;
 	__u32 mem_clock = ctx->mclk;
+	__u32 device_id;
 
-	submit_gpu_event(device_id, core_clock, mem_clock, 0, 0, 0, 0);
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
+
+	record_gpu_metric(device_id, GPU_METRIC_CORE_CLOCK, core_clock);
+	record_gpu_metric(device_id, GPU_METRIC_MEM_CLOCK, mem_clock);
 	return 0;
 }
 
@@ -110,10 +158,13 @@ int handle_amdgpu_clock(struct trace_event_raw_amdgpu_gpu_clock *ctx)
 SEC("tp/amdgpu/amdgpu_gpu_power")
 int handle_amdgpu_power(struct trace_event_raw_amdgpu_gpu_power *ctx)
 {
-	__u32 device_id = ctx->dev_id;
 	__u32 power = ctx->power; /* in milliwatts */
+	__u32 device_id;
+
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
 
-	submit_gpu_event(device_id, 0, 0, power, 0, 0, 0);
+	record_gpu_metric(device_id, GPU_METRIC_POWER, power);
 	return 0;
 }
 
@@ -121,10 +172,13 @@ int handle_amdgpu_power(struct trace_event_raw_amdgpu_gpu_power *ctx)
 SEC("tp/amdgpu/amdgpu_gpu_temp")
 int handle_amdgpu_temp(struct trace_event_raw_amdgpu_gpu_temp *ctx)
 {
-	__u32 device_id = ctx->dev_id;
 	__u32 temperature = ctx->temp; /* in millidegrees Celsius */
+	__u32 device_id;
+
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
 
-	submit_gpu_event(device_id, 0, 0, 0, temperature / 1000, 0, 0);
+	record_gpu_metric(device_id, GPU_METRIC_TEMPERATURE, temperature / 1000);
 	return 0;
 }
 
@@ -132,22 +186,13 @@ int handle_amdgpu_temp(struct trace_event_raw_amdgpu_gpu_temp *ctx)
 SEC("tp/amdgpu/amdgpu_gpu_busy")
 int handle_amdgpu_busy(struct trace_event_raw_amdgpu_gpu_busy *ctx)
 {
-	__u32 device_id = ctx->dev_id;
 	__u32 utilization = ctx->busy_percent;
+	__u32 device_id;
 
-	submit_gpu_event(device_id, 0, 0, 0, 0, utilization, 0);
-	return 0;
-}
-
-/* Fallback: kprobe for GPU frequency scaling */
-SEC("kprobe/update_util")
-int BPF_KPROBE(handle_update_util, struct task_struct *p, unsigned int util)
-{
-	/* This is a generic fallback for when tracepoints aren't available */
-	__u32 device_id = 0; /* Would be determined from context */
-	__u32 utilization = util;
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
 
-	submit_gpu_event(device_id, 0, 0, 0, 0, utilization, 0);
+	record_gpu_metric(device_id, GPU_METRIC_UTILIZATION, utilization);
 	return 0;
 }
 
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/* hcs_devices.h - accelerator device registry shared by the HCS eBPF programs
+ *
+ * Userspace (EBPFManager.AddDevices) maps every accelerator it manages to
+ * a compact HCS device index (the N in "gpu-N"):
+ * - PCI domain/bus/devfn of the device itself
+ * - IRQ numbers of the device and its upstream port
+ * - thermal zones bound to the device
+ * - the driver's own device number (NVIDIA minor, DRM card index)
+ * - the device's memory BAR range (for MCE / memory_failure addresses)
+ *
+ * Programs resolve events through these maps and drop anything that is
+ * not registered, so NICs, NVMe and host-memory errors cost one lookup
+ * and are never attributed to device 0.
+ *
+ * The maps are pinned by name so all programs share a single registry.
+ */
+#ifndef __HCS_DEVICES_H
+#define __HCS_DEVICES_H
+
+#include <bpf/bpf_core_read.h>
+
+#define HCS_MAX_DEVICES 64
+
+/* Kinds of identity that map to a device */
+enum hcs_key_kind {
+	HCS_KEY_PCI = 0,          /* domain + (bus << 8 | devfn) */
+	HCS_KEY_IRQ = 1,          /* irq number */
+	HCS_KEY_THERMAL_ZONE = 2, /* thermal zone id */
+	HCS_KEY_NVIDIA_MINOR = 3, /* /dev/nvidiaN */
+	HCS_KEY_DRM_MINOR = 4,    /* /dev/dri/cardN */
+};
+
+struct hcs_device_key {
+	__u32 kind;
+	__u32 domain; /* PCI domain, 0 for other kinds */
+	__u32 id;
+};
+
+/* Physical address range owned by a device */
+struct hcs_addr_range {
+	__u64 start;
+	__u64 end; /* exclusive, 0 = slot unused */
+};
+
+/* Identity -> HCS device index */
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, HCS_MAX_DEVICES * 8);
+	__type(key, struct hcs_device_key);
+	__type(value, __u32);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} hcs_device_registry SEC(".maps");
+
+/* HCS device index -> memory BAR range */
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, HCS_MAX_DEVICES);
+	__type(key, __u32);
+	__type(value, struct hcs_addr_range);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} hcs_device_ranges SEC(".maps");
+
+/* Resolve an identity, returns 0 and sets *index when registered */
+static __always_inline int hcs_lookup(__u32 kind, __u32 domain, __u32 id,
+				      __u32 *index)
+{
+	struct hcs_device_key key = {
+		.kind = kind,
+		.domain = domain,
+		.id = id,
+	};
+	__u32 *value;
+
+	value = bpf_map_lookup_elem(&hcs_device_registry, &key);
+	if (!value)
+		return -1;
+
+	*index = *value;
+	return 0;
+}
+
+/* PCI domain of a device.
+ * Generic-domain architectures keep it in pci_bus; x86 keeps it in the
+ * host bridge sysdata.
+ */
+static __always_inline __u32 hcs_pci_domain(struct pci_dev *pdev)
+{
+	struct pci_bus *bus = BPF_CORE_READ(pdev, bus);
+
+	if (!bus)
+		return 0;
+	if (bpf_core_field_exists(bus->domain_nr))
+		return BPF_CORE_READ(bus, domain_nr);
+#if defined(__TARGET_ARCH_x86)
+	{
+		struct pci_sysdata *sd = BPF_CORE_READ(bus, sysdata);
+
+		if (sd)
+			return BPF_CORE_READ(sd, domain);
+	}
+#endif
+	return 0;
+}
+
+/* Resolve a PCI device by its full BDF */
+static __always_inline int hcs_lookup_pci(struct pci_dev *pdev, __u32 *index)
+{
+	__u32 bus, devfn;
+
+	if (!pdev)
+		return -1;
+
+	bus = BPF_CORE_READ(pdev, bus, number);
+	devfn = BPF_CORE_READ(pdev, devfn);
+	return hcs_lookup(HCS_KEY_PCI, hcs_pci_domain(pdev),
+			  bus << 8 | devfn, index);
+}
+
+/* Resolve a physical address to the device whose BAR contains it */
+static __always_inline int hcs_lookup_addr(__u64 addr, __u32 *index)
+{
+	struct hcs_addr_range *r;
+	__u32 i;
+
+	for (i = 0; i < HCS_MAX_DEVICES; i++) {
+		r = bpf_map_lookup_elem(&hcs_device_ranges, &i);
+		if (!r || r->end == 0)
+			continue;
+		if (addr >= r->start && addr < r->end) {
+			*index = i;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+#endif /* __HCS_DEVICES_H */
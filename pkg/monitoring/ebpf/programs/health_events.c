@@ -7,13 +7,25 @@
  * - Page retirement events
  * - GPU reset events
  * - Thermal throttling events
- * - Power throttling events
+ *
+ * Every path resolves the device through hcs_device_registry, so records
+ * carry the HCS device index; events from unregistered devices are dropped.
+ * Power throttling is not detected: nothing emits EVENT_THROTTLE_POWER
+ * (RAPL energy thresholds name a CPU package, not an accelerator) and
+ * gpu_monitor does not record throttle flags.
+ *
+ * Bursts are rate limited per (device, event type) and coalesced into a
+ * single record carrying the event count; submission and drop counters
+ * are kept in health_event_stats. Counts still pending when a burst ends
+ * are flushed by flush_health_throttle, which userspace runs periodically.
  */
 
 #include "vmlinux.h"
 #include <bpf/bpf_helpers.h>
 #include <bpf/bpf_tracing.h>
 
+#include "hcs_devices.h"
+
 /* Health event types */
 #define EVENT_ECC_SB      0  /* Single-bit ECC error */
 #define EVENT_ECC_DB      1  /* Double-bit ECC error */
@@ -21,6 +33,7 @@
 #define EVENT_GPU_RESET   3  /* GPU reset */
 #define EVENT_THROTTLE_THERM 4 /* Thermal throttling */
 #define EVENT_THROTTLE_POWER  5 /* Power throttling */
+#define EVENT_TYPE_MAX    6
 
 /* Health event structure */
 struct health_event {
@@ -35,6 +48,7 @@ struct health_event {
 struct {
 	__uint(type, BPF_MAP_TYPE_RINGBUF);
 	__uint(max_entries, 256 * 1024);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
 } health_events SEC(".maps");
 
 /* Per-CPU buffer for event submission */
@@ -45,15 +59,101 @@ struct {
 	__type(value, struct health_event);
 } health_event_buf SEC(".maps");
 
-/* Submit health event to ring buffer */
-static __always_inline int submit_health_event(__u32 device_id,
+/* Rate limiting
+ *
+ * Userspace writes a minimum interval per event type (derived from
+ * Config.GPUSampleInterval). Within an interval, events of the same
+ * (device, type) are not submitted; their counts accumulate in the
+ * throttle state and are carried by the next record that is submitted,
+ * so an ECC storm becomes one record per interval with the total count.
+ * If no further event arrives, flush_health_throttle submits the pending
+ * count once the interval has passed (trailing edge).
+ * An interval of 0 disables throttling for that type.
+ */
+struct health_throttle_config {
+	__u64 min_interval_ns[EVENT_TYPE_MAX];
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_ARRAY);
+	__uint(max_entries, 1);
+	__type(key, __u32);
+	__type(value, struct health_throttle_config);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} health_throttle_cfg SEC(".maps");
+
+struct health_throttle_key {
+	__u32 device_id;
+	__u32 event_type;
+};
+
+struct health_throttle_state {
+	__u64 last_emit_ns;
+	__u32 pending;  /* events coalesced since last_emit_ns */
+	__u32 pad;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, HCS_MAX_DEVICES * EVENT_TYPE_MAX);
+	__type(key, struct health_throttle_key);
+	__type(value, struct health_throttle_state);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} health_throttle SEC(".maps");
+
+/* Submission counters, exported by userspace as metrics */
+enum health_stat {
+	HEALTH_STAT_EMITTED = 0,   /* records written to the ring buffer */
+	HEALTH_STAT_COALESCED = 1, /* events folded into a later record */
+	HEALTH_STAT_DROPPED = 2,   /* records lost because the ring was full */
+	HEALTH_STAT_MAX,
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, HEALTH_STAT_MAX);
+	__type(key, __u32);
+	__type(value, __u64);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} health_event_stats SEC(".maps");
+
+static __always_inline void count_stat(__u32 stat, __u64 n)
+{
+	__u64 *value = bpf_map_lookup_elem(&health_event_stats, &stat);
+
+	if (value)
+		*value += n;
+}
+
+/* Throttle state of (device, type), created on first use */
+static __always_inline struct health_throttle_state *
+lookup_throttle(__u32 device_id, __u8 event_type)
+{
+	struct health_throttle_key key = {
+		.device_id = device_id,
+		.event_type = event_type,
+	};
+	struct health_throttle_state zero = {};
+	struct health_throttle_state *st;
+
+	st = bpf_map_lookup_elem(&health_throttle, &key);
+	if (st)
+		return st;
+
+	bpf_map_update_elem(&health_throttle, &key, &zero, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&health_throttle, &key);
+}
+
+/* Write one record to the ring buffer; a dropped record's count goes
+ * back to the throttle state so the next record carries it */
+static __always_inline int emit_health_record(__u32 device_id,
 					      __u8 event_type,
 					      __u32 count,
-					      __u64 address)
+					      __u64 address,
+					      struct health_throttle_state *st)
 {
 	struct health_event *e;
 	__u32 key = 0;
-	__u64 flags;
 
 	e = bpf_map_lookup_elem(&health_event_buf, &key);
 	if (!e)
@@ -65,20 +165,115 @@ static __always_inline int submit_health_event(__u32 device_id,
 	e->count = count;
 	e->address = address;
 
-	flags = BPF_F_CURRENT_CPU;
-	bpf_ringbuf_output(&health_events, e, sizeof(*e), flags);
+	if (bpf_ringbuf_output(&health_events, e, sizeof(*e), 0)) {
+		if (st)
+			__sync_fetch_and_add(&st->pending, count);
+		count_stat(HEALTH_STAT_DROPPED, 1);
+		return 0;
+	}
 
+	count_stat(HEALTH_STAT_EMITTED, 1);
 	return 0;
 }
 
-/* NVIDIA ECC error tracepoint */
+/* Submit health event to ring buffer, subject to rate limiting */
+static __always_inline int submit_health_event(__u32 device_id,
+					      __u8 event_type,
+					      __u32 count,
+					      __u64 address)
+{
+	struct health_throttle_config *cfg;
+	struct health_throttle_state *st = NULL;
+	__u64 now = bpf_ktime_get_ns();
+	__u64 interval = 0;
+	__u32 key = 0;
+
+	if (event_type >= EVENT_TYPE_MAX)
+		return 0;
+
+	cfg = bpf_map_lookup_elem(&health_throttle_cfg, &key);
+	if (cfg)
+		interval = cfg->min_interval_ns[event_type];
+
+	if (interval) {
+		st = lookup_throttle(device_id, event_type);
+		if (st) {
+			__u64 last = st->last_emit_ns;
+
+			/* Only the CPU that advances last_emit_ns submits */
+			if (now - last < interval ||
+			    __sync_val_compare_and_swap(&st->last_emit_ns, last,
+							now) != last) {
+				__sync_fetch_and_add(&st->pending, count);
+				count_stat(HEALTH_STAT_COALESCED, count);
+				return 0;
+			}
+			count += __sync_lock_test_and_set(&st->pending, 0);
+		}
+	}
+
+	return emit_health_record(device_id, event_type, count, address, st);
+}
+
+struct flush_ctx {
+	struct health_throttle_config *cfg;
+	__u64 now;
+};
+
+static long flush_throttle_entry(struct bpf_map *map,
+				 struct health_throttle_key *key,
+				 struct health_throttle_state *st,
+				 struct flush_ctx *ctx)
+{
+	__u32 type = key->event_type;
+	__u64 last = st->last_emit_ns;
+	__u64 interval;
+	__u32 count;
+
+	if (type >= EVENT_TYPE_MAX || !st->pending)
+		return 0;
+	interval = ctx->cfg->min_interval_ns[type];
+	if (!interval || ctx->now - last < interval)
+		return 0;
+
+	/* Same claim as submit_health_event: whoever advances last_emit_ns
+	 * owns the pending count, so a racing event is never counted twice */
+	if (__sync_val_compare_and_swap(&st->last_emit_ns, last, ctx->now) != last)
+		return 0;
+	count = __sync_lock_test_and_set(&st->pending, 0);
+	if (count)
+		emit_health_record(key->device_id, type, count, 0, st);
+	return 0;
+}
+
+/* Trailing-edge flush, run by userspace through BPF_PROG_RUN every
+ * sample interval: submits the counts of (device, type) pairs whose
+ * burst ended before the interval elapsed */
+SEC("syscall")
+int flush_health_throttle(void *ctx)
+{
+	struct flush_ctx fc = { .now = bpf_ktime_get_ns() };
+	__u32 key = 0;
+
+	fc.cfg = bpf_map_lookup_elem(&health_throttle_cfg, &key);
+	if (!fc.cfg)
+		return 0;
+
+	bpf_for_each_map_elem(&health_throttle, flush_throttle_entry, &fc, 0);
+	return 0;
+}
+
+/* NVIDIA ECC error tracepoint, gpu_id is the device minor */
 SEC("tp/nvml/nvml_ecc_error")
 int handle_nvml_ecc(struct trace_event_raw_nvml_ecc_error *ctx)
 {
-	__u32 device_id = ctx->gpu_id;
+	__u32 device_id;
 	__u8 event_type;
 	__u64 address = ctx->address;
 
+	if (hcs_lookup(HCS_KEY_NVIDIA_MINOR, 0, ctx->gpu_id, &device_id))
+		return 0;
+
 	if (ctx->error_type == 0) {
 		event_type = EVENT_ECC_SB;
 	} else {
@@ -89,14 +284,17 @@ int handle_nvml_ecc(struct trace_event_raw_nvml_ecc_error *ctx)
 	return 0;
 }
 
-/* AMD GPU ECC error tracepoint */
+/* AMD GPU ECC error tracepoint, dev_id is the DRM card index */
 SEC("tp/amdgpu/amdgpu_ecc_error")
 int handle_amdgpu_ecc(struct trace_event_raw_amdgpu_ecc_error *ctx)
 {
-	__u32 device_id = ctx->dev_id;
+	__u32 device_id;
 	__u8 event_type;
 	__u64 address = ctx->address;
 
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
+
 	if (ctx->error_type == 0) {
 		event_type = EVENT_ECC_SB;
 	} else {
@@ -111,7 +309,10 @@ int handle_amdgpu_ecc(struct trace_event_raw_amdgpu_ecc_error *ctx)
 SEC("tp/nvml/nvml_gpu_reset")
 int handle_nvml_reset(struct trace_event_raw_nvml_gpu_reset *ctx)
 {
-	__u32 device_id = ctx->gpu_id;
+	__u32 device_id;
+
+	if (hcs_lookup(HCS_KEY_NVIDIA_MINOR, 0, ctx->gpu_id, &device_id))
+		return 0;
 
 	submit_health_event(device_id, EVENT_GPU_RESET, 1, 0);
 	return 0;
@@ -121,7 +322,10 @@ int handle_nvml_reset(struct trace_event_raw_nvml_gpu_reset *ctx)
 SEC("tp/amdgpu/amdgpu_gpu_reset")
 int handle_amdgpu_reset(struct trace_event_raw_amdgpu_gpu_reset *ctx)
 {
-	__u32 device_id = ctx->dev_id;
+	__u32 device_id;
+
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
 
 	submit_health_event(device_id, EVENT_GPU_RESET, 1, 0);
 	return 0;
@@ -131,9 +335,12 @@ int handle_amdgpu_reset(struct trace_event_raw_amdgpu_gpu_reset *ctx)
 SEC("tp/amdgpu/amdgpu_bad_page")
 int handle_amdgpu_bad_page(struct trace_event_raw_amdgpu_bad_page *ctx)
 {
-	__u32 device_id = ctx->dev_id;
+	__u32 device_id;
 	__u64 address = ctx->page_address;
 
+	if (hcs_lookup(HCS_KEY_DRM_MINOR, 0, ctx->dev_id, &device_id))
+		return 0;
+
 	submit_health_event(device_id, EVENT_PAGE_RETIRE, 1, address);
 	return 0;
 }
@@ -142,39 +349,13 @@ int handle_amdgpu_bad_page(struct trace_event_raw_amdgpu_bad_page *ctx)
 SEC("tp/thermal/thermal_temperature_trip")
 int handle_thermal_trip(struct trace_event_raw_thermal_temperature_trip *ctx)
 {
-	/* Check if this is a GPU thermal zone */
-	char tz_name[16];
-
-	bpf_probe_read_kernel_str(tz_name, sizeof(tz_name), ctx->tz_name);
-
-	/* Check for GPU-related thermal zones */
-	if (bpf_strstr(tz_name, "gpu") ||
-	    bpf_strstr(tz_name, "GPU") ||
-	    bpf_strstr(tz_name, "amdgpu") ||
-	    bpf_strstr(tz_name, "nvidia")) {
-		__u32 device_id = 0; /* Would parse from thermal zone name */
-		submit_health_event(device_id, EVENT_THROTTLE_THERM, 1, 0);
-	}
-
-	return 0;
-}
-
-/* RAPL (Running Average Power Limit) events for power throttling */
-SEC("tp/power/energy_threshold")
-int handle_power_threshold(struct trace_event_raw_power_energy_threshold *ctx)
-{
-	char domain_name[16];
-
-	bpf_probe_read_kernel_str(domain_name, sizeof(domain_name),
-				  ctx->domain_name);
+	__u32 device_id;
 
-	/* Check for GPU power domains */
-	if (bpf_strstr(domain_name, "gpu") ||
-	    bpf_strstr(domain_name, "GPU")) {
-		__u32 device_id = 0; /* Would parse from domain name */
-		submit_health_event(device_id, EVENT_THROTTLE_POWER, 1, 0);
-	}
+	/* Only thermal zones bound to a registered accelerator */
+	if (hcs_lookup(HCS_KEY_THERMAL_ZONE, 0, ctx->id, &device_id))
+		return 0;
 
+	submit_health_event(device_id, EVENT_THROTTLE_THERM, 1, 0);
 	return 0;
 }
 
@@ -183,11 +364,13 @@ SEC("kprobe/memory_failure")
 int BPF_KPROBE(handle_memory_failure, unsigned long pfn, int flags)
 {
 	/* This is called when a memory error is detected */
-	/* Could be mapped to GPU memory if the PFN range matches GPU BAR */
-
-	__u32 device_id = 0; /* Would need PFN to device mapping */
+	/* Only attributed when the PFN falls inside an accelerator BAR */
+	__u32 device_id;
 	__u64 address = pfn << PAGE_SHIFT;
 
+	if (hcs_lookup_addr(address, &device_id))
+		return 0;
+
 	submit_health_event(device_id, EVENT_ECC_DB, 1, address);
 	return 0;
 }
@@ -196,40 +379,47 @@ int BPF_KPROBE(handle_memory_failure, unsigned long pfn, int flags)
 SEC("kprobe/amdgpu_device_gpu_recover")
 int BPF_KPROBE(handle_amdgpu_recover, struct amdgpu_device *adev)
 {
-	__u32 device_id = 0;
+	__u32 device_id;
 
-	if (adev) {
-		/* Try to get device ID from adev structure */
-		struct pci_dev *pdev = BPF_CORE_READ(adev, pdev);
-		if (pdev) {
-			device_id = BPF_CORE_READ(pdev, devfn);
-		}
-	}
+	if (!adev)
+		return 0;
+
+	if (hcs_lookup_pci(BPF_CORE_READ(adev, pdev), &device_id))
+		return 0;
 
 	submit_health_event(device_id, EVENT_GPU_RESET, 1, 0);
 	return 0;
 }
 
+/* IA32_MCi_STATUS fields */
+#define MCI_STATUS_VAL   (1ULL << 63) /* register holds a valid error */
+#define MCI_STATUS_UC    (1ULL << 61) /* uncorrected */
+#define MCI_STATUS_ADDRV (1ULL << 58) /* MCi_ADDR is valid */
+#define MCACOD_MEM_MASK  0xef80       /* MCA error code, filter bit ignored */
+#define MCACOD_MEM       0x0080       /* memory controller error: 0000 0000 1MMM CCCC */
+
 /* MCE (Machine Check Exception) monitoring for x86 */
 SEC("tp/mce/mce_record")
 int handle_mce_record(struct trace_event_raw_mce_record *ctx)
 {
-	/* Check if MCE is from GPU memory (requires address range matching) */
+	__u64 status = ctx->status;
 	__u64 address = ctx->addr;
-	__u8 status = ctx->status;
-
-	/* Check if this is a memory error */
-	if (status & 0x800) {
-		__u32 device_id = 0; /* Would need address to device mapping */
-
-		if (status & 0x40) {
-			/* Uncorrected error */
-			submit_health_event(device_id, EVENT_ECC_DB, 1, address);
-		} else {
-			/* Corrected error */
-			submit_health_event(device_id, EVENT_ECC_SB, 1, address);
-		}
-	}
+	__u32 device_id;
+
+	/* Only valid memory controller errors with a usable address */
+	if (!(status & MCI_STATUS_VAL) || !(status & MCI_STATUS_ADDRV))
+		return 0;
+	if ((status & MCACOD_MEM_MASK) != MCACOD_MEM)
+		return 0;
+
+	/* Host memory errors are not ours */
+	if (hcs_lookup_addr(address, &device_id))
+		return 0;
+
+	if (status & MCI_STATUS_UC)
+		submit_health_event(device_id, EVENT_ECC_DB, 1, address);
+	else
+		submit_health_event(device_id, EVENT_ECC_SB, 1, address);
 
 	return 0;
 }
@@ -7,76 +7,199 @@
  * - Transaction layer utilization
  * - Replay count (retries)
  *
- * Uses kprobes on PCIe driver functions and tracepoints.
+ * - DMA mapping size and map-to-unmap latency histograms (log2 buckets)
+ * - Bytes per (cgroup, device), to find the pod saturating a link
+ *
+ * Uses kprobes on PCIe driver functions and tracepoints. Counters live in
+ * per-CPU maps that userspace reads and sums at PCIeSampleInterval.
  */
 
 #include "vmlinux.h"
 #include <bpf/bpf_helpers.h>
 #include <bpf/bpf_tracing.h>
 
-/* PCIe event structure */
-struct pcie_event {
-	__u32 device_id;
-	__u64 timestamp;
+#include "hcs_devices.h"
+
+/* Statistics per device, one copy per CPU.
+ * Counters are cumulative: userspace sums the per-CPU copies and diffs
+ * successive reads to get per-interval bytes.
+ */
+struct pcie_stats {
 	__u64 read_bytes;
 	__u64 write_bytes;
+	__u64 last_update;
 	__u32 replay_count;
+	__u32 pad;
 };
 
-/* Statistics per device */
-struct pcie_stats {
+/* Per-device, per-CPU statistics map, keyed by HCS device index.
+ * dma_map_page is one of the hottest kprobes on a busy GPU host, so each
+ * CPU only touches its own copy: plain adds, no atomics and no shared
+ * cache line.
+ */
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+	__uint(max_entries, HCS_MAX_DEVICES);
+	__type(key, __u32);
+	__type(value, struct pcie_stats);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} pcie_stats_map SEC(".maps");
+
+/* log2 histogram buckets: bucket i counts values in [2^i, 2^(i+1)) */
+#define PCIE_HIST_BUCKETS 32
+
+/* Per-device DMA histograms, one copy per CPU, cumulative */
+struct pcie_hist {
+	__u64 size[PCIE_HIST_BUCKETS];    /* bytes per mapping */
+	__u64 latency[PCIE_HIST_BUCKETS]; /* ns from map to unmap */
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_HASH);
+	__uint(max_entries, HCS_MAX_DEVICES);
+	__type(key, __u32);
+	__type(value, struct pcie_hist);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} pcie_hist_map SEC(".maps");
+
+/* Per-(cgroup, device) DMA bytes, one copy per CPU, cumulative.
+ * Attributed to the task that maps the buffer, which is the process
+ * issuing the transfer (or pinning the host buffer, for drivers that map
+ * once at registration).
+ */
+struct pcie_cgroup_key {
+	__u64 cgroup_id;
+	__u32 device_id;
+	__u32 pad;
+};
+
+struct pcie_cgroup_bytes {
 	__u64 read_bytes;
 	__u64 write_bytes;
-	__u32 replay_count;
-	__u64 last_update;
 };
 
-/* BPF map for PCIe events */
 struct {
-	__uint(type, BPF_MAP_TYPE_RINGBUF);
-	__uint(max_entries, 256 * 1024);
-} pcie_events SEC(".maps");
+	__uint(type, BPF_MAP_TYPE_LRU_PERCPU_HASH);
+	__uint(max_entries, 4096);
+	__type(key, struct pcie_cgroup_key);
+	__type(value, struct pcie_cgroup_bytes);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} pcie_cgroup_map SEC(".maps");
+
+/* dma_map_page_attrs arguments, from entry to return */
+struct pcie_dma_args {
+	__u32 device_id;
+	__u32 pad;
+	__u64 size;
+};
 
-/* Per-device statistics map */
 struct {
 	__uint(type, BPF_MAP_TYPE_HASH);
-	__uint(max_entries, 256);
-	__type(key, __u32);
-	__type(value, struct pcie_stats);
-} pcie_stats_map SEC(".maps");
+	__uint(max_entries, 4096);
+	__type(key, __u64); /* pid_tgid */
+	__type(value, struct pcie_dma_args);
+} pcie_dma_args_map SEC(".maps");
+
+/* Live mappings, keyed by (device, dma address) */
+struct pcie_dma_key {
+	__u32 device_id;
+	__u32 pad;
+	__u64 addr;
+};
 
-/* Per-CPU buffer for event submission */
 struct {
-	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
-	__uint(max_entries, 1);
-	__type(key, __u32);
-	__type(value, struct pcie_event);
-} pcie_event_buf SEC(".maps");
-
-/* Submit PCIe event to ring buffer */
-static __always_inline int submit_pcie_event(__u32 device_id,
-					     __u64 read_bytes,
-					     __u64 write_bytes,
-					     __u32 replay_count)
+	__uint(type, BPF_MAP_TYPE_LRU_HASH);
+	__uint(max_entries, 65536);
+	__type(key, struct pcie_dma_key);
+	__type(value, __u64); /* map timestamp */
+} pcie_dma_inflight SEC(".maps");
+
+/* Index of the highest set bit, 0 for 0 and 1 */
+static __always_inline __u32 log2_u64(__u64 v)
 {
-	struct pcie_event *e;
-	__u32 key = 0;
-	__u64 flags;
+	__u32 r = 0;
+
+	if (v >> 32) { v >>= 32; r += 32; }
+	if (v >> 16) { v >>= 16; r += 16; }
+	if (v >> 8)  { v >>= 8;  r += 8; }
+	if (v >> 4)  { v >>= 4;  r += 4; }
+	if (v >> 2)  { v >>= 2;  r += 2; }
+	if (v >> 1)  { r += 1; }
+	return r;
+}
 
-	e = bpf_map_lookup_elem(&pcie_event_buf, &key);
-	if (!e)
-		return 0;
+static __always_inline __u32 hist_bucket(__u64 v)
+{
+	__u32 b = log2_u64(v);
 
-	e->device_id = device_id;
-	e->timestamp = bpf_ktime_get_ns();
-	e->read_bytes = read_bytes;
-	e->write_bytes = write_bytes;
-	e->replay_count = replay_count;
+	return b < PCIE_HIST_BUCKETS ? b : PCIE_HIST_BUCKETS - 1;
+}
 
-	flags = BPF_F_CURRENT_CPU;
-	bpf_ringbuf_output(&pcie_events, e, sizeof(*e), flags);
+static __always_inline struct pcie_hist *lookup_hist(__u32 device_id)
+{
+	struct pcie_hist *hist;
+	struct pcie_hist zero = {};
 
-	return 0;
+	hist = bpf_map_lookup_elem(&pcie_hist_map, &device_id);
+	if (hist)
+		return hist;
+
+	bpf_map_update_elem(&pcie_hist_map, &device_id, &zero, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&pcie_hist_map, &device_id);
+}
+
+#define IRQ_NAME_LEN 32
+
+/* Whether an IRQ handler name contains "pcie", ignoring case. There is no
+ * string search helper; the loop is bounded by IRQ_NAME_LEN */
+static __always_inline bool irq_name_is_pcie(const char *name)
+{
+	int i;
+
+	for (i = 0; i < IRQ_NAME_LEN - 4; i++) {
+		if (!name[i])
+			return false;
+		if ((name[i] | 0x20) == 'p' && (name[i + 1] | 0x20) == 'c' &&
+		    (name[i + 2] | 0x20) == 'i' && (name[i + 3] | 0x20) == 'e')
+			return true;
+	}
+	return false;
+}
+
+/* Whether dev sits on the PCI bus. The DMA API takes any struct device;
+ * container_of to pci_dev is only valid when dev->bus is pci_bus_type */
+static __always_inline bool dev_is_pci(struct device *dev)
+{
+	const char *name = BPF_CORE_READ(dev, bus, name);
+	char bus[4] = {};
+
+	if (!name || bpf_probe_read_kernel_str(bus, sizeof(bus), name) < 0)
+		return false;
+	return bus[0] == 'p' && bus[1] == 'c' && bus[2] == 'i' && bus[3] == '\0';
+}
+
+/* Account DMA bytes to the current cgroup */
+static __always_inline void update_cgroup_bytes(__u32 device_id,
+						__u64 read_bytes,
+						__u64 write_bytes)
+{
+	struct pcie_cgroup_key key = {
+		.cgroup_id = bpf_get_current_cgroup_id(),
+		.device_id = device_id,
+	};
+	struct pcie_cgroup_bytes zero = {};
+	struct pcie_cgroup_bytes *b;
+
+	b = bpf_map_lookup_elem(&pcie_cgroup_map, &key);
+	if (!b) {
+		bpf_map_update_elem(&pcie_cgroup_map, &key, &zero, BPF_NOEXIST);
+		b = bpf_map_lookup_elem(&pcie_cgroup_map, &key);
+		if (!b)
+			return;
+	}
+
+	b->read_bytes += read_bytes;
+	b->write_bytes += write_bytes;
 }
 
 /* Update device statistics */
@@ -85,25 +208,24 @@ static __always_inline int update_stats(__u32 device_id,
 				       __u64 write_bytes,
 				       __u32 replay_count)
 {
-	struct pcie_stats *stats, new_stats;
-	__u64 now = bpf_ktime_get_ns();
+	struct pcie_stats *stats;
+	struct pcie_stats zero = {};
 
 	stats = bpf_map_lookup_elem(&pcie_stats_map, &device_id);
 	if (!stats) {
-		/* Initialize new stats entry */
-		new_stats.read_bytes = read_bytes;
-		new_stats.write_bytes = write_bytes;
-		new_stats.replay_count = replay_count;
-		new_stats.last_update = now;
-		bpf_map_update_elem(&pcie_stats_map, &device_id, &new_stats, BPF_ANY);
-		return 0;
+		/* Insert a zeroed entry and add to it like any other hit, so
+		 * concurrent first hits on other CPUs are never overwritten.
+		 */
+		bpf_map_update_elem(&pcie_stats_map, &device_id, &zero, BPF_NOEXIST);
+		stats = bpf_map_lookup_elem(&pcie_stats_map, &device_id);
+		if (!stats)
+			return 0;
 	}
 
-	/* Update statistics */
-	__sync_fetch_and_add(&stats->read_bytes, read_bytes);
-	__sync_fetch_and_add(&stats->write_bytes, write_bytes);
-	__sync_fetch_and_add(&stats->replay_count, replay_count);
-	stats->last_update = now;
+	stats->read_bytes += read_bytes;
+	stats->write_bytes += write_bytes;
+	stats->replay_count += replay_count;
+	stats->last_update = bpf_ktime_get_ns();
 
 	return 0;
 }
@@ -113,7 +235,10 @@ SEC("kprobe/pci_read")
 int BPF_KPROBE(handle_pci_read, struct pci_dev *dev,
 	       void *buf, int len, int offset)
 {
-	__u32 device_id = dev->devfn;
+	__u32 device_id;
+
+	if (hcs_lookup_pci(dev, &device_id))
+		return 0;
 
 	update_stats(device_id, len, 0, 0);
 	return 0;
@@ -124,7 +249,10 @@ SEC("kprobe/pci_write")
 int BPF_KPROBE(handle_pci_write, struct pci_dev *dev,
 	       void *buf, int len, int offset)
 {
-	__u32 device_id = dev->devfn;
+	__u32 device_id;
+
+	if (hcs_lookup_pci(dev, &device_id))
+		return 0;
 
 	update_stats(device_id, 0, len, 0);
 	return 0;
@@ -135,82 +263,122 @@ SEC("tp/irq/irq_handler_entry")
 int handle_irq_entry(struct trace_event_raw_irq_handler_entry *ctx)
 {
 	/* Monitor interrupt handler for PCIe error conditions */
-	char handler_name[32];
+	char handler_name[IRQ_NAME_LEN];
+	__u32 device_id;
+
+	/* Only IRQs registered for an accelerator or its upstream port */
+	if (hcs_lookup(HCS_KEY_IRQ, 0, ctx->irq, &device_id))
+		return 0;
 
 	bpf_probe_read_kernel_str(handler_name, sizeof(handler_name),
 				  ctx->name);
 
 	/* Check for PCIe error-related interrupts */
-	if (bpf_strstr(handler_name, "pcie") ||
-	    bpf_strstr(handler_name, "PCIe")) {
+	if (irq_name_is_pcie(handler_name)) {
 		/* This could indicate a replay or error condition */
-		__u32 device_id = 0; /* Would need context mapping */
 		update_stats(device_id, 0, 0, 1);
 	}
 
 	return 0;
 }
 
-/* kprobe: dma_map_page - monitor DMA transfers (GPU memory transfers) */
-SEC("kprobe/dma_map_page")
+/* kprobe: dma_map_page_attrs - monitor DMA transfers (GPU memory transfers)
+ * dma_map_page() is a macro around dma_map_page_attrs() on current kernels.
+ */
+SEC("kprobe/dma_map_page_attrs")
 int BPF_KPROBE(handle_dma_map_page, struct device *dev,
 	       struct page *page, unsigned long offset,
 	       size_t size, enum dma_data_direction dir)
 {
+	struct pcie_dma_args args = {};
+	struct pcie_hist *hist;
 	struct pci_dev *pdev;
 	__u32 device_id;
-	__u64 len = size;
+	__u64 id, len = size;
 
 	/* Get PCI device if available */
-	if (!dev)
+	if (!dev || !dev_is_pci(dev))
 		return 0;
 
 	pdev = bpf_container_of(dev, struct pci_dev, dev);
-	if (!pdev)
-		return 0;
 
-	device_id = pdev->devfn;
+	/* Drops DMA for NICs, NVMe and anything else not registered */
+	if (hcs_lookup_pci(pdev, &device_id))
+		return 0;
 
 	if (dir == DMA_TO_DEVICE) {
 		/* Device read (host to device) */
 		update_stats(device_id, 0, len, 0);
+		update_cgroup_bytes(device_id, 0, len);
 	} else if (dir == DMA_FROM_DEVICE) {
 		/* Device write (device to host) */
 		update_stats(device_id, len, 0, 0);
+		update_cgroup_bytes(device_id, len, 0);
 	}
 
+	hist = lookup_hist(device_id);
+	if (hist)
+		hist->size[hist_bucket(len)]++;
+
+	/* The dma address is only known on return */
+	id = bpf_get_current_pid_tgid();
+	args.device_id = device_id;
+	args.size = len;
+	bpf_map_update_elem(&pcie_dma_args_map, &id, &args, BPF_ANY);
+
 	return 0;
 }
 
-/* Periodic statistics reader (called from userspace) */
-SEC("syscall/read")
-int handle_pcie_read(void)
+/* kretprobe: dma_map_page_attrs - start the latency clock for the mapping */
+SEC("kretprobe/dma_map_page_attrs")
+int BPF_KRETPROBE(handle_dma_map_page_ret, dma_addr_t addr)
 {
-	struct pcie_stats *stats;
-	__u32 device_id = 0;
+	__u64 id = bpf_get_current_pid_tgid();
+	struct pcie_dma_args *args;
+	struct pcie_dma_key key = {};
 	__u64 now = bpf_ktime_get_ns();
-	int i;
 
-	/* Iterate through all devices and emit events for recent activity */
-	for (i = 0; i < 256; i++) {
-		device_id = i;
-		stats = bpf_map_lookup_elem(&pcie_stats_map, &device_id);
-		if (!stats)
-			continue;
+	args = bpf_map_lookup_elem(&pcie_dma_args_map, &id);
+	if (!args)
+		return 0;
 
-		/* Only report if updated recently (within 1 second) */
-		if (now - stats->last_update > 1000000000ULL)
-			continue;
+	key.device_id = args->device_id;
+	key.addr = addr;
+	bpf_map_delete_elem(&pcie_dma_args_map, &id);
 
-		submit_pcie_event(device_id, stats->read_bytes,
-				stats->write_bytes, stats->replay_count);
+	/* DMA_MAPPING_ERROR */
+	if (addr == ~(dma_addr_t)0)
+		return 0;
 
-		/* Reset counters after reporting */
-		__sync_fetch_and_and(&stats->read_bytes, 0);
-		__sync_fetch_and_and(&stats->write_bytes, 0);
-		__sync_fetch_and_and(&stats->replay_count, 0);
-	}
+	bpf_map_update_elem(&pcie_dma_inflight, &key, &now, BPF_ANY);
+	return 0;
+}
+
+/* kprobe: dma_unmap_page_attrs - record map-to-unmap latency */
+SEC("kprobe/dma_unmap_page_attrs")
+int BPF_KPROBE(handle_dma_unmap_page, struct device *dev, dma_addr_t addr)
+{
+	struct pcie_dma_key key = { .addr = addr };
+	struct pcie_hist *hist;
+	struct pci_dev *pdev;
+	__u64 *start;
+
+	if (!dev || !dev_is_pci(dev))
+		return 0;
+
+	pdev = bpf_container_of(dev, struct pci_dev, dev);
+	if (hcs_lookup_pci(pdev, &key.device_id))
+		return 0;
+
+	start = bpf_map_lookup_elem(&pcie_dma_inflight, &key);
+	if (!start)
+		return 0;
+
+	hist = lookup_hist(key.device_id);
+	if (hist)
+		hist->latency[hist_bucket(bpf_ktime_get_ns() - *start)]++;
 
+	bpf_map_delete_elem(&pcie_dma_inflight, &key);
 	return 0;
 }
 
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-2.0 OR BSD-3-Clause
+/* vram_tracker.c - eBPF program for per-cgroup VRAM accounting
+ *
+ * Optional alternative to libhcs_interceptor for workloads the LD_PRELOAD
+ * hook cannot reach (static runtimes, RTLD_DEEPBIND, stripped LD_PRELOAD).
+ * Userspace attaches uprobes to the allocation entry points of the
+ * lowest shared library of each runtime:
+ * - CUDA driver: cuMemAlloc_v2, cuMemAllocAsync / cuMemFree_v2, cuMemFreeAsync
+ *   (libcudart, static or not, always calls into libcuda.so)
+ * - AMD/Hygon HIP: hipMalloc, hipMallocAsync / hipFree, hipFreeAsync
+ * - Huawei ACL: aclrtMalloc / aclrtFree
+ *
+ * All of them take the output pointer as the first argument and the size
+ * as the second, return 0 on success, and free by device address, so one
+ * set of programs serves every runtime.
+ *
+ * Usage is kept per cgroup (the container) and per process; the process
+ * total is returned when the thread group exits, since the driver frees
+ * everything the process still holds. Userspace maps cgroup ids to pods
+ * and deletes the vram_allocs entries of exited processes.
+ *
+ * vram_allocs is a plain hash: evicting a live allocation would leave its
+ * bytes charged forever, so a full table refuses the insert instead and
+ * the allocation is counted in vram_tracker_stats, not accounted.
+ */
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+#include <bpf/bpf_core_read.h>
+
+#define VRAM_MAX_CGROUPS  4096
+#define VRAM_MAX_PROCS    8192
+#define VRAM_MAX_ALLOCS   65536
+
+/* Arguments of an allocation in flight, keyed by pid_tgid */
+struct vram_alloc_args {
+	__u64 out;  /* user address of the returned device pointer */
+	__u64 size;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, VRAM_MAX_PROCS);
+	__type(key, __u64);
+	__type(value, struct vram_alloc_args);
+} vram_alloc_args SEC(".maps");
+
+/* Live allocation, keyed by (tgid, device address) */
+struct vram_alloc_key {
+	__u32 tgid;
+	__u32 pad;
+	__u64 addr;
+};
+
+struct vram_alloc {
+	__u64 cgroup_id;
+	__u64 start_time; /* owner's start time, guards against pid reuse */
+	__u64 size;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, VRAM_MAX_ALLOCS);
+	__type(key, struct vram_alloc_key);
+	__type(value, struct vram_alloc);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} vram_allocs SEC(".maps");
+
+/* Per-cgroup usage, read by userspace */
+struct vram_usage {
+	__s64 bytes;
+	__u64 allocs;
+	__u64 frees;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, VRAM_MAX_CGROUPS);
+	__type(key, __u64);
+	__type(value, struct vram_usage);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} vram_cgroup_usage SEC(".maps");
+
+/* Per-process usage, returned to the cgroup on exit */
+struct vram_proc {
+	__u64 cgroup_id;
+	__u64 start_time;
+	__s64 bytes;
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_HASH);
+	__uint(max_entries, VRAM_MAX_PROCS);
+	__type(key, __u32);
+	__type(value, struct vram_proc);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} vram_procs SEC(".maps");
+
+/* Tracking failures, exported by userspace as metrics */
+enum vram_stat {
+	VRAM_STAT_ALLOCS_UNTRACKED = 0, /* vram_allocs full, allocation not accounted */
+	VRAM_STAT_PROCS_UNTRACKED = 1,  /* vram_procs full, process total not kept */
+	VRAM_STAT_MAX,
+};
+
+struct {
+	__uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+	__uint(max_entries, VRAM_STAT_MAX);
+	__type(key, __u32);
+	__type(value, __u64);
+	__uint(pinning, LIBBPF_PIN_BY_NAME);
+} vram_tracker_stats SEC(".maps");
+
+static __always_inline void count_vram_stat(__u32 stat)
+{
+	__u64 *value = bpf_map_lookup_elem(&vram_tracker_stats, &stat);
+
+	if (value)
+		*value += 1;
+}
+
+static __always_inline __u64 current_start_time(void)
+{
+	struct task_struct *task = (struct task_struct *)bpf_get_current_task();
+
+	return BPF_CORE_READ(task, group_leader, start_time);
+}
+
+static __always_inline struct vram_usage *lookup_usage(__u64 cgroup_id)
+{
+	struct vram_usage zero = {};
+	struct vram_usage *u;
+
+	u = bpf_map_lookup_elem(&vram_cgroup_usage, &cgroup_id);
+	if (u)
+		return u;
+
+	bpf_map_update_elem(&vram_cgroup_usage, &cgroup_id, &zero, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&vram_cgroup_usage, &cgroup_id);
+}
+
+static __always_inline struct vram_proc *lookup_proc(__u32 tgid, __u64 cgroup_id,
+						     __u64 start_time)
+{
+	struct vram_proc init = {
+		.cgroup_id = cgroup_id,
+		.start_time = start_time,
+	};
+	struct vram_proc *p;
+
+	p = bpf_map_lookup_elem(&vram_procs, &tgid);
+	if (p) {
+		__u64 old = p->start_time;
+		__s64 stale;
+
+		if (old == start_time)
+			return p;
+
+		/* Stale entry left by a reused pid: the thread that claims it
+		 * drops the dead process's bytes, keeping concurrent adds */
+		stale = p->bytes;
+		if (__sync_val_compare_and_swap(&p->start_time, old, start_time) == old) {
+			p->cgroup_id = cgroup_id;
+			__sync_fetch_and_add(&p->bytes, -stale);
+		}
+		return p;
+	}
+
+	/* First allocation: concurrent threads race to insert, the losers
+	 * use the winner's entry */
+	if (bpf_map_update_elem(&vram_procs, &tgid, &init, BPF_NOEXIST) == 0)
+		return bpf_map_lookup_elem(&vram_procs, &tgid);
+
+	p = bpf_map_lookup_elem(&vram_procs, &tgid);
+	if (!p)
+		count_vram_stat(VRAM_STAT_PROCS_UNTRACKED);
+	return p;
+}
+
+/* Allocation entry: remember where the runtime will store the pointer */
+SEC("uprobe")
+int BPF_UPROBE(vram_alloc_enter, void *out, __u64 size)
+{
+	__u64 id = bpf_get_current_pid_tgid();
+	struct vram_alloc_args args = {
+		.out = (__u64)out,
+		.size = size,
+	};
+
+	if (!out || !size)
+		return 0;
+
+	bpf_map_update_elem(&vram_alloc_args, &id, &args, BPF_ANY);
+	return 0;
+}
+
+/* Allocation return: account successful allocations */
+SEC("uretprobe")
+int BPF_URETPROBE(vram_alloc_exit, int ret)
+{
+	__u64 id = bpf_get_current_pid_tgid();
+	struct vram_alloc_args *args;
+	struct vram_alloc_key key = { .tgid = id >> 32 };
+	struct vram_alloc alloc = {};
+	struct vram_usage *u;
+	struct vram_proc *p;
+
+	args = bpf_map_lookup_elem(&vram_alloc_args, &id);
+	if (!args)
+		return 0;
+
+	if (ret != 0 ||
+	    bpf_probe_read_user(&key.addr, sizeof(key.addr), (void *)args->out) ||
+	    !key.addr) {
+		bpf_map_delete_elem(&vram_alloc_args, &id);
+		return 0;
+	}
+
+	alloc.cgroup_id = bpf_get_current_cgroup_id();
+	alloc.start_time = current_start_time();
+	alloc.size = args->size;
+	bpf_map_delete_elem(&vram_alloc_args, &id);
+
+	if (bpf_map_update_elem(&vram_allocs, &key, &alloc, BPF_ANY)) {
+		count_vram_stat(VRAM_STAT_ALLOCS_UNTRACKED);
+		return 0;
+	}
+
+	u = lookup_usage(alloc.cgroup_id);
+	if (u) {
+		__sync_fetch_and_add(&u->bytes, alloc.size);
+		__sync_fetch_and_add(&u->allocs, 1);
+	}
+	p = lookup_proc(key.tgid, alloc.cgroup_id, alloc.start_time);
+	if (p)
+		__sync_fetch_and_add(&p->bytes, alloc.size);
+
+	return 0;
+}
+
+/* Free entry: release the allocation recorded for this address */
+SEC("uprobe")
+int BPF_UPROBE(vram_free, void *addr)
+{
+	struct vram_alloc_key key = {
+		.tgid = bpf_get_current_pid_tgid() >> 32,
+		.addr = (__u64)addr,
+	};
+	struct vram_alloc *alloc;
+	struct vram_usage *u;
+	struct vram_proc *p;
+	__u64 size;
+
+	alloc = bpf_map_lookup_elem(&vram_allocs, &key);
+	if (!alloc)
+		return 0;
+	if (alloc->start_time != current_start_time()) {
+		/* Left behind by an exited process with the same pid */
+		bpf_map_delete_elem(&vram_allocs, &key);
+		return 0;
+	}
+
+	size = alloc->size;
+	u = bpf_map_lookup_elem(&vram_cgroup_usage, &alloc->cgroup_id);
+	if (u) {
+		__sync_fetch_and_add(&u->bytes, -(__s64)size);
+		__sync_fetch_and_add(&u->frees, 1);
+	}
+	p = bpf_map_lookup_elem(&vram_procs, &key.tgid);
+	if (p)
+		__sync_fetch_and_add(&p->bytes, -(__s64)size);
+
+	bpf_map_delete_elem(&vram_allocs, &key);
+	return 0;
+}
+
+/* Thread group exit: the driver releases whatever the process still holds */
+SEC("tp/sched/sched_process_exit")
+int handle_vram_exit(void *ctx)
+{
+	struct task_struct *task = (struct task_struct *)bpf_get_current_task();
+	__u32 tgid = bpf_get_current_pid_tgid() >> 32;
+	struct vram_usage *u;
+	struct vram_proc *p;
+
+	p = bpf_map_lookup_elem(&vram_procs, &tgid);
+	if (!p)
+		return 0;
+
+	/* Only the last thread of the group */
+	if (BPF_CORE_READ(task, signal, live.counter) != 0)
+		return 0;
+
+	u = bpf_map_lookup_elem(&vram_cgroup_usage, &p->cgroup_id);
+	if (u)
+		__sync_fetch_and_add(&u->bytes, -p->bytes);
+
+	/* Remaining vram_allocs entries are deleted by userspace */
+	bpf_map_delete_elem(&vram_procs, &tgid);
+	return 0;
+}
+
+char LICENSE[] SEC("license") = "Dual BSD/GPL";
@@ -0,0 +1,237 @@
+package ebpf
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+)
+
+// DeviceKeyKind 设备身份类型（与 hcs_devices.h 中 enum hcs_key_kind 一致）
+type DeviceKeyKind uint32
+
+const (
+	DeviceKeyPCI         DeviceKeyKind = 0 // domain + (bus<<8 | devfn)
+	DeviceKeyIRQ         DeviceKeyKind = 1 // 中断号
+	DeviceKeyThermalZone DeviceKeyKind = 2 // thermal zone 编号
+	DeviceKeyNVIDIAMinor DeviceKeyKind = 3 // NVIDIA 驱动的设备次设备号（/dev/nvidiaN）
+	DeviceKeyDRMMinor    DeviceKeyKind = 4 // DRM 设备编号（/dev/dri/cardN），amdgpu 使用
+)
+
+// MaxRegisteredDevices 内核注册表可容纳的设备数（HCS_MAX_DEVICES）
+const MaxRegisteredDevices = 64
+
+// DeviceKey 注册表键（与 struct hcs_device_key 布局一致）
+type DeviceKey struct {
+	Kind   DeviceKeyKind
+	Domain uint32
+	ID     uint32
+}
+
+// AddressRange 设备占用的物理地址范围，End 不包含在内
+type AddressRange struct {
+	Start uint64
+	End   uint64
+}
+
+// DeviceRegistry 内核设备注册表的写入接口
+// 由 eBPF 加载器基于 hcs_device_registry / hcs_device_ranges 实现
+type DeviceRegistry interface {
+	RegisterDevice(key DeviceKey, index uint32) error
+	RegisterRange(index uint32, r AddressRange) error
+}
+
+// sysfs 路径，测试时可替换
+var (
+	sysfsPCIDevices = "/sys/bus/pci/devices"
+	sysfsThermal    = "/sys/class/thermal"
+	procNVIDIAGPUs  = "/proc/driver/nvidia/gpus"
+)
+
+// parseDeviceIndex 从设备 ID（"gpu-N"、"dcu-N"、"npu-N" 等）解析 HCS 设备编号 N
+// 末段不是十进制数的 ID 返回 false，调用方应跳过该设备，而不是当作设备 0
+func parseDeviceIndex(id string) (uint32, bool) {
+	i := strings.LastIndexByte(id, '-')
+	if i < 0 {
+		return 0, false
+	}
+	n, err := strconv.ParseUint(id[i+1:], 10, 32)
+	if err != nil {
+		return 0, false
+	}
+	return uint32(n), true
+}
+
+// parseBDF 解析 PCIe 总线 ID，支持 DDDD:BB:DD.F、DDDDDDDD:BB:DD.F（NVML）和 BB:DD.F
+func parseBDF(busID string) (domain, bus, devfn uint32, err error) {
+	var dom, b, dev, fn uint64
+	parts := strings.Split(strings.ToLower(busID), ":")
+	switch len(parts) {
+	case 3:
+		if dom, err = strconv.ParseUint(parts[0], 16, 32); err != nil {
+			return 0, 0, 0, fmt.Errorf("invalid PCI domain in %q", busID)
+		}
+		parts = parts[1:]
+	case 2:
+	default:
+		return 0, 0, 0, fmt.Errorf("invalid PCI bus ID %q", busID)
+	}
+
+	df := strings.Split(parts[1], ".")
+	if len(df) != 2 {
+		return 0, 0, 0, fmt.Errorf("invalid PCI bus ID %q", busID)
+	}
+	if b, err = strconv.ParseUint(parts[0], 16, 8); err != nil {
+		return 0, 0, 0, fmt.Errorf("invalid PCI bus in %q", busID)
+	}
+	if dev, err = strconv.ParseUint(df[0], 16, 5); err != nil {
+		return 0, 0, 0, fmt.Errorf("invalid PCI device in %q", busID)
+	}
+	if fn, err = strconv.ParseUint(df[1], 16, 3); err != nil {
+		return 0, 0, 0, fmt.Errorf("invalid PCI function in %q", busID)
+	}
+
+	return uint32(dom), uint32(b), uint32(dev<<3 | fn), nil
+}
+
+// discoverDeviceKeys 收集设备在内核中的全部身份
+// 包括 BDF、设备及其上游端口的中断号、绑定的 thermal zone、驱动的设备编号，以及显存 BAR 范围
+func discoverDeviceKeys(busID string) ([]DeviceKey, *AddressRange, error) {
+	domain, bus, devfn, err := parseBDF(busID)
+	if err != nil {
+		return nil, nil, err
+	}
+
+	keys := []DeviceKey{{Kind: DeviceKeyPCI, Domain: domain, ID: bus<<8 | devfn}}
+
+	name := fmt.Sprintf("%04x:%02x:%02x.%x", domain, bus, devfn>>3, devfn&7)
+	devDir := filepath.Join(sysfsPCIDevices, name)
+
+	// 设备自身的中断（legacy + MSI/MSI-X）
+	for _, irq := range pciIRQs(devDir) {
+		keys = append(keys, DeviceKey{Kind: DeviceKeyIRQ, ID: irq})
+	}
+
+	// 上游端口的中断（AER/PME 等 PCIe 端口服务运行在端口上）
+	if resolved, err := filepath.EvalSymlinks(devDir); err == nil {
+		parent := filepath.Dir(resolved)
+		if _, err := os.Stat(filepath.Join(parent, "config")); err == nil {
+			for _, irq := range pciIRQs(parent) {
+				keys = append(keys, DeviceKey{Kind: DeviceKeyIRQ, ID: irq})
+			}
+		}
+	}
+
+	// 绑定到该设备的 thermal zone
+	zones, _ := filepath.Glob(filepath.Join(sysfsThermal, "thermal_zone*"))
+	for _, zone := range zones {
+		target, err := filepath.EvalSymlinks(filepath.Join(zone, "device"))
+		if err != nil || filepath.Base(target) != name {
+			continue
+		}
+		id, err := strconv.ParseUint(strings.TrimPrefix(filepath.Base(zone), "thermal_zone"), 10, 32)
+		if err == nil {
+			keys = append(keys, DeviceKey{Kind: DeviceKeyThermalZone, ID: uint32(id)})
+		}
+	}
+
+	// 驱动自己的设备编号，驱动 tracepoint 只携带该编号
+	if minor, ok := nvidiaMinor(name); ok {
+		keys = append(keys, DeviceKey{Kind: DeviceKeyNVIDIAMinor, ID: minor})
+	}
+	cards, _ := filepath.Glob(filepath.Join(devDir, "drm", "card*"))
+	for _, card := range cards {
+		if n, err := strconv.ParseUint(strings.TrimPrefix(filepath.Base(card), "card"), 10, 32); err == nil {
+			keys = append(keys, DeviceKey{Kind: DeviceKeyDRMMinor, ID: uint32(n)})
+		}
+	}
+
+	return keys, largestMemoryBAR(devDir), nil
+}
+
+// nvidiaMinor 从 NVIDIA 驱动的 procfs 信息中读取设备次设备号
+func nvidiaMinor(name string) (uint32, bool) {
+	data, err := os.ReadFile(filepath.Join(procNVIDIAGPUs, name, "information"))
+	if err != nil {
+		return 0, false
+	}
+	for _, line := range strings.Split(string(data), "\n") {
+		if value, ok := strings.CutPrefix(line, "Device Minor:"); ok {
+			n, err := strconv.ParseUint(strings.TrimSpace(value), 10, 32)
+			return uint32(n), err == nil
+		}
+	}
+	return 0, false
+}
+
+// pciIRQs 读取 PCI 设备的中断号
+func pciIRQs(devDir string) []uint32 {
+	seen := make(map[uint32]bool)
+	var irqs []uint32
+	add := func(s string) {
+		if n, err := strconv.ParseUint(strings.TrimSpace(s), 10, 32); err == nil && n != 0 && !seen[uint32(n)] {
+			seen[uint32(n)] = true
+			irqs = append(irqs, uint32(n))
+		}
+	}
+
+	if data, err := os.ReadFile(filepath.Join(devDir, "irq")); err == nil {
+		add(string(data))
+	}
+	if entries, err := os.ReadDir(filepath.Join(devDir, "msi_irqs")); err == nil {
+		for _, e := range entries {
+			add(e.Name())
+		}
+	}
+	return irqs
+}
+
+// largestMemoryBAR 从 sysfs resource 文件中找出最大的内存 BAR（通常是显存 BAR）
+func largestMemoryBAR(devDir string) *AddressRange {
+	const ioResourceMem = 0x200
+
+	data, err := os.ReadFile(filepath.Join(devDir, "resource"))
+	if err != nil {
+		return nil
+	}
+
+	var best *AddressRange
+	for _, line := range strings.Split(string(data), "\n") {
+		var start, end, flags uint64
+		if n, _ := fmt.Sscanf(line, "0x%x 0x%x 0x%x", &start, &end, &flags); n != 3 {
+			continue
+		}
+		if flags&ioResourceMem == 0 || end <= start {
+			continue
+		}
+		if best == nil || end-start > best.End-best.Start {
+			best = &AddressRange{Start: start, End: end + 1}
+		}
+	}
+	return best
+}
+
+// registerDevice 将设备的全部身份写入内核注册表
+func (m *EBPFManager) registerDevice(index uint32, busID string) error {
+	if index >= MaxRegisteredDevices {
+		return fmt.Errorf("device index %d exceeds registry capacity %d", index, MaxRegisteredDevices)
+	}
+
+	keys, bar, err := discoverDeviceKeys(busID)
+	if err != nil {
+		return err
+	}
+
+	for _, key := range keys {
+		if err := m.registry.RegisterDevice(key, index); err != nil {
+			return fmt.Errorf("failed to register %+v: %w", key, err)
+		}
+	}
+	if bar != nil {
+		if err := m.registry.RegisterRange(index, *bar); err != nil {
+			return fmt.Errorf("failed to register BAR range: %w", err)
+		}
+	}
+	return nil
+}
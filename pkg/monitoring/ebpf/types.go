@@ -1,6 +1,10 @@
 package ebpf
 
-import "time"
+import (
+	"encoding/binary"
+	"math"
+	"time"
+)
 
 // HealthEventType 健康事件类型
 type HealthEventType string
@@ -27,6 +31,95 @@ type GPUEvent struct {
 	ThrottlingFlags uint8
 }
 
+// GPUMetric 内核聚合的 GPU 指标下标（与 gpu_monitor.c 中 enum gpu_metric 一致）
+type GPUMetric int
+
+const (
+	GPUMetricCoreClock GPUMetric = iota
+	GPUMetricMemoryClock
+	GPUMetricPower
+	GPUMetricTemperature
+	GPUMetricUtilization
+	GPUMetricCount
+)
+
+// GPUMetricStats 单个指标在单个 CPU 上的累计聚合值
+// 内存布局与 gpu_monitor.c 中 struct gpu_metric_stats 一致，Count 为 0 表示尚无采样
+type GPUMetricStats struct {
+	Sum           uint64
+	Count         uint64
+	LastTimestamp uint64 // bpf_ktime_get_ns
+	Last          uint32
+	Min           uint32
+	Max           uint32
+	_             uint32
+}
+
+// GPUDeviceStats 单设备的指标聚合值（对应 gpu_stats_map 的一个 per-CPU 值）
+type GPUDeviceStats struct {
+	Metrics [GPUMetricCount]GPUMetricStats
+}
+
+// MergeGPUStats 合并 per-CPU 聚合值
+// Sum/Count 相加，Min/Max 取极值，Last 取 LastTimestamp 最新的 CPU
+func MergeGPUStats(perCPU []GPUDeviceStats) GPUDeviceStats {
+	var merged GPUDeviceStats
+	for i := range perCPU {
+		for m := range merged.Metrics {
+			src := &perCPU[i].Metrics[m]
+			if src.Count == 0 {
+				continue
+			}
+			dst := &merged.Metrics[m]
+			if dst.Count == 0 || src.Min < dst.Min {
+				dst.Min = src.Min
+			}
+			if dst.Count == 0 || src.Max > dst.Max {
+				dst.Max = src.Max
+			}
+			if dst.Count == 0 || src.LastTimestamp > dst.LastTimestamp {
+				dst.Last = src.Last
+				dst.LastTimestamp = src.LastTimestamp
+			}
+			dst.Sum += src.Sum
+			dst.Count += src.Count
+		}
+	}
+	return merged
+}
+
+// IntervalEvent 根据两次读取之间的差值生成一条完整的 GPU 事件
+// 区间内有新采样的指标取区间均值，没有新采样的指标沿用最近值，
+// 因此每条事件都包含全部指标。区间内没有任何新采样时返回 false。
+func (s *GPUDeviceStats) IntervalEvent(deviceID uint32, prev *GPUDeviceStats, now time.Time) (GPUEvent, bool) {
+	var values [GPUMetricCount]uint32
+	fresh := false
+
+	for m := range s.Metrics {
+		cur := &s.Metrics[m]
+		var prevSum, prevCount uint64
+		if prev != nil {
+			prevSum, prevCount = prev.Metrics[m].Sum, prev.Metrics[m].Count
+		}
+		if cur.Count > prevCount {
+			values[m] = uint32((cur.Sum - prevSum) / (cur.Count - prevCount))
+			fresh = true
+		} else {
+			values[m] = cur.Last
+		}
+	}
+
+	return GPUEvent{
+		DeviceID:    deviceID,
+		Timestamp:   now,
+		CoreClock:   values[GPUMetricCoreClock],
+		MemoryClock: values[GPUMetricMemoryClock],
+		Power:       values[GPUMetricPower],
+		Temperature: values[GPUMetricTemperature],
+		Utilization: values[GPUMetricUtilization],
+	}, fresh
+}
+
 // PCIeEvent PCIe 带宽事件（来自 eBPF）
 type PCIeEvent struct {
 	DeviceID    uint32
@@ -36,6 +129,140 @@ type PCIeEvent struct {
 	ReplayCount uint32
 }
 
+// PCIeDeviceStats 单设备在单个 CPU 上的累计 PCIe 计数
+// 内存布局与 pcie_monitor.c 中 struct pcie_stats 一致
+type PCIeDeviceStats struct {
+	ReadBytes   uint64
+	WriteBytes  uint64
+	LastUpdate  uint64 // bpf_ktime_get_ns
+	ReplayCount uint32
+	_           uint32
+}
+
+// SumPCIeStats 汇总 per-CPU 计数
+func SumPCIeStats(perCPU []PCIeDeviceStats) PCIeDeviceStats {
+	var sum PCIeDeviceStats
+	for i := range perCPU {
+		sum.ReadBytes += perCPU[i].ReadBytes
+		sum.WriteBytes += perCPU[i].WriteBytes
+		sum.ReplayCount += perCPU[i].ReplayCount
+		if perCPU[i].LastUpdate > sum.LastUpdate {
+			sum.LastUpdate = perCPU[i].LastUpdate
+		}
+	}
+	return sum
+}
+
+// IntervalEvent 根据两次读取之间的差值生成 PCIe 事件
+// 区间内没有任何新流量时返回 false
+func (s *PCIeDeviceStats) IntervalEvent(deviceID uint32, prev *PCIeDeviceStats, now time.Time) (PCIeEvent, bool) {
+	event := PCIeEvent{
+		DeviceID:    deviceID,
+		Timestamp:   now,
+		ReadBytes:   s.ReadBytes,
+		WriteBytes:  s.WriteBytes,
+		ReplayCount: s.ReplayCount,
+	}
+	if prev != nil {
+		event.ReadBytes -= prev.ReadBytes
+		event.WriteBytes -= prev.WriteBytes
+		event.ReplayCount -= prev.ReplayCount
+	}
+	fresh := event.ReadBytes != 0 || event.WriteBytes != 0 || event.ReplayCount != 0
+	return event, fresh
+}
+
+// PCIeHistBuckets DMA 直方图桶数（与 pcie_monitor.c 中 PCIE_HIST_BUCKETS 一致）
+const PCIeHistBuckets = 32
+
+// Log2Histogram log2 直方图，第 i 个桶计数 [2^i, 2^(i+1)) 内的值（桶 0 包含 0），
+// 最后一个桶包含所有更大的值
+type Log2Histogram [PCIeHistBuckets]uint64
+
+// Count 返回样本总数
+func (h *Log2Histogram) Count() uint64 {
+	var n uint64
+	for _, c := range h {
+		n += c
+	}
+	return n
+}
+
+// Quantile 返回 q 分位数所在桶的上界 2^(i+1)，无样本时返回 0
+func (h *Log2Histogram) Quantile(q float64) uint64 {
+	total := h.Count()
+	if total == 0 {
+		return 0
+	}
+
+	rank := uint64(math.Ceil(q * float64(total)))
+	if rank == 0 {
+		rank = 1
+	}
+	var seen uint64
+	for i, c := range h {
+		seen += c
+		if seen >= rank {
+			return 1 << (i + 1)
+		}
+	}
+	return 1 << PCIeHistBuckets
+}
+
+// since 返回相对 prev 的增量；计数回退（map 重建）时返回当前值
+func (h *Log2Histogram) since(prev *Log2Histogram) Log2Histogram {
+	var d Log2Histogram
+	for i := range h {
+		if h[i] < prev[i] {
+			return *h
+		}
+		d[i] = h[i] - prev[i]
+	}
+	return d
+}
+
+// PCIeDeviceHistogram 单设备在单个 CPU 上的累计 DMA 直方图
+// 内存布局与 pcie_monitor.c 中 struct pcie_hist 一致
+type PCIeDeviceHistogram struct {
+	Size    Log2Histogram // 每次映射的字节数
+	Latency Log2Histogram // 映射到解除映射的纳秒数
+}
+
+// SumPCIeHistograms 汇总 per-CPU 直方图
+func SumPCIeHistograms(perCPU []PCIeDeviceHistogram) PCIeDeviceHistogram {
+	var sum PCIeDeviceHistogram
+	for i := range perCPU {
+		for b := 0; b < PCIeHistBuckets; b++ {
+			sum.Size[b] += perCPU[i].Size[b]
+			sum.Latency[b] += perCPU[i].Latency[b]
+		}
+	}
+	return sum
+}
+
+// PCIeCgroupKey 按 (cgroup, 设备) 统计 DMA 字节的键（与 struct pcie_cgroup_key 一致）
+type PCIeCgroupKey struct {
+	CgroupID uint64
+	DeviceID uint32
+	_        uint32
+}
+
+// PCIeCgroupBytes 单个 CPU 上的累计 DMA 字节（与 struct pcie_cgroup_bytes 一致）
+type PCIeCgroupBytes struct {
+	ReadBytes  uint64
+	WriteBytes uint64
+}
+
+// SumPCIeCgroupBytes 汇总 per-CPU 字节数
+func SumPCIeCgroupBytes(perCPU []PCIeCgroupBytes) PCIeCgroupBytes {
+	var sum PCIeCgroupBytes
+	for i := range perCPU {
+		sum.ReadBytes += perCPU[i].ReadBytes
+		sum.WriteBytes += perCPU[i].WriteBytes
+	}
+	return sum
+}
+
 // HealthEvent 健康相关事件（来自 eBPF）
 type HealthEvent struct {
 	DeviceID  uint32
@@ -45,6 +272,69 @@ type HealthEvent struct {
 	Address   uint64
 }
 
+// healthEventTypes health_events.c 中事件类型编号到 HealthEventType 的映射
+var healthEventTypes = [...]HealthEventType{
+	EventECCSingleBit,
+	EventECCDoubleBit,
+	EventPageRetire,
+	EventGPUReset,
+	EventThermalThrottle,
+	EventPowerThrottle,
+}
+
+// healthEventSize struct health_event 的大小
+const healthEventSize = 32
+
+// decodeHealthEvent 将 ring buffer 中的 struct health_event 解码到 e
+// 布局: device_id@0 timestamp@8 event_type@16 count@20 address@24（小端）
+func decodeHealthEvent(raw []byte, e *HealthEvent) bool {
+	if len(raw) < healthEventSize {
+		return false
+	}
+	kind := raw[16]
+	if int(kind) >= len(healthEventTypes) {
+		return false
+	}
+
+	e.DeviceID = binary.LittleEndian.Uint32(raw[0:])
+	// 内核时间戳为 CLOCK_MONOTONIC，记录被实时消费，这里取读取时间
+	e.Timestamp = time.Now()
+	e.Type = healthEventTypes[kind]
+	e.Count = binary.LittleEndian.Uint32(raw[20:])
+	e.Address = binary.LittleEndian.Uint64(raw[24:])
+	return true
+}
+
+// HealthThrottleConfig 内核健康事件限速配置（与 struct health_throttle_config 布局一致）
+// MinIntervalNs 按 health_events.c 中的事件类型编号索引，0 表示该类型不限速
+type HealthThrottleConfig struct {
+	MinIntervalNs [len(healthEventTypes)]uint64
+}
+
+// NewHealthThrottleConfig 按采样间隔生成限速配置
+// 同一设备的同类事件每个间隔最多提交一条记录，期间的事件数累加到该记录的 Count；
+// overrides 按类型覆盖间隔
+func NewHealthThrottleConfig(interval time.Duration, overrides map[HealthEventType]time.Duration) HealthThrottleConfig {
+	var cfg HealthThrottleConfig
+	for i, t := range healthEventTypes {
+		d := interval
+		if o, ok := overrides[t]; ok {
+			d = o
+		}
+		if d > 0 {
+			cfg.MinIntervalNs[i] = uint64(d)
+		}
+	}
+	return cfg
+}
+
+// HealthEventStats 健康事件提交计数（health_event_stats 汇总 per-CPU 后的累计值）
+type HealthEventStats struct {
+	Emitted   uint64 // 写入 ring buffer 的记录数
+	Coalesced uint64 // 合并进后续记录的事件数
+	Dropped   uint64 // ring buffer 已满而丢弃的记录数
+}
+
 // ThrottleReason 降频原因
 type ThrottleReason string
 
@@ -148,56 +438,109 @@ func GetHealthLevel(score float64) string {
 	}
 }
 
-// EventBuffer 事件环形缓冲区
-type EventBuffer struct {
-	buffer []interface{}
-	size   int
-	index  int
-	count  int
+// Ring 定长类型化环形缓冲区
+// 元素按值存放在预分配的切片中，写入不产生堆分配；已满时覆盖最旧元素
+type Ring[T any] struct {
+	items []T
+	head  int // 最旧元素位置
+	count int
 }
 
-// NewEventBuffer 创建新的事件缓冲区
-func NewEventBuffer(size int) *EventBuffer {
-	return &EventBuffer{
-		buffer: make([]interface{}, size),
-		size:   size,
-		index:  0,
-		count:  0,
+// NewRing 创建容量为 capacity 的环形缓冲区
+func NewRing[T any](capacity int) *Ring[T] {
+	return &Ring[T]{items: make([]T, capacity)}
+}
+
+// Push 写入元素；缓冲区已满时返回被覆盖的最旧元素
+func (r *Ring[T]) Push(v T) (evicted T, ok bool) {
+	if r.count < len(r.items) {
+		r.items[(r.head+r.count)%len(r.items)] = v
+		r.count++
+		return evicted, false
 	}
+
+	evicted = r.items[r.head]
+	r.items[r.head] = v
+	r.head = (r.head + 1) % len(r.items)
+	return evicted, true
 }
 
-// Add 添加事件到缓冲区
-func (b *EventBuffer) Add(event interface{}) {
-	b.buffer[b.index] = event
-	b.index = (b.index + 1) % b.size
-	if b.count < b.size {
-		b.count++
+// Len 返回有效元素数量
+func (r *Ring[T]) Len() int {
+	return r.count
+}
+
+// Cap 返回容量
+func (r *Ring[T]) Cap() int {
+	return len(r.items)
+}
+
+// At 返回第 i 个元素，0 为最旧
+func (r *Ring[T]) At(i int) T {
+	return r.items[(r.head+i)%len(r.items)]
+}
+
+// Oldest 返回最旧元素
+func (r *Ring[T]) Oldest() (T, bool) {
+	var zero T
+	if r.count == 0 {
+		return zero, false
+	}
+	return r.items[r.head], true
+}
+
+// Latest 返回最新元素
+func (r *Ring[T]) Latest() (T, bool) {
+	var zero T
+	if r.count == 0 {
+		return zero, false
+	}
+	return r.At(r.count - 1), true
+}
+
+// Do 按从旧到新的顺序遍历元素，不复制缓冲区
+func (r *Ring[T]) Do(fn func(T)) {
+	for i := 0; i < r.count; i++ {
+		fn(r.At(i))
 	}
 }
 
-// GetAll 获取缓冲区中所有有效事件
-func (b *EventBuffer) GetAll() []interface{} {
-	if b.count < b.size {
-		return b.buffer[:b.count]
+// Reset 清空缓冲区
+func (r *Ring[T]) Reset() {
+	var zero T
+	for i := range r.items {
+		r.items[i] = zero
 	}
+	r.head = 0
+	r.count = 0
+}
+
+// EventBuffer 事件环形缓冲区（兼容旧接口，分析器内部使用类型化窗口）
+type EventBuffer = Ring[interface{}]
+
+// NewEventBuffer 创建新的事件缓冲区
+func NewEventBuffer(size int) *EventBuffer {
+	return NewRing[interface{}](size)
+}
+
+// Add 添加事件到缓冲区
+func (r *Ring[T]) Add(event T) {
+	r.Push(event)
+}
 
-	// 缓冲区已满，返回从 index 开始的所有元素
-	result := make([]interface{}, b.count)
-	copy(result, b.buffer[b.index:])
-	copy(result[b.size-b.index:], b.buffer[:b.index])
+// GetAll 获取缓冲区中所有有效事件（按从旧到新顺序复制）
+func (r *Ring[T]) GetAll() []T {
+	result := make([]T, 0, r.count)
+	r.Do(func(v T) { result = append(result, v) })
 	return result
 }
 
 // Count 返回有效事件数量
-func (b *EventBuffer) Count() int {
-	return b.count
+func (r *Ring[T]) Count() int {
+	return r.count
 }
 
 // Clear 清空缓冲区
-func (b *EventBuffer) Clear() {
-	b.index = 0
-	b.count = 0
-	for i := range b.buffer {
-		b.buffer[i] = nil
-	}
+func (r *Ring[T]) Clear() {
+	r.Reset()
 }
@@ -0,0 +1,293 @@
+package ebpf
+
+import (
+	"io/fs"
+	"os"
+	"path/filepath"
+	"regexp"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"syscall"
+	"time"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/collectors"
+)
+
+// VRAMCgroupUsage 单个 cgroup 的显存使用（与 vram_tracker.c 中 struct vram_usage 布局一致）
+type VRAMCgroupUsage struct {
+	Bytes  int64 // 当前占用，进程退出时归还
+	Allocs uint64
+	Frees  uint64
+}
+
+// VRAMTrackerStats vram_tracker 的追踪失败计数（vram_tracker_stats 汇总 per-CPU 后的累计值）
+// 非零表示 map 已满，部分显存未计入 VRAMCgroupUsage
+type VRAMTrackerStats struct {
+	AllocsUntracked uint64 // vram_allocs 已满而未记录的分配
+	ProcsUntracked  uint64 // vram_procs 已满而未记录的进程
+}
+
+// VRAMUsageSource 按 cgroup 统计的显存使用读取接口
+// 由 eBPF 加载器基于 vram_cgroup_usage 实现，未启用 VRAM 追踪时返回空结果
+type VRAMUsageSource interface {
+	ReadVRAMUsage() (map[uint64]VRAMCgroupUsage, error)
+	// DeleteVRAMUsage 删除已销毁 cgroup 的条目
+	DeleteVRAMUsage(cgroupID uint64) error
+	ReadVRAMTrackerStats() (VRAMTrackerStats, error)
+	// PruneVRAMAllocs 删除 alive 返回 false 的进程遗留的 vram_allocs 条目，返回删除数
+	// vram_allocs 不是 LRU，进程退出后未释放的分配只能由用户态清理
+	PruneVRAMAllocs(alive func(tgid uint32) bool) (int, error)
+}
+
+// vramRuntime 一个运行时库上挂载 uprobe 的分配/释放符号
+// 分配函数均为 (void **out, size_t size, ...) 且成功返回 0，释放函数以设备地址为第一个参数
+type vramRuntime struct {
+	library string // 库文件名前缀
+	allocs  []string
+	frees   []string
+}
+
+// vramRuntimes 支持的运行时
+// CUDA 挂在驱动库上：静态链接的 libcudart 最终也调用 libcuda.so，
+// 且容器内的 libcuda.so 由 NVIDIA container toolkit 从宿主机挂载，同一 inode 覆盖所有容器
+var vramRuntimes = []vramRuntime{
+	{library: "libcuda.so", allocs: []string{"cuMemAlloc_v2", "cuMemAllocAsync"}, frees: []string{"cuMemFree_v2", "cuMemFreeAsync"}},
+	{library: "libamdhip64.so", allocs: []string{"hipMalloc", "hipMallocAsync"}, frees: []string{"hipFree", "hipFreeAsync"}},
+	{library: "libascendcl.so", allocs: []string{"aclrtMalloc"}, frees: []string{"aclrtFree"}},
+}
+
+// vramLibraryDirs 未配置库路径时搜索的宿主机目录
+var vramLibraryDirs = []string{
+	"/usr/lib/x86_64-linux-gnu",
+	"/usr/lib/aarch64-linux-gnu",
+	"/usr/lib64",
+	"/opt/rocm/lib",
+	"/usr/local/Ascend/ascend-toolkit/latest/lib64",
+}
+
+// vramTarget 一个待挂载 uprobe 的库文件
+type vramTarget struct {
+	path    string
+	runtime *vramRuntime
+}
+
+// vramTargets 解析要挂载的库
+// paths 为空时在 dirs（为空时为 vramLibraryDirs）中查找，每个运行时取第一个找到的库；
+// 指向同一文件的路径只保留一个，避免重复计数
+func vramTargets(paths, dirs []string) []vramTarget {
+	if len(dirs) == 0 {
+		dirs = vramLibraryDirs
+	}
+	if len(paths) == 0 {
+		for i := range vramRuntimes {
+			for _, dir := range dirs {
+				matches, _ := filepath.Glob(filepath.Join(dir, vramRuntimes[i].library+"*"))
+				if len(matches) > 0 {
+					sort.Strings(matches)
+					paths = append(paths, matches[0])
+					break
+				}
+			}
+		}
+	}
+
+	seen := make(map[string]bool)
+	var targets []vramTarget
+	for _, path := range paths {
+		resolved, err := filepath.EvalSymlinks(path)
+		if err != nil || seen[resolved] {
+			continue
+		}
+		base := filepath.Base(path)
+		for i := range vramRuntimes {
+			if strings.HasPrefix(base, vramRuntimes[i].library) {
+				seen[resolved] = true
+				targets = append(targets, vramTarget{path: resolved, runtime: &vramRuntimes[i]})
+				break
+			}
+		}
+	}
+	return targets
+}
+
+// sysfsCgroup cgroup v2 挂载点，测试时可替换
+var sysfsCgroup = "/sys/fs/cgroup"
+
+// procDir 用于判断进程是否存活的 procfs 挂载点，测试时可替换
+var procDir = "/proc"
+
+// processAlive 判断 tgid 对应的进程是否仍存在
+// tgid 为宿主机 PID，node-agent 需运行在宿主机 PID 命名空间（hostPID）
+func processAlive(tgid uint32) bool {
+	_, err := os.Stat(filepath.Join(procDir, strconv.FormatUint(uint64(tgid), 10)))
+	return err == nil
+}
+
+// podUIDPattern 匹配 cgroup 路径中的 Pod UID
+// cgroupfs 驱动为 pod<uid>，systemd 驱动为 pod<uid 中 - 替换为 _>.slice
+var podUIDPattern = regexp.MustCompile(`pod([0-9a-f]{8}[-_][0-9a-f]{4}[-_][0-9a-f]{4}[-_][0-9a-f]{4}[-_][0-9a-f]{12})`)
+
+// containerIDPattern 匹配 cgroup 目录名中的容器 ID（cri-containerd-/crio-/docker-<id>.scope 或裸 ID）
+var containerIDPattern = regexp.MustCompile(`([0-9a-f]{64})(\.scope)?$`)
+
+// cgroupOwner cgroup 所属的 Pod 与容器
+type cgroupOwner struct {
+	PodUID      string
+	ContainerID string
+}
+
+// cgroupResolver 将 cgroup id（cgroup v2 目录的 inode 号）解析为 Pod/容器
+// 未命中时重新遍历 cgroup 树，遍历频率受 minRescan 限制；
+// 只有在首次未命中之后完成的遍历中仍找不到，才认定 cgroup 已销毁
+type cgroupResolver struct {
+	mu        sync.Mutex
+	root      string
+	owners    map[uint64]cgroupOwner
+	missing   map[uint64]time.Time // 首次未命中的时间
+	lastScan  time.Time
+	minRescan time.Duration
+}
+
+func newCgroupResolver(root string) *cgroupResolver {
+	return &cgroupResolver{
+		root:      root,
+		owners:    make(map[uint64]cgroupOwner),
+		missing:   make(map[uint64]time.Time),
+		minRescan: 5 * time.Second,
+	}
+}
+
+// resolve 返回 cgroup 的归属；ok 为 false 表示 cgroup 已不存在
+func (r *cgroupResolver) resolve(id uint64) (cgroupOwner, bool) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+
+	if owner, ok := r.owners[id]; ok {
+		return owner, true
+	}
+
+	since, ok := r.missing[id]
+	if !ok {
+		since = time.Now()
+		r.missing[id] = since
+	}
+	if !r.lastScan.After(since) && time.Since(r.lastScan) >= r.minRescan {
+		r.scan()
+	}
+
+	if owner, ok := r.owners[id]; ok {
+		delete(r.missing, id)
+		return owner, true
+	}
+	if r.lastScan.After(since) {
+		delete(r.missing, id)
+		return cgroupOwner{}, false
+	}
+	// 尚未确认 cgroup 已销毁
+	return cgroupOwner{}, true
+}
+
+// scan 遍历 cgroup 树重建缓存
+func (r *cgroupResolver) scan() {
+	owners := make(map[uint64]cgroupOwner, len(r.owners))
+	filepath.WalkDir(r.root, func(path string, d fs.DirEntry, err error) error {
+		if err != nil || !d.IsDir() {
+			return nil
+		}
+		info, err := os.Stat(path)
+		if err != nil {
+			return nil
+		}
+		st, ok := info.Sys().(*syscall.Stat_t)
+		if !ok {
+			return nil
+		}
+		owners[st.Ino] = parseCgroupOwner(path)
+		return nil
+	})
+	r.owners = owners
+	r.lastScan = time.Now()
+}
+
+// parseCgroupOwner 从 cgroup 路径解析 Pod UID 与容器 ID，非 Pod 的 cgroup 返回零值
+func parseCgroupOwner(path string) cgroupOwner {
+	m := podUIDPattern.FindStringSubmatch(path)
+	if m == nil {
+		return cgroupOwner{}
+	}
+
+	owner := cgroupOwner{PodUID: strings.ReplaceAll(m[1], "_", "-")}
+	if c := containerIDPattern.FindStringSubmatch(filepath.Base(path)); c != nil {
+		owner.ContainerID = c[1]
+	}
+	return owner
+}
+
+// GetContainerVRAMUsage 返回 eBPF 追踪到的每容器显存使用
+// 非 Pod 的 cgroup 被忽略，已销毁 cgroup 的条目从内核 map 中删除；未启用 VRAM 追踪时返回 nil
+func (m *EBPFManager) GetContainerVRAMUsage() []collectors.ContainerVRAMUsage {
+	m.mu.RLock()
+	source := m.vramUsage
+	m.mu.RUnlock()
+
+	if source == nil {
+		return nil
+	}
+	// 先清理已退出进程的分配记录，避免 vram_allocs 被占满
+	source.PruneVRAMAllocs(processAlive)
+	usage, err := source.ReadVRAMUsage()
+	if err != nil {
+		return nil
+	}
+
+	var result []collectors.ContainerVRAMUsage
+	for id, u := range usage {
+		owner, ok := m.cgroups.resolve(id)
+		if !ok {
+			source.DeleteVRAMUsage(id)
+			continue
+		}
+		if owner.PodUID == "" {
+			continue
+		}
+
+		used := uint64(0)
+		if u.Bytes > 0 {
+			used = uint64(u.Bytes)
+		}
+		result = append(result, collectors.ContainerVRAMUsage{
+			PodUID:      owner.PodUID,
+			ContainerID: owner.ContainerID,
+			CgroupID:    id,
+			Used:        used,
+			Allocs:      u.Allocs,
+			Frees:       u.Frees,
+		})
+	}
+
+	sort.Slice(result, func(i, j int) bool {
+		if result[i].PodUID != result[j].PodUID {
+			return result[i].PodUID < result[j].PodUID
+		}
+		return result[i].ContainerID < result[j].ContainerID
+	})
+	return result
+}
+
+// GetVRAMTrackerStats 返回 vram_tracker 的追踪失败计数，未启用 VRAM 追踪时返回零值
+func (m *EBPFManager) GetVRAMTrackerStats() VRAMTrackerStats {
+	m.mu.RLock()
+	source := m.vramUsage
+	m.mu.RUnlock()
+
+	if source == nil {
+		return VRAMTrackerStats{}
+	}
+	stats, err := source.ReadVRAMTrackerStats()
+	if err != nil {
+		return VRAMTrackerStats{}
+	}
+	return stats
+}
@@ -0,0 +1,276 @@
+package ebpf
+
+import "math"
+
+// 分析窗口：每设备按指标拆分为独立的数值列（struct-of-arrays），
+// 写入时增量维护趋势、累计量等统计值，快照读取均为 O(1)
+
+// baselineAlpha 基线指数加权系数
+const baselineAlpha = 0.1
+
+// trendSeries 定长时间序列，维护滑动线性回归（y 对时间）所需的累加量
+// x 为相对窗口内最旧样本的秒数；淘汰最旧样本时所有 x 平移 d，
+// 由 Σ(x-d) = Σx-nd、Σ(x-d)² = Σx²-2dΣx+nd²、Σ(x-d)y = Σxy-dΣy 更新，
+// 因此写入和斜率读取都是 O(1)
+type trendSeries struct {
+	times  *Ring[int64] // UnixNano
+	values *Ring[float64]
+	sumX   float64
+	sumX2  float64
+	sumY   float64
+	sumXY  float64
+}
+
+func newTrendSeries(capacity int) trendSeries {
+	return trendSeries{
+		times:  NewRing[int64](capacity),
+		values: NewRing[float64](capacity),
+	}
+}
+
+// push 写入样本并更新回归累加量
+func (s *trendSeries) push(t int64, y float64) {
+	oldT, evicted := s.times.Push(t)
+	oldY, _ := s.values.Push(y)
+
+	if evicted {
+		// 移除 x=0 的最旧样本，再把原点平移到新的最旧样本
+		s.sumY -= oldY
+		n := float64(s.values.Len() - 1)
+		newOldest, _ := s.times.Oldest()
+		d := float64(newOldest-oldT) / 1e9
+		s.sumXY -= d * s.sumY
+		s.sumX2 -= 2*d*s.sumX - n*d*d
+		s.sumX -= n * d
+	}
+
+	oldest, _ := s.times.Oldest()
+	x := float64(t-oldest) / 1e9
+	s.sumX += x
+	s.sumX2 += x * x
+	s.sumY += y
+	s.sumXY += x * y
+
+	// 每绕回一圈按窗口重算一次，消除浮点累积误差（均摊 O(1)）
+	if s.times.head == 0 && s.times.Len() == s.times.Cap() {
+		s.recompute()
+	}
+}
+
+// recompute 按当前窗口重新计算累加量
+func (s *trendSeries) recompute() {
+	s.sumX, s.sumX2, s.sumY, s.sumXY = 0, 0, 0, 0
+	oldest, _ := s.times.Oldest()
+	for i := 0; i < s.values.Len(); i++ {
+		x := float64(s.times.At(i)-oldest) / 1e9
+		y := s.values.At(i)
+		s.sumX += x
+		s.sumX2 += x * x
+		s.sumY += y
+		s.sumXY += x * y
+	}
+}
+
+// slope 返回每秒变化量（最小二乘斜率），样本时间跨度为 0 时返回 0
+func (s *trendSeries) slope() float64 {
+	n := float64(s.values.Len())
+	if n < 2 {
+		return 0
+	}
+
+	denom := n*s.sumX2 - s.sumX*s.sumX
+	if denom <= 1e-12 {
+		return 0
+	}
+	return (n*s.sumXY - s.sumX*s.sumY) / denom
+}
+
+// len 返回窗口内样本数
+func (s *trendSeries) len() int {
+	return s.values.Len()
+}
+
+// ewStats 指数加权均值与方差
+// 样本数少于 1/alpha 时权重取 1/n，即 Welford 算术均值/方差，避免冷启动偏向 0
+type ewStats struct {
+	mean     float64
+	variance float64
+	n        uint64
+}
+
+// add 写入样本
+func (s *ewStats) add(x, alpha float64) {
+	s.n++
+	a := alpha
+	if w := 1 / float64(s.n); w > a {
+		a = w
+	}
+	diff := x - s.mean
+	incr := a * diff
+	s.mean += incr
+	s.variance = (1 - a) * (s.variance + diff*incr)
+}
+
+// stdDev 返回标准差
+func (s *ewStats) stdDev() float64 {
+	return math.Sqrt(s.variance)
+}
+
+// gpuWindow 单设备的 GPU 指标窗口
+type gpuWindow struct {
+	latest      GPUEvent
+	temperature trendSeries
+	power       trendSeries
+
+	// 基线估计（写入时更新）
+	baseTemperature ewStats
+	basePower       ewStats
+	baseClock       ewStats
+}
+
+func newGPUWindow(capacity int) *gpuWindow {
+	return &gpuWindow{
+		temperature: newTrendSeries(capacity),
+		power:       newTrendSeries(capacity),
+	}
+}
+
+func (w *gpuWindow) add(e GPUEvent) {
+	ts := e.Timestamp.UnixNano()
+	w.latest = e
+	w.temperature.push(ts, float64(e.Temperature))
+	w.power.push(ts, float64(e.Power))
+
+	w.baseTemperature.add(float64(e.Temperature), baselineAlpha)
+	w.basePower.add(float64(e.Power), baselineAlpha)
+	w.baseClock.add(float64(e.CoreClock), baselineAlpha)
+}
+
+// Len 返回窗口内事件数
+func (w *gpuWindow) Len() int {
+	return w.temperature.len()
+}
+
+// pcieWindow 单设备的 PCIe 流量窗口
+type pcieWindow struct {
+	timestamps *Ring[int64] // UnixNano
+	readBytes  *Ring[uint64]
+	writeBytes *Ring[uint64]
+	totalRead  uint64
+	totalWrite uint64
+}
+
+func newPCIeWindow(capacity int) *pcieWindow {
+	return &pcieWindow{
+		timestamps: NewRing[int64](capacity),
+		readBytes:  NewRing[uint64](capacity),
+		writeBytes: NewRing[uint64](capacity),
+	}
+}
+
+func (w *pcieWindow) add(e PCIeEvent) {
+	w.timestamps.Push(e.Timestamp.UnixNano())
+	if old, evicted := w.readBytes.Push(e.ReadBytes); evicted {
+		w.totalRead -= old
+	}
+	if old, evicted := w.writeBytes.Push(e.WriteBytes); evicted {
+		w.totalWrite -= old
+	}
+	w.totalRead += e.ReadBytes
+	w.totalWrite += e.WriteBytes
+}
+
+// bytesPerSecond 返回窗口内的平均传输速率
+// 每个事件是截至其时间戳的一个采样区间的增量，最旧事件的区间起点不在窗口内，
+// 因此用 (总量 - 最旧事件) / (最新时间 - 最旧时间) 计算，至少需要两个事件
+func (w *pcieWindow) bytesPerSecond() float64 {
+	if w.timestamps.Len() < 2 {
+		return 0
+	}
+
+	first, _ := w.timestamps.Oldest()
+	last, _ := w.timestamps.Latest()
+	duration := float64(last-first) / 1e9
+	if duration <= 0 {
+		return 0
+	}
+
+	firstRead, _ := w.readBytes.Oldest()
+	firstWrite, _ := w.writeBytes.Oldest()
+	bytes := (w.totalRead - firstRead) + (w.totalWrite - firstWrite)
+	return float64(bytes) / duration
+}
+
+// Len 返回窗口内事件数
+func (w *pcieWindow) Len() int {
+	return w.readBytes.Len()
+}
+
+// healthWindow 单设备的健康事件窗口
+type healthWindow struct {
+	timestamps *Ring[int64] // UnixNano
+	types      *Ring[HealthEventType]
+	counts     *Ring[uint32]
+
+	eccSingleBit uint64
+	eccDoubleBit uint64
+	pageRetire   uint64
+}
+
+func newHealthWindow(capacity int) *healthWindow {
+	return &healthWindow{
+		timestamps: NewRing[int64](capacity),
+		types:      NewRing[HealthEventType](capacity),
+		counts:     NewRing[uint32](capacity),
+	}
+}
+
+func (w *healthWindow) add(e HealthEvent) {
+	w.timestamps.Push(e.Timestamp.UnixNano())
+	oldType, evicted := w.types.Push(e.Type)
+	oldCount, _ := w.counts.Push(e.Count)
+	if evicted {
+		w.account(oldType, oldCount, -1)
+	}
+	w.account(e.Type, e.Count, 1)
+}
+
+// account 按事件类型增减累计计数
+func (w *healthWindow) account(t HealthEventType, count uint32, sign int) {
+	var counter *uint64
+	switch t {
+	case EventECCSingleBit:
+		counter = &w.eccSingleBit
+	case EventECCDoubleBit:
+		counter = &w.eccDoubleBit
+	case EventPageRetire:
+		counter = &w.pageRetire
+	default:
+		return
+	}
+	if sign > 0 {
+		*counter += uint64(count)
+	} else {
+		*counter -= uint64(count)
+	}
+}
+
+// eccErrorRate 返回窗口内 ECC 错误率 (errors/sec)
+func (w *healthWindow) eccErrorRate() float64 {
+	if w.timestamps.Len() < 2 {
+		return 0
+	}
+
+	first, _ := w.timestamps.Oldest()
+	last, _ := w.timestamps.Latest()
+	duration := float64(last-first) / 1e9
+	if duration <= 0 {
+		return 0
+	}
+	return float64(w.eccSingleBit+w.eccDoubleBit) / duration
+}
+
+// Len 返回窗口内事件数
+func (w *healthWindow) Len() int {
+	return w.timestamps.Len()
+}
@@ -25,6 +25,7 @@ const (
 // FilterPlugin HCS 过滤插件
 type FilterPlugin struct {
 	client client.Client
+	cache  *ComputeNodeCache // 可选，配置后每个周期只在 PreFilter 取一次快照
 }
 
 var _ framework.FilterPlugin = &FilterPlugin{}
@@ -42,6 +43,12 @@ func (p *FilterPlugin) Name() string {
 	return PluginName
 }
 
+// UseComputeNodeCache 使用 informer 维护的 ComputeNode 缓存，
+// Filter/Score/Reserve 改为查询 PreFilter 写入 CycleState 的快照
+func (p *FilterPlugin) UseComputeNodeCache(cache *ComputeNodeCache) {
+	p.cache = cache
+}
+
 // PreFilter 预过滤阶段
 func (p *FilterPlugin) PreFilter(ctx context.Context, state *framework.CycleState, pod *v1.Pod) *framework.Status {
 	// 解析 Pod 的算力请求
@@ -54,6 +61,11 @@ func (p *FilterPlugin) PreFilter(ctx context.Context, state *framework.CycleStat
 	// 将请求存储到 CycleState 供 Filter 阶段使用
 	state.Write(stateKey, &stateData{request: req})
 
+	// 本周期内所有节点共用同一份快照
+	if p.cache != nil {
+		state.Write(snapshotStateKey, p.cache.Snapshot())
+	}
+
 	return framework.NewStatus(framework.Success, "")
 }
 
@@ -69,31 +81,41 @@ func (p *FilterPlugin) Filter(ctx context.Context, state *framework.CycleState,
 	req := data.(*stateData).request
 
 	// 获取节点对应的 ComputeNode
-	cn, err := p.getComputeNode(ctx, nodeInfo.Node().Name)
+	node, err := lookupNode(ctx, state, nodeInfo.Node().Name, p.getComputeNode)
 	if err != nil {
 		return framework.NewStatus(framework.UnschedulableAndUnresolvable,
 			fmt.Sprintf("failed to get ComputeNode: %v", err))
 	}
 
-	if cn == nil {
+	if node == nil {
 		return framework.NewStatus(framework.UnschedulableAndUnresolvable,
 			"node does not have ComputeNode resource")
 	}
+	cn := node.ComputeNode
 
 	// 检查节点是否就绪
-	if cn.Status.Phase != v1alpha1.ComputeNodePhaseReady {
+	if !node.Ready {
 		return framework.NewStatus(framework.UnschedulableAndUnresolvable,
 			fmt.Sprintf("ComputeNode is not ready: %s", cn.Status.Phase))
 	}
 
 	// 检查 VRAM 是否满足
 	if req.VRAMBytes > 0 {
-		availableVRAM := p.calculateAvailableVRAM(cn)
+		availableVRAM := node.AvailableVRAM
 		if availableVRAM < req.VRAMBytes {
 			return framework.NewStatus(framework.Unschedulable,
 				fmt.Sprintf("insufficient VRAM: requested %d, available %d",
 					req.VRAMBytes, availableVRAM))
 		}
+
+		// 总量足够时还需能按设备放下，碎片化的余量无法满足单卡请求
+		if node.DeviceVRAM != nil {
+			if _, ok := placeVRAM(node.DeviceVRAM, req.vramRequests()); !ok {
+				return framework.NewStatus(framework.Unschedulable,
+					fmt.Sprintf("insufficient VRAM per device: requested %v, free %v",
+						req.vramRequests(), deviceFreeList(node.DeviceVRAM)))
+			}
+		}
 	}
 
 	// 检查算力是否满足
@@ -121,6 +143,7 @@ func (p *FilterPlugin) parseComputeRequest(pod *v1.Pod) *ComputeRequest {
 		// 解析 VRAM 请求
 		if vram, ok := container.Resources.Requests[v1.ResourceName(VRAMResourceName)]; ok {
 			req.VRAMBytes += uint64(vram.Value())
+			req.ContainerVRAM = append(req.ContainerVRAM, uint64(vram.Value()))
 			hasRequest = true
 		}
 
@@ -154,14 +177,7 @@ func (p *FilterPlugin) getComputeNode(ctx context.Context, nodeName string) (*v1
 
 // calculateAvailableVRAM 计算可用 VRAM
 func (p *FilterPlugin) calculateAvailableVRAM(cn *v1alpha1.ComputeNode) uint64 {
-	var totalUsed uint64
-	for _, dev := range cn.Status.Devices {
-		totalUsed += dev.VRAMUsed
-	}
-	if cn.Spec.TotalCapacity.VRAM > totalUsed {
-		return cn.Spec.TotalCapacity.VRAM - totalUsed
-	}
-	return 0
+	return availableVRAM(cn)
 }
 
 // ComputeRequest 算力请求
@@ -169,6 +185,20 @@ type ComputeRequest struct {
 	VRAMBytes  uint64
 	FP16TFLOPS uint64
 	FP32TFLOPS uint64
+
+	// ContainerVRAM 各容器的 VRAM 请求，按设备放置时每个容器单独放置
+	ContainerVRAM []uint64
+}
+
+// vramRequests 返回需要按设备放置的 VRAM 请求，未记录容器明细时视为单个请求
+func (r *ComputeRequest) vramRequests() []uint64 {
+	if len(r.ContainerVRAM) > 0 {
+		return r.ContainerVRAM
+	}
+	if r.VRAMBytes > 0 {
+		return []uint64{r.VRAMBytes}
+	}
+	return nil
 }
 
 // stateKey CycleState 键
@@ -186,6 +216,8 @@ func (d *stateData) Clone() framework.StateData {
 			VRAMBytes:  d.request.VRAMBytes,
 			FP16TFLOPS: d.request.FP16TFLOPS,
 			FP32TFLOPS: d.request.FP32TFLOPS,
+
+			ContainerVRAM: append([]uint64(nil), d.request.ContainerVRAM...),
 		},
 	}
 }
@@ -0,0 +1,240 @@
+package plugins
+
+import (
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// NodeReservations 单个节点上所有预留的汇总，不可变
+type NodeReservations struct {
+	VRAMBytes  uint64
+	FP16TFLOPS uint64
+	Devices    map[string]uint64 // 设备 ID -> bytes
+	Pods       int
+}
+
+// emptyNodeReservations 没有任何预留的节点
+var emptyNodeReservations = &NodeReservations{}
+
+// SubtractVRAM 从可用 VRAM 中扣除节点上已预留的量
+func (r *NodeReservations) SubtractVRAM(available uint64) uint64 {
+	if available > r.VRAMBytes {
+		return available - r.VRAMBytes
+	}
+	return 0
+}
+
+// apply 返回加上 add、减去 sub 之后的新汇总
+// 先加后减，无符号回绕保证并发调整按任意顺序提交时结果一致
+func (r *NodeReservations) apply(add, sub *PodReservation) *NodeReservations {
+	next := &NodeReservations{
+		VRAMBytes:  r.VRAMBytes,
+		FP16TFLOPS: r.FP16TFLOPS,
+		Devices:    make(map[string]uint64, len(r.Devices)),
+		Pods:       r.Pods,
+	}
+	for id, bytes := range r.Devices {
+		next.Devices[id] = bytes
+	}
+	if add != nil {
+		next.VRAMBytes += add.VRAMBytes
+		next.FP16TFLOPS += add.FP16TFLOPS
+		for id, bytes := range add.Devices {
+			next.Devices[id] += bytes
+		}
+		next.Pods++
+	}
+	if sub != nil {
+		next.VRAMBytes -= sub.VRAMBytes
+		next.FP16TFLOPS -= sub.FP16TFLOPS
+		for id, bytes := range sub.Devices {
+			next.Devices[id] -= bytes
+		}
+		next.Pods--
+	}
+	for id, bytes := range next.Devices {
+		if bytes == 0 {
+			delete(next.Devices, id)
+		}
+	}
+	return next
+}
+
+// ledgerEntry 单个 Pod 的预留，不可变
+type ledgerEntry struct {
+	node       string
+	requested  uint64    // Reserve 时的 VRAM 请求，对账时据此计算剩余预留
+	reservedAt time.Time // 过期清理据此判断 Pod 是否超过宽限期仍未上报
+	res        *PodReservation
+}
+
+// ReservationLedger 按节点汇总的资源预留
+//
+// 每个节点的汇总是一个不可变的 NodeReservations，写入时复制一份并以 CAS 替换：
+// 读取（Filter/Reserve 扣除已预留量）只是一次原子加载，不同节点的预留互不竞争，
+// 同一节点并发预留时失败的一方基于新汇总重新校验。另以 Pod 键索引各自的预留，
+// Unreserve 与对账不需要遍历节点。
+type ReservationLedger struct {
+	nodes sync.Map // nodeName -> *atomic.Pointer[NodeReservations]
+	pods  sync.Map // podKey -> *ledgerEntry
+}
+
+// NewReservationLedger 创建预留账本
+func NewReservationLedger() *ReservationLedger {
+	return &ReservationLedger{}
+}
+
+func (l *ReservationLedger) node(nodeName string) *atomic.Pointer[NodeReservations] {
+	if ptr, ok := l.nodes.Load(nodeName); ok {
+		return ptr.(*atomic.Pointer[NodeReservations])
+	}
+	ptr := &atomic.Pointer[NodeReservations]{}
+	ptr.Store(emptyNodeReservations)
+	actual, _ := l.nodes.LoadOrStore(nodeName, ptr)
+	return actual.(*atomic.Pointer[NodeReservations])
+}
+
+// Node 返回节点当前的预留汇总，结果只读
+func (l *ReservationLedger) Node(nodeName string) *NodeReservations {
+	if ptr, ok := l.nodes.Load(nodeName); ok {
+		return ptr.(*atomic.Pointer[NodeReservations]).Load()
+	}
+	return emptyNodeReservations
+}
+
+// Get 返回 Pod 的预留及其所在节点
+func (l *ReservationLedger) Get(podKey string) (*PodReservation, string, bool) {
+	if e, ok := l.pods.Load(podKey); ok {
+		entry := e.(*ledgerEntry)
+		return entry.res, entry.node, true
+	}
+	return nil, "", false
+}
+
+// Reserve 在节点上为 Pod 预留资源
+//
+// try 基于节点当前的预留汇总校验并给出预留内容，返回错误时放弃；汇总在提交前被其他
+// 预留改变时以新汇总重新调用 try。Pod 已在该节点预留时不调用 try，返回 true。
+func (l *ReservationLedger) Reserve(podKey, nodeName string,
+	try func(current *NodeReservations) (*PodReservation, error)) (bool, error) {
+	if _, node, ok := l.Get(podKey); ok {
+		if node == nodeName {
+			return true, nil
+		}
+		// 调度器改选了节点，旧预留作废
+		l.Release(podKey)
+	}
+
+	ptr := l.node(nodeName)
+	var res *PodReservation
+	for {
+		current := ptr.Load()
+		var err error
+		res, err = try(current)
+		if err != nil {
+			return false, err
+		}
+		if ptr.CompareAndSwap(current, current.apply(res, nil)) {
+			break
+		}
+	}
+
+	entry := &ledgerEntry{node: nodeName, requested: res.VRAMBytes, reservedAt: time.Now(), res: res}
+	if _, loaded := l.pods.LoadOrStore(podKey, entry); loaded {
+		// 同一 Pod 的并发预留已先提交，撤回本次
+		l.update(ptr, nil, res)
+		return true, nil
+	}
+	return false, nil
+}
+
+// Release 释放 Pod 的预留，返回其原所在节点
+func (l *ReservationLedger) Release(podKey string) (string, bool) {
+	e, ok := l.pods.LoadAndDelete(podKey)
+	if !ok {
+		return "", false
+	}
+	entry := e.(*ledgerEntry)
+	l.update(l.node(entry.node), nil, entry.res)
+	return entry.node, true
+}
+
+// Settle 按 Pod 的实际显存使用收缩预留
+//
+// 实际使用已计入 ComputeNode 的设备用量，预留只需保留请求中尚未使用的部分；
+// used 达到请求量后释放预留。Pod 不在该节点预留时返回 false。
+func (l *ReservationLedger) Settle(podKey, nodeName string, used uint64) bool {
+	e, ok := l.pods.Load(podKey)
+	if !ok {
+		return false
+	}
+	entry := e.(*ledgerEntry)
+	if entry.node != nodeName {
+		return false
+	}
+
+	if used >= entry.requested {
+		if !l.pods.CompareAndDelete(podKey, e) {
+			return false
+		}
+		l.update(l.node(nodeName), nil, entry.res)
+		return true
+	}
+
+	remaining := entry.requested - used
+	if remaining == entry.res.VRAMBytes {
+		return true
+	}
+
+	res := &PodReservation{
+		VRAMBytes:  remaining,
+		FP16TFLOPS: entry.res.FP16TFLOPS,
+	}
+	if len(entry.res.Devices) > 0 {
+		// 各设备按同一比例收缩
+		res.Devices = make(map[string]uint64, len(entry.res.Devices))
+		scale := float64(remaining) / float64(entry.requested)
+		for id, bytes := range entry.res.Devices {
+			if b := uint64(float64(bytes) * scale); b > 0 {
+				res.Devices[id] = b
+			}
+		}
+	}
+
+	next := &ledgerEntry{node: entry.node, requested: entry.requested, reservedAt: entry.reservedAt, res: res}
+	if !l.pods.CompareAndSwap(podKey, e, next) {
+		// 期间被释放或再次调整，以对方为准
+		return false
+	}
+	l.update(l.node(nodeName), res, entry.res)
+	return true
+}
+
+// Expire 释放 before 之前创建、且 active 返回 false 的预留，返回被释放的 Pod 键
+func (l *ReservationLedger) Expire(before time.Time, active func(podKey, nodeName string) bool) []string {
+	var expired []string
+	l.pods.Range(func(key, e interface{}) bool {
+		podKey, entry := key.(string), e.(*ledgerEntry)
+		if !entry.reservedAt.Before(before) || active(podKey, entry.node) {
+			return true
+		}
+		// 期间被释放或重新预留时以对方为准
+		if l.pods.CompareAndDelete(podKey, e) {
+			l.update(l.node(entry.node), nil, entry.res)
+			expired = append(expired, podKey)
+		}
+		return true
+	})
+	return expired
+}
+
+// update 以 CAS 循环把 add/sub 应用到节点汇总
+func (l *ReservationLedger) update(ptr *atomic.Pointer[NodeReservations], add, sub *PodReservation) {
+	for {
+		current := ptr.Load()
+		if ptr.CompareAndSwap(current, current.apply(add, sub)) {
+			return
+		}
+	}
+}
@@ -0,0 +1,153 @@
+package plugins
+
+import (
+	"sort"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
+)
+
+// DeviceVRAM 单个设备的显存容量与余量
+type DeviceVRAM struct {
+	ID    string
+	Total uint64 // bytes
+	Free  uint64 // bytes，总量减去已用量
+}
+
+// deviceVRAM 提取各设备的显存余量，设备未上报 VRAMTotal 时返回 nil（退回节点级判断）
+func deviceVRAM(cn *v1alpha1.ComputeNode) []DeviceVRAM {
+	var devices []DeviceVRAM
+	for _, dev := range cn.Status.Devices {
+		if dev.VRAMTotal == 0 {
+			return nil
+		}
+		d := DeviceVRAM{ID: dev.ID, Total: dev.VRAMTotal}
+		if dev.VRAMTotal > dev.VRAMUsed {
+			d.Free = dev.VRAMTotal - dev.VRAMUsed
+		}
+		devices = append(devices, d)
+	}
+	return devices
+}
+
+// deviceFreeList 各设备余量，用于状态信息
+func deviceFreeList(devices []DeviceVRAM) []uint64 {
+	free := make([]uint64, len(devices))
+	for i, d := range devices {
+		free[i] = d.Free
+	}
+	return free
+}
+
+// subtractDeviceReserved 返回扣除各设备已预留量后的副本
+func subtractDeviceReserved(devices []DeviceVRAM, reserved map[string]uint64) []DeviceVRAM {
+	out := make([]DeviceVRAM, len(devices))
+	copy(out, devices)
+	for i := range out {
+		r := reserved[out[i].ID]
+		if out[i].Free > r {
+			out[i].Free -= r
+		} else {
+			out[i].Free = 0
+		}
+	}
+	return out
+}
+
+// placeVRAM 将各容器的显存请求放置到设备上，返回 设备 ID -> 分配量
+//
+// 请求按从大到小依次放置：不超过单卡容量的请求必须落在一张卡上，选择放得下且余量最小的
+// 设备（best-fit），避免 8×2GiB 的碎片被当作 16GiB 使用；超过单卡容量的请求按余量从大到小
+// 占用尽量少的设备。任一请求放不下时返回 false。devices 不会被修改。
+func placeVRAM(devices []DeviceVRAM, requests []uint64) (map[string]uint64, bool) {
+	free := make([]uint64, len(devices))
+	var maxTotal uint64
+	for i, d := range devices {
+		free[i] = d.Free
+		if d.Total > maxTotal {
+			maxTotal = d.Total
+		}
+	}
+
+	sorted := append([]uint64(nil), requests...)
+	sort.Slice(sorted, func(a, b int) bool { return sorted[a] > sorted[b] })
+
+	assignment := make(map[string]uint64)
+	for _, req := range sorted {
+		if req == 0 {
+			continue
+		}
+
+		if req <= maxTotal {
+			best := -1
+			for i := range free {
+				if free[i] >= req && (best < 0 || free[i] < free[best]) {
+					best = i
+				}
+			}
+			if best < 0 {
+				return nil, false
+			}
+			free[best] -= req
+			assignment[devices[best].ID] += req
+			continue
+		}
+
+		// 多卡请求：按余量降序取设备
+		order := make([]int, len(free))
+		for i := range order {
+			order[i] = i
+		}
+		sort.SliceStable(order, func(a, b int) bool { return free[order[a]] > free[order[b]] })
+
+		remaining := req
+		for _, i := range order {
+			if remaining == 0 || free[i] == 0 {
+				break
+			}
+			take := free[i]
+			if take > remaining {
+				take = remaining
+			}
+			free[i] -= take
+			assignment[devices[i].ID] += take
+			remaining -= take
+		}
+		if remaining > 0 {
+			return nil, false
+		}
+	}
+	return assignment, true
+}
+
+// packingScore 放置方案的装箱得分（0-1），越高越紧凑
+//
+// 一半来自贴合度：请求量占所用设备余量的比例，请求恰好填满设备时为 1；
+// 另一半来自放置后的连续度：最大单卡余量占总余量的比例，保留完整大块的节点得分更高。
+func packingScore(devices []DeviceVRAM, assignment map[string]uint64) float64 {
+	var used, touched, totalAfter, largestAfter uint64
+	for _, d := range devices {
+		after := d.Free
+		if a, ok := assignment[d.ID]; ok {
+			used += a
+			touched += d.Free
+			after -= a
+		}
+		totalAfter += after
+		if after > largestAfter {
+			largestAfter = after
+		}
+	}
+
+	tightness := 0.0
+	if touched > 0 {
+		tightness = float64(used) / float64(touched)
+	}
+
+	// 放置后没有余量，不存在碎片
+	contiguity := 1.0
+	if totalAfter > 0 {
+		contiguity = float64(largestAfter) / float64(totalAfter)
+	}
+
+	return 0.5*tightness + 0.5*contiguity
+}
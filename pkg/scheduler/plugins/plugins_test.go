@@ -2,7 +2,11 @@ package plugins
 
 import (
 	"context"
+	"fmt"
+	"sync"
+	"sync/atomic"
 	"testing"
+	"time"
 
 	v1 "k8s.io/api/core/v1"
 	"k8s.io/apimachinery/pkg/api/meta"
@@ -10,6 +14,7 @@ import (
 	metav1 "k8s.io/apimachinery/pkg/apis/meta/v1"
 	"k8s.io/apimachinery/pkg/runtime"
 	"k8s.io/apimachinery/pkg/runtime/schema"
+	toolscache "k8s.io/client-go/tools/cache"
 	"sigs.k8s.io/controller-runtime/pkg/client"
 
 	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
@@ -386,6 +391,13 @@ func TestScorePlugin_NormalizeScore_AllSame(t *testing.T) {
 	}
 }
 
+// seedReservation 不经校验直接写入预留
+func seedReservation(plugin *ReservePlugin, nodeName, podKey string, res *PodReservation) {
+	plugin.ledger.Reserve(podKey, nodeName, func(*NodeReservations) (*PodReservation, error) {
+		return res, nil
+	})
+}
+
 func TestReservePlugin_ReserveAndUnreserve(t *testing.T) {
 	plugin := NewReservePlugin(nil)
 
@@ -401,15 +413,10 @@ func TestReservePlugin_ReserveAndUnreserve(t *testing.T) {
 	})
 
 	// 预留资源（不需要实际的 K8s 客户端）
-	plugin.mu.Lock()
-	plugin.reservations["node-1"] = &Reservation{
-		Pods: make(map[string]*PodReservation),
-	}
-	plugin.reservations["node-1"].Pods["default/test-pod"] = &PodReservation{
+	seedReservation(plugin, "node-1", "default/test-pod", &PodReservation{
 		VRAMBytes:  16 * 1024 * 1024 * 1024,
 		FP16TFLOPS: 100,
-	}
-	plugin.mu.Unlock()
+	})
 
 	// 验证预留
 	reserved := plugin.GetTotalReservedVRAM("node-1")
@@ -1324,15 +1331,9 @@ func TestReservePlugin_CalculateAvailableVRAMWithReservation(t *testing.T) {
 	plugin := NewReservePlugin(nil)
 
 	// Add a reservation
-	plugin.mu.Lock()
-	plugin.reservations["node-1"] = &Reservation{
-		Pods: map[string]*PodReservation{
-			"default/test-pod": {
-				VRAMBytes: 20 * 1024 * 1024 * 1024,
-			},
-		},
-	}
-	plugin.mu.Unlock()
+	seedReservation(plugin, "node-1", "default/test-pod", &PodReservation{
+		VRAMBytes: 20 * 1024 * 1024 * 1024,
+	})
 
 	cn := &v1alpha1.ComputeNode{
 		Spec: v1alpha1.ComputeNodeSpec{
@@ -1382,18 +1383,12 @@ func TestReservePlugin_ClearPodReservation(t *testing.T) {
 	plugin := NewReservePlugin(nil)
 
 	// Add reservations
-	plugin.mu.Lock()
-	plugin.reservations["node-1"] = &Reservation{
-		Pods: map[string]*PodReservation{
-			"default/test-pod": {
-				VRAMBytes: 20 * 1024 * 1024 * 1024,
-			},
-			"default/other-pod": {
-				VRAMBytes: 10 * 1024 * 1024 * 1024,
-			},
-		},
-	}
-	plugin.mu.Unlock()
+	seedReservation(plugin, "node-1", "default/test-pod", &PodReservation{
+		VRAMBytes: 20 * 1024 * 1024 * 1024,
+	})
+	seedReservation(plugin, "node-1", "default/other-pod", &PodReservation{
+		VRAMBytes: 10 * 1024 * 1024 * 1024,
+	})
 
 	// Clear one pod's reservation
 	plugin.ClearPodReservation("default/test-pod")
@@ -1410,15 +1405,9 @@ func TestReservePlugin_ClearPodReservation_LastPod(t *testing.T) {
 	plugin := NewReservePlugin(nil)
 
 	// Add single reservation
-	plugin.mu.Lock()
-	plugin.reservations["node-1"] = &Reservation{
-		Pods: map[string]*PodReservation{
-			"default/test-pod": {
-				VRAMBytes: 20 * 1024 * 1024 * 1024,
-			},
-		},
-	}
-	plugin.mu.Unlock()
+	seedReservation(plugin, "node-1", "default/test-pod", &PodReservation{
+		VRAMBytes: 20 * 1024 * 1024 * 1024,
+	})
 
 	// Clear the last pod's reservation
 	plugin.ClearPodReservation("default/test-pod")
@@ -1429,11 +1418,11 @@ func TestReservePlugin_ClearPodReservation_LastPod(t *testing.T) {
 		t.Errorf("Expected reserved VRAM 0 after clearing last pod, got %d", reserved)
 	}
 
-	plugin.mu.RLock()
-	_, exists := plugin.reservations["node-1"]
-	plugin.mu.RUnlock()
-	if exists {
-		t.Error("Node reservation entry should be deleted when empty")
+	if pods := plugin.ledger.Node("node-1").Pods; pods != 0 {
+		t.Errorf("Node should have no reserved pods, got %d", pods)
+	}
+	if _, _, exists := plugin.ledger.Get("default/test-pod"); exists {
+		t.Error("Pod entry should be deleted from the ledger")
 	}
 }
 
@@ -1484,4 +1473,546 @@ func TestGetPodKey(t *testing.T) {
 	if key != expected {
 		t.Errorf("Expected key %s, got %s", expected, key)
 	}
+
+	pod.UID = "pod-uid"
+	if key := getPodKey(pod); key != "pod-uid" {
+		t.Errorf("Expected the UID as key, got %s", key)
+	}
+}
+
+// testInformer 记录注册的事件处理器
+type testInformer struct {
+	handler toolscache.ResourceEventHandler
+}
+
+func (i *testInformer) AddEventHandler(handler toolscache.ResourceEventHandler) (toolscache.ResourceEventHandlerRegistration, error) {
+	i.handler = handler
+	return nil, nil
+}
+
+func newCacheFromMockClient() *ComputeNodeCache {
+	cache := NewComputeNodeCache()
+	for _, cn := range newMockClient().computeNodes {
+		cache.Upsert(cn)
+	}
+	return cache
+}
+
+func TestNewNodeSnapshot(t *testing.T) {
+	cn := newMockClient().computeNodes["node-1"]
+	s := newNodeSnapshot(cn)
+
+	if !s.Ready {
+		t.Error("node-1 should be ready")
+	}
+	if s.AvailableVRAM != availableVRAM(cn) {
+		t.Errorf("Expected AvailableVRAM %d, got %d", availableVRAM(cn), s.AvailableVRAM)
+	}
+	if s.AverageHealth != averageHealth(cn) {
+		t.Errorf("Expected AverageHealth %f, got %f", averageHealth(cn), s.AverageHealth)
+	}
+	if s.DeviceModel != "NVIDIA A100-SXM4-80GB" {
+		t.Errorf("Expected DeviceModel NVIDIA A100-SXM4-80GB, got %s", s.DeviceModel)
+	}
+	if !s.HasNVLink {
+		t.Error("node-1 should have NVLink")
+	}
+
+	empty := newNodeSnapshot(&v1alpha1.ComputeNode{})
+	if empty.Ready || empty.HasNVLink || empty.DeviceModel != "" || empty.AverageHealth != 100.0 {
+		t.Errorf("Unexpected snapshot for empty ComputeNode: %+v", empty)
+	}
+}
+
+func TestComputeNodeCache_Snapshot(t *testing.T) {
+	cache := newCacheFromMockClient()
+
+	first := cache.Snapshot()
+	if first.Get("node-1") == nil {
+		t.Fatal("Snapshot should contain node-1")
+	}
+	if cache.Snapshot() != first {
+		t.Error("Snapshot should be reused while nothing changes")
+	}
+	if first.Clone() != first {
+		t.Error("Clone of an immutable snapshot should share it")
+	}
+
+	// 变更后生成新快照，旧快照保持不变
+	updated := first.Get("node-1").ComputeNode.DeepCopy()
+	updated.Status.Phase = v1alpha1.ComputeNodePhaseUnhealthy
+	cache.Upsert(updated)
+
+	second := cache.Snapshot()
+	if second == first {
+		t.Fatal("Snapshot should be rebuilt after Upsert")
+	}
+	if second.Get("node-1").Ready {
+		t.Error("New snapshot should see the update")
+	}
+	if !first.Get("node-1").Ready {
+		t.Error("Old snapshot should not change")
+	}
+
+	cache.Delete("node-1")
+	if cache.Snapshot().Get("node-1") != nil {
+		t.Error("node-1 should be removed")
+	}
+	if second.Get("node-1") == nil {
+		t.Error("Old snapshot should still contain node-1")
+	}
+
+	// 删除不存在的节点不使快照失效
+	third := cache.Snapshot()
+	cache.Delete("nonexistent-node")
+	if cache.Snapshot() != third {
+		t.Error("Deleting an unknown node should not rebuild the snapshot")
+	}
+}
+
+func TestComputeNodeCache_InformerEvents(t *testing.T) {
+	cache := NewComputeNodeCache()
+	informer := &testInformer{}
+	if err := cache.AddToInformer(informer); err != nil {
+		t.Fatalf("AddToInformer failed: %v", err)
+	}
+
+	cn := newMockClient().computeNodes["node-1"]
+	informer.handler.OnAdd(cn, true)
+	if cache.Snapshot().Get("node-1") == nil {
+		t.Fatal("Add event should insert node-1")
+	}
+
+	updated := cn.DeepCopy()
+	updated.Status.Devices = nil
+	informer.handler.OnUpdate(cn, updated)
+	if got := cache.Snapshot().Get("node-1").AvailableVRAM; got != cn.Spec.TotalCapacity.VRAM {
+		t.Errorf("Update event should refresh derived values, got AvailableVRAM %d", got)
+	}
+
+	// 非 ComputeNode 对象被忽略
+	informer.handler.OnAdd(&v1.Pod{}, false)
+	if cache.Snapshot().Len() != 1 {
+		t.Errorf("Expected 1 node, got %d", cache.Snapshot().Len())
+	}
+
+	informer.handler.OnDelete(toolscache.DeletedFinalStateUnknown{Key: "node-1", Obj: updated})
+	if cache.Snapshot().Len() != 0 {
+		t.Error("Tombstone delete should remove node-1")
+	}
+}
+
+func TestPlugins_WithComputeNodeCache(t *testing.T) {
+	// 客户端为 nil：所有读取都必须来自快照
+	filter := NewFilterPlugin(nil)
+	filter.UseComputeNodeCache(newCacheFromMockClient())
+	score := NewScorePlugin(nil, nil)
+	reserve := NewReservePlugin(nil)
+
+	state := framework.NewCycleState()
+	pod := createTestPod(16, 100)
+	if status := filter.PreFilter(context.Background(), state, pod); !status.IsSuccess() {
+		t.Fatalf("PreFilter should succeed, got: %s", status.Message)
+	}
+	if _, err := state.Read(snapshotStateKey); err != nil {
+		t.Fatalf("PreFilter should store the snapshot: %v", err)
+	}
+
+	node := framework.NewNodeInfo(&v1.Node{ObjectMeta: metav1.ObjectMeta{Name: "node-1"}})
+	if status := filter.Filter(context.Background(), state, pod, node); !status.IsSuccess() {
+		t.Errorf("Filter should succeed for node-1, got: %s", status.Message)
+	}
+
+	missing := framework.NewNodeInfo(&v1.Node{ObjectMeta: metav1.ObjectMeta{Name: "nonexistent-node"}})
+	status := filter.Filter(context.Background(), state, pod, missing)
+	if status.Code != framework.UnschedulableAndUnresolvable {
+		t.Errorf("Expected UnschedulableAndUnresolvable for missing node, got %d", status.Code)
+	}
+
+	got, status := score.Score(context.Background(), state, pod, "node-1")
+	if !status.IsSuccess() {
+		t.Errorf("Score should succeed, got: %s", status.Message)
+	}
+	req := &ComputeRequest{VRAMBytes: 16 * 1024 * 1024 * 1024, FP16TFLOPS: 100}
+	if want := score.calculateScore(newMockClient().computeNodes["node-1"], req); got != want {
+		t.Errorf("Snapshot score %d should match direct score %d", got, want)
+	}
+
+	if status := reserve.Reserve(context.Background(), state, pod, "node-1"); !status.IsSuccess() {
+		t.Errorf("Reserve should succeed, got: %s", status.Message)
+	}
+}
+
+// newFragmentedComputeNode 创建 count 张卡、每张卡剩余 freeGi 的 ComputeNode
+func newFragmentedComputeNode(name string, count int, totalGi, freeGi uint64) *v1alpha1.ComputeNode {
+	const gi = 1024 * 1024 * 1024
+	cn := &v1alpha1.ComputeNode{
+		ObjectMeta: metav1.ObjectMeta{Name: name},
+		Spec: v1alpha1.ComputeNodeSpec{
+			NodeName: name,
+			TotalCapacity: v1alpha1.ComputeCapacity{
+				VRAM: uint64(count) * totalGi * gi,
+			},
+		},
+		Status: v1alpha1.ComputeNodeStatus{Phase: v1alpha1.ComputeNodePhaseReady},
+	}
+	for i := 0; i < count; i++ {
+		cn.Status.Devices = append(cn.Status.Devices, v1alpha1.DeviceInfo{
+			ID:          fmt.Sprintf("gpu-%d", i),
+			VRAMTotal:   totalGi * gi,
+			VRAMUsed:    (totalGi - freeGi) * gi,
+			HealthScore: 100,
+		})
+	}
+	return cn
+}
+
+func TestPlaceVRAM(t *testing.T) {
+	const gi = 1024 * 1024 * 1024
+	devices := []DeviceVRAM{
+		{ID: "gpu-0", Total: 80 * gi, Free: 70 * gi},
+		{ID: "gpu-1", Total: 80 * gi, Free: 20 * gi},
+		{ID: "gpu-2", Total: 80 * gi, Free: 80 * gi},
+	}
+
+	tests := []struct {
+		name     string
+		requests []uint64
+		ok       bool
+		expected map[string]uint64
+	}{
+		{
+			name:     "best fit picks the tightest device",
+			requests: []uint64{16 * gi},
+			ok:       true,
+			expected: map[string]uint64{"gpu-1": 16 * gi},
+		},
+		{
+			name:     "containers placed largest first",
+			requests: []uint64{16 * gi, 60 * gi},
+			ok:       true,
+			expected: map[string]uint64{"gpu-0": 60 * gi, "gpu-1": 16 * gi},
+		},
+		{
+			name:     "request above one device spreads over the largest",
+			requests: []uint64{120 * gi},
+			ok:       true,
+			expected: map[string]uint64{"gpu-2": 80 * gi, "gpu-0": 40 * gi},
+		},
+		{
+			name:     "single-device request does not fit anywhere",
+			requests: []uint64{75 * gi, 75 * gi},
+			ok:       false,
+		},
+	}
+
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			assignment, ok := placeVRAM(devices, tt.requests)
+			if ok != tt.ok {
+				t.Fatalf("Expected ok=%v, got %v (%v)", tt.ok, ok, assignment)
+			}
+			if !tt.ok {
+				return
+			}
+			if len(assignment) != len(tt.expected) {
+				t.Fatalf("Expected assignment %v, got %v", tt.expected, assignment)
+			}
+			for id, bytes := range tt.expected {
+				if assignment[id] != bytes {
+					t.Errorf("Expected %s=%d, got %d", id, bytes, assignment[id])
+				}
+			}
+		})
+	}
+
+	if devices[1].Free != 20*gi {
+		t.Error("placeVRAM should not modify the device slice")
+	}
+}
+
+func TestPackingScore(t *testing.T) {
+	const gi = 1024 * 1024 * 1024
+	tight := []DeviceVRAM{{ID: "a", Total: 80 * gi, Free: 16 * gi}, {ID: "b", Total: 80 * gi, Free: 80 * gi}}
+	loose := []DeviceVRAM{{ID: "a", Total: 80 * gi, Free: 80 * gi}, {ID: "b", Total: 80 * gi, Free: 80 * gi}}
+
+	tightScore := packingScore(tight, map[string]uint64{"a": 16 * gi})
+	looseScore := packingScore(loose, map[string]uint64{"a": 16 * gi})
+	if tightScore != 1.0 {
+		t.Errorf("Exact fit leaving one whole device should score 1, got %f", tightScore)
+	}
+	if tightScore <= looseScore {
+		t.Errorf("Tight fit should score higher: tight %f, loose %f", tightScore, looseScore)
+	}
+}
+
+func TestFilterPlugin_Filter_FragmentedVRAM(t *testing.T) {
+	// 8 × 2GiB 余量：总量 16GiB，但没有一张卡放得下 16GiB
+	c := newTestK8sClient()
+	c.computeNodes["fragmented"] = newFragmentedComputeNode("fragmented", 8, 24, 2)
+	c.computeNodes["whole"] = newFragmentedComputeNode("whole", 1, 24, 16)
+	plugin := NewFilterPlugin(c)
+
+	state := framework.NewCycleState()
+	state.Write(stateKey, &stateData{request: &ComputeRequest{VRAMBytes: 16 * 1024 * 1024 * 1024}})
+	pod := createTestPod(16, 0)
+
+	status := plugin.Filter(context.Background(), state, pod,
+		framework.NewNodeInfo(&v1.Node{ObjectMeta: metav1.ObjectMeta{Name: "fragmented"}}))
+	if status.Code != framework.Unschedulable {
+		t.Errorf("Expected Unschedulable for fragmented node, got %d: %s", status.Code, status.Message)
+	}
+
+	status = plugin.Filter(context.Background(), state, pod,
+		framework.NewNodeInfo(&v1.Node{ObjectMeta: metav1.ObjectMeta{Name: "whole"}}))
+	if !status.IsSuccess() {
+		t.Errorf("Filter should succeed when one device has 16GiB free, got: %s", status.Message)
+	}
+}
+
+func TestScorePlugin_CalculateScore_BestFit(t *testing.T) {
+	plugin := &ScorePlugin{}
+	req := &ComputeRequest{VRAMBytes: 16 * 1024 * 1024 * 1024}
+
+	// 总余量同为 96GiB：一张卡恰好剩 16GiB 的节点应优于两张卡各剩 48GiB 的节点
+	tight := newFragmentedComputeNode("tight", 2, 80, 80)
+	tight.Status.Devices[0].VRAMUsed = 64 * 1024 * 1024 * 1024
+	even := newFragmentedComputeNode("even", 2, 80, 48)
+
+	tightScore := plugin.calculateScore(tight, req)
+	evenScore := plugin.calculateScore(even, req)
+	if tightScore <= evenScore {
+		t.Errorf("Best-fit node should score higher: tight %d, even %d", tightScore, evenScore)
+	}
+	if tightScore > MaxScore {
+		t.Errorf("Score should be <= %d, got %d", MaxScore, tightScore)
+	}
+}
+
+func TestReservePlugin_Reserve_PerDevice(t *testing.T) {
+	const gi = 1024 * 1024 * 1024
+	c := newTestK8sClient()
+	c.computeNodes["node"] = newFragmentedComputeNode("node", 2, 24, 20)
+	plugin := NewReservePlugin(c)
+
+	reserve := func(name string, vramGi uint64) *framework.Status {
+		state := framework.NewCycleState()
+		state.Write(stateKey, &stateData{request: &ComputeRequest{VRAMBytes: vramGi * gi}})
+		pod := &v1.Pod{ObjectMeta: metav1.ObjectMeta{Name: name, Namespace: "default"}}
+		return plugin.Reserve(context.Background(), state, pod, "node")
+	}
+
+	if status := reserve("pod1", 12); !status.IsSuccess() {
+		t.Fatalf("First reserve should succeed, got: %s", status.Message)
+	}
+	if status := reserve("pod2", 12); !status.IsSuccess() {
+		t.Fatalf("Second reserve should land on the other device, got: %s", status.Message)
+	}
+
+	devices := plugin.GetReservedDeviceVRAM("node")
+	if devices["gpu-0"] != 12*gi || devices["gpu-1"] != 12*gi {
+		t.Errorf("Expected 12GiB on each device, got %v", devices)
+	}
+
+	// 节点总余量还剩 16GiB，但每张卡只剩 8GiB
+	status := reserve("pod3", 10)
+	if status.Code != framework.Unschedulable {
+		t.Errorf("Expected Unschedulable for per-device shortfall, got %d: %s", status.Code, status.Message)
+	}
+}
+
+func TestReservationLedger_ConcurrentReserve(t *testing.T) {
+	const gi = 1024 * 1024 * 1024
+	ledger := NewReservationLedger()
+
+	// 64 个 Pod 争抢 32GiB，恰好 32 个成功
+	var wg sync.WaitGroup
+	var succeeded atomic.Int32
+	for i := 0; i < 64; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			_, err := ledger.Reserve(fmt.Sprintf("default/pod-%d", i), "node-1",
+				func(current *NodeReservations) (*PodReservation, error) {
+					if current.SubtractVRAM(32*gi) < gi {
+						return nil, fmt.Errorf("full")
+					}
+					return &PodReservation{VRAMBytes: gi, Devices: map[string]uint64{"gpu-0": gi}}, nil
+				})
+			if err == nil {
+				succeeded.Add(1)
+			}
+		}(i)
+	}
+	wg.Wait()
+
+	node := ledger.Node("node-1")
+	if succeeded.Load() != 32 || node.Pods != 32 || node.VRAMBytes != 32*gi || node.Devices["gpu-0"] != 32*gi {
+		t.Fatalf("Expected 32 reservations of 1GiB, got %d succeeded, %+v", succeeded.Load(), node)
+	}
+
+	for i := 0; i < 64; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			ledger.Release(fmt.Sprintf("default/pod-%d", i))
+		}(i)
+	}
+	wg.Wait()
+
+	node = ledger.Node("node-1")
+	if node.Pods != 0 || node.VRAMBytes != 0 || len(node.Devices) != 0 {
+		t.Errorf("Expected empty ledger after release, got %+v", node)
+	}
+}
+
+func TestReservationLedger_Settle(t *testing.T) {
+	const gi = 1024 * 1024 * 1024
+	ledger := NewReservationLedger()
+	ledger.Reserve("default/pod", "node-1", func(*NodeReservations) (*PodReservation, error) {
+		return &PodReservation{VRAMBytes: 16 * gi, Devices: map[string]uint64{"gpu-0": 16 * gi}}, nil
+	})
+
+	if ledger.Settle("default/pod", "node-2", 10*gi) {
+		t.Error("Settle should ignore usage reported by another node")
+	}
+
+	// 已使用 10GiB，只保留尚未使用的 6GiB
+	if !ledger.Settle("default/pod", "node-1", 10*gi) {
+		t.Fatal("Settle should adjust the reservation")
+	}
+	node := ledger.Node("node-1")
+	if node.VRAMBytes != 6*gi || node.Devices["gpu-0"] != 6*gi || node.Pods != 1 {
+		t.Errorf("Expected 6GiB left on gpu-0, got %+v", node)
+	}
+
+	// 使用量回落时按原始请求重新计算
+	ledger.Settle("default/pod", "node-1", 4*gi)
+	if got := ledger.Node("node-1").VRAMBytes; got != 12*gi {
+		t.Errorf("Expected 12GiB reserved, got %d", got)
+	}
+
+	// 使用量达到请求量后释放预留
+	if !ledger.Settle("default/pod", "node-1", 20*gi) {
+		t.Fatal("Settle should release the reservation")
+	}
+	if _, _, ok := ledger.Get("default/pod"); ok {
+		t.Error("Expected the entry to be released once usage reaches the request")
+	}
+	if node := ledger.Node("node-1"); node.Pods != 0 || node.VRAMBytes != 0 || len(node.Devices) != 0 {
+		t.Errorf("Expected empty ledger after release, got %+v", node)
+	}
+}
+
+func TestReservationLedger_Expire(t *testing.T) {
+	ledger := NewReservationLedger()
+	for _, key := range []string{"uid-1", "uid-2"} {
+		ledger.Reserve(key, "node-1", func(*NodeReservations) (*PodReservation, error) {
+			return &PodReservation{VRAMBytes: 1024}, nil
+		})
+	}
+
+	// 宽限期内不释放
+	if expired := ledger.Expire(time.Now().Add(-time.Hour), func(string, string) bool { return false }); len(expired) != 0 {
+		t.Errorf("Expected no expired reservations within the TTL, got %v", expired)
+	}
+
+	expired := ledger.Expire(time.Now().Add(time.Second), func(podKey, _ string) bool { return podKey == "uid-1" })
+	if len(expired) != 1 || expired[0] != "uid-2" {
+		t.Errorf("Expected only uid-2 to expire, got %v", expired)
+	}
+	if node := ledger.Node("node-1"); node.Pods != 1 || node.VRAMBytes != 1024 {
+		t.Errorf("Expected uid-1 to keep its reservation, got %+v", node)
+	}
+}
+
+func TestReservePlugin_Unreserve_OtherNode(t *testing.T) {
+	plugin := NewReservePlugin(nil)
+	seedReservation(plugin, "node-1", "default/test-pod", &PodReservation{VRAMBytes: 1024})
+
+	plugin.Unreserve(context.Background(), framework.NewCycleState(), createTestPod(1, 0), "node-2")
+	if plugin.GetTotalReservedVRAM("node-1") != 1024 {
+		t.Error("Unreserve on another node should keep the reservation")
+	}
+}
+
+func TestReservePlugin_Reconcile(t *testing.T) {
+	const gi = 1024 * 1024 * 1024
+	cache := NewComputeNodeCache()
+	cn := newFragmentedComputeNode("node", 2, 80, 80)
+	cache.Upsert(cn)
+
+	plugin := NewReservePlugin(nil)
+	state := framework.NewCycleState()
+	state.Write(stateKey, &stateData{request: &ComputeRequest{VRAMBytes: 16 * gi}})
+	state.Write(snapshotStateKey, cache.Snapshot())
+	pod := &v1.Pod{ObjectMeta: metav1.ObjectMeta{Name: "pod1", Namespace: "default", UID: "uid-1"}}
+	if status := plugin.Reserve(context.Background(), state, pod, "node"); !status.IsSuccess() {
+		t.Fatalf("Reserve should succeed, got: %s", status.Message)
+	}
+
+	ctx, cancel := context.WithCancel(context.Background())
+	defer cancel()
+	go plugin.RunReconciler(ctx, cache, 10*time.Millisecond, time.Hour)
+
+	// 拦截器上报 Pod 已使用 12GiB，设备用量随之增加
+	updated := cn.DeepCopy()
+	updated.Status.Devices[0].VRAMUsed = 12 * gi
+	updated.Status.Workloads = []v1alpha1.WorkloadUsage{
+		{PodUID: "uid-1", Namespace: "default", Name: "pod1", Processes: 1, VRAMUsed: 12 * gi},
+		{PodUID: "uid-2", VRAMUsed: 8 * gi}, // eBPF 追踪条目，没有名称
+	}
+	cache.Upsert(updated)
+
+	deadline := time.Now().Add(5 * time.Second)
+	for plugin.GetTotalReservedVRAM("node") != 4*gi {
+		if time.Now().After(deadline) {
+			t.Fatalf("Expected reservation to settle at 4GiB, got %d", plugin.GetTotalReservedVRAM("node"))
+		}
+		time.Sleep(5 * time.Millisecond)
+	}
+	if res, _, _ := plugin.ledger.Get("uid-1"); res.Devices["gpu-0"] != 4*gi {
+		t.Errorf("Expected 4GiB left on gpu-0, got %v", res.Devices)
+	}
+}
+
+func TestReservePlugin_Expire(t *testing.T) {
+	cache := NewComputeNodeCache()
+	cn := newFragmentedComputeNode("node", 2, 80, 80)
+	cn.Status.Workloads = []v1alpha1.WorkloadUsage{{PodUID: "uid-running", VRAMUsed: 1024}}
+	cache.Upsert(cn)
+
+	plugin := NewReservePlugin(nil)
+	seedReservation(plugin, "node", "uid-running", &PodReservation{VRAMBytes: 4096})
+	seedReservation(plugin, "node", "uid-gone", &PodReservation{VRAMBytes: 2048})
+	seedReservation(plugin, "deleted-node", "uid-orphan", &PodReservation{VRAMBytes: 1024})
+
+	plugin.Expire(cache.Snapshot(), time.Now().Add(time.Second))
+	if _, _, ok := plugin.ledger.Get("uid-running"); !ok {
+		t.Error("Reservation of a reported pod should be kept")
+	}
+	if plugin.GetTotalReservedVRAM("node") != 4096 || plugin.GetTotalReservedVRAM("deleted-node") != 0 {
+		t.Errorf("Expected unreported reservations to be released, got node=%d deleted-node=%d",
+			plugin.GetTotalReservedVRAM("node"), plugin.GetTotalReservedVRAM("deleted-node"))
+	}
+}
+
+func TestReservePlugin_Reserve_RecreatedPod(t *testing.T) {
+	plugin := NewReservePlugin(newMockClient())
+	state := framework.NewCycleState()
+	state.Write(stateKey, &stateData{request: &ComputeRequest{VRAMBytes: 1024}})
+
+	// 同名 Pod 重建后 UID 不同，不能命中旧预留
+	old := createTestPod(1, 0)
+	old.UID = "uid-old"
+	recreated := old.DeepCopy()
+	recreated.UID = "uid-new"
+	for _, pod := range []*v1.Pod{old, recreated} {
+		if status := plugin.Reserve(context.Background(), state, pod, "node-1"); !status.IsSuccess() {
+			t.Fatalf("Reserve should succeed, got: %s", status.Message)
+		}
+	}
+	if pods := plugin.ledger.Node("node-1").Pods; pods != 2 {
+		t.Errorf("Expected separate reservations for the recreated pod, got %d", pods)
+	}
 }
@@ -3,7 +3,7 @@ package plugins
 import (
 	"context"
 	"fmt"
-	"sync"
+	"time"
 
 	v1 "k8s.io/api/core/v1"
 	"k8s.io/klog/v2"
@@ -18,26 +18,29 @@ const (
 	ReservePluginName = "HCSComputeReserve"
 )
 
+const (
+	// DefaultReconcileInterval 预留与实际用量对账的默认间隔
+	DefaultReconcileInterval = 5 * time.Second
+
+	// DefaultReservationTTL 预留的宽限期，超过后 Pod 仍未出现在节点上报的负载中则释放预留
+	DefaultReservationTTL = 5 * time.Minute
+)
+
 // ReservePlugin HCS 资源预留插件
 type ReservePlugin struct {
 	client client.Client
 
-	// reservations 存储每个节点的资源预留
-	// key: nodeName, value: 预留的资源量
-	reservations map[string]*Reservation
-	mu           sync.RWMutex
-}
-
-// Reservation 资源预留
-type Reservation struct {
-	// Pods 存储在该节点预留的 Pod
-	Pods map[string]*PodReservation
+	// ledger 按节点汇总的预留，读取无锁
+	ledger *ReservationLedger
 }
 
 // PodReservation Pod 资源预留
 type PodReservation struct {
 	VRAMBytes  uint64
 	FP16TFLOPS uint64
+
+	// Devices 各设备上预留的 VRAM（设备 ID -> bytes），节点未上报设备容量时为 nil
+	Devices map[string]uint64
 }
 
 var _ framework.ReservePlugin = &ReservePlugin{}
@@ -45,8 +48,8 @@ var _ framework.ReservePlugin = &ReservePlugin{}
 // NewReservePlugin 创建预留插件
 func NewReservePlugin(c client.Client) *ReservePlugin {
 	return &ReservePlugin{
-		client:       c,
-		reservations: make(map[string]*Reservation),
+		client: c,
+		ledger: NewReservationLedger(),
 	}
 }
 
@@ -67,41 +70,52 @@ func (p *ReservePlugin) Reserve(ctx context.Context, state *framework.CycleState
 	req := data.(*stateData).request
 	podKey := getPodKey(pod)
 
-	p.mu.Lock()
-	defer p.mu.Unlock()
-
-	// 获取或创建节点的预留记录
-	reservation, ok := p.reservations[nodeName]
-	if !ok {
-		reservation = &Reservation{
-			Pods: make(map[string]*PodReservation),
-		}
-		p.reservations[nodeName] = reservation
-	}
-
 	// 检查是否已存在预留（幂等性）
-	if _, exists := reservation.Pods[podKey]; exists {
+	if _, reservedOn, ok := p.ledger.Get(podKey); ok && reservedOn == nodeName {
 		klog.V(2).Infof("Reservation already exists for pod %s on node %s", podKey, nodeName)
 		return framework.NewStatus(framework.Success, "")
 	}
 
 	// 验证资源是否足够（包含已预留的资源）
-	cn, err := p.getComputeNode(ctx, nodeName)
+	node, err := lookupNode(ctx, state, nodeName, p.getComputeNode)
 	if err != nil {
 		return framework.NewStatus(framework.Error, fmt.Sprintf("failed to get ComputeNode: %v", err))
 	}
-
-	availableVRAM := p.calculateAvailableVRAMWithReservation(cn, nodeName)
-	if req.VRAMBytes > 0 && availableVRAM < req.VRAMBytes {
-		return framework.NewStatus(framework.Unschedulable,
-			fmt.Sprintf("insufficient VRAM after reservation: requested %d, available %d",
-				req.VRAMBytes, availableVRAM))
+	if node == nil {
+		return framework.NewStatus(framework.Error, "node does not have ComputeNode resource")
 	}
 
-	// 创建预留
-	reservation.Pods[podKey] = &PodReservation{
-		VRAMBytes:  req.VRAMBytes,
-		FP16TFLOPS: req.FP16TFLOPS,
+	existed, err := p.ledger.Reserve(podKey, nodeName, func(current *NodeReservations) (*PodReservation, error) {
+		availableVRAM := current.SubtractVRAM(node.AvailableVRAM)
+		if req.VRAMBytes > 0 && availableVRAM < req.VRAMBytes {
+			return nil, fmt.Errorf("insufficient VRAM after reservation: requested %d, available %d",
+				req.VRAMBytes, availableVRAM)
+		}
+
+		// 按设备放置，扣除其他 Pod 在各设备上的预留
+		var devices map[string]uint64
+		if req.VRAMBytes > 0 && node.DeviceVRAM != nil {
+			free := subtractDeviceReserved(node.DeviceVRAM, current.Devices)
+			assignment, ok := placeVRAM(free, req.vramRequests())
+			if !ok {
+				return nil, fmt.Errorf("insufficient VRAM per device after reservation: requested %v, free %v",
+					req.vramRequests(), deviceFreeList(free))
+			}
+			devices = assignment
+		}
+
+		return &PodReservation{
+			VRAMBytes:  req.VRAMBytes,
+			FP16TFLOPS: req.FP16TFLOPS,
+			Devices:    devices,
+		}, nil
+	})
+	if err != nil {
+		return framework.NewStatus(framework.Unschedulable, err.Error())
+	}
+	if existed {
+		klog.V(2).Infof("Reservation already exists for pod %s on node %s", podKey, nodeName)
+		return framework.NewStatus(framework.Success, "")
 	}
 
 	klog.V(2).Infof("Reserved resources for pod %s on node %s: VRAM=%d, FP16TFLOPS=%d",
@@ -114,75 +128,106 @@ func (p *ReservePlugin) Reserve(ctx context.Context, state *framework.CycleState
 func (p *ReservePlugin) Unreserve(ctx context.Context, state *framework.CycleState, pod *v1.Pod, nodeName string) {
 	podKey := getPodKey(pod)
 
-	p.mu.Lock()
-	defer p.mu.Unlock()
-
-	reservation, ok := p.reservations[nodeName]
-	if !ok {
+	// 只释放该节点上的预留
+	if _, reservedOn, ok := p.ledger.Get(podKey); !ok || reservedOn != nodeName {
 		return
 	}
-
-	if _, exists := reservation.Pods[podKey]; exists {
-		delete(reservation.Pods, podKey)
+	if _, ok := p.ledger.Release(podKey); ok {
 		klog.V(2).Infof("Unreserved resources for pod %s on node %s", podKey, nodeName)
 	}
-
-	// 如果节点没有任何预留，清理记录
-	if len(reservation.Pods) == 0 {
-		delete(p.reservations, nodeName)
-	}
 }
 
 // calculateAvailableVRAMWithReservation 计算考虑预留后的可用 VRAM
 func (p *ReservePlugin) calculateAvailableVRAMWithReservation(cn *v1alpha1.ComputeNode, nodeName string) uint64 {
-	// 计算实际使用量
-	var totalUsed uint64
-	for _, dev := range cn.Status.Devices {
-		totalUsed += dev.VRAMUsed
-	}
-
-	// 加上已预留的量
-	if reservation, ok := p.reservations[nodeName]; ok {
-		for _, podRes := range reservation.Pods {
-			totalUsed += podRes.VRAMBytes
-		}
-	}
+	return p.ledger.Node(nodeName).SubtractVRAM(availableVRAM(cn))
+}
 
-	if cn.Spec.TotalCapacity.VRAM > totalUsed {
-		return cn.Spec.TotalCapacity.VRAM - totalUsed
-	}
-	return 0
+// GetReservedDeviceVRAM 获取节点上各设备预留的 VRAM（设备 ID -> bytes），结果只读
+func (p *ReservePlugin) GetReservedDeviceVRAM(nodeName string) map[string]uint64 {
+	return p.ledger.Node(nodeName).Devices
 }
 
 // GetTotalReservedVRAM 获取节点上预留的总 VRAM
 func (p *ReservePlugin) GetTotalReservedVRAM(nodeName string) uint64 {
-	p.mu.RLock()
-	defer p.mu.RUnlock()
-
-	var total uint64
-	if reservation, ok := p.reservations[nodeName]; ok {
-		for _, podRes := range reservation.Pods {
-			total += podRes.VRAMBytes
-		}
-	}
-	return total
+	return p.ledger.Node(nodeName).VRAMBytes
 }
 
 // ClearPodReservation 清除指定 Pod 的预留（Pod 启动成功后调用）
 func (p *ReservePlugin) ClearPodReservation(podKey string) {
-	p.mu.Lock()
-	defer p.mu.Unlock()
+	if nodeName, ok := p.ledger.Release(podKey); ok {
+		klog.V(2).Infof("Cleared reservation for pod %s on node %s", podKey, nodeName)
+	}
+}
 
-	for nodeName, reservation := range p.reservations {
-		if _, exists := reservation.Pods[podKey]; exists {
-			delete(reservation.Pods, podKey)
-			klog.V(2).Infof("Cleared reservation for pod %s on node %s", podKey, nodeName)
+// Reconcile 按 ComputeNode 上报的 Pod 实际显存使用收缩预留
+// 拦截器统计到的用量已计入设备的 VRAMUsed，继续按请求量预留会重复扣除
+func (p *ReservePlugin) Reconcile(node *NodeSnapshot) {
+	nodeName := node.ComputeNode.Name
+	for _, w := range node.ComputeNode.Status.Workloads {
+		if w.PodUID == "" {
+			continue
+		}
+		if p.ledger.Settle(w.PodUID, nodeName, w.VRAMUsed) {
+			klog.V(4).Infof("Settled reservation for pod %s on node %s: used %d", w.PodUID, nodeName, w.VRAMUsed)
+		}
+	}
+}
 
-			if len(reservation.Pods) == 0 {
-				delete(p.reservations, nodeName)
+// Expire 释放 before 之前创建、但 Pod 未出现在所在节点上报负载中的预留
+// Pod 已结束、被删除或绑定失败时不会再有 Unreserve，只能由此回收
+func (p *ReservePlugin) Expire(snapshot *Snapshot, before time.Time) {
+	workloads := make(map[string]map[string]bool)
+	expired := p.ledger.Expire(before, func(podKey, nodeName string) bool {
+		pods, ok := workloads[nodeName]
+		if !ok {
+			pods = make(map[string]bool)
+			if node := snapshot.Get(nodeName); node != nil {
+				for _, w := range node.ComputeNode.Status.Workloads {
+					pods[w.PodUID] = true
+				}
 			}
+			workloads[nodeName] = pods
+		}
+		return pods[podKey]
+	})
+	for _, podKey := range expired {
+		klog.V(2).Infof("Released expired reservation for pod %s", podKey)
+	}
+}
+
+// RunReconciler 周期性地对缓存中发生变化的节点执行 Reconcile，并释放超过 ttl 的预留，直到 ctx 结束
+func (p *ReservePlugin) RunReconciler(ctx context.Context, cache *ComputeNodeCache, interval, ttl time.Duration) {
+	ticker := time.NewTicker(interval)
+	defer ticker.Stop()
+
+	var last *Snapshot
+	seen := make(map[string]*NodeSnapshot)
+	for {
+		select {
+		case <-ctx.Done():
 			return
+		case <-ticker.C:
 		}
+
+		// 快照不可变，两次对账之间没有事件时跳过对账
+		snapshot := cache.Snapshot()
+		if snapshot != last {
+			last = snapshot
+			for name, node := range snapshot.nodes {
+				if seen[name] != node {
+					p.Reconcile(node)
+					seen[name] = node
+				}
+			}
+			for name := range seen {
+				if snapshot.Get(name) == nil {
+					delete(seen, name)
+				}
+			}
+		}
+
+		// 过期与快照是否变化无关，每次都检查
+		p.Expire(snapshot, time.Now().Add(-ttl))
 	}
 }
 
@@ -201,6 +246,11 @@ func (p *ReservePlugin) getComputeNode(ctx context.Context, nodeName string) (*v
 }
 
 // getPodKey 获取 Pod 唯一键
+// 使用 UID：同名 Pod 重建后不会沿用旧预留，且与节点上报的 WorkloadUsage.PodUID 一致；
+// 尚未持久化、没有 UID 的 Pod 退回 namespace/name
 func getPodKey(pod *v1.Pod) string {
+	if pod.UID != "" {
+		return string(pod.UID)
+	}
 	return fmt.Sprintf("%s/%s", pod.Namespace, pod.Name)
 }
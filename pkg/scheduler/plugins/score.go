@@ -57,13 +57,13 @@ func (p *ScorePlugin) Score(ctx context.Context, state *framework.CycleState, po
 	req := data.(*stateData).request
 
 	// 获取 ComputeNode
-	cn, err := p.getComputeNode(ctx, nodeName)
-	if err != nil || cn == nil {
+	node, err := lookupNode(ctx, state, nodeName, p.getComputeNode)
+	if err != nil || node == nil {
 		return 0, framework.NewStatus(framework.Success, "")
 	}
 
 	// 计算综合分数
-	score := p.calculateScore(cn, req)
+	score := p.scoreNode(node, req)
 
 	return score, framework.NewStatus(framework.Success, "")
 }
@@ -104,77 +104,95 @@ func (p *ScorePlugin) NormalizeScore(ctx context.Context, state *framework.Cycle
 
 // calculateScore 计算节点分数
 func (p *ScorePlugin) calculateScore(cn *v1alpha1.ComputeNode, req *ComputeRequest) int64 {
+	return p.scoreNode(newNodeSnapshot(cn), req)
+}
+
+// scoreNode 基于节点快照中预先计算的派生值打分
+func (p *ScorePlugin) scoreNode(node *NodeSnapshot, req *ComputeRequest) int64 {
 	var score int64 = 0
 
 	// 获取节点硬件信息
+	cn := node.ComputeNode
 	vendor := cn.Spec.Vendor
-	model := p.getDeviceModel(cn)
+	model := node.DeviceModel
 	deviceCount := len(cn.Status.Devices)
 
-	// 1. 使用汇率归一化计算分数（40%权重）
+	// 1. 使用汇率归一化计算分数（30%权重）
 	// 归一化后的分数反映跨厂商的等效算力
 	if vendor != "" && model != "" && deviceCount > 0 {
-		normalized, err := p.calculator.NormalizeCompute(vendor, model, deviceCount)
-		if err == nil {
+		normalizedTFLOPS, normalizedVRAM, ok := p.calculator.Normalize(vendor, model, deviceCount)
+		if ok {
 			// 归一化算力分数：综合 TFLOPS 和 VRAM
-			computeRatio := normalized.NormalizedTFLOPS
+			computeRatio := normalizedTFLOPS
 			if computeRatio > 1.0 {
 				computeRatio = 1.0 // 上限为 1.0
 			}
-			score += int64(computeRatio * 25) // 25% for normalized compute
+			score += int64(computeRatio * 20) // 20% for normalized compute
 
-			memoryRatio := normalized.NormalizedVRAM
+			memoryRatio := normalizedVRAM
 			if memoryRatio > 1.0 {
 				memoryRatio = 1.0
 			}
-			score += int64(memoryRatio * 15) // 15% for normalized memory
+			score += int64(memoryRatio * 10) // 10% for normalized memory
 		} else {
 			// 归一化失败，使用原始 VRAM 比例作为后备
-			availableVRAM := p.calculateAvailableVRAM(cn)
+			availableVRAM := node.AvailableVRAM
 			totalVRAM := cn.Spec.TotalCapacity.VRAM
 			if totalVRAM > 0 {
 				vramRatio := float64(availableVRAM) / float64(totalVRAM)
-				score += int64(vramRatio * 40)
+				score += int64(vramRatio * 30)
 			}
 		}
 	} else {
 		// 没有硬件信息，使用原始 VRAM 余量
-		availableVRAM := p.calculateAvailableVRAM(cn)
+		availableVRAM := node.AvailableVRAM
 		totalVRAM := cn.Spec.TotalCapacity.VRAM
 		if totalVRAM > 0 {
 			vramRatio := float64(availableVRAM) / float64(totalVRAM)
-			score += int64(vramRatio * 40)
+			score += int64(vramRatio * 30)
 		}
 	}
 
-	// 2. 健康分数（30%权重）
-	avgHealth := p.calculateAverageHealth(cn)
-	score += int64(avgHealth * 0.3)
+	// 2. 健康分数（25%权重）
+	score += int64(node.AverageHealth * 0.25)
 
-	// 3. 算力匹配分数（20%权重）
+	// 3. 算力匹配分数（15%权重）
 	// 优先选择算力更匹配的节点，避免资源浪费
 	if req.FP16TFLOPS > 0 && cn.Spec.TotalCapacity.FP16TFLOPS > 0 {
 		matchRatio := float64(req.FP16TFLOPS) / float64(cn.Spec.TotalCapacity.FP16TFLOPS)
 		// 匹配度越接近 1（不超过1），分数越高
 		if matchRatio <= 1 {
-			score += int64(matchRatio * 20)
+			score += int64(matchRatio * 15)
 		}
 	} else {
-		score += 10 // 没有特定算力需求，给基础分
+		score += 7 // 没有特定算力需求，给基础分
 	}
 
 	// 4. 互联类型加分（10%权重）
 	// NVLink 节点优先
-	for _, dev := range cn.Status.Devices {
-		if dev.InterconnectType == "NVLink" {
-			score += 10
-			break
-		}
+	if node.HasNVLink {
+		score += 10
 	}
 
+	// 5. 设备级装箱分数（20%权重）
+	// 优先放进余量最贴合的设备，保留完整的大块显存给后续的大任务
+	score += int64(packingRatio(node, req) * 20)
+
 	return score
 }
 
+// packingRatio 请求在节点设备上的装箱得分（0-1），无法按设备评估时取中间值
+func packingRatio(node *NodeSnapshot, req *ComputeRequest) float64 {
+	if req.VRAMBytes == 0 || node.DeviceVRAM == nil {
+		return 0.5
+	}
+	assignment, ok := placeVRAM(node.DeviceVRAM, req.vramRequests())
+	if !ok {
+		return 0
+	}
+	return packingScore(node.DeviceVRAM, assignment)
+}
+
 // getDeviceModel 从 ComputeNode 获取设备型号
 func (p *ScorePlugin) getDeviceModel(cn *v1alpha1.ComputeNode) string {
 	if len(cn.Status.Devices) > 0 {
@@ -185,27 +203,12 @@ func (p *ScorePlugin) getDeviceModel(cn *v1alpha1.ComputeNode) string {
 
 // calculateAvailableVRAM 计算可用 VRAM
 func (p *ScorePlugin) calculateAvailableVRAM(cn *v1alpha1.ComputeNode) uint64 {
-	var totalUsed uint64
-	for _, dev := range cn.Status.Devices {
-		totalUsed += dev.VRAMUsed
-	}
-	if cn.Spec.TotalCapacity.VRAM > totalUsed {
-		return cn.Spec.TotalCapacity.VRAM - totalUsed
-	}
-	return 0
+	return availableVRAM(cn)
 }
 
 // calculateAverageHealth 计算平均健康分
 func (p *ScorePlugin) calculateAverageHealth(cn *v1alpha1.ComputeNode) float64 {
-	if len(cn.Status.Devices) == 0 {
-		return 100.0
-	}
-
-	var total float64
-	for _, dev := range cn.Status.Devices {
-		total += dev.HealthScore
-	}
-	return total / float64(len(cn.Status.Devices))
+	return averageHealth(cn)
 }
 
 // getComputeNode 获取 ComputeNode
@@ -0,0 +1,208 @@
+package plugins
+
+import (
+	"context"
+	"fmt"
+	"sync"
+
+	toolscache "k8s.io/client-go/tools/cache"
+	"k8s.io/klog/v2"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
+	"github.com/zrs-products/hetero-compute-router/pkg/scheduler/framework"
+)
+
+// snapshotStateKey CycleState 中节点快照的键
+const snapshotStateKey = "HCSComputeNodeSnapshot"
+
+// NodeSnapshot 单个 ComputeNode 及其派生值，在对象变化时计算一次
+// ComputeNode 与 informer 缓存共享，只读
+type NodeSnapshot struct {
+	ComputeNode   *v1alpha1.ComputeNode
+	Ready         bool
+	AvailableVRAM uint64  // bytes，总容量减去各设备已用量
+	AverageHealth float64 // 各设备健康分均值，无设备时为 100
+	DeviceModel   string  // 首个设备的型号
+	HasNVLink     bool
+	DeviceVRAM    []DeviceVRAM // 各设备显存余量，设备未上报容量时为 nil
+}
+
+// newNodeSnapshot 计算 ComputeNode 的派生值
+func newNodeSnapshot(cn *v1alpha1.ComputeNode) *NodeSnapshot {
+	s := &NodeSnapshot{
+		ComputeNode:   cn,
+		Ready:         cn.Status.Phase == v1alpha1.ComputeNodePhaseReady,
+		AvailableVRAM: availableVRAM(cn),
+		AverageHealth: averageHealth(cn),
+		DeviceVRAM:    deviceVRAM(cn),
+	}
+	if len(cn.Status.Devices) > 0 {
+		s.DeviceModel = cn.Status.Devices[0].Model
+	}
+	for _, dev := range cn.Status.Devices {
+		if dev.InterconnectType == "NVLink" {
+			s.HasNVLink = true
+			break
+		}
+	}
+	return s
+}
+
+// availableVRAM 计算可用 VRAM
+func availableVRAM(cn *v1alpha1.ComputeNode) uint64 {
+	var totalUsed uint64
+	for _, dev := range cn.Status.Devices {
+		totalUsed += dev.VRAMUsed
+	}
+	if cn.Spec.TotalCapacity.VRAM > totalUsed {
+		return cn.Spec.TotalCapacity.VRAM - totalUsed
+	}
+	return 0
+}
+
+// averageHealth 计算平均健康分
+func averageHealth(cn *v1alpha1.ComputeNode) float64 {
+	if len(cn.Status.Devices) == 0 {
+		return 100.0
+	}
+
+	var total float64
+	for _, dev := range cn.Status.Devices {
+		total += dev.HealthScore
+	}
+	return total / float64(len(cn.Status.Devices))
+}
+
+// Snapshot 某一时刻全部 ComputeNode 的不可变视图，一个调度周期内的各插件共享
+type Snapshot struct {
+	nodes map[string]*NodeSnapshot
+}
+
+var _ framework.StateData = &Snapshot{}
+
+// Get 返回节点的快照，不存在时返回 nil
+func (s *Snapshot) Get(nodeName string) *NodeSnapshot {
+	return s.nodes[nodeName]
+}
+
+// Len 返回快照中的节点数
+func (s *Snapshot) Len() int {
+	return len(s.nodes)
+}
+
+// Clone 快照不可变，直接共享
+func (s *Snapshot) Clone() framework.StateData {
+	return s
+}
+
+// ComputeNodeInformer ComputeNode 事件来源，controller-runtime 的 cache.Informer 满足该接口
+type ComputeNodeInformer interface {
+	AddEventHandler(handler toolscache.ResourceEventHandler) (toolscache.ResourceEventHandlerRegistration, error)
+}
+
+// ComputeNodeCache 由 informer 事件维护的 ComputeNode 缓存
+//
+// 事件处理时即计算派生值并使当前快照失效；Snapshot() 仅在失效后复制一份新的
+// 不可变视图，两次变更之间的所有调度周期共享同一份快照，Filter/Score 不再访问 API Server。
+type ComputeNodeCache struct {
+	mu       sync.Mutex
+	nodes    map[string]*NodeSnapshot
+	snapshot *Snapshot // nil 表示自上次快照后有变更
+}
+
+// NewComputeNodeCache 创建 ComputeNode 缓存
+func NewComputeNodeCache() *ComputeNodeCache {
+	return &ComputeNodeCache{
+		nodes: make(map[string]*NodeSnapshot),
+	}
+}
+
+// AddToInformer 订阅 informer 的 ComputeNode 事件
+func (c *ComputeNodeCache) AddToInformer(informer ComputeNodeInformer) error {
+	_, err := informer.AddEventHandler(toolscache.ResourceEventHandlerFuncs{
+		AddFunc: c.onUpsert,
+		UpdateFunc: func(_, newObj interface{}) {
+			c.onUpsert(newObj)
+		},
+		DeleteFunc: c.onDelete,
+	})
+	return err
+}
+
+func (c *ComputeNodeCache) onUpsert(obj interface{}) {
+	cn, ok := obj.(*v1alpha1.ComputeNode)
+	if !ok {
+		klog.Warningf("Unexpected object in ComputeNode informer: %T", obj)
+		return
+	}
+	c.Upsert(cn)
+}
+
+func (c *ComputeNodeCache) onDelete(obj interface{}) {
+	// 错过删除事件时 informer 投递 tombstone
+	if tombstone, ok := obj.(toolscache.DeletedFinalStateUnknown); ok {
+		obj = tombstone.Obj
+	}
+	cn, ok := obj.(*v1alpha1.ComputeNode)
+	if !ok {
+		klog.Warningf("Unexpected object in ComputeNode informer: %T", obj)
+		return
+	}
+	c.Delete(cn.Name)
+}
+
+// Upsert 写入或替换 ComputeNode，cn 此后不得再被修改
+func (c *ComputeNodeCache) Upsert(cn *v1alpha1.ComputeNode) {
+	s := newNodeSnapshot(cn)
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.nodes[cn.Name] = s
+	c.snapshot = nil
+}
+
+// Delete 删除 ComputeNode
+func (c *ComputeNodeCache) Delete(name string) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if _, ok := c.nodes[name]; ok {
+		delete(c.nodes, name)
+		c.snapshot = nil
+	}
+}
+
+// Snapshot 返回当前的不可变快照
+func (c *ComputeNodeCache) Snapshot() *Snapshot {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	if c.snapshot == nil {
+		nodes := make(map[string]*NodeSnapshot, len(c.nodes))
+		for name, s := range c.nodes {
+			nodes[name] = s
+		}
+		c.snapshot = &Snapshot{nodes: nodes}
+	}
+	return c.snapshot
+}
+
+// lookupNode 返回节点快照：优先使用 PreFilter 写入的周期快照，
+// 未配置缓存时回退到 get 直接读取
+func lookupNode(ctx context.Context, state *framework.CycleState, nodeName string,
+	get func(context.Context, string) (*v1alpha1.ComputeNode, error)) (*NodeSnapshot, error) {
+	if data, err := state.Read(snapshotStateKey); err == nil {
+		if s := data.(*Snapshot).Get(nodeName); s != nil {
+			return s, nil
+		}
+		return nil, fmt.Errorf("ComputeNode %s not found", nodeName)
+	}
+
+	cn, err := get(ctx, nodeName)
+	if err != nil {
+		return nil, err
+	}
+	if cn == nil {
+		return nil, nil
+	}
+	return newNodeSnapshot(cn), nil
+}
@@ -17,6 +17,28 @@ const (
 	HCSInjectAnnotation = "hcs.io/vram-inject"
 )
 
+// Shared stats page settings. Each pod gets its own subdirectory of the
+// host stats path, mounted at HCSStatsMountPath in every injected container;
+// the node-agent reads the pages from the host side.
+const (
+	HCSStatsDirEnvVar   = "HCS_STATS_DIR"
+	HCSPodUIDEnvVar     = "HCS_POD_UID"
+	HCSStatsVolumeName  = "hcs-stats"
+	HCSStatsMountPath   = "/var/run/hcs/stats"
+	DefaultStatsHostDir = "/dev/shm/hcs"
+)
+
+// Shared quota pool settings. With the pool annotation set to "true", every
+// injected process in the pod reserves against one quota kept in a file on
+// a shared in-memory volume, instead of each process getting its own.
+const (
+	HCSQuotaPoolAnnotation = "hcs.io/vram-pool"
+	HCSQuotaPoolEnvVar     = "HCS_QUOTA_POOL"
+	HCSPoolVolumeName      = "hcs-pool"
+	HCSPoolMountPath       = "/var/run/hcs/pool"
+	HCSPoolFileName        = "quota"
+)
+
 // HCSInjectionResult contains the result of HCS injection operation
 type HCSInjectionResult struct {
 	// Injected indicates if any injection was performed
@@ -43,6 +65,10 @@ type HCSInjector struct {
 	// containerLibPath is the path inside the container where HCS libraries are mounted
 	containerLibPath string
 
+	// statsHostPath is the host directory for interceptor stats pages;
+	// empty disables the stats page
+	statsHostPath string
+
 	// skipContainers is a list of container names to skip during injection
 	skipContainers map[string]bool
 
@@ -74,6 +100,14 @@ func WithContainerLibPath(path string) HCSInjectorOption {
 	}
 }
 
+// WithStatsHostPath sets the host directory for interceptor stats pages.
+// An empty path disables the stats page.
+func WithStatsHostPath(path string) HCSInjectorOption {
+	return func(h *HCSInjector) {
+		h.statsHostPath = path
+	}
+}
+
 // WithHCSSkipContainers sets container names to skip during HCS injection
 func WithHCSSkipContainers(names ...string) HCSInjectorOption {
 	return func(h *HCSInjector) {
@@ -96,6 +130,7 @@ func NewHCSInjector(opts ...HCSInjectorOption) *HCSInjector {
 		interceptorPath:  "/usr/local/hcs/lib/libhcs_interceptor.so",
 		hostLibPath:      "/usr/local/hcs/lib",
 		containerLibPath: "/usr/local/hcs/lib",
+		statsHostPath:    DefaultStatsHostDir,
 		skipContainers:   make(map[string]bool),
 		enabled:          true,
 	}
@@ -133,8 +168,10 @@ func (h *HCSInjector) InjectHCS(pod *corev1.Pod) (*HCSInjectionResult, error) {
 		}
 	}
 
+	pooled := pod.Annotations[HCSQuotaPoolAnnotation] == "true"
+
 	// Extract VRAM quota from pod
-	vramQuota := h.extractVRAMQuota(pod)
+	vramQuota := h.extractVRAMQuota(pod, pooled)
 	if vramQuota == "" {
 		return result, nil
 	}
@@ -148,6 +185,9 @@ func (h *HCSInjector) InjectHCS(pod *corev1.Pod) (*HCSInjectionResult, error) {
 		}
 
 		h.injectContainer(container, vramQuota)
+		if pooled {
+			h.injectQuotaPool(container)
+		}
 		result.ContainersInjected++
 	}
 
@@ -159,10 +199,19 @@ func (h *HCSInjector) InjectHCS(pod *corev1.Pod) (*HCSInjectionResult, error) {
 		}
 
 		h.injectContainer(container, vramQuota)
+		if pooled {
+			h.injectQuotaPool(container)
+		}
 	}
 
-	// Add volume to pod spec
+	// Add volumes to pod spec
 	h.injectVolume(pod)
+	if h.statsHostPath != "" {
+		h.injectStatsVolume(pod)
+	}
+	if pooled {
+		h.injectPoolVolume(pod)
+	}
 
 	result.Injected = result.ContainersInjected > 0
 
@@ -180,7 +229,9 @@ func (h *HCSInjector) InjectHCS(pod *corev1.Pod) (*HCSInjectionResult, error) {
 
 // extractVRAMQuota extracts the VRAM quota from pod resource requests.
 // It returns the quota as a string suitable for HCS_VRAM_QUOTA env var.
-func (h *HCSInjector) extractVRAMQuota(pod *corev1.Pod) string {
+// Without a pool each process may use the largest container request; a
+// pool covers the whole pod, so the container requests are summed.
+func (h *HCSInjector) extractVRAMQuota(pod *corev1.Pod, pooled bool) string {
 	// Check annotation override first
 	if pod.Annotations != nil {
 		if quota, ok := pod.Annotations["hcs.io/vram-quota"]; ok && quota != "" {
@@ -188,12 +239,16 @@ func (h *HCSInjector) extractVRAMQuota(pod *corev1.Pod) string {
 		}
 	}
 
-	// Find the maximum VRAM request across all containers
+	// Find the maximum (or, pooled, total) VRAM request across all containers
 	var maxVRAM *resource.Quantity
 
 	for _, container := range pod.Spec.Containers {
 		if quota := h.getContainerVRAMRequest(container); quota != nil {
-			if maxVRAM == nil || quota.Cmp(*maxVRAM) > 0 {
+			if maxVRAM == nil {
+				maxVRAM = quota.DeepCopy()
+			} else if pooled {
+				maxVRAM.Add(*quota)
+			} else if quota.Cmp(*maxVRAM) > 0 {
 				maxVRAM = quota
 			}
 		}
@@ -236,6 +291,12 @@ func (h *HCSInjector) injectContainer(container *corev1.Container, vramQuota str
 
 	// Inject volume mount
 	h.injectVolumeMount(container)
+
+	// Inject stats page settings
+	if h.statsHostPath != "" {
+		h.injectStatsEnv(container)
+		h.injectStatsVolumeMount(container)
+	}
 }
 
 // injectLDPreload injects or appends to LD_PRELOAD environment variable
@@ -315,6 +376,117 @@ func (h *HCSInjector) injectVolume(pod *corev1.Pod) {
 	})
 }
 
+// injectStatsEnv injects the environment the interceptor needs to publish
+// its stats page: the stats directory and the pod identity from the
+// downward API. Existing values are left untouched.
+func (h *HCSInjector) injectStatsEnv(container *corev1.Container) {
+	fieldEnv := func(name, fieldPath string) corev1.EnvVar {
+		return corev1.EnvVar{
+			Name: name,
+			ValueFrom: &corev1.EnvVarSource{
+				FieldRef: &corev1.ObjectFieldSelector{FieldPath: fieldPath},
+			},
+		}
+	}
+
+	vars := []corev1.EnvVar{
+		{Name: HCSStatsDirEnvVar, Value: HCSStatsMountPath},
+		fieldEnv(HCSPodUIDEnvVar, "metadata.uid"),
+		fieldEnv("HCS_POD_NAMESPACE", "metadata.namespace"),
+		fieldEnv("HCS_POD_NAME", "metadata.name"),
+		{Name: "HCS_CONTAINER_NAME", Value: container.Name},
+	}
+
+	for _, v := range vars {
+		if !hasEnv(container, v.Name) {
+			container.Env = append(container.Env, v)
+		}
+	}
+}
+
+// injectStatsVolumeMount mounts this pod's stats subdirectory. The
+// subPathExpr expands HCS_POD_UID, so the env var must be injected first.
+func (h *HCSInjector) injectStatsVolumeMount(container *corev1.Container) {
+	for _, mount := range container.VolumeMounts {
+		if mount.Name == HCSStatsVolumeName || mount.MountPath == HCSStatsMountPath {
+			return
+		}
+	}
+
+	container.VolumeMounts = append(container.VolumeMounts, corev1.VolumeMount{
+		Name:        HCSStatsVolumeName,
+		MountPath:   HCSStatsMountPath,
+		SubPathExpr: "$(" + HCSPodUIDEnvVar + ")",
+	})
+}
+
+// injectStatsVolume adds the host stats directory volume to the pod spec
+func (h *HCSInjector) injectStatsVolume(pod *corev1.Pod) {
+	for _, vol := range pod.Spec.Volumes {
+		if vol.Name == HCSStatsVolumeName {
+			return
+		}
+	}
+
+	hostPathType := corev1.HostPathDirectoryOrCreate
+	pod.Spec.Volumes = append(pod.Spec.Volumes, corev1.Volume{
+		Name: HCSStatsVolumeName,
+		VolumeSource: corev1.VolumeSource{
+			HostPath: &corev1.HostPathVolumeSource{
+				Path: h.statsHostPath,
+				Type: &hostPathType,
+			},
+		},
+	})
+}
+
+// injectQuotaPool points a container's interceptor at the pod's shared quota
+// pool and mounts the pool volume
+func (h *HCSInjector) injectQuotaPool(container *corev1.Container) {
+	if !hasEnv(container, HCSQuotaPoolEnvVar) {
+		container.Env = append(container.Env, corev1.EnvVar{
+			Name:  HCSQuotaPoolEnvVar,
+			Value: HCSPoolMountPath + "/" + HCSPoolFileName,
+		})
+	}
+
+	for _, mount := range container.VolumeMounts {
+		if mount.Name == HCSPoolVolumeName || mount.MountPath == HCSPoolMountPath {
+			return
+		}
+	}
+	container.VolumeMounts = append(container.VolumeMounts, corev1.VolumeMount{
+		Name:      HCSPoolVolumeName,
+		MountPath: HCSPoolMountPath,
+	})
+}
+
+// injectPoolVolume adds the in-memory volume holding the quota pool
+func (h *HCSInjector) injectPoolVolume(pod *corev1.Pod) {
+	for _, vol := range pod.Spec.Volumes {
+		if vol.Name == HCSPoolVolumeName {
+			return
+		}
+	}
+
+	pod.Spec.Volumes = append(pod.Spec.Volumes, corev1.Volume{
+		Name: HCSPoolVolumeName,
+		VolumeSource: corev1.VolumeSource{
+			EmptyDir: &corev1.EmptyDirVolumeSource{Medium: corev1.StorageMediumMemory},
+		},
+	})
+}
+
+// hasEnv reports whether a container already defines an environment variable
+func hasEnv(container *corev1.Container, name string) bool {
+	for _, env := range container.Env {
+		if env.Name == name {
+			return true
+		}
+	}
+	return false
+}
+
 // NeedsHCSInjection checks if a pod requires HCS interceptor injection based on resource requests
 func NeedsHCSInjection(pod *corev1.Pod) bool {
 	if pod == nil {
@@ -379,6 +551,11 @@ func (h *HCSInjector) GetContainerLibPath() string {
 	return h.containerLibPath
 }
 
+// GetStatsHostPath returns the host directory for interceptor stats pages
+func (h *HCSInjector) GetStatsHostPath() string {
+	return h.statsHostPath
+}
+
 // IsEnabled returns whether HCS injection is enabled
 func (h *HCSInjector) IsEnabled() bool {
 	return h.enabled
@@ -636,7 +636,7 @@ func TestHCSInjector_ExtractVRAMQuota(t *testing.T) {
 
 	for _, tt := range tests {
 		t.Run(tt.name, func(t *testing.T) {
-			quota := injector.extractVRAMQuota(tt.pod)
+			quota := injector.extractVRAMQuota(tt.pod, false)
 			if quota != tt.wantQuota {
 				t.Errorf("extractVRAMQuota() = %v, want %v", quota, tt.wantQuota)
 			}
@@ -747,3 +747,163 @@ func TestHCSInjector_FullInjection(t *testing.T) {
 		t.Error("expected injection annotation")
 	}
 }
+
+func TestHCSInjector_InjectStatsPage(t *testing.T) {
+	newPod := func() *corev1.Pod {
+		return &corev1.Pod{
+			ObjectMeta: metav1.ObjectMeta{Name: "test-pod"},
+			Spec: corev1.PodSpec{
+				Containers: []corev1.Container{
+					{
+						Name: "main",
+						Resources: corev1.ResourceRequirements{
+							Requests: corev1.ResourceList{
+								corev1.ResourceName(HCSVRAMResource): resource.MustParse("16Gi"),
+							},
+						},
+					},
+				},
+			},
+		}
+	}
+
+	t.Run("enabled by default", func(t *testing.T) {
+		pod := newPod()
+		if _, err := NewHCSInjector().InjectHCS(pod); err != nil {
+			t.Fatalf("InjectHCS() error = %v", err)
+		}
+
+		container := pod.Spec.Containers[0]
+		env := make(map[string]corev1.EnvVar)
+		for _, e := range container.Env {
+			env[e.Name] = e
+		}
+		if env[HCSStatsDirEnvVar].Value != HCSStatsMountPath {
+			t.Errorf("HCS_STATS_DIR = %q, want %q", env[HCSStatsDirEnvVar].Value, HCSStatsMountPath)
+		}
+		uid := env[HCSPodUIDEnvVar]
+		if uid.ValueFrom == nil || uid.ValueFrom.FieldRef == nil || uid.ValueFrom.FieldRef.FieldPath != "metadata.uid" {
+			t.Errorf("HCS_POD_UID should come from metadata.uid, got %+v", uid)
+		}
+		if env["HCS_CONTAINER_NAME"].Value != "main" {
+			t.Errorf("HCS_CONTAINER_NAME = %q, want main", env["HCS_CONTAINER_NAME"].Value)
+		}
+
+		var mount *corev1.VolumeMount
+		for i := range container.VolumeMounts {
+			if container.VolumeMounts[i].Name == HCSStatsVolumeName {
+				mount = &container.VolumeMounts[i]
+			}
+		}
+		if mount == nil || mount.SubPathExpr != "$(HCS_POD_UID)" || mount.ReadOnly {
+			t.Errorf("expected writable per-pod stats mount, got %+v", mount)
+		}
+
+		var volume *corev1.Volume
+		for i := range pod.Spec.Volumes {
+			if pod.Spec.Volumes[i].Name == HCSStatsVolumeName {
+				volume = &pod.Spec.Volumes[i]
+			}
+		}
+		if volume == nil || volume.HostPath == nil || volume.HostPath.Path != DefaultStatsHostDir {
+			t.Errorf("expected stats hostPath volume, got %+v", volume)
+		}
+	})
+
+	t.Run("disabled with empty host path", func(t *testing.T) {
+		pod := newPod()
+		if _, err := NewHCSInjector(WithStatsHostPath("")).InjectHCS(pod); err != nil {
+			t.Fatalf("InjectHCS() error = %v", err)
+		}
+		for _, e := range pod.Spec.Containers[0].Env {
+			if e.Name == HCSStatsDirEnvVar {
+				t.Error("HCS_STATS_DIR should not be injected")
+			}
+		}
+		for _, vol := range pod.Spec.Volumes {
+			if vol.Name == HCSStatsVolumeName {
+				t.Error("stats volume should not be injected")
+			}
+		}
+	})
+}
+
+func TestHCSInjector_InjectQuotaPool(t *testing.T) {
+	container := func(name, vram string) corev1.Container {
+		return corev1.Container{
+			Name: name,
+			Resources: corev1.ResourceRequirements{
+				Requests: corev1.ResourceList{
+					corev1.ResourceName(HCSVRAMResource): resource.MustParse(vram),
+				},
+			},
+		}
+	}
+	newPod := func(annotations map[string]string) *corev1.Pod {
+		return &corev1.Pod{
+			ObjectMeta: metav1.ObjectMeta{Name: "test-pod", Annotations: annotations},
+			Spec: corev1.PodSpec{
+				Containers: []corev1.Container{container("main", "16Gi"), container("sidecar", "8Gi")},
+			},
+		}
+	}
+
+	t.Run("pooled pod shares the summed quota", func(t *testing.T) {
+		pod := newPod(map[string]string{HCSQuotaPoolAnnotation: "true"})
+		result, err := NewHCSInjector().InjectHCS(pod)
+		if err != nil {
+			t.Fatalf("InjectHCS() error = %v", err)
+		}
+		if result.VRAMQuota != "24Gi" {
+			t.Errorf("VRAMQuota = %v, want 24Gi", result.VRAMQuota)
+		}
+
+		for _, c := range pod.Spec.Containers {
+			var poolPath string
+			for _, env := range c.Env {
+				if env.Name == HCSQuotaPoolEnvVar {
+					poolPath = env.Value
+				}
+			}
+			if poolPath != HCSPoolMountPath+"/"+HCSPoolFileName {
+				t.Errorf("container %s: HCS_QUOTA_POOL = %q", c.Name, poolPath)
+			}
+
+			var hasMount bool
+			for _, mount := range c.VolumeMounts {
+				if mount.Name == HCSPoolVolumeName && mount.MountPath == HCSPoolMountPath {
+					hasMount = true
+				}
+			}
+			if !hasMount {
+				t.Errorf("container %s: expected pool volume mount", c.Name)
+			}
+		}
+
+		var volume *corev1.Volume
+		for i := range pod.Spec.Volumes {
+			if pod.Spec.Volumes[i].Name == HCSPoolVolumeName {
+				volume = &pod.Spec.Volumes[i]
+			}
+		}
+		if volume == nil || volume.EmptyDir == nil || volume.EmptyDir.Medium != corev1.StorageMediumMemory {
+			t.Errorf("expected in-memory pool volume, got %+v", volume)
+		}
+	})
+
+	t.Run("unpooled pod keeps per-process quota", func(t *testing.T) {
+		pod := newPod(nil)
+		result, err := NewHCSInjector().InjectHCS(pod)
+		if err != nil {
+			t.Fatalf("InjectHCS() error = %v", err)
+		}
+		if result.VRAMQuota != "16Gi" {
+			t.Errorf("VRAMQuota = %v, want 16Gi", result.VRAMQuota)
+		}
+		for _, env := range pod.Spec.Containers[0].Env {
+			if env.Name == HCSQuotaPoolEnvVar {
+				t.Error("HCS_QUOTA_POOL should not be injected without the annotation")
+			}
+		}
+	})
+}
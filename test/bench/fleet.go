@@ -0,0 +1,159 @@
+package main
+
+import (
+	"bufio"
+	"encoding/json"
+	"fmt"
+	"math/rand"
+	"os"
+
+	metav1 "k8s.io/apimachinery/pkg/apis/meta/v1"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
+	"github.com/zrs-products/hetero-compute-router/pkg/exchange"
+)
+
+const gib = 1024 * 1024 * 1024
+
+// fleetVendors 合成集群使用的厂商及其占比
+var fleetVendors = []struct {
+	vendor       string
+	weight       int
+	devices      int
+	interconnect string
+}{
+	{exchange.VendorNVIDIA, 5, 8, "NVLink"},
+	{exchange.VendorHuawei, 3, 8, "HCCS"},
+	{exchange.VendorHygon, 2, 8, "PCIe"},
+}
+
+// generateFleet 按 exchange 中的硬件档案生成 n 个 ComputeNode
+// 每个节点只有一种型号，设备已用显存在 0-60% 之间随机分布
+func generateFleet(rng *rand.Rand, calc *exchange.Calculator, n int) ([]*v1alpha1.ComputeNode, error) {
+	byVendor := make(map[string][]*exchange.HardwareProfile)
+	for _, p := range calc.ListProfiles() {
+		byVendor[p.Vendor] = append(byVendor[p.Vendor], p)
+	}
+
+	totalWeight := 0
+	for _, v := range fleetVendors {
+		if len(byVendor[v.vendor]) == 0 {
+			return nil, fmt.Errorf("no hardware profile for vendor %s", v.vendor)
+		}
+		totalWeight += v.weight
+	}
+
+	nodes := make([]*v1alpha1.ComputeNode, 0, n)
+	for i := 0; i < n; i++ {
+		pick := rng.Intn(totalWeight)
+		v := fleetVendors[0]
+		for _, candidate := range fleetVendors {
+			if pick < candidate.weight {
+				v = candidate
+				break
+			}
+			pick -= candidate.weight
+		}
+		profiles := byVendor[v.vendor]
+		profile := profiles[rng.Intn(len(profiles))]
+
+		name := fmt.Sprintf("node-%05d", i)
+		cn := &v1alpha1.ComputeNode{
+			ObjectMeta: metav1.ObjectMeta{Name: name},
+			Spec: v1alpha1.ComputeNodeSpec{
+				NodeName: name,
+				Vendor:   profile.Vendor,
+				TotalCapacity: v1alpha1.ComputeCapacity{
+					VRAM:       uint64(v.devices) * profile.VRAMBytes,
+					FP16TFLOPS: uint64(float64(v.devices) * profile.FP16TFLOPS),
+					FP32TFLOPS: uint64(float64(v.devices) * profile.FP32TFLOPS),
+				},
+			},
+			Status: v1alpha1.ComputeNodeStatus{Phase: v1alpha1.ComputeNodePhaseReady},
+		}
+		for d := 0; d < v.devices; d++ {
+			cn.Status.Devices = append(cn.Status.Devices, v1alpha1.DeviceInfo{
+				ID:               fmt.Sprintf("dev-%d", d),
+				Model:            profile.Model,
+				VRAMTotal:        profile.VRAMBytes,
+				VRAMUsed:         uint64(rng.Float64() * 0.6 * float64(profile.VRAMBytes)),
+				HealthScore:      85 + rng.Float64()*15,
+				InterconnectType: v.interconnect,
+			})
+		}
+		nodes = append(nodes, cn)
+	}
+	return nodes, nil
+}
+
+// podSpec 到达轨迹中的一个 Pod
+type podSpec struct {
+	// VRAMGi 各容器的 VRAM 请求（GiB）
+	VRAMGi []float64 `json:"vram_gi"`
+
+	// FP16TFLOPS Pod 的 FP16 算力请求
+	FP16TFLOPS int64 `json:"fp16_tflops,omitempty"`
+
+	// Lifetime 再到达多少个 Pod 后该 Pod 结束并释放预留
+	Lifetime int `json:"lifetime"`
+}
+
+// podMix 合成轨迹的请求分布：推理小任务居多，少量多卡训练任务
+var podMix = []struct {
+	weight int
+	vramGi []float64
+	fp16   int64
+}{
+	{30, []float64{4}, 0},
+	{25, []float64{8}, 50},
+	{20, []float64{16}, 100},
+	{10, []float64{24, 8}, 150},
+	{8, []float64{40}, 200},
+	{5, []float64{80}, 300},
+	{2, []float64{160}, 600},
+}
+
+// generateTrace 生成 count 个 Pod 的到达轨迹，生命周期服从均值为 meanLifetime 的指数分布
+func generateTrace(rng *rand.Rand, count, meanLifetime int) []podSpec {
+	totalWeight := 0
+	for _, m := range podMix {
+		totalWeight += m.weight
+	}
+
+	trace := make([]podSpec, count)
+	for i := range trace {
+		pick := rng.Intn(totalWeight)
+		for _, m := range podMix {
+			if pick < m.weight {
+				trace[i] = podSpec{VRAMGi: m.vramGi, FP16TFLOPS: m.fp16}
+				break
+			}
+			pick -= m.weight
+		}
+		trace[i].Lifetime = 1 + int(rng.ExpFloat64()*float64(meanLifetime))
+	}
+	return trace
+}
+
+// loadTrace 读取 JSON Lines 格式的到达轨迹，每行一个 podSpec
+func loadTrace(path string) ([]podSpec, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	var trace []podSpec
+	scanner := bufio.NewScanner(f)
+	for line := 1; scanner.Scan(); line++ {
+		if len(scanner.Bytes()) == 0 {
+			continue
+		}
+		var spec podSpec
+		if err := json.Unmarshal(scanner.Bytes(), &spec); err != nil {
+			return nil, fmt.Errorf("%s:%d: %w", path, line, err)
+		}
+		trace = append(trace, spec)
+	}
+	return trace, scanner.Err()
+}
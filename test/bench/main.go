@@ -0,0 +1,186 @@
+// HCS 端到端负载基准
+//
+// 衡量调度器插件每秒能放置多少 Pod，以及节点侧遥测路径单设备消耗多少 CPU，
+// 用于确定调度器副本数与 node-agent 的 CPU requests。
+//
+// 套件：
+//
+//	schedule   - 生成 100 至 5000 节点的合成集群（NVIDIA/昇腾/海光混合，硬件档案来自
+//	             exchange 内置档案与 -profiles），按到达轨迹依次执行
+//	             PreFilter/Filter/Score/NormalizeScore/Reserve，Pod 在其生命周期结束后释放预留
+//	analyzer   - 按 eBPF 管理器的采样间隔把事件流送入 HealthAnalyzer，每个采集间隔读取快照
+//	collectors - 对合成设备重复执行默认采集器组合的 CollectAll
+//
+// 每个结果输出一行 JSON，例如：
+//
+//	{"bench":"schedule","nodes":1000,"pods":2000,"scheduled":1874,"unschedulable":126,
+//	 "pods_per_sec":2210.4,"p50_us":402.1,"p99_us":951.3,...,"allocs_per_op":3120.5,...}
+//
+// 运行：
+//
+//	make bench
+//	go run ./test/bench -suite schedule -nodes 5000 -trace arrivals.jsonl
+//	go run ./test/bench -suite analyzer -events recorded.jsonl
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math/rand"
+	"os"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/exchange"
+)
+
+// config 命令行参数
+type config struct {
+	suites          map[string]bool
+	nodes           []int
+	pods            int
+	lifetime        int
+	trace           string
+	profiles        string
+	devices         []int
+	simDuration     time.Duration
+	healthRate      float64
+	events          string
+	collects        int
+	collectInterval time.Duration
+	seed            int64
+}
+
+// rng 每个用例使用相同种子的独立随机源，结果可复现
+func (c *config) rng() *rand.Rand {
+	return rand.New(rand.NewSource(c.seed))
+}
+
+func main() {
+	cfg, err := parseFlags()
+	if err != nil {
+		fatalf("%v", err)
+	}
+
+	if cfg.suites["schedule"] {
+		runScheduleSuite(cfg)
+	}
+	if cfg.suites["analyzer"] {
+		runAnalyzerSuite(cfg)
+	}
+	if cfg.suites["collectors"] {
+		for _, devices := range cfg.devices {
+			result, err := runCollectors(devices, cfg.collects, cfg.collectInterval)
+			if err != nil {
+				fatalf("collectors: %v", err)
+			}
+			emit(result)
+		}
+	}
+}
+
+func parseFlags() (*config, error) {
+	var suites, nodes, devices string
+	cfg := &config{}
+
+	flag.StringVar(&suites, "suite", "schedule,analyzer,collectors", "Comma-separated suites to run")
+	flag.StringVar(&nodes, "nodes", "100,500,1000,5000", "Comma-separated fleet sizes for the schedule suite")
+	flag.IntVar(&cfg.pods, "pods", 2000, "Pods in the generated arrival trace")
+	flag.IntVar(&cfg.lifetime, "lifetime", 500, "Mean pod lifetime, in subsequent arrivals")
+	flag.StringVar(&cfg.trace, "trace", "", "Pod arrival trace (JSON Lines), replaces the generated trace")
+	flag.StringVar(&cfg.profiles, "profiles", "test/bench/profiles.yaml", "Hardware profiles merged with the exchange builtins")
+	flag.StringVar(&devices, "devices", "8,16,64", "Comma-separated device counts for the analyzer and collectors suites")
+	flag.DurationVar(&cfg.simDuration, "sim-duration", 10*time.Minute, "Simulated time covered by the generated event stream")
+	flag.Float64Var(&cfg.healthRate, "health-rate", 0.05, "Health events per device per second in the generated stream")
+	flag.StringVar(&cfg.events, "events", "", "Recorded event stream (JSON Lines), replaces the generated stream")
+	flag.IntVar(&cfg.collects, "collects", 1000, "CollectAll calls per collectors case")
+	flag.DurationVar(&cfg.collectInterval, "collect-interval", 10*time.Second, "node-agent collection interval used to derive CPU per device")
+	flag.Int64Var(&cfg.seed, "seed", 1, "Random seed for generated fleets, traces and events")
+	flag.Parse()
+
+	cfg.suites = make(map[string]bool)
+	for _, s := range strings.Split(suites, ",") {
+		switch s = strings.TrimSpace(s); s {
+		case "schedule", "analyzer", "collectors":
+			cfg.suites[s] = true
+		case "":
+		default:
+			return nil, fmt.Errorf("unknown suite %q", s)
+		}
+	}
+
+	var err error
+	if cfg.nodes, err = parseInts(nodes); err != nil {
+		return nil, fmt.Errorf("-nodes: %w", err)
+	}
+	if cfg.devices, err = parseInts(devices); err != nil {
+		return nil, fmt.Errorf("-devices: %w", err)
+	}
+	if cfg.collectInterval <= 0 {
+		return nil, fmt.Errorf("-collect-interval must be positive")
+	}
+	return cfg, nil
+}
+
+func parseInts(s string) ([]int, error) {
+	var values []int
+	for _, field := range strings.Split(s, ",") {
+		if field = strings.TrimSpace(field); field == "" {
+			continue
+		}
+		v, err := strconv.Atoi(field)
+		if err != nil || v <= 0 {
+			return nil, fmt.Errorf("invalid count %q", field)
+		}
+		values = append(values, v)
+	}
+	return values, nil
+}
+
+func runScheduleSuite(cfg *config) {
+	calc := exchange.NewCalculator()
+	if cfg.profiles != "" {
+		var err error
+		if calc, err = exchange.NewCalculatorFromFile(cfg.profiles); err != nil {
+			fatalf("%v", err)
+		}
+	}
+
+	trace := generateTrace(cfg.rng(), cfg.pods, cfg.lifetime)
+	if cfg.trace != "" {
+		var err error
+		if trace, err = loadTrace(cfg.trace); err != nil {
+			fatalf("load trace: %v", err)
+		}
+	}
+
+	for _, nodes := range cfg.nodes {
+		result, err := runSchedule(cfg, calc, trace, nodes)
+		if err != nil {
+			fatalf("schedule: %v", err)
+		}
+		emit(result)
+	}
+}
+
+func runAnalyzerSuite(cfg *config) {
+	if cfg.events != "" {
+		events, err := loadEvents(cfg.events)
+		if err != nil {
+			fatalf("load events: %v", err)
+		}
+		emit(runAnalyzer(events, cfg.collectInterval))
+		return
+	}
+
+	for _, devices := range cfg.devices {
+		events := generateEvents(cfg.rng(), devices, cfg.simDuration, cfg.healthRate)
+		emit(runAnalyzer(events, cfg.collectInterval))
+	}
+}
+
+func fatalf(format string, args ...interface{}) {
+	fmt.Fprintf(os.Stderr, "bench: "+format+"\n", args...)
+	os.Exit(1)
+}
@@ -0,0 +1,199 @@
+package main
+
+import (
+	"context"
+	"fmt"
+	"sort"
+	"time"
+
+	v1 "k8s.io/api/core/v1"
+	"k8s.io/apimachinery/pkg/api/resource"
+	metav1 "k8s.io/apimachinery/pkg/apis/meta/v1"
+	"k8s.io/apimachinery/pkg/types"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/api/v1alpha1"
+	"github.com/zrs-products/hetero-compute-router/pkg/exchange"
+	"github.com/zrs-products/hetero-compute-router/pkg/scheduler/framework"
+	"github.com/zrs-products/hetero-compute-router/pkg/scheduler/plugins"
+)
+
+// maxReserveAttempts Reserve 失败时依次尝试的候选节点数
+const maxReserveAttempts = 3
+
+// scheduleResult 一个集群规模下的调度结果
+type scheduleResult struct {
+	Bench         string  `json:"bench"`
+	Nodes         int     `json:"nodes"`
+	Pods          int     `json:"pods"`
+	Scheduled     int     `json:"scheduled"`
+	Unschedulable int     `json:"unschedulable"`
+	PodsPerSec    float64 `json:"pods_per_sec"`
+	P50us         float64 `json:"p50_us"`
+	P99us         float64 `json:"p99_us"`
+	FilterP99us   float64 `json:"filter_p99_us"`
+	ScoreP99us    float64 `json:"score_p99_us"`
+	ReserveP99us  float64 `json:"reserve_p99_us"`
+	AllocsPerOp   float64 `json:"allocs_per_op"`
+	BytesPerOp    float64 `json:"bytes_per_op"`
+}
+
+// scheduler 与调度器扩展器相同的插件组合，ComputeNode 来自内存缓存
+type scheduler struct {
+	filter  *plugins.FilterPlugin
+	score   *plugins.ScorePlugin
+	reserve *plugins.ReservePlugin
+	nodes   []*framework.NodeInfo
+}
+
+func newScheduler(calc *exchange.Calculator, fleet []*v1alpha1.ComputeNode) *scheduler {
+	cache := plugins.NewComputeNodeCache()
+	nodes := make([]*framework.NodeInfo, 0, len(fleet))
+	for _, cn := range fleet {
+		cache.Upsert(cn)
+		nodes = append(nodes, framework.NewNodeInfo(&v1.Node{ObjectMeta: metav1.ObjectMeta{Name: cn.Name}}))
+	}
+
+	// 客户端为 nil：所有读取都必须命中快照
+	filter := plugins.NewFilterPlugin(nil)
+	filter.UseComputeNodeCache(cache)
+	return &scheduler{
+		filter:  filter,
+		score:   plugins.NewScorePlugin(nil, calc),
+		reserve: plugins.NewReservePlugin(nil),
+		nodes:   nodes,
+	}
+}
+
+// phaseTimes 单个 Pod 各阶段的耗时
+type phaseTimes struct {
+	filter, score, reserve time.Duration
+}
+
+// schedule 对一个 Pod 执行 PreFilter/Filter/Score/NormalizeScore/Reserve，返回是否成功预留
+func (s *scheduler) schedule(ctx context.Context, pod *v1.Pod) (bool, phaseTimes) {
+	var times phaseTimes
+	start := time.Now()
+
+	state := framework.NewCycleState()
+	if status := s.filter.PreFilter(ctx, state, pod); !status.IsSuccess() {
+		return false, times
+	}
+
+	feasible := make([]string, 0, len(s.nodes))
+	for _, node := range s.nodes {
+		if s.filter.Filter(ctx, state, pod, node).IsSuccess() {
+			feasible = append(feasible, node.Node().Name)
+		}
+	}
+	scoreStart := time.Now()
+	times.filter = scoreStart.Sub(start)
+	if len(feasible) == 0 {
+		return false, times
+	}
+
+	scores := make(framework.NodeScoreList, 0, len(feasible))
+	for _, name := range feasible {
+		score, _ := s.score.Score(ctx, state, pod, name)
+		scores = append(scores, framework.NodeScore{Name: name, Score: score})
+	}
+	s.score.ScoreExtensions().NormalizeScore(ctx, state, pod, scores)
+	sort.SliceStable(scores, func(a, b int) bool { return scores[a].Score > scores[b].Score })
+	reserveStart := time.Now()
+	times.score = reserveStart.Sub(scoreStart)
+
+	// Filter 不计入其他 Pod 的预留，得分最高的节点可能已被占满
+	reserved := false
+	for i := 0; i < len(scores) && i < maxReserveAttempts; i++ {
+		if s.reserve.Reserve(ctx, state, pod, scores[i].Name).IsSuccess() {
+			reserved = true
+			break
+		}
+	}
+	times.reserve = time.Since(reserveStart)
+	return reserved, times
+}
+
+// newPod 按 podSpec 构造 Pod，每个 VRAM 请求一个容器
+func newPod(i int, spec podSpec) *v1.Pod {
+	pod := &v1.Pod{
+		ObjectMeta: metav1.ObjectMeta{
+			Name:      fmt.Sprintf("pod-%06d", i),
+			Namespace: "bench",
+			UID:       types.UID(fmt.Sprintf("bench-%06d", i)),
+		},
+	}
+	for c, vram := range spec.VRAMGi {
+		requests := v1.ResourceList{
+			v1.ResourceName(plugins.VRAMResourceName): *resource.NewQuantity(int64(vram*gib), resource.BinarySI),
+		}
+		if c == 0 && spec.FP16TFLOPS > 0 {
+			requests[v1.ResourceName(plugins.FP16TFLOPSResourceName)] = *resource.NewQuantity(spec.FP16TFLOPS, resource.DecimalSI)
+		}
+		pod.Spec.Containers = append(pod.Spec.Containers, v1.Container{
+			Name:      fmt.Sprintf("c%d", c),
+			Resources: v1.ResourceRequirements{Requests: requests},
+		})
+	}
+	return pod
+}
+
+// runSchedule 在 nodes 个节点的合成集群上回放 trace
+// 每个 Pod 在其 Lifetime 个后续到达之后结束，释放预留
+func runSchedule(cfg *config, calc *exchange.Calculator, trace []podSpec, nodes int) (*scheduleResult, error) {
+	fleet, err := generateFleet(cfg.rng(), calc, nodes)
+	if err != nil {
+		return nil, err
+	}
+	s := newScheduler(calc, fleet)
+
+	// Pod 对象在计时之外构造，只统计插件本身的开销
+	pods := make([]*v1.Pod, len(trace))
+	for i, spec := range trace {
+		pods[i] = newPod(i, spec)
+	}
+
+	result := &scheduleResult{Bench: "schedule", Nodes: nodes, Pods: len(trace)}
+	all := make(latencies, 0, len(trace))
+	filterTimes := make(latencies, 0, len(trace))
+	scoreTimes := make(latencies, 0, len(trace))
+	reserveTimes := make(latencies, 0, len(trace))
+	departures := make(map[int][]string)
+
+	ctx := context.Background()
+	allocs := startAllocs()
+	start := time.Now()
+	for i, pod := range pods {
+		for _, key := range departures[i] {
+			s.reserve.ClearPodReservation(key)
+		}
+		delete(departures, i)
+
+		podStart := time.Now()
+		ok, times := s.schedule(ctx, pod)
+		all = append(all, time.Since(podStart))
+		filterTimes = append(filterTimes, times.filter)
+		scoreTimes = append(scoreTimes, times.score)
+		reserveTimes = append(reserveTimes, times.reserve)
+
+		if !ok {
+			result.Unschedulable++
+			continue
+		}
+		result.Scheduled++
+		end := i + trace[i].Lifetime
+		departures[end] = append(departures[end], string(pod.UID))
+	}
+	elapsed := time.Since(start)
+	result.AllocsPerOp, result.BytesPerOp = allocs.perOp(len(trace))
+
+	for _, l := range []latencies{all, filterTimes, scoreTimes, reserveTimes} {
+		l.sort()
+	}
+	result.PodsPerSec = float64(len(trace)) / elapsed.Seconds()
+	result.P50us = micros(all.quantile(0.50))
+	result.P99us = micros(all.quantile(0.99))
+	result.FilterP99us = micros(filterTimes.quantile(0.99))
+	result.ScoreP99us = micros(scoreTimes.quantile(0.99))
+	result.ReserveP99us = micros(reserveTimes.quantile(0.99))
+	return result, nil
+}
@@ -0,0 +1,61 @@
+package main
+
+import (
+	"encoding/json"
+	"os"
+	"runtime"
+	"sort"
+	"time"
+)
+
+// latencies 记录每次操作的耗时
+type latencies []time.Duration
+
+// quantile 返回分位数，q 取 0-1；调用前需已排序
+func (l latencies) quantile(q float64) time.Duration {
+	if len(l) == 0 {
+		return 0
+	}
+	i := int(q * float64(len(l)-1))
+	return l[i]
+}
+
+func (l latencies) sort() {
+	sort.Slice(l, func(a, b int) bool { return l[a] < l[b] })
+}
+
+func micros(d time.Duration) float64 {
+	return float64(d) / float64(time.Microsecond)
+}
+
+// allocCounter 统计区间内的堆分配次数与字节数
+type allocCounter struct {
+	mallocs uint64
+	bytes   uint64
+}
+
+func startAllocs() allocCounter {
+	var ms runtime.MemStats
+	runtime.GC()
+	runtime.ReadMemStats(&ms)
+	return allocCounter{mallocs: ms.Mallocs, bytes: ms.TotalAlloc}
+}
+
+// perOp 返回自 startAllocs 起平均每次操作的分配次数与字节数
+func (c allocCounter) perOp(ops int) (allocs, bytes float64) {
+	if ops == 0 {
+		return 0, 0
+	}
+	var ms runtime.MemStats
+	runtime.ReadMemStats(&ms)
+	return float64(ms.Mallocs-c.mallocs) / float64(ops), float64(ms.TotalAlloc-c.bytes) / float64(ops)
+}
+
+// output 每个结果输出为一行 JSON
+var output = json.NewEncoder(os.Stdout)
+
+func emit(result interface{}) {
+	if err := output.Encode(result); err != nil {
+		fatalf("write result: %v", err)
+	}
+}
@@ -0,0 +1,271 @@
+package main
+
+import (
+	"bufio"
+	"context"
+	"encoding/json"
+	"fmt"
+	"math/rand"
+	"os"
+	"sort"
+	"time"
+
+	"github.com/zrs-products/hetero-compute-router/pkg/collectors"
+	"github.com/zrs-products/hetero-compute-router/pkg/detectors"
+	"github.com/zrs-products/hetero-compute-router/pkg/monitoring/ebpf"
+)
+
+// telemetryResult 节点侧遥测路径的开销
+type telemetryResult struct {
+	Bench      string  `json:"bench"`
+	Devices    int     `json:"devices"`
+	Ops        int     `json:"ops"`
+	SimSeconds float64 `json:"sim_seconds,omitempty"`
+	NsPerOp    float64 `json:"ns_per_op"`
+	P99us      float64 `json:"p99_us"`
+
+	// AllocsPerOp 每个事件（analyzer）或每次采集（collectors）的堆分配
+	AllocsPerOp float64 `json:"allocs_per_op"`
+	BytesPerOp  float64 `json:"bytes_per_op"`
+
+	// MillicoresPerDevice 按实际采样频率折算的单设备 CPU 占用
+	MillicoresPerDevice float64 `json:"millicores_per_device"`
+}
+
+// eventRecord 录制的事件流中的一条记录（JSON Lines）
+type eventRecord struct {
+	Kind     string `json:"kind"` // gpu, pcie, health
+	Device   uint32 `json:"device"`
+	OffsetMs int64  `json:"offset_ms"`
+
+	CoreClock   uint32 `json:"core_clock,omitempty"`
+	MemoryClock uint32 `json:"memory_clock,omitempty"`
+	PowerMw     uint32 `json:"power_mw,omitempty"`
+	Temperature uint32 `json:"temperature,omitempty"`
+	Utilization uint32 `json:"utilization,omitempty"`
+	Throttle    uint8  `json:"throttle,omitempty"`
+
+	ReadBytes  uint64 `json:"read_bytes,omitempty"`
+	WriteBytes uint64 `json:"write_bytes,omitempty"`
+	Replay     uint32 `json:"replay,omitempty"`
+
+	Type  ebpf.HealthEventType `json:"type,omitempty"`
+	Count uint32               `json:"count,omitempty"`
+}
+
+// healthEventMix 合成事件流中健康事件的类型分布
+var healthEventMix = []ebpf.HealthEventType{
+	ebpf.EventECCSingleBit, ebpf.EventECCSingleBit, ebpf.EventECCSingleBit,
+	ebpf.EventClockThrottle, ebpf.EventPowerThrottle, ebpf.EventThermalThrottle,
+	ebpf.EventPageRetire,
+}
+
+// generateEvents 按 eBPF 管理器的默认采样间隔生成 devices 个设备 duration 时长的事件流
+// 健康事件按每设备每秒 healthRate 个的泊松过程到达
+func generateEvents(rng *rand.Rand, devices int, duration time.Duration, healthRate float64) []eventRecord {
+	defaults := ebpf.DefaultConfig()
+	var events []eventRecord
+
+	for d := 0; d < devices; d++ {
+		dev := uint32(d)
+		util := 50 + rng.Intn(40)
+		for t := time.Duration(0); t < duration; t += defaults.GPUSampleInterval {
+			events = append(events, eventRecord{
+				Kind: "gpu", Device: dev, OffsetMs: t.Milliseconds(),
+				CoreClock:   1410 - uint32(rng.Intn(60)),
+				MemoryClock: 1593,
+				PowerMw:     250000 + uint32(rng.Intn(50000)),
+				Temperature: 60 + uint32(rng.Intn(15)),
+				Utilization: uint32(util + rng.Intn(10)),
+			})
+		}
+		for t := time.Duration(0); t < duration; t += defaults.PCIeSampleInterval {
+			events = append(events, eventRecord{
+				Kind: "pcie", Device: dev, OffsetMs: t.Milliseconds(),
+				ReadBytes:  uint64(rng.Intn(2 << 30)),
+				WriteBytes: uint64(rng.Intn(1 << 30)),
+			})
+		}
+		if healthRate > 0 {
+			for t := 0.0; ; {
+				t += rng.ExpFloat64() / healthRate
+				offset := time.Duration(t * float64(time.Second))
+				if offset >= duration {
+					break
+				}
+				events = append(events, eventRecord{
+					Kind: "health", Device: dev, OffsetMs: offset.Milliseconds(),
+					Type:  healthEventMix[rng.Intn(len(healthEventMix))],
+					Count: 1,
+				})
+			}
+		}
+	}
+
+	sort.SliceStable(events, func(a, b int) bool { return events[a].OffsetMs < events[b].OffsetMs })
+	return events
+}
+
+// loadEvents 读取录制的事件流，按 offset_ms 排序
+func loadEvents(path string) ([]eventRecord, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	var events []eventRecord
+	scanner := bufio.NewScanner(f)
+	for line := 1; scanner.Scan(); line++ {
+		if len(scanner.Bytes()) == 0 {
+			continue
+		}
+		var e eventRecord
+		if err := json.Unmarshal(scanner.Bytes(), &e); err != nil {
+			return nil, fmt.Errorf("%s:%d: %w", path, line, err)
+		}
+		events = append(events, e)
+	}
+	if err := scanner.Err(); err != nil {
+		return nil, err
+	}
+	sort.SliceStable(events, func(a, b int) bool { return events[a].OffsetMs < events[b].OffsetMs })
+	return events, nil
+}
+
+// runAnalyzer 将事件流按顺序送入 HealthAnalyzer，并按采集间隔读取每个设备的快照
+// 与 node-agent 一样在采集时调用 GetSnapshot 与 IsPredictiveFailure
+func runAnalyzer(events []eventRecord, collectInterval time.Duration) *telemetryResult {
+	deviceSet := make(map[uint32]bool)
+	var last int64
+	for _, e := range events {
+		deviceSet[e.Device] = true
+		if e.OffsetMs > last {
+			last = e.OffsetMs
+		}
+	}
+	devices := make([]uint32, 0, len(deviceSet))
+	for d := range deviceSet {
+		devices = append(devices, d)
+	}
+	sort.Slice(devices, func(a, b int) bool { return devices[a] < devices[b] })
+
+	analyzer := ebpf.NewHealthAnalyzer()
+	base := time.Now()
+	snapshots := make(latencies, 0)
+	nextCollect := collectInterval.Milliseconds()
+
+	allocs := startAllocs()
+	start := time.Now()
+	for _, e := range events {
+		// 模拟时间越过采集点时读取一次所有设备
+		for e.OffsetMs >= nextCollect {
+			collectStart := time.Now()
+			for _, d := range devices {
+				analyzer.GetSnapshot(d)
+				analyzer.IsPredictiveFailure(d)
+			}
+			snapshots = append(snapshots, time.Since(collectStart))
+			nextCollect += collectInterval.Milliseconds()
+		}
+
+		ts := base.Add(time.Duration(e.OffsetMs) * time.Millisecond)
+		switch e.Kind {
+		case "gpu":
+			analyzer.AddGPUEvent(ebpf.GPUEvent{
+				DeviceID: e.Device, Timestamp: ts,
+				CoreClock: e.CoreClock, MemoryClock: e.MemoryClock, Power: e.PowerMw,
+				Temperature: e.Temperature, Utilization: e.Utilization, ThrottlingFlags: e.Throttle,
+			})
+		case "pcie":
+			analyzer.AddPCIeEvent(ebpf.PCIeEvent{
+				DeviceID: e.Device, Timestamp: ts,
+				ReadBytes: e.ReadBytes, WriteBytes: e.WriteBytes, ReplayCount: e.Replay,
+			})
+		case "health":
+			analyzer.AddHealthEvent(ebpf.HealthEvent{
+				DeviceID: e.Device, Timestamp: ts, Type: e.Type, Count: e.Count,
+			})
+		}
+	}
+	elapsed := time.Since(start)
+
+	result := &telemetryResult{
+		Bench:      "analyzer",
+		Devices:    len(devices),
+		Ops:        len(events),
+		SimSeconds: float64(last) / 1000,
+	}
+	result.AllocsPerOp, result.BytesPerOp = allocs.perOp(len(events))
+	if len(events) > 0 {
+		result.NsPerOp = float64(elapsed.Nanoseconds()) / float64(len(events))
+	}
+	snapshots.sort()
+	result.P99us = micros(snapshots.quantile(0.99))
+	if result.SimSeconds > 0 && len(devices) > 0 {
+		// 每模拟秒消耗的 CPU 纳秒数，1 核 = 1e9 ns/s = 1000 millicores
+		result.MillicoresPerDevice = float64(elapsed.Nanoseconds()) / result.SimSeconds / float64(len(devices)) / 1e6
+	}
+	return result
+}
+
+// syntheticDevices 构造 count 个设备及其全互联拓扑
+func syntheticDevices(count int) ([]*detectors.Device, *detectors.Topology) {
+	devices := make([]*detectors.Device, count)
+	topology := &detectors.Topology{}
+	for i := range devices {
+		devices[i] = &detectors.Device{
+			ID:          fmt.Sprintf("dev-%d", i),
+			Model:       "A100-80GB",
+			VRAMTotal:   80 * gib,
+			VRAMUsed:    20 * gib,
+			VRAMFree:    60 * gib,
+			PCIEBusID:   fmt.Sprintf("0000:%02x:00.0", i+1),
+			ComputeCap:  detectors.ComputeCapability{FP16TFLOPS: 312, FP32TFLOPS: 19},
+			Temperature: 65,
+			PowerUsage:  300,
+			HealthScore: 95,
+		}
+		topology.Devices = append(topology.Devices, detectors.TopologyDevice{ID: devices[i].ID, PCIEBusID: devices[i].PCIEBusID})
+		for j := 0; j < i; j++ {
+			topology.Links = append(topology.Links, detectors.TopologyLink{
+				SourceID: devices[j].ID, TargetID: devices[i].ID,
+				Type: detectors.LinkTypeNVLink, Bandwidth: 600,
+			})
+		}
+	}
+	return devices, topology
+}
+
+// runCollectors 重复执行默认采集器组合的 CollectAll
+func runCollectors(devices, collects int, collectInterval time.Duration) (*telemetryResult, error) {
+	devs, topology := syntheticDevices(devices)
+	manager := collectors.NewDefaultManager()
+	ctx := context.Background()
+
+	// 首次采集填充 RefreshOnce 采集器的缓存，与 agent 稳态一致
+	if _, err := manager.CollectAll(ctx, devs, topology); err != nil {
+		return nil, err
+	}
+
+	times := make(latencies, 0, collects)
+	allocs := startAllocs()
+	start := time.Now()
+	for i := 0; i < collects; i++ {
+		collectStart := time.Now()
+		if _, err := manager.CollectAll(ctx, devs, topology); err != nil {
+			return nil, err
+		}
+		times = append(times, time.Since(collectStart))
+	}
+	elapsed := time.Since(start)
+
+	result := &telemetryResult{Bench: "collectors", Devices: devices, Ops: collects}
+	result.AllocsPerOp, result.BytesPerOp = allocs.perOp(collects)
+	result.NsPerOp = float64(elapsed.Nanoseconds()) / float64(collects)
+	times.sort()
+	result.P99us = micros(times.quantile(0.99))
+	// 每个采集间隔执行一次
+	result.MillicoresPerDevice = result.NsPerOp / collectInterval.Seconds() / float64(devices) / 1e6
+	return result, nil
+}